@@ -30,12 +30,14 @@ const char NAME_CLOCK[] = "ClockSpeed";
 const char NAME_CORE_HIL[] = "HILCoreCount";
 const char NAME_CORE_ICL[] = "ICLCoreCount";
 const char NAME_CORE_FTL[] = "FTLCoreCount";
+const char NAME_CORE_ISC[] = "ISCCoreCount";
 
 Config::Config() {
   clock = 400000000;
   hilCore = 1;
   iclCore = 1;
   ftlCore = 1;
+  iscCore = 1;
 }
 
 bool Config::setConfig(const char *name, const char *value) {
@@ -54,6 +56,9 @@ bool Config::setConfig(const char *name, const char *value) {
   else if (MATCH_NAME(NAME_CORE_FTL)) {
     ftlCore = (uint32_t)strtoul(value, nullptr, 10);
   }
+  else if (MATCH_NAME(NAME_CORE_ISC)) {
+    iscCore = (uint32_t)strtoul(value, nullptr, 10);
+  }
   else {
     ret = false;
   }
@@ -65,6 +70,9 @@ void Config::update() {
   if (clock == 0) {
     panic("Invalid ClockSpeed");
   }
+  if (iscCore == 0 || iscCore >= ftlCore) {
+    panic("ISCCoreCount should be in [1, FTLCoreCount)");
+  }
 }
 
 uint64_t Config::readUint(uint32_t idx) {
@@ -83,6 +91,9 @@ uint64_t Config::readUint(uint32_t idx) {
     case CPU_CORE_FTL:
       ret = ftlCore;
       break;
+    case CPU_CORE_ISC:
+      ret = iscCore;
+      break;
   }
 
   return ret;
@@ -33,6 +33,7 @@ typedef enum {
   CPU_CORE_HIL,
   CPU_CORE_ICL,
   CPU_CORE_FTL,
+  CPU_CORE_ISC,
 } CPU_CONFIG;
 
 class Config : public BaseConfig {
@@ -41,6 +42,7 @@ class Config : public BaseConfig {
   uint32_t hilCore;  //!< Default: 1
   uint32_t iclCore;  //!< Default: 1
   uint32_t ftlCore;  //!< Default: 1
+  uint32_t iscCore;  //!< Default: 1 (taken from the FTL cores)
 
  public:
   Config();
@@ -145,8 +145,9 @@ CPU::CPU(ConfigReader &c) : conf(c), lastResetStat(0) {
 
   hilCore.resize(conf.readUint(CONFIG_CPU, CPU_CORE_HIL));
   iclCore.resize(conf.readUint(CONFIG_CPU, CPU_CORE_ICL));
-  ftlCore.resize(conf.readUint(CONFIG_CPU, CPU_CORE_FTL) - NUM_ISC_CORES);
-  iscCore.resize(NUM_ISC_CORES);
+  ftlCore.resize(conf.readUint(CONFIG_CPU, CPU_CORE_FTL) -
+                 conf.readUint(CONFIG_CPU, CPU_CORE_ISC));
+  iscCore.resize(conf.readUint(CONFIG_CPU, CPU_CORE_ISC));
 
   assert(ftlCore.size() > 0 || !"Number of FTL Cores not expected to be zero");
   assert(iscCore.size() > 0 || !"Number of ISC Cores not expected to be zero");
@@ -317,10 +318,14 @@ CPU::CPU(ConfigReader &c) : conf(c), lastResetStat(0) {
   cpi.insert({ISC__SLET__GREP, std::unordered_map<uint16_t, InstStat>()});
   cpi.insert({ISC__SLET__STATS32, std::unordered_map<uint16_t, InstStat>()});
   cpi.insert({ISC__SLET__STATS64, std::unordered_map<uint16_t, InstStat>()});
+  cpi.insert({ISC__SLET__HASH, std::unordered_map<uint16_t, InstStat>()});
+  cpi.insert({ISC__SLET__SCAN, std::unordered_map<uint16_t, InstStat>()});
   
   //CPI for Scheduler module
   cpi.insert({CREDIT_SCHEDULER, std::unordered_map<uint16_t, InstStat>()});
   cpi.insert({FCFS_SCHEDULER, std::unordered_map<uint16_t, InstStat>()});
+  cpi.insert({DRR_SCHEDULER, std::unordered_map<uint16_t, InstStat>()});
+  cpi.insert({FLIN_SCHEDULER, std::unordered_map<uint16_t, InstStat>()});
   
   if (cpi.size() != NAMESPACE::TOTAL_NAMESPACES) {
     printf("[DEBUG] CPI size = %lu, TOTAL_NAMESPACES = %d\n",
@@ -354,6 +359,8 @@ CPU::CPU(ConfigReader &c) : conf(c), lastResetStat(0) {
   cpi.find(ISC__RUNTIME)->second.insert({ISC__START_SLET,InstStat(18,68,10,52,0,2,clockPeriod)});
   cpi.find(ISC__RUNTIME)->second.insert({ISC__SET_OPT,InstStat(11,36,6,27,0,1,clockPeriod)});
   cpi.find(ISC__RUNTIME)->second.insert({ISC__GET_OPT,InstStat(11,36,6,27,0,0,clockPeriod)});
+  cpi.find(ISC__RUNTIME)->second.insert({ISC__TASK1,InstStat(6,22,5,16,0,0,clockPeriod)});
+  cpi.find(ISC__RUNTIME)->second.insert({ISC__TASK2,InstStat(14,48,12,37,0,1,clockPeriod)});
   cpi.find(ISC__RUNTIME)->second.insert({ISC__ADD_SLET__EXT4,InstStat(8,28,9,25,0,0,clockPeriod)});
   cpi.find(ISC__FSA__EXT4)->second.insert({ISC__START_SLET,InstStat(1,0,0,1,0,0,clockPeriod)});
   cpi.find(ISC__RUNTIME)->second.insert({ISC__ADD_SLET__STATDIR,InstStat(15,44,26,49,0,0,clockPeriod)});
@@ -365,18 +372,38 @@ CPU::CPU(ConfigReader &c) : conf(c), lastResetStat(0) {
   cpi.find(ISC__SLET__MD5)->second.insert({ISC__TASK2,InstStat(4,92,18,620,0,0,clockPeriod)});
   cpi.find(ISC__SLET__MD5)->second.insert({ISC__TASK3,InstStat(18,56,17,75,0,2,clockPeriod)});
   cpi.find(ISC__SLET__MD5)->second.insert({ISC__TASK4,InstStat(3,32,9,22,0,0,clockPeriod)});
+  cpi.find(ISC__SLET__MD5)->second.insert({ISC__VTASK1,InstStat(4,156,18,684,0,0,clockPeriod)});
   cpi.find(ISC__RUNTIME)->second.insert({ISC__ADD_SLET__GREP,InstStat(12,44,28,44,0,0,clockPeriod)});
   cpi.find(ISC__SLET__GREP)->second.insert({ISC__START_SLET,InstStat(131,484,96,317,0,4,clockPeriod)});
   cpi.find(ISC__SLET__GREP)->second.insert({ISC__TASK1,InstStat(25,44,33,79,0,2,clockPeriod)});
   cpi.find(ISC__SLET__GREP)->second.insert({ISC__TASK2,InstStat(13,36,9,45,0,1,clockPeriod)});
+  cpi.find(ISC__SLET__GREP)->second.insert({ISC__TASK3,InstStat(2,3,0,4,0,0,clockPeriod)});
+  cpi.find(ISC__SLET__GREP)->second.insert({ISC__VTASK1,InstStat(1,1,0,4,0,0,clockPeriod)});
   cpi.find(ISC__RUNTIME)->second.insert({ISC__ADD_SLET__STATS32,InstStat(12,44,27,43,0,0,clockPeriod)});
   cpi.find(ISC__SLET__STATS32)->second.insert({ISC__START_SLET,InstStat(140,484,103,311,0,6,clockPeriod)});
   cpi.find(ISC__SLET__STATS32)->second.insert({ISC__TASK1,InstStat(3,16,3,8,0,1,clockPeriod)});
+  cpi.find(ISC__SLET__STATS32)->second.insert({ISC__VTASK1,InstStat(1,1,0,6,0,0,clockPeriod)});
   cpi.find(ISC__RUNTIME)->second.insert({ISC__ADD_SLET__STATS64,InstStat(12,44,27,43,0,0,clockPeriod)});
   cpi.find(ISC__SLET__STATS64)->second.insert({ISC__START_SLET,InstStat(140,488,104,337,0,5,clockPeriod)});
   cpi.find(ISC__SLET__STATS64)->second.insert({ISC__TASK1,InstStat(3,20,3,8,0,1,clockPeriod)});
+  cpi.find(ISC__SLET__STATS64)->second.insert({ISC__VTASK1,InstStat(1,1,0,7,0,0,clockPeriod)});
+  cpi.find(ISC__RUNTIME)->second.insert({ISC__ADD_SLET__HASH,InstStat(12,44,27,43,0,0,clockPeriod)});
+  cpi.find(ISC__SLET__HASH)->second.insert({ISC__START_SLET,InstStat(138,486,102,325,0,5,clockPeriod)});
+  cpi.find(ISC__SLET__HASH)->second.insert({ISC__TASK1,InstStat(1,8,0,34,0,0,clockPeriod)});
+  cpi.find(ISC__SLET__HASH)->second.insert({ISC__TASK2,InstStat(1,8,0,10,0,0,clockPeriod)});
+  cpi.find(ISC__SLET__HASH)->second.insert({ISC__TASK3,InstStat(1,20,0,104,0,0,clockPeriod)});
+  cpi.find(ISC__SLET__HASH)->second.insert({ISC__TASK4,InstStat(6,24,10,42,0,1,clockPeriod)});
+  cpi.find(ISC__RUNTIME)->second.insert({ISC__ADD_SLET__SCAN,InstStat(12,44,27,43,0,0,clockPeriod)});
+  cpi.find(ISC__SLET__SCAN)->second.insert({ISC__START_SLET,InstStat(164,540,118,362,0,6,clockPeriod)});
+  cpi.find(ISC__SLET__SCAN)->second.insert({ISC__TASK1,InstStat(1,1,0,3,0,0,clockPeriod)});
+  cpi.find(ISC__SLET__SCAN)->second.insert({ISC__TASK2,InstStat(3,6,2,14,2,1,clockPeriod)});
+  cpi.find(ISC__SLET__SCAN)->second.insert({ISC__VTASK1,InstStat(1,1,0,5,0,0,clockPeriod)});
+  cpi.find(ISC__SLET)->second.insert({ISC__DECODE_LZ4,InstStat(5,18,16,14,0,1,clockPeriod)});
+  cpi.find(ISC__SLET)->second.insert({ISC__DECODE_ZSTD,InstStat(14,46,20,62,0,3,clockPeriod)});
   cpi.find(CREDIT_SCHEDULER)->second.insert({SCHEDULE,InstStat(30,180,26,80,0,1,clockPeriod)});
   cpi.find(FCFS_SCHEDULER)->second.insert({SCHEDULE,InstStat(32,212,28,101,0,1,clockPeriod)});
+  cpi.find(DRR_SCHEDULER)->second.insert({SCHEDULE,InstStat(36,204,30,92,0,1,clockPeriod)});
+  cpi.find(FLIN_SCHEDULER)->second.insert({SCHEDULE,InstStat(58,342,44,131,0,2,clockPeriod)});
 
 // check values defines in functions.py match those defined in def.hh
 #define ERR_MSG "Unexpected NAMESPACE ID"
@@ -402,9 +429,13 @@ CPU::CPU(ConfigReader &c) : conf(c), lastResetStat(0) {
   static_assert(NAMESPACE::ISC__SLET__GREP == 19, ERR_MSG);
   static_assert(NAMESPACE::ISC__SLET__STATS32 == 20, ERR_MSG);
   static_assert(NAMESPACE::ISC__SLET__STATS64 == 21, ERR_MSG);
-  static_assert(NAMESPACE::CREDIT_SCHEDULER == 22, ERR_MSG);
-  static_assert(NAMESPACE::FCFS_SCHEDULER == 23, ERR_MSG);
-  static_assert(NAMESPACE::TOTAL_NAMESPACES == 24, ERR_MSG);
+  static_assert(NAMESPACE::ISC__SLET__HASH == 22, ERR_MSG);
+  static_assert(NAMESPACE::ISC__SLET__SCAN == 23, ERR_MSG);
+  static_assert(NAMESPACE::CREDIT_SCHEDULER == 24, ERR_MSG);
+  static_assert(NAMESPACE::FCFS_SCHEDULER == 25, ERR_MSG);
+  static_assert(NAMESPACE::DRR_SCHEDULER == 26, ERR_MSG);
+  static_assert(NAMESPACE::FLIN_SCHEDULER == 27, ERR_MSG);
+  static_assert(NAMESPACE::TOTAL_NAMESPACES == 28, ERR_MSG);
 #undef ERR_MSG
 #define ERR_MSG "Unexpected FUNCTION ID"
   static_assert(FUNCTION::READ == 0, ERR_MSG);
@@ -469,14 +500,19 @@ CPU::CPU(ConfigReader &c) : conf(c), lastResetStat(0) {
   static_assert(FUNCTION::ISC__TASK3 == 59, ERR_MSG);
   static_assert(FUNCTION::ISC__TASK4 == 60, ERR_MSG);
   static_assert(FUNCTION::ISC__TASK5 == 61, ERR_MSG);
-  static_assert(FUNCTION::ISC__ADD_SLET__EXT4 == 62, ERR_MSG);
-  static_assert(FUNCTION::ISC__ADD_SLET__STATDIR == 63, ERR_MSG);
-  static_assert(FUNCTION::ISC__ADD_SLET__MD5 == 64, ERR_MSG);
-  static_assert(FUNCTION::ISC__ADD_SLET__GREP == 65, ERR_MSG);
-  static_assert(FUNCTION::ISC__ADD_SLET__STATS32 == 66, ERR_MSG);
-  static_assert(FUNCTION::ISC__ADD_SLET__STATS64 == 67, ERR_MSG);
-  static_assert(FUNCTION::SCHEDULE == 68, ERR_MSG);
-  static_assert(FUNCTION::TOTAL_FUNCTIONS == 69, ERR_MSG);
+  static_assert(FUNCTION::ISC__VTASK1 == 62, ERR_MSG);
+  static_assert(FUNCTION::ISC__ADD_SLET__EXT4 == 63, ERR_MSG);
+  static_assert(FUNCTION::ISC__ADD_SLET__STATDIR == 64, ERR_MSG);
+  static_assert(FUNCTION::ISC__ADD_SLET__MD5 == 65, ERR_MSG);
+  static_assert(FUNCTION::ISC__ADD_SLET__GREP == 66, ERR_MSG);
+  static_assert(FUNCTION::ISC__ADD_SLET__STATS32 == 67, ERR_MSG);
+  static_assert(FUNCTION::ISC__ADD_SLET__STATS64 == 68, ERR_MSG);
+  static_assert(FUNCTION::ISC__ADD_SLET__HASH == 69, ERR_MSG);
+  static_assert(FUNCTION::ISC__ADD_SLET__SCAN == 70, ERR_MSG);
+  static_assert(FUNCTION::ISC__DECODE_LZ4 == 71, ERR_MSG);
+  static_assert(FUNCTION::ISC__DECODE_ZSTD == 72, ERR_MSG);
+  static_assert(FUNCTION::SCHEDULE == 73, ERR_MSG);
+  static_assert(FUNCTION::TOTAL_FUNCTIONS == 74, ERR_MSG);
 #undef ERR_MSG
   } // used for folding this section
   // clang-format on
@@ -965,6 +1001,10 @@ uint64_t CPU::applyLatency(NAMESPACE ns, FUNCTION fct) {
   return 0;
 }
 
+uint32_t CPU::getISCCoreCount() {
+  return (uint32_t)iscCore.size();
+}
+
 void CPU::getStatList(std::vector<Stats> &list, std::string prefix) {
   Stats temp;
   std::string number;
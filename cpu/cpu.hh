@@ -126,6 +126,7 @@ class CPU : public StatObject {
   void execute(NAMESPACE, FUNCTION, DMAFunction &, void * = nullptr,
                uint64_t = 0);
   uint64_t applyLatency(NAMESPACE, FUNCTION);
+  uint32_t getISCCoreCount();
 
   void getStatList(std::vector<Stats> &, std::string) override;
   void getStatValues(std::vector<double> &) override;
@@ -53,10 +53,14 @@ typedef enum : uint16_t {
   ISC__SLET__GREP,
   ISC__SLET__STATS32,
   ISC__SLET__STATS64,
+  ISC__SLET__HASH,
+  ISC__SLET__SCAN,
 
   //Scheduler namespace
   CREDIT_SCHEDULER,
   FCFS_SCHEDULER,
+  DRR_SCHEDULER,
+  FLIN_SCHEDULER,
 
   TOTAL_NAMESPACES
 } NAMESPACE;
@@ -152,12 +156,17 @@ typedef enum : uint16_t {
   ISC__TASK3,
   ISC__TASK4,
   ISC__TASK5,
+  ISC__VTASK1,  // vectorized tasks, one 128-bit vector step per call
   ISC__ADD_SLET__EXT4,
   ISC__ADD_SLET__STATDIR,
   ISC__ADD_SLET__MD5,
   ISC__ADD_SLET__GREP,
   ISC__ADD_SLET__STATS32,
   ISC__ADD_SLET__STATS64,
+  ISC__ADD_SLET__HASH,
+  ISC__ADD_SLET__SCAN,
+  ISC__DECODE_LZ4,
+  ISC__DECODE_ZSTD,
   SCHEDULE,
 
   TOTAL_FUNCTIONS,
@@ -173,8 +173,12 @@ ISC__SLET__MD5      = 18
 ISC__SLET__GREP     = 19
 ISC__SLET__STATS32  = 20
 ISC__SLET__STATS64  = 21
-CREDIT_SCHEDULER = 22
-FCFS_SCHEDULER = 23
+ISC__SLET__HASH     = 22
+ISC__SLET__SCAN     = 23
+CREDIT_SCHEDULER = 24
+FCFS_SCHEDULER = 25
+DRR_SCHEDULER = 26
+FLIN_SCHEDULER = 27
 
 # FCT
 FCT_IDX = 41
@@ -199,12 +203,17 @@ FCT_IDX, ISC__TASK2                 = FCT_IDX + 1, FCT_IDX
 FCT_IDX, ISC__TASK3                 = FCT_IDX + 1, FCT_IDX
 FCT_IDX, ISC__TASK4                 = FCT_IDX + 1, FCT_IDX
 FCT_IDX, ISC__TASK5                 = FCT_IDX + 1, FCT_IDX
+FCT_IDX, ISC__VTASK1                = FCT_IDX + 1, FCT_IDX
 FCT_IDX, ISC__ADD_SLET__EXT4        = FCT_IDX + 1, FCT_IDX
 FCT_IDX, ISC__ADD_SLET__STATDIR     = FCT_IDX + 1, FCT_IDX
 FCT_IDX, ISC__ADD_SLET__MD5         = FCT_IDX + 1, FCT_IDX
 FCT_IDX, ISC__ADD_SLET__GREP        = FCT_IDX + 1, FCT_IDX
 FCT_IDX, ISC__ADD_SLET__STATS32     = FCT_IDX + 1, FCT_IDX
 FCT_IDX, ISC__ADD_SLET__STATS64     = FCT_IDX + 1, FCT_IDX
+FCT_IDX, ISC__ADD_SLET__HASH        = FCT_IDX + 1, FCT_IDX
+FCT_IDX, ISC__ADD_SLET__SCAN        = FCT_IDX + 1, FCT_IDX
+FCT_IDX, ISC__DECODE_LZ4            = FCT_IDX + 1, FCT_IDX
+FCT_IDX, ISC__DECODE_ZSTD           = FCT_IDX + 1, FCT_IDX
 FCT_IDX, SCHEDULE                   = FCT_IDX + 1, FCT_IDX
 
 
@@ -231,6 +240,7 @@ function = [
     ["isc/runtime.cc", "Runtime::startSlet",             ISC__RUNTIME, ISC__START_SLET],
     ["isc/runtime.cc", "Runtime::setOpt",                ISC__RUNTIME, ISC__SET_OPT],
     ["isc/runtime.cc", "Runtime::getOpt",                ISC__RUNTIME, ISC__GET_OPT],
+    ["isc/runtime.cc", "Runtime::runTasks",              ISC__RUNTIME, ISC__TASK1],
     ["isc/fs/ext4/ext4.cc", "Runtime::addSlet<SimpleSSD::ISC::Ext4>",       ISC__RUNTIME, ISC__ADD_SLET__EXT4],
     ["isc/fs/ext4/ext4.cc", "builtin_startup",                              ISC__FSA__EXT4, ISC__START_SLET],
     ["isc/slet/statdir.cc", "Runtime::addSlet<SimpleSSD::ISC::StatdirAPP>", ISC__RUNTIME, ISC__ADD_SLET__STATDIR],
@@ -245,13 +255,27 @@ function = [
     ["isc/slet/grep.cc", "Runtime::addSlet<SimpleSSD::ISC::GrepAPP>",       ISC__RUNTIME, ISC__ADD_SLET__GREP],
     ["isc/slet/grep.cc", "builtin_startup",                                 ISC__SLET__GREP, ISC__START_SLET],
     ["isc/slet/grep.cc", "GrepAPP::grep",                                   ISC__SLET__GREP, ISC__TASK1],
-    ["isc/slet/grep.cc", "GrepAPP::strstr",                                 ISC__SLET__GREP, ISC__TASK2],
+    ["isc/slet/grep.cc", "GrepAPP::Matcher::findBM",                        ISC__SLET__GREP, ISC__TASK2],
+    ["isc/slet/grep.cc", "GrepAPP::Matcher::findAC",                        ISC__SLET__GREP, ISC__TASK3],
     ["isc/slet/stats32.cc", "Runtime::addSlet<SimpleSSD::ISC::Stats32APP>", ISC__RUNTIME, ISC__ADD_SLET__STATS32],
     ["isc/slet/stats32.cc", "builtin_startup",                              ISC__SLET__STATS32, ISC__START_SLET],
     ["isc/slet/stats32.cc", "Stats32APP::sum",                              ISC__SLET__STATS32, ISC__TASK1],
     ["isc/slet/stats64.cc", "Runtime::addSlet<SimpleSSD::ISC::Stats64APP>", ISC__RUNTIME, ISC__ADD_SLET__STATS64],
     ["isc/slet/stats64.cc", "builtin_startup",                              ISC__SLET__STATS64, ISC__START_SLET],
     ["isc/slet/stats64.cc", "Stats64APP::sum",                              ISC__SLET__STATS64, ISC__TASK1],
+    ["isc/slet/hash.cc", "Runtime::addSlet<SimpleSSD::ISC::HashAPP>",       ISC__RUNTIME, ISC__ADD_SLET__HASH],
+    ["isc/slet/hash.cc", "builtin_startup",                                 ISC__SLET__HASH, ISC__START_SLET],
+    ["isc/slet/hash.cc", "XXH64::update",                                   ISC__SLET__HASH, ISC__TASK1],
+    ["isc/slet/hash.cc", "CRC32C::update",                                  ISC__SLET__HASH, ISC__TASK2],
+    ["isc/slet/hash.cc", "SHA256::update",                                  ISC__SLET__HASH, ISC__TASK3],
+    ["isc/slet/scan.cc", "Runtime::addSlet<SimpleSSD::ISC::ScanAPP>",       ISC__RUNTIME, ISC__ADD_SLET__SCAN],
+    ["isc/slet/scan.cc", "builtin_startup",                                 ISC__SLET__SCAN, ISC__START_SLET],
+    ["isc/slet/scan.cc", "accumulate",                                      ISC__SLET__SCAN, ISC__TASK1],
+    ["isc/slet/scan.cc", "aggregateRow",                                    ISC__SLET__SCAN, ISC__TASK2],
+    ["isc/utils/codec.cc", "LZ4Decoder::decode",                            ISC__SLET, ISC__DECODE_LZ4],
+    ["isc/utils/codec.cc", "ZstdDecoder::decode",                           ISC__SLET, ISC__DECODE_ZSTD],
     ["hil/scheduler/credit_scheduler.cc", "CreditScheduler::schedule",      CREDIT_SCHEDULER, SCHEDULE],
     ["hil/scheduler/fcfs_scheduler.cc", "FCFSScheduler::schedule",          FCFS_SCHEDULER, SCHEDULE],
+    ["hil/scheduler/drr_scheduler.cc", "DRRScheduler::run",                 DRR_SCHEDULER, SCHEDULE],
+    ["hil/scheduler/flin_scheduler.cc", "FLINScheduler::run",               FLIN_SCHEDULER, SCHEDULE],
 ]
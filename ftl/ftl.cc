@@ -39,6 +39,7 @@ FTL::FTL(ConfigReader &c, DRAM::AbstractDRAM *d) : conf(c), pDRAM(d) {
   param.pageSize = palparam->superPageSize;
   param.ioUnitInPage = palparam->pageInSuperPage;
   param.pageCountToMaxPerf = palparam->superBlock / palparam->block;
+  gcThreshold = conf.readFloat(CONFIG_FTL, FTL_GC_THRESHOLD_RATIO);
 
   switch (conf.readInt(CONFIG_FTL, FTL_MAPPING_MODE)) {
     case PAGE_MAPPING:
@@ -104,6 +105,16 @@ uint64_t FTL::getUsedPageCount(uint64_t lpnBegin, uint64_t lpnEnd) {
   return pFTL->getStatus(lpnBegin, lpnEnd)->mappedLogicalPages;
 }
 
+void FTL::getFlashState(FlashState &state) {
+  // an empty range only refreshes the free block count
+  Status *status = pFTL->getStatus(0, 0);
+
+  state.freeBlockRatio =
+      (float)status->freePhysicalBlocks / param.totalPhysicalBlocks;
+  state.gcThreshold = gcThreshold;
+  pPAL->getBusyState(state.dieBusyUntil);
+}
+
 void FTL::getStatList(std::vector<Stats> &list, std::string prefix) {
   pFTL->getStatList(list, prefix + "ftl.");
   pPAL->getStatList(list, prefix);
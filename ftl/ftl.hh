@@ -39,6 +39,12 @@ typedef struct {
   uint32_t pageCountToMaxPerf;  //!< # pages to fully utilize internal parallism
 } Parameter;
 
+typedef struct {
+  std::vector<uint64_t> dieBusyUntil;  //!< Per die (PAL timeline)
+  float freeBlockRatio;                //!< Free physical blocks / total
+  float gcThreshold;  //!< GC is triggered below this free block ratio
+} FlashState;
+
 class FTL : public StatObject {
  private:
   Parameter param;
@@ -48,6 +54,8 @@ class FTL : public StatObject {
   AbstractFTL *pFTL;
   DRAM::AbstractDRAM *pDRAM;
 
+  float gcThreshold;
+
  public:
   FTL(ConfigReader &, DRAM::AbstractDRAM *);
   ~FTL();
@@ -60,6 +68,7 @@ class FTL : public StatObject {
 
   Parameter *getInfo();
   uint64_t getUsedPageCount(uint64_t, uint64_t);
+  void getFlashState(FlashState &);
 
   void getStatList(std::vector<Stats> &, std::string) override;
   void getStatValues(std::vector<double> &) override;
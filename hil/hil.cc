@@ -21,10 +21,13 @@
 #include "hil/nvme/namespace.hh"
 #include "hil/scheduler/fcfs_scheduler.hh"
 #include "hil/scheduler/credit_scheduler.hh"
+#include "hil/scheduler/drr_scheduler.hh"
+#include "hil/scheduler/flin_scheduler.hh"
 
 #include "util/algorithm.hh"
 #include "util/def.hh"
 
+#include "isc/sims/dram.hh"
 #include "isc/sims/ftl.hh"
 
 #include "isc/fs/ext4/ext4.hh"
@@ -32,7 +35,9 @@
 
 #include "isc/sims/configs.hh"
 #include "isc/slet/grep.hh"
+#include "isc/slet/hash.hh"
 #include "isc/slet/md5.hh"
+#include "isc/slet/scan.hh"
 #include "isc/slet/statdir.hh"
 #include "isc/slet/stats32.hh"
 #include "isc/slet/stats64.hh"
@@ -48,6 +53,9 @@ namespace HIL {
 
 #define PR_SECTION LOG_HIL
 
+// a postponed scheduler switch is retried every 1ms (1e12 ticks/sec)
+static const uint64_t SwitchRetryTicks = 1000000000ULL;
+
 HIL::HIL(ConfigReader &c) : conf(c), reqCount(0), lastScheduled(0) {
   pICL = new ICL::ICL(conf);
   
@@ -75,60 +83,139 @@ HIL::HIL(ConfigReader &c) : conf(c), reqCount(0), lastScheduled(0) {
       currentSchedulerType = SchedulerType::CREDIT;
       debugprint(LOG_HIL, "Use Dynamic CreditScheduler (cfg) - Period: 1ms");
       break;
+    case 2: //DRR
+      pScheduler = new DRRScheduler(pICL, 1000000000000ULL);  // 1e12 ticks/sec
+      currentSchedulerType = SchedulerType::DRR;
+      debugprint(LOG_HIL, "Use DRRScheduler (cfg)");
+      break;
+    case 3: //FLIN
+      // 1ms epoch, >32 requests per epoch is high intensity, boost the most
+      // slowed-down user below 0.6 fairness, writes wait up to 500us on GC
+      pScheduler = new FLINScheduler(pICL, 1000000000000ULL, 1000000000ULL, 32,
+                                     0.6, 500000000ULL);
+      currentSchedulerType = SchedulerType::FLIN;
+      debugprint(LOG_HIL, "Use FLINScheduler (cfg)");
+      break;
   }
   
   gScheduler = pScheduler; 
+  pScheduler->setCompletion(
+      [this](Request *pReq, uint64_t tick) { finishIO(pReq, tick); });
   ISC::SIM::FTL::setCache(pICL);
 
   memset(&stat, 0, sizeof(stat));
 
   completionEvent = allocate([this](uint64_t) { completion(); });
-}
+  nextSchedulerType = currentSchedulerType;
+  switchEvent =
+      allocate([this](uint64_t) { switchScheduler(nextSchedulerType); });
 
-HIL::~HIL() {
-  delete pICL;
-  delete pScheduler;
-}
-
-void HIL::read(Request &req) {
-  DMAFunction doRead = [this](uint64_t beginAt, void *context) {
+  // read/write 只把請求交給排程器，完成時由 finishIO() 接手
+  readFunction = [this](uint64_t beginAt, void *context) {
     auto pReq = (Request *)context;
-    uint64_t tick = beginAt;
 
     pReq->reqID = ++reqCount;
-    pReq->op    = OpType::READ; 
+    pReq->op = OpType::READ;
+    pReq->beginAt = beginAt;
 
     debugprint(LOG_HIL,
                "READ  | REQ %7u | LCA %" PRIu64 " + %" PRIu64 " | BYTE %" PRIu64
                " + %" PRIu64,
                pReq->reqID, pReq->range.slpn, pReq->range.nlp, pReq->offset,
                pReq->length);
-      
-    // ★ 讓排程器「同步」處理到這筆 req 完成，tick 會在內部被 ICL 更新為完成時間
-    pScheduler->processUntil(*pReq, tick);
-    stat.request[0]++;
-    stat.iosize[0] += pReq->length;
-    updateBusyTime(0, beginAt, tick);
-    updateBusyTime(2, beginAt, tick);
 
-    pReq->finishedAt = tick;
-    completionQueue.push(*pReq);
+    pScheduler->submit(pReq);
+  };
 
-    updateCompletion();
+  writeFunction = [this](uint64_t beginAt, void *context) {
+    auto pReq = (Request *)context;
+
+    pReq->reqID = ++reqCount;
+    pReq->op = OpType::WRITE;
+    pReq->beginAt = beginAt;
+
+    debugprint(LOG_HIL,
+               "WRITE | REQ %7u | LCA %" PRIu64 " + %" PRIu64 " | BYTE %" PRIu64
+               " + %" PRIu64,
+               pReq->reqID, pReq->range.slpn, pReq->range.nlp, pReq->offset,
+               pReq->length);
 
-    delete pReq;
+    pScheduler->submit(pReq);
   };
+}
 
-  execute(CPU::HIL, CPU::READ, doRead, new Request(req));
+HIL::~HIL() {
+  if (scheduled(switchEvent, nullptr))
+    deschedule(switchEvent);
+  deallocate(switchEvent);
+  delete pICL;
+  delete pScheduler;
+}
+
+Request *HIL::allocRequest(Request &req) {
+  Request *pReq;
+
+  if (freeRequests.empty()) {
+    // deque 擴充時既有元素位址不變
+    requestPool.push_back(std::move(req));
+    pReq = &requestPool.back();
+  }
+  else {
+    pReq = freeRequests.back();
+    freeRequests.pop_back();
+    *pReq = std::move(req);
+  }
+
+  return pReq;
+}
+
+void HIL::releaseRequest(Request *pReq) {
+  // 釋放 callback 捕獲的資源
+  pReq->function.reset();
+  freeRequests.push_back(pReq);
+}
+
+void HIL::finishIO(Request *pReq, uint64_t tick) {
+  int idx = pReq->op == OpType::WRITE ? 1 : 0;
+
+  stat.request[idx]++;
+  stat.iosize[idx] += pReq->length;
+  updateBusyTime(idx, pReq->beginAt, tick);
+  updateBusyTime(2, pReq->beginAt, tick);
+
+  pReq->finishedAt = tick;
+  completionQueue.push(pReq);
+
+  updateCompletion();
+}
+
+void HIL::read(Request &req) {
+  execute(CPU::HIL, CPU::READ, readFunction, allocRequest(req));
 }
 
 
 void HIL::switchScheduler(SchedulerType type) {
+  // the latest request wins over a postponed one
+  if (scheduled(switchEvent, nullptr))
+    deschedule(switchEvent);
+
   if (type == currentSchedulerType) {
     return;
   }
-  //FIXME: we have to handle if old scheduler still have request
 
+  // work only the old scheduler can finish (ISC waiting for credit,
+  // processUntil callers) would be lost with it, retry once it is dispatched
+  if (pScheduler->holdsWork()) {
+    nextSchedulerType = type;
+    schedule(switchEvent, getTick() + SwitchRetryTicks);
+    pr("Scheduler switch postponed, the current one still holds work");
+    return;
+  }
+
+  // requests not dispatched yet move to the new scheduler
+  RequestList pending;
+
+  pScheduler->drain(pending);
   delete pScheduler;
 
   // FIXME: when we build this project we have an attr to decide which scheduler to use
@@ -141,18 +228,42 @@ void HIL::switchScheduler(SchedulerType type) {
       pScheduler = new CreditScheduler(pICL,
                                  1ULL * 1000000000ULL,  // 1ms period (同上)
                                  1000000000000ULL);
-      gScheduler = pScheduler;
       pr("Switched to Dynamic Credit scheduler (Period: 1ms)");
       break;
-    // case SchedulerType::FLIN:
-    //   pScheduler = new FLINScheduler(1000000, 1000000, 100000, 500000);
-    //   pr("Switched to FLIN scheduler");
-    //   break;
+    case SchedulerType::DRR:
+      pScheduler = new DRRScheduler(pICL, 1000000000000ULL);
+      for (auto &w : userWeights)
+        static_cast<DRRScheduler *>(pScheduler)->setUserWeight(w.first,
+                                                               w.second);
+      pr("Switched to DRR scheduler");
+      break;
+    case SchedulerType::FLIN:
+      pScheduler = new FLINScheduler(pICL, 1000000000000ULL, 1000000000ULL, 32,
+                                     0.6, 500000000ULL);
+      pr("Switched to FLIN scheduler");
+      break;
     default:
       panic("Unknown scheduler type");
   }
 
   currentSchedulerType = type;
+  gScheduler = pScheduler;
+  pScheduler->setCompletion(
+      [this](Request *pReq, uint64_t tick) { finishIO(pReq, tick); });
+
+  while (Request *pReq = pending.pop()) {
+    pScheduler->submit(pReq);
+  }
+}
+
+void HIL::setUserWeight(uint32_t uid, uint64_t weight) {
+  weight = weight ? weight : 1;
+  userWeights[uid] = weight;
+
+  if (currentSchedulerType == SchedulerType::DRR)
+    static_cast<DRRScheduler *>(pScheduler)->setUserWeight(uid, weight);
+
+  pr("Set DRR weight of uid %u to %" PRIu64, uid, weight);
 }
 
 void HIL::isc_set(Request &req) {
@@ -169,12 +280,16 @@ void HIL::isc_set(Request &req) {
 
     if (ISC_SUBCMD_IS(slba, ISC_SUBCMD_INIT)) {
       pr("Runtime Initialization -----------------------------------------");
+      // drop slets of the last init, so caches of the old FSA go with them
+      ISC::Runtime::destory();
       if (ISC_STS_FAIL == ISC::Runtime::addSlet<ISC::Ext4>(tick, ctx) ||
           ISC_STS_FAIL == ISC::Runtime::addSlet<ISC::StatdirAPP>(tick, ctx) ||
           ISC_STS_FAIL == ISC::Runtime::addSlet<ISC::MD5APP>(tick, ctx) ||
           ISC_STS_FAIL == ISC::Runtime::addSlet<ISC::GrepAPP>(tick, ctx) ||
           ISC_STS_FAIL == ISC::Runtime::addSlet<ISC::Stats32APP>(tick, ctx) ||
-          ISC_STS_FAIL == ISC::Runtime::addSlet<ISC::Stats64APP>(tick, ctx))
+          ISC_STS_FAIL == ISC::Runtime::addSlet<ISC::Stats64APP>(tick, ctx) ||
+          ISC_STS_FAIL == ISC::Runtime::addSlet<ISC::HashAPP>(tick, ctx) ||
+          ISC_STS_FAIL == ISC::Runtime::addSlet<ISC::ScanAPP>(tick, ctx))
         panic("Failed to setup predefined slets");
 
       tick += applyLatency(CPU::ISC__RUNTIME, CPU::ISC__ADD_SLET__EXT4);
@@ -183,6 +298,8 @@ void HIL::isc_set(Request &req) {
       tick += applyLatency(CPU::ISC__RUNTIME, CPU::ISC__ADD_SLET__GREP);
       tick += applyLatency(CPU::ISC__RUNTIME, CPU::ISC__ADD_SLET__STATS32);
       tick += applyLatency(CPU::ISC__RUNTIME, CPU::ISC__ADD_SLET__STATS64);
+      tick += applyLatency(CPU::ISC__RUNTIME, CPU::ISC__ADD_SLET__HASH);
+      tick += applyLatency(CPU::ISC__RUNTIME, CPU::ISC__ADD_SLET__SCAN);
       pr("Initialization done    -----------------------------------------");
     }
     else if (ISC_SUBCMD_IS(slba, ISC_SUBCMD_FREE)) {
@@ -201,24 +318,32 @@ void HIL::isc_set(Request &req) {
         case ISC_SUBCMD_SCHEDULER_FLIN:
           switchScheduler(SchedulerType::FLIN);
           break;
+        case ISC_SUBCMD_SCHEDULER_DRR:
+          switchScheduler(SchedulerType::DRR);
+          break;
         default:
           panic("Unknown scheduler type: 0x%x", schedulerType);
       }
     }
+    else if (ISC_SUBCMD_IS(slba, ISC_SUBCMD_SCHEDULER_WEIGHT)) {
+      auto opt = ISC_SUBCMD_OPT(slba);
+      setUserWeight(ISC_WEIGHT_UID(opt), ISC_WEIGHT_VAL(opt));
+    }
     else if (ISC_SUBCMD_IS(slba, ISC_SUBCMD_SLET_OPT)) {
       auto id = ISC_SUBCMD_OPT(slba);
       auto data = ((NVMe::IOContext *)hReq->context)->buffer;
       Utils::pipe2xxd("setOpt", data, hReq->length, NULL);
 
-      // fixme: handle calloc fails
-      char *key = (char *)calloc(1, ISC_KEY_LEN + 1);
+      // the key is interned by the runtime, only the value is kept
+      char key[ISC_KEY_LEN + 1] = {0};
       memcpy(key, data, ISC_KEY_LEN);
 
+      // fixme: handle calloc fails
       byte *val = (byte *)calloc(1, ISC_VAL_LEN(hReq->length) + 1);
       memcpy(val, data + ISC_KEY_LEN, ISC_VAL_LEN(hReq->length));
 
-      ISC::Runtime::setOpt(id, key, val, tick, ctx);
-      free(key);
+      ISC::Runtime::setOpt(id, key, val, ISC_VAL_LEN(hReq->length), tick,
+                           ctx);
     }
     else {
       panic("Unexpected ISC-SET CMD: 0x%x", ISC_SUBCMD(slba));
@@ -232,12 +357,10 @@ void HIL::isc_set(Request &req) {
     updateBusyTime(2, beginAt, tick);
 
     hReq->finishedAt = tick;
-    completionQueue.push(*hReq);
+    completionQueue.push(hReq);
     updateCompletion();
-
-    delete hReq;
   };
-  execute(CPU::HIL, CPU::ISC__SET, doSet, new Request(req));
+  execute(CPU::HIL, CPU::ISC__SET, doSet, allocRequest(req));
 }
 
 void HIL::isc_get(Request &hReq) {
@@ -256,67 +379,66 @@ void HIL::isc_get(Request &hReq) {
     if (ISC_SUBCMD_IS(slba, ISC_SUBCMD_SLET_RUN)) {
       pr("Runtime startSlet      -----------------------------------------");
       auto id = ISC_SUBCMD_OPT(slba);
-      auto res = ISC::Runtime::startSlet(id, tick, ctx);
+
+      // a slet run by events completes this request when it ends, the HIL
+      // goes on with other requests meanwhile
+      auto done = [this, hReq, beginAt, id](ISC::ISC_STS res,
+                                            uint64_t endAt) {
+        if (ISC_STS_FAIL == res) {
+          pr("failed to run slet: %d", id);
+        }
+        completeISCGet(hReq, beginAt, endAt);
+      };
+      auto res = ISC::Runtime::startSletAsync(id, done, tick, ctx);
+      if (ISC_STS_OK == res) {
+        pr("startSlet by events    -----------------------------------------");
+        return;
+      }
+      if (ISC_STS_EFUNC == res) {
+        res = ISC::Runtime::startSlet(id, tick, ctx);
+      }
       if (ISC_STS_FAIL == res) {
         pr("failed to start slet: %d", id);
       }
 
       pr("startSlet done         -----------------------------------------");
     }
-    else if (ISC_SUBCMD_IS(slba, ISC_SUBCMD_SLET_RES) ||
-             ISC_SUBCMD_IS(slba, ISC_SUBCMD_SLET_RESSZ))
+    else if (ISC_SUBCMD_IS(slba, ISC_SUBCMD_SLET_RES)) {
+      pr("Runtime getRes         -----------------------------------------");
+      // a ring slet produces more of the result as the host releases bytes,
+      // its reads are charged to this request and delay its completion
+      auto pContext = (NVMe::IOContext *)hReq->context;
+      pContext->resLen =
+          ISC::Runtime::getResult(ISC_SUBCMD_OPT(slba), pContext->offset,
+                                  pContext->buffer, hReq->length, tick, ctx);
+
+      pr("getRes done            -----------------------------------------");
+    }
+    else if (ISC_SUBCMD_IS(slba, ISC_SUBCMD_SLET_RESSZ))
       ;  // nothing to do here, just add latency
     else {
       panic("Unexpected ISC-GET SUBCMD: 0x%x", ISC_SUBCMD(slba));
     }
 
-    stat.request[0]++;
-    stat.iosize[0] += hReq->length;
-    updateBusyTime(0, beginAt, tick);
-    updateBusyTime(2, beginAt, tick);
-
-    hReq->finishedAt = tick;
-    completionQueue.push(*hReq);
-
-    updateCompletion(); 
-
-    delete hReq;
+    completeISCGet(hReq, beginAt, tick);
   };
-  execute(CPU::HIL, CPU::ISC__GET, doISC, new Request(hReq));
+  execute(CPU::HIL, CPU::ISC__GET, doISC, allocRequest(hReq));
 }
 
-void HIL::write(Request &req) {
-  DMAFunction doWrite = [this](uint64_t beginAt, void *context) {
-    auto pReq = (Request *)context;
-    uint64_t tick = beginAt;
-
-    pReq->reqID = ++reqCount;
-    pReq->op = OpType::WRITE;
-
-    debugprint(LOG_HIL,
-               "WRITE | REQ %7u | LCA %" PRIu64 " + %" PRIu64 " | BYTE %" PRIu64
-               " + %" PRIu64,
-               pReq->reqID, pReq->range.slpn, pReq->range.nlp, pReq->offset,
-               pReq->length);
-
-    // ★ 同步等到完成
-    pScheduler->processUntil(*pReq, tick);
-
-
-    stat.request[1]++;
-    stat.iosize[1] += pReq->length;
-    updateBusyTime(1, beginAt, tick);
-    updateBusyTime(2, beginAt, tick);
-
-    pReq->finishedAt = tick;
-    completionQueue.push(*pReq);
+void HIL::completeISCGet(Request *hReq, uint64_t beginAt, uint64_t tick) {
+  stat.request[0]++;
+  stat.iosize[0] += hReq->length;
+  updateBusyTime(0, beginAt, tick);
+  updateBusyTime(2, beginAt, tick);
 
-    updateCompletion();
+  hReq->finishedAt = tick;
+  completionQueue.push(hReq);
 
-    delete pReq;
-  };
+  updateCompletion();
+}
 
-  execute(CPU::HIL, CPU::WRITE, doWrite, new Request(req));
+void HIL::write(Request &req) {
+  execute(CPU::HIL, CPU::WRITE, writeFunction, allocRequest(req));
 }
 
 void HIL::flush(Request &req) {
@@ -331,14 +453,12 @@ void HIL::flush(Request &req) {
     pICL->flush(pReq->range, tick);
 
     pReq->finishedAt = tick;
-    completionQueue.push(*pReq);
+    completionQueue.push(pReq);
 
     updateCompletion();
-
-    delete pReq;
   };
 
-  execute(CPU::HIL, CPU::FLUSH, doFlush, new Request(req));
+  execute(CPU::HIL, CPU::FLUSH, doFlush, allocRequest(req));
 }
 
 void HIL::trim(Request &req) {
@@ -353,14 +473,12 @@ void HIL::trim(Request &req) {
     pICL->trim(pReq->range, tick);
 
     pReq->finishedAt = tick;
-    completionQueue.push(*pReq);
+    completionQueue.push(pReq);
 
     updateCompletion();
-
-    delete pReq;
   };
 
-  execute(CPU::HIL, CPU::FLUSH, doFlush, new Request(req));
+  execute(CPU::HIL, CPU::FLUSH, doFlush, allocRequest(req));
 }
 
 void HIL::format(Request &req, bool erase) {
@@ -378,14 +496,12 @@ void HIL::format(Request &req, bool erase) {
     }
 
     pReq->finishedAt = tick;
-    completionQueue.push(*pReq);
+    completionQueue.push(pReq);
 
     updateCompletion();
-
-    delete pReq;
   };
 
-  execute(CPU::HIL, CPU::FLUSH, doFlush, new Request(req));
+  execute(CPU::HIL, CPU::FLUSH, doFlush, allocRequest(req));
 }
 
 void HIL::getLPNInfo(uint64_t &totalLogicalPages, uint32_t &logicalPageSize) {
@@ -413,8 +529,8 @@ void HIL::updateBusyTime(int idx, uint64_t begin, uint64_t end) {
 
 void HIL::updateCompletion() {
   if (completionQueue.size() > 0) {
-    if (lastScheduled != completionQueue.top().finishedAt) {
-      lastScheduled = completionQueue.top().finishedAt;
+    if (lastScheduled != completionQueue.top()->finishedAt) {
+      lastScheduled = completionQueue.top()->finishedAt;
       schedule(completionEvent, lastScheduled);
     }
   }
@@ -423,13 +539,18 @@ void HIL::updateCompletion() {
 void HIL::completion() {
   uint64_t tick = getTick();
 
-  while (completionQueue.size() > 0) {
-    auto &req = completionQueue.top();
+  // the event has fired: a completion at this same tick must re-arm it
+  lastScheduled = UINT64_MAX;
 
-    if (req.finishedAt <= tick) {
-      req.function(tick, req.context);
+  while (completionQueue.size() > 0) {
+    auto pReq = completionQueue.top();
 
+    if (pReq->finishedAt <= tick) {
+      // the callback may issue new requests into the queue
       completionQueue.pop();
+      pReq->function(tick, pReq->context);
+
+      releaseRequest(pReq);
     }
     else {
       break;
@@ -478,6 +599,14 @@ void HIL::getStatList(std::vector<Stats> &list, std::string prefix) {
   temp.desc = "Total device busy time";
   list.push_back(temp);
 
+  temp.name = prefix + "request.pool";
+  temp.desc = "Request objects allocated by the pool";
+  list.push_back(temp);
+
+  temp.name = prefix + "request.size";
+  temp.desc = "Size of one request object in byte";
+  list.push_back(temp);
+
   if (pScheduler) {
       debugprint(LOG_HIL,
              "Scheduler | adding stats to list");
@@ -486,6 +615,9 @@ void HIL::getStatList(std::vector<Stats> &list, std::string prefix) {
   } 
 
   pICL->getStatList(list, prefix);
+
+  // the DRAM cache of slets, kept by the ISC runtime
+  ISC::SIM::DRAM::getStatList(list, prefix + "isc.dram.");
 }
 
 void HIL::getStatValues(std::vector<double> &values) {
@@ -498,11 +630,14 @@ void HIL::getStatValues(std::vector<double> &values) {
   values.push_back(stat.request[0] + stat.request[1]);
   values.push_back(stat.iosize[0] + stat.iosize[1]);
   values.push_back(stat.busy[2]);
-  
+  values.push_back(requestPool.size());
+  values.push_back(sizeof(Request));
+
   if (pScheduler)
     pScheduler->getStatValues(values);
 
   pICL->getStatValues(values);
+  ISC::SIM::DRAM::getStatValues(values);
 }
 
 void HIL::resetStatValues() {
@@ -512,6 +647,7 @@ void HIL::resetStatValues() {
     pScheduler->resetStatValues();
   
   pICL->resetStatValues();
+  ISC::SIM::DRAM::resetStatValues();
 }
 
 bool HIL::canServe(uint32_t uid) const {
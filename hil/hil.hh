@@ -21,7 +21,9 @@
 #define __HIL_HIL__
 
 #include <cinttypes>
+#include <deque>
 #include <queue>
+#include <unordered_map>
 #include <vector>
 
 #include "icl/icl.hh"
@@ -33,7 +35,6 @@
 #include "hil/scheduler/fcfs_scheduler.hh"
 #include "hil/scheduler/credit_scheduler.hh"
 
-//#include "hil/scheduler/flin_scheduler.hh"
 extern SimpleSSD::HIL::Scheduler *gScheduler;
 namespace SimpleSSD {
 
@@ -43,21 +44,44 @@ namespace HIL {
 enum class SchedulerType {
   FCFS,
   CREDIT,
-  FLIN
+  FLIN,
+  DRR
 };
 
 class HIL : public StatObject {
  private:
+  // completionQueue 依完成時間排序（最早的在 top）
+  struct LaterFinish {
+    bool operator()(const Request *a, const Request *b) const {
+      return a->finishedAt > b->finishedAt;
+    }
+  };
+
   ConfigReader &conf;
   ICL::ICL *pICL;
   Scheduler *pScheduler;  // 改用基礎類別指標
   SchedulerType currentSchedulerType;
+
+  // 切換排程器時舊排程器還有交不出去的工作：記下目標，之後再試
+  SchedulerType nextSchedulerType;
+  Event switchEvent;
   
   uint64_t reqCount;
 
   uint64_t lastScheduled;
   Event completionEvent;
-  std::priority_queue<Request, std::vector<Request>, Request> completionQueue;
+  std::priority_queue<Request *, std::vector<Request *>, LaterFinish>
+      completionQueue;
+
+  // 請求物件池：HIL 從收到請求到 completion() 回呼之間擁有它
+  std::deque<Request> requestPool;
+  std::vector<Request *> freeRequests;
+
+  // DRR 的使用者權重：切換排程器時重新套用
+  std::unordered_map<uint32_t, uint64_t> userWeights;
+
+  DMAFunction readFunction;
+  DMAFunction writeFunction;
 
   struct {
     uint64_t request[2];
@@ -66,15 +90,22 @@ class HIL : public StatObject {
     uint64_t lastBusyAt[3];
   } stat;
 
+  Request *allocRequest(Request &);
+  void releaseRequest(Request *);
+  void finishIO(Request *, uint64_t);
+  void completeISCGet(Request *, uint64_t, uint64_t);
+
   void updateBusyTime(int, uint64_t, uint64_t);
   void updateCompletion();
   void completion();
   void switchScheduler(SchedulerType type);  // 新增切換排程器的方法
+  void setUserWeight(uint32_t uid, uint64_t weight);
 
  public:
   HIL(ConfigReader &);
   ~HIL();
 
+  // 請求移入物件池：callback 歸池中物件，呼叫端只剩欄位的副本
   void read(Request &);
   void write(Request &);
   void flush(Request &);
@@ -385,7 +385,8 @@ void Namespace::write(SQEntryWrapper &req, RequestFunction &func) {
                             context);
       }
 
-      pParent->write(this, pContext->slba, pContext->nlb, pContext->uid, dmaDone, context);
+      pParent->write(this, pContext->slba, pContext->nlb, pContext->uid,
+                     pContext->prio, dmaDone, context);
     };
 
     IOContext *pContext = new IOContext(func, resp);
@@ -494,7 +495,8 @@ void Namespace::read(SQEntryWrapper &req, RequestFunction &func) {
       pContext->beginAt = 0;
      
 
-      pParent->read(this, pContext->slba, pContext->nlb, pContext->uid, dmaDone, pContext);
+      pParent->read(this, pContext->slba, pContext->nlb, pContext->uid,
+                    pContext->prio, dmaDone, pContext);
 
       pContext->buffer = (uint8_t *)calloc(pContext->nlb, info.lbaSize);
 
@@ -598,94 +600,84 @@ void Namespace::isc_get(SQEntryWrapper &req, RequestFunction &func) {
 
       pContext->tick = tick;
       pContext->beginAt = 0;
-
-      pParent->isc_get(this, pContext->slba, pContext->nlb, pContext->uid, dmaDone, pContext);
-
       pContext->buffer = (uint8_t *)calloc(pContext->nlb, info.lbaSize);
 
-      // do not read data from disk
+      // the HIL pulls results from the offset into the buffer, so a large
+      // result is got by chunks, and a ring slet produces more of it on the
+      // time of the request. The data is sent after the HIL completes it
       if (ISC_SUBCMD_IS(pContext->slba, ISC_SUBCMD_SLET_RES)) {
-        pr("Runtime getRes         -----------ch------------------------------");
-        auto id = ISC_SUBCMD_OPT(pContext->slba);
-        auto psz = ISC::Runtime::getOpt(id, ISC_KEY_RESULT_SIZE, tick, nullptr);
-        auto rsz = MIN(pContext->nlb * info.lbaSize, *(size_t *)psz);
+        DMAFunction resDone = [this, dmaDone](uint64_t, void *context) mutable {
+          IOContext *pContext = (IOContext *)context;
 
-        //Calculate page size and send to scheduler 
+          pContext->beginAt++;
 
-        const uint64_t pages = (rsz + PAGE_SIZE - 1) / PAGE_SIZE;
+          auto rsz = pContext->resLen;
+          pr("result at %lu: %lu/%lu", pContext->offset, rsz,
+             pContext->nlb * info.lbaSize);
+
+          //Calculate page size and send to scheduler 
+
+          const uint64_t pages = (rsz + PAGE_SIZE - 1) / PAGE_SIZE;
         
-        // ★ NEW: Admin ISC resource consumption tracking
-        if (pContext->uid == 0) {
-          debugprint(LOG_HIL_NVME, "ADMIN_ISC_CONSUME: uid=0 result_size=%lu pages=%lu subcmd_id=%lu", 
-                     rsz, pages, ISC_SUBCMD_OPT(pContext->slba));
-        }
-        // 只在 CreditScheduler 啟用時做 credit gate
-        if (gScheduler) {
-          auto *cs = dynamic_cast<SimpleSSD::HIL::CreditScheduler*>(gScheduler);
-          if (cs) {
-            if (!gScheduler->checkCredit(pContext->uid, pages)) {
-              // ---- 信用不足：委託 Scheduler 等夠再呼叫回來 ----
-              struct ISCResumeCtx { Namespace* ns; IOContext* ctx; };
-              auto *rc = new ISCResumeCtx{ this, pContext };
-              // 回呼：扣到 credit 後，搬結果 + DMA 寫回並讓 dmaDone 收尾
-              auto resumeThunk = [](void* vp, uint64_t now) {
-                  auto *rc = static_cast<ISCResumeCtx*>(vp);
-                  Namespace *ns = rc->ns;
-                  IOContext *p = rc->ctx;
-                  // 重新計算尺寸（以現在 tick 取值）
-                  auto id2  = ISC_SUBCMD_OPT(p->slba);
-                  auto psz2 = ISC::Runtime::getOpt(id2, ISC_KEY_RESULT_SIZE, now, nullptr);
-                  auto rsz2 = MIN(p->nlb * ns->info.lbaSize, *(size_t *)psz2);
-                  auto res2 = ISC::Runtime::getOpt(id2, ISC_KEY_RESULT, now, nullptr);
-                  if (!p->buffer)
-                      p->buffer = (uint8_t*)calloc(p->nlb, ns->info.lbaSize);
-                  memcpy(p->buffer, res2, rsz2);
-                  // 排一筆 DMA，完成後由 dmaDone 釋放 pContext
-                  DMAFunction dmaDone2 = [ns](uint64_t t, void *context) {
-                      IOContext *pc = (IOContext *)context;
-                      pc->beginAt++;
-                      if (pc->beginAt == 2) {
-                          debugprint(LOG_HIL_NVME,
-                              "NVM     | ISC-GET  | CQ %u | SQ %u:%u | CID %u | NSID %-5d | "
-                              "%" PRIX64 " + %d | %" PRIu64 " - %" PRIu64 " (%" PRIu64 ")",
-                              pc->resp.cqID, pc->resp.entry.dword2.sqID,
-                              pc->resp.sqUID, pc->resp.entry.dword3.commandID, ns->nsid,
-                              pc->slba, pc->nlb, pc->tick, t, t - pc->tick);
-                          pc->function(pc->resp);
-                          if (pc->buffer) free(pc->buffer);
-                          delete pc->dma;
-                          delete pc;
-                      }
-                  };
-                  p->dma->write(0, p->nlb * ns->info.lbaSize, p->buffer, dmaDone2, p);
-                  delete rc;
-              };
-              cs->submitISCDeferred(pContext->uid, pages, rc, resumeThunk);
-              // 這筆 isc-get 先不完成，等待回呼做 DMA 並收尾
-              return;
-            } else {
-              // 信用足：立刻扣款 → 繼續完成本次 DMA
+          // ★ NEW: Admin ISC resource consumption tracking
+          if (pContext->uid == 0) {
+            debugprint(LOG_HIL_NVME, "ADMIN_ISC_CONSUME: uid=0 result_size=%lu pages=%lu subcmd_id=%lu", 
+                       rsz, pages, ISC_SUBCMD_OPT(pContext->slba));
+          }
+          // 只在 CreditScheduler 啟用時做 credit gate
+          if (gScheduler) {
+            auto *cs = dynamic_cast<SimpleSSD::HIL::CreditScheduler*>(gScheduler);
+            if (cs) {
+              if (!gScheduler->checkCredit(pContext->uid, pages)) {
+                // ---- 信用不足：委託 Scheduler 等夠再呼叫回來 ----
+                struct ISCResumeCtx { Namespace* ns; IOContext* ctx; DMAFunction done; };
+                auto *rc = new ISCResumeCtx{ this, pContext, dmaDone };
+                // 回呼：扣到 credit 後，DMA 寫回已取得的結果並讓 dmaDone 收尾
+                auto resumeThunk = [](void* vp, uint64_t) {
+                    auto *rc = static_cast<ISCResumeCtx*>(vp);
+                    IOContext *p = rc->ctx;
+                    p->dma->write(0, p->nlb * rc->ns->info.lbaSize, p->buffer,
+                                  rc->done, p);
+                    delete rc;
+                };
+                cs->submitISCDeferred(pContext->uid, pages, rc, resumeThunk);
+                // 這筆 isc-get 先不完成，等待回呼做 DMA 並收尾
+                return;
+              } else {
+                // 信用足：立刻扣款 → 繼續完成本次 DMA
+                gScheduler->useCreditISC(pContext->uid, pages);
+              }
+            }
+            else {
+              // 其他排程器不擋：只把結果傳輸記到 ISC 用量
               gScheduler->useCreditISC(pContext->uid, pages);
             }
           }
-        }
-        // 走到這裡表示：不是 CreditScheduler 或已扣款 → 直接搬結果與 DMA
-        {
-          auto res = ISC::Runtime::getOpt(id, ISC_KEY_RESULT, tick, nullptr);
-          memcpy(pContext->buffer, res, rsz);
-          pr("result/buffer size: %lu/%lu", *(size_t *)psz,
-             pContext->nlb * info.lbaSize);
-        }
+          // 走到這裡表示：不是 CreditScheduler 或已扣款 → 直接 DMA
+
+          pContext->dma->write(0, pContext->nlb * info.lbaSize,
+                               pContext->buffer, dmaDone, context);
+        };
 
-        pr("getRes done            -----------------------------------------");
+        pParent->isc_get(this, pContext->slba, pContext->nlb, pContext->uid, resDone, pContext);
+
+        return;
       }
-      else if (ISC_SUBCMD_IS(pContext->slba, ISC_SUBCMD_SLET_RESSZ)) {
+
+      pParent->isc_get(this, pContext->slba, pContext->nlb, pContext->uid, dmaDone, pContext);
+
+      // do not read data from disk
+      if (ISC_SUBCMD_IS(pContext->slba, ISC_SUBCMD_SLET_RESSZ)) {
         pr("Runtime getResSz         ---------------------------------------");
+        // the size so far and whether it is complete
         auto id = ISC_SUBCMD_OPT(pContext->slba);
-        auto psz = ISC::Runtime::getOpt(id, ISC_KEY_RESULT_SIZE, tick, nullptr);
-        auto rsz = MIN(pContext->nlb * info.lbaSize, sizeof(size_t));
+        uint64_t sz[2] = {0, 0};
+        bool done = false;
+        sz[0] = ISC::Runtime::getResultSize(id, &done, tick, nullptr);
+        sz[1] = done;
+        auto rsz = MIN(pContext->nlb * info.lbaSize, sizeof(sz));
 
-        memcpy(pContext->buffer, psz, rsz);
+        memcpy(pContext->buffer, sz, rsz);
 
         pr("getResSz done            ---------------------------------------");
       }
@@ -701,6 +693,7 @@ void Namespace::isc_get(SQEntryWrapper &req, RequestFunction &func) {
     pContext->nlb = nlb;
     pContext->uid = uid;
     pContext->prio = prio;
+    pContext->offset = ((uint64_t)req.entry.dword14 << 32) | req.entry.dword13;
     pContext->tick    = pContext->beginAt;   /* remember the first time try tick */
     pContext->buffer  = nullptr;
 
@@ -891,7 +884,8 @@ void Namespace::compare(SQEntryWrapper &req, RequestFunction &func) {
       pContext->tick = tick;
       pContext->beginAt = 0;
 
-      pParent->read(this, pContext->slba, pContext->nlb, pContext->uid, dmaDone, pContext);
+      pParent->read(this, pContext->slba, pContext->nlb, pContext->uid,
+                    pContext->prio, dmaDone, pContext);
 
       pContext->buffer = (uint8_t *)calloc(pContext->nlb, info.lbaSize);
       pContext->hostContent = (uint8_t *)calloc(pContext->nlb, info.lbaSize);
@@ -69,11 +69,15 @@ class IOContext : public RequestContext {
   uint64_t nlb;
   uint64_t tick;
 
+  uint64_t offset;  // byte offset of ISC results to get
+  uint64_t resLen;  // bytes of ISC results got by the HIL
+
   uint32_t uid;
   uint32_t prio;
 
   IOContext(RequestFunction &f, CQEntryWrapper &r)
-      : RequestContext(f, r), beginAt(0), slba(0), nlb(0), tick(0), uid(0), prio(0) {}
+      : RequestContext(f, r), beginAt(0), slba(0), nlb(0), tick(0), offset(0),
+        resLen(0), uid(0), prio(0) {}
 };
 
 class CompareContext : public IOContext {
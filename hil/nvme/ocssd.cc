@@ -837,7 +837,7 @@ void OpenChannelSSD12::physicalBlockErase(SQEntryWrapper &req,
         Request req = Request(nandDone, context);
         req.finishedAt = finishedAt;
 
-        completionQueue.push(req);
+        completionQueue.push(std::move(req));
         updateCompletion();
 
         delete pContext->dma;
@@ -943,7 +943,7 @@ void OpenChannelSSD12::physicalPageWrite(SQEntryWrapper &req,
           Request req = Request(nandDone, context);
           req.finishedAt = finishedAt;
 
-          completionQueue.push(req);
+          completionQueue.push(std::move(req));
           updateCompletion();
 
           free(pContext->buffer);
@@ -1091,7 +1091,7 @@ void OpenChannelSSD12::physicalPageRead(SQEntryWrapper &req,
         Request req = Request(nandDone, context);
         req.finishedAt = finishedAt;
 
-        completionQueue.push(req);
+        completionQueue.push(std::move(req));
         updateCompletion();
       };
 
@@ -1564,7 +1564,7 @@ void OpenChannelSSD20::readInternal(std::vector<uint64_t> &lbaList,
     }
 
     pContext->req.finishedAt = finishedAt;
-    completionQueue.push(pContext->req);
+    completionQueue.push(std::move(pContext->req));
 
     updateCompletion();
 
@@ -1675,7 +1675,7 @@ void OpenChannelSSD20::writeInternal(std::vector<uint64_t> &lbaList,
     }
 
     pContext->req.finishedAt = finishedAt;
-    completionQueue.push(pContext->req);
+    completionQueue.push(std::move(pContext->req));
 
     updateCompletion();
 
@@ -1779,7 +1779,7 @@ void OpenChannelSSD20::eraseInternal(std::vector<uint64_t> &lbaList,
     }
 
     pContext->req.finishedAt = finishedAt;
-    completionQueue.push(pContext->req);
+    completionQueue.push(std::move(pContext->req));
 
     updateCompletion();
 
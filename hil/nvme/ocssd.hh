@@ -102,6 +102,12 @@ class VectorContext : public IOContext {
 
 class OpenChannelSSD12 : public Subsystem {
  protected:
+  struct LaterFinish {
+    bool operator()(const Request &a, const Request &b) const {
+      return a.finishedAt > b.finishedAt;
+    }
+  };
+
   PAL::Parameter param;
   PAL::PALOLD *pPALOLD;
 
@@ -112,7 +118,8 @@ class OpenChannelSSD12 : public Subsystem {
 
   uint64_t lastScheduled;
   Event completionEvent;
-  std::priority_queue<Request, std::vector<Request>, Request> completionQueue;
+  std::priority_queue<Request, std::vector<Request>, LaterFinish>
+      completionQueue;
 
   // Stats
   uint64_t eraseCount;
@@ -41,8 +41,8 @@ typedef union _SQEntry {
       uint16_t commandID;
     } dword0;
     uint32_t namespaceID;
-    uint32_t reserved1;
-    uint32_t reserved2;
+    uint32_t reserved1;  // CDW2, I/O priority class set by the host driver
+    uint32_t reserved2;  // CDW3, uid of the issuing host user
     uint64_t metadata;
     uint64_t data1;
     uint64_t data2;
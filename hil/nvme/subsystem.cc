@@ -518,7 +518,7 @@ uint32_t Subsystem::validNamespaceCount() {
 }
 
 void Subsystem::read(Namespace *ns, uint64_t slba, uint64_t nlblk, uint32_t uid,
-                     DMAFunction &func, void *context) {
+                     uint32_t prio, DMAFunction &func, void *context) {
   Request *req = new Request(func, context);
   DMAFunction doRead = [this, ns](uint64_t, void *context) {
     auto req = (Request *)context;
@@ -532,6 +532,7 @@ void Subsystem::read(Namespace *ns, uint64_t slba, uint64_t nlblk, uint32_t uid,
 
   convertUnit(ns, slba, nlblk, *req);
   req->userID = uid;
+  req->prio = prio;
   execute(CPU::NVME__SUBSYSTEM, CPU::CONVERT_UNIT, doRead, req);
 }
 
@@ -570,7 +571,7 @@ void Subsystem::isc_set(Namespace *ns, uint64_t slba, uint64_t nlblk,
 }
 
 void Subsystem::write(Namespace *ns, uint64_t slba, uint64_t nlblk, uint32_t uid,
-                      DMAFunction &func, void *context) {
+                      uint32_t prio, DMAFunction &func, void *context) {
   Request *req = new Request(func, context);
   DMAFunction doWrite = [this, ns](uint64_t, void *context) {
     auto req = (Request *)context;
@@ -583,7 +584,8 @@ void Subsystem::write(Namespace *ns, uint64_t slba, uint64_t nlblk, uint32_t uid
 
   convertUnit(ns, slba, nlblk, *req);
   req->userID = uid;
-  
+  req->prio = prio;
+
   execute(CPU::NVME__SUBSYSTEM, CPU::CONVERT_UNIT, doWrite, req);
 }
 
@@ -1,20 +1,21 @@
 // ============================================================================
-// credit_scheduler.cc —— Simple token-bucket + RR + admin-queue
-// 修正點：
-//  A) 固定相位補發：用 lastGlobalRefillTick_ 作為「下一次」補發相位（不改名，改語意）；
-//     while(now >= lastGlobalRefillTick_) 逐期補齊，避免“誰先喚醒就拿大鍋”。
-//  B) submit 可觸發派發，但補發嚴格依相位進行（不再把相位綁到 submit 時刻）。
-//  C) 真正 RR 交錯：每成功派發 1 筆，就從 lastChosenUid 的下一位重啟一輪掃描。
+// credit_scheduler.cc —— Lazy token-bucket + RR + admin-queue
+// 設計：
+//  A) 每個用戶一個 token bucket：credit 由 (now - lastRefillTick) * rate 臨時算出，
+//     不需週期補發事件；rate 只在活躍集合或 SLO 設定改變時由 rebalance() 重算。
+//  B) 所有等 credit 的工作（Host/Gate/ISC 回呼/ICL 讀取）走同一個每用戶
+//     佇列（pool_ 節點串成每優先級 FIFO）；只在有人等待時排一個喚醒事件到
+//     「最早夠 credit」的時間。
+//  C) 真正 RR 交錯：最前端夠 credit 的用戶在 ring_ 裡輪流，每次派發 1 筆；
+//     不夠的依夠 credit 的時間睡在 sleepers_，派發成本與註冊用戶數無關。
 // ============================================================================
 #include "hil/scheduler/credit_scheduler.hh"
 #include "icl/icl.hh"           // pICL->read/write(...)
 #include "sim/simulator.hh"     // allocate/schedule/deschedule/scheduled/getTick
 #include "sim/trace.hh"         // debugprint, LOG_HIL_CREDIT_SCHEDULER
-#include "isc/sims/ftl.hh"      // For ISCRequestContext
-#include <algorithm>            // std::min
+#include <algorithm>            // std::min, std::push_heap
 #include <cstdio>
 #include <inttypes.h>
-#include <map>                  // std::map
 
 namespace SimpleSSD { namespace HIL {
 
@@ -23,113 +24,524 @@ namespace SimpleSSD { namespace HIL {
 // ------------ 建構 / 解構 ----------------------------------------------------
 CreditScheduler::CreditScheduler(ICL::ICL* icl, uint64_t period_ticks, uint64_t ticks_per_sec)
     : pICL(icl), periodTicks_(period_ticks), ticksPerSec_(ticks_per_sec)
-{   
+{
     debugprint(LOG_HIL_CREDIT_SCHEDULER,
                "ctor: periodTicks=%" PRIu64 ", ticksPerSec=%" PRIu64,
                periodTicks_, ticksPerSec_);
 
-    // 計算每週期應發放的總 pages (throughput-based 批量發放)
+    // 每週期的總 pages（只用來決定 credit cap，補發本身是連續的）
     pagesPerPeriod_ =
         static_cast<double>(PagesPerSec) *
         static_cast<double>(periodTicks_) /
         static_cast<double>(ticksPerSec_);
     debugprint(LOG_HIL_CREDIT_SCHEDULER,
-               "pagesPerPeriod = %.3f pages / %" PRIu64 " ticks", 
+               "pagesPerPeriod = %.3f pages / %" PRIu64 " ticks",
                pagesPerPeriod_, periodTicks_);
 
-    // 1) 先固定把 1001、1002 建起來，確保 stats 一開始就有 per-user 欄位
-    statUsers_.clear();
-    statUsers_.push_back(1001);
-    statUsers_.push_back(1002);
-    statUsers_.push_back(1003); // 新增 best-effort 使用者
-    for (uint32_t uid : statUsers_) {
-        auto &acc = getOrCreateUser(uid);
-        acc.isActive       = false;
-        acc.credit         = 0;
-        acc.lastRefillTick = SimpleSSD::getTick();
-        debugprint(LOG_HIL_CREDIT_SCHEDULER,
-                   "init user uid=%u weight=%" PRIu64 " cap=%" PRIu64 " credit=%" PRIu64,
-                   uid, acc.weight, acc.creditCap, acc.credit);
-    }
-
-    // 配置週期事件（使用 SimpleSSD::Simulator 的事件 API）
-    refillEvent = SimpleSSD::allocate([this](uint64_t now){
+    // 喚醒事件：僅 allocate，有工作在等 credit 時才 schedule
+    wakeEvent = SimpleSSD::allocate([this](uint64_t now){
         this->processEvent(now);
     });
+}
 
-    // 僅 allocate，不立即 schedule
-    timerStarted = false;
+CreditScheduler::~CreditScheduler() {
+    // 確保事件已取消並釋放
+    if (SimpleSSD::scheduled(wakeEvent, nullptr)) {
+        SimpleSSD::deschedule(wakeEvent);
+        debugprint(LOG_HIL_CREDIT_SCHEDULER, "dtor: deschedule wake event");
+    }
+    debugprint(LOG_HIL_CREDIT_SCHEDULER, "dtor: deallocate wake event");
+    SimpleSSD::deallocate(wakeEvent);
+}
 
-    // 重要：把 lastGlobalRefillTick_ 改作「下一次應補發的相位」
-    // 尚未啟動前不生效，等第一次 start 時設成 now + periodTicks_
-    lastGlobalRefillTick_ = 0;
+// ------------ Token bucket ---------------------------------------------------
+// tokens 以 1/ticksPerSec_ 頁為單位：經過 dt tick 增加 dt * rate（rate = pages/sec）
+uint64_t CreditScheduler::tokensAt(const UserAccount& acc, uint64_t now) const
+{
+    uint64_t capT = acc.creditCap * ticksPerSec_;
+    uint64_t t = std::min(acc.tokens, capT);
+    if (!acc.isActive || acc.rate == 0 || now <= acc.lastRefillTick)
+        return t;
+
+    // 先判斷會不會滿，避免 elapsed * rate 溢位
+    uint64_t elapsed = now - acc.lastRefillTick;
+    if (elapsed >= (capT - t + acc.rate - 1) / acc.rate)
+        return capT;
+    return t + elapsed * acc.rate;
+}
 
+void CreditScheduler::settle(UserAccount& acc, uint64_t now)
+{
+    if (now <= acc.lastRefillTick) return;
+    acc.tokens = tokensAt(acc, now);
+    acc.lastRefillTick = now;
+}
+
+// 超過 cap 的工作在 bucket 滿時放行並扣光，避免永遠等不到
+bool CreditScheduler::charge(UserAccount& acc, uint64_t pages, uint64_t now)
+{
+    settle(acc, now);
+    uint64_t need = std::min(pages, acc.creditCap) * ticksPerSec_;
+    if (acc.tokens < need) return false;
+    acc.tokens -= need;
+    return true;
+}
+
+// 何時 tokens 足夠 pages；不活躍或 rate 為 0 時無法預測（UINT64_MAX）
+uint64_t CreditScheduler::readyTick(const UserAccount& acc, uint64_t pages,
+                                    uint64_t now) const
+{
+    uint64_t need = std::min(pages, acc.creditCap) * ticksPerSec_;
+    uint64_t have = tokensAt(acc, now);
+    if (have >= need) return now;
+    if (!acc.isActive || acc.rate == 0) return UINT64_MAX;
+
+    uint64_t from = std::max(now, acc.lastRefillTick);
+    return from + (need - have + acc.rate - 1) / acc.rate;
+}
+
+// ------------ 活躍集合與速率 -------------------------------------------------
+void CreditScheduler::activate(uint32_t slot, uint64_t now)
+{
+    auto &acc = table_[slot];
+    acc.idleSince = now;
+    if (acc.isActive) {
+        // 空佇列的用戶被再次點名：寬限期從現在重新起算
+        if (acc.pendingCount == 0)
+            idleTimers_.push({now + IdleGracePeriods * periodTicks_, slot, ++acc.idleGen});
+        return;
+    }
+
+    acc.isActive       = true;
+    acc.tokens         = 0;  // 不給初始credit，確保權重分配公平性
+    acc.lastRefillTick = now;
+    acc.activeIdx      = static_cast<uint32_t>(active_.size());
+    active_.push_back(slot);
+    if (acc.pendingCount == 0)
+        idleTimers_.push({now + IdleGracePeriods * periodTicks_, slot, ++acc.idleGen});
     debugprint(LOG_HIL_CREDIT_SCHEDULER,
-               "refillEvent allocated, will be scheduled when HIL is ready");
+               "user[%u] activated at tick=%" PRIu64 " (active=%zu)",
+               acc.uid, now, active_.size());
+    rebalance(now);
 }
 
-CreditScheduler::~CreditScheduler() {
-    // 確保事件已取消並釋放
-    if (SimpleSSD::scheduled(refillEvent, nullptr)) {
-        SimpleSSD::deschedule(refillEvent);
-        debugprint(LOG_HIL_CREDIT_SCHEDULER, "dtor: deschedule timer");
+// 有工作、不在 ring_ 的用戶：最前端夠 credit 就排進 ring_，否則睡到夠的時間
+void CreditScheduler::place(uint32_t slot, uint64_t now)
+{
+    auto &acc = table_[slot];
+    uint32_t head = headOf(acc);
+    acc.sleeping = false;
+    ++acc.sleepGen;  // 舊的 sleepers_ 項目作廢
+    if (head == NIL) return;
+
+    uint64_t at = readyTick(acc, pool_[head].pages, now);
+    if (at <= now) {
+        ring_.push_back(slot);
+        acc.inRing = true;
+        return;
+    }
+
+    // 沒有速率時不排時間，rebalance() 給了速率再放進 sleepers_
+    acc.sleeping = true;
+    if (at != UINT64_MAX) sleepers_.push({at, slot, acc.sleepGen});
+}
+
+void CreditScheduler::wakeSleepers(uint64_t now)
+{
+    while (!sleepers_.empty() && sleepers_.top().at <= now) {
+        Timer t = sleepers_.top();
+        sleepers_.pop();
+        auto &acc = table_[t.slot];
+        if (!acc.sleeping || acc.sleepGen != t.gen) continue;
+        acc.sleeping = false;
+        acc.inRing   = true;
+        ring_.push_back(t.slot);
+    }
+}
+
+// 佇列清空超過寬限期的用戶退出活躍集合，把速率讓給其他人
+void CreditScheduler::expireIdle(uint64_t now)
+{
+    bool changed = false;
+
+    while (!idleTimers_.empty() && idleTimers_.top().at <= now) {
+        Timer t = idleTimers_.top();
+        idleTimers_.pop();
+        auto &acc = table_[t.slot];
+        if (acc.idleGen != t.gen || !acc.isActive || acc.pendingCount != 0)
+            continue;
+
+        settle(acc, now);
+        acc.isActive = false;
+        acc.rate     = 0;
+        debugprint(LOG_HIL_CREDIT_SCHEDULER,
+                   "user[%u] idle since %" PRIu64 ", deactivated at %" PRIu64,
+                   acc.uid, acc.idleSince, now);
+
+        uint32_t last = active_.back();
+        active_[acc.activeIdx] = last;
+        table_[last].activeIdx = acc.activeIdx;
+        active_.pop_back();
+        acc.activeIdx = NIL;
+        changed = true;
+    }
+
+    if (changed) rebalance(now);
+}
+
+// 依活躍集合重算每個用戶的 rate（SLO 先分、剩餘給 BE），與舊的相位補發同一套分法
+void CreditScheduler::rebalance(uint64_t now)
+{
+    uint64_t activeWSLO = 0, activeWBE = 0;
+    for (uint32_t slot : active_) {
+        auto &acc = table_[slot];
+        settle(acc, now);  // 舊速率結算到 now
+        if (acc.isSLO) activeWSLO += acc.weight; else activeWBE += acc.weight;
     }
-    debugprint(LOG_HIL_CREDIT_SCHEDULER, "dtor: deallocate timer");
-    SimpleSSD::deallocate(refillEvent);
+
+    const double capacity = static_cast<double>(PagesPerSec);
+    uint64_t sloGranted = 0;
+
+    if (activeWSLO > 0) {
+        // ★ Phase 2: Demand-Driven SLO Allocation (需求驱动分配)
+        double totalDemand = 0.0;
+        auto demandOf = [&](const UserAccount &acc) -> double {
+            if (acc.sloMode == UserAccount::SLOMode::IOPS_TARGET)
+                return acc.targetIOPS;
+            // Tail 模式：按所有活躍者的權重分，再乘 budgetBoost；BE 吸收剩下的
+            if (acc.sloMode == UserAccount::SLOMode::TAIL_TARGET)
+                return capacity * static_cast<double>(acc.weight) /
+                       static_cast<double>(activeWSLO + activeWBE) * acc.budgetBoost;
+            return capacity * static_cast<double>(acc.weight) /
+                   static_cast<double>(activeWSLO);
+        };
+        for (uint32_t slot : active_) {
+            auto &acc = table_[slot];
+            if (acc.isSLO) totalDemand += demandOf(acc);
+        }
+
+        // 需求超载 → 按比例缩放 SLO，BE 得 0
+        double scale = totalDemand > capacity ? capacity / totalDemand : 1.0;
+        for (uint32_t slot : active_) {
+            auto &acc = table_[slot];
+            if (!acc.isSLO) continue;
+            acc.rate = static_cast<uint64_t>(demandOf(acc) * scale);
+            sloGranted += acc.rate;
+            debugprint(LOG_HIL_CREDIT_SCHEDULER,
+                       "rate-SLO: uid=%u mode=%d rate=%" PRIu64 " pages/s scale=%.3f",
+                       acc.uid, static_cast<int>(acc.sloMode), acc.rate, scale);
+        }
+    }
+
+    uint64_t budgetBE = PagesPerSec > sloGranted ? PagesPerSec - sloGranted : 0;
+    for (uint32_t slot : active_) {
+        auto &acc = table_[slot];
+        if (acc.isSLO) continue;
+        acc.rate = budgetBE * acc.weight / activeWBE;
+        debugprint(LOG_HIL_CREDIT_SCHEDULER,
+                   "rate-BE: uid=%u rate=%" PRIu64 " pages/s w=%" PRIu64 "/%" PRIu64,
+                   acc.uid, acc.rate, acc.weight, activeWBE);
+    }
+
+    // 速率變了，睡著的用戶重新算醒來的時間（睡著的必有工作，一定在 active_ 裡）
+    TimerQueue fresh;
+    for (uint32_t slot : active_) {
+        const auto &acc = table_[slot];
+        if (!acc.sleeping) continue;
+        uint64_t at = readyTick(acc, pool_[headOf(acc)].pages, now);
+        if (at != UINT64_MAX) fresh.push({at, slot, acc.sleepGen});
+    }
+    std::swap(sleepers_, fresh);
+}
+
+// 把喚醒事件排到「最早有工作夠 credit」或「最早有閒置用戶退出（速率會變）」的時間
+void CreditScheduler::armWake(uint64_t now)
+{
+    // 清掉過期的項目，堆頂才是真正最早的時間
+    while (!sleepers_.empty()) {
+        const Timer &t = sleepers_.top();
+        const auto &acc = table_[t.slot];
+        if (acc.sleeping && acc.sleepGen == t.gen) break;
+        sleepers_.pop();
+    }
+
+    uint64_t earliest = UINT64_MAX;
+    if (!ring_.empty())
+        earliest = now;  // 達到單次派發上限，剩下的下一個事件接著派
+    else if (!sleepers_.empty())
+        earliest = sleepers_.top().at;
+
+    // 沒人在等就不需要任何事件；閒置用戶到期時再順便處理
+    bool armed = SimpleSSD::scheduled(wakeEvent, nullptr);
+    if (earliest == UINT64_MAX) {
+        if (armed) SimpleSSD::deschedule(wakeEvent);
+        return;
+    }
+
+    uint64_t expiry = idleTimers_.empty() ? UINT64_MAX : idleTimers_.top().at;
+    uint64_t when = std::max(std::min(earliest, expiry), SimpleSSD::getTick());
+    if (armed) {
+        if (wakeAt_ == when) return;
+        SimpleSSD::deschedule(wakeEvent);
+    }
+    SimpleSSD::schedule(wakeEvent, when);
+    wakeAt_ = when;
+}
+
+// Tail SLO 回饋控制：窗口內 p(tailPercentile) 超標就加大 budgetBoost，
+// 明顯低於目標就慢慢退回 1.0；SLO 拿多少，BE 就少分多少
+void CreditScheduler::tailControl(uint64_t now)
+{
+    bool changed = false;
+
+    for (uint32_t slot : active_) {
+        auto &acc = table_[slot];
+        if (!acc.isSLO || acc.sloMode != UserAccount::SLOMode::TAIL_TARGET)
+            continue;
+        if (acc.tailTargetUs == 0 || acc.tailWindow.count() < TailMinSamples) {
+            acc.tailWindow.reset();
+            continue;
+        }
+
+        double q = acc.tailPercentile > 0.0 ? acc.tailPercentile : 0.99;
+        uint64_t tail = acc.tailWindow.percentile(q);
+        uint64_t target = acc.tailTargetUs * (ticksPerSec_ / 1000000);
+        double boost = acc.budgetBoost;
+
+        if (tail > target)
+            boost = boost * BoostUp > BoostMax ? BoostMax : boost * BoostUp;
+        else if (tail < target * TailSlack)
+            boost = boost * BoostDown < 1.0 ? 1.0 : boost * BoostDown;
+
+        debugprint(LOG_HIL_CREDIT_SCHEDULER,
+                   "tail: uid=%u p%.1f=%" PRIu64 " target=%" PRIu64 " samples=%" PRIu64
+                   " boost %.3f -> %.3f",
+                   acc.uid, q * 100.0, tail, target, acc.tailWindow.count(),
+                   acc.budgetBoost, boost);
+
+        if (boost != acc.budgetBoost) {
+            acc.budgetBoost = boost;
+            changed = true;
+        }
+        acc.tailWindow.reset();
+    }
+
+    if (changed) rebalance(now);
 }
 
 // ------------ submitRequest -------------------------------------------------
 void CreditScheduler::submitRequest(Request& req)
+{
+    // 沒有週期事件：入列後當下就派發，credit 不夠的由 tick() 排喚醒事件
+    Tick now = SimpleSSD::getTick();
+    submitAt(req, now);
+    tick(now);
+}
+
+// now：請求到達的時間，延遲從這裡起算；回傳工作節點（admin 為 NIL）
+uint32_t CreditScheduler::submitAt(Request& req, uint64_t now, Request* owner,
+                                   uint64_t* done)
 {
     debugprint(LOG_HIL_CREDIT_SCHEDULER,
                "submit: uid=%u op=%d len=%" PRIu64 " now=%" PRIu64,
-               req.userID, int(req.op), (uint64_t)req.length, SimpleSSD::getTick());
+               req.userID, int(req.op), (uint64_t)req.length, now);
 
     if (req.userID == 0) {               // admin
-        adminQueue.push(req);
+        uint32_t node = allocHostWork(WorkType::HOST, req);
+        pool_[node].owner = owner;
+        pool_[node].done  = done;
+        adminQueue.push(node);
         debugprint(LOG_HIL_CREDIT_SCHEDULER,
                    "submit: -> adminQ size=%zu", adminQueue.size());
-    } else {
-        auto& acc = getOrCreateUser(req.userID);
-        const bool isGate = (req.op == OpType::CREDIT_ONLY || req.op == OpType::ISC_RESULT);
-
-        if (isGate) {
-            if (req.op == OpType::CREDIT_ONLY) { acc.pendingGates += 1; }
-            // ★ Gate 放到 ISC 佇列；若你想「插到最前端」，用重建 queue 的方式：
-            std::queue<Request> newQ;
-            newQ.push(req);
-            while (!acc.queueISC.empty()) { newQ.push(acc.queueISC.front()); acc.queueISC.pop(); }
-            acc.queueISC.swap(newQ);
-            debugprint(LOG_HIL_CREDIT_SCHEDULER,
-                       "submit: -> user[%u].ISC size=%zu", req.userID, acc.queueISC.size());
-        } else {
-            acc.queue.push(req);
-            debugprint(LOG_HIL_CREDIT_SCHEDULER,
-                       "submit: -> user[%u] Q size=%zu, credit=%" PRIu64,
-                       req.userID, acc.queue.size(), acc.credit);
-        }
+        return NIL;
+    }
 
-        if (!acc.isActive) {
-            acc.isActive       = true;
-            acc.credit         = 0;  // 不給初始credit，確保權重分配公平性
-            acc.idlePeriods    = 0;
-            acc.lastRefillTick = SimpleSSD::getTick();
-            debugprint(LOG_HIL_CREDIT_SCHEDULER,
-                       "submit: user[%u] activated at tick=%" PRIu64,
-                       req.userID, acc.lastRefillTick);
-            
-            // 第一個用戶啟動時開始 timer（相位固定為 now + periodTicks_）
-            if (!timerStarted) {
-                auto first = SimpleSSD::getTick() + periodTicks_;
-                lastGlobalRefillTick_ = first; // 注意：此變數語意改為「下一次補發相位」
-                debugprint(LOG_HIL_CREDIT_SCHEDULER,
-                           "starting timer, first refill phase at tick=%" PRIu64, first);
-                SimpleSSD::schedule(refillEvent, first);
-                timerStarted = true;
+    const bool isGate = (req.op == OpType::CREDIT_ONLY || req.op == OpType::ISC_RESULT);
+    uint32_t node = allocHostWork(isGate ? WorkType::GATE : WorkType::HOST,  // ★ Gate 插到最前端
+                                  req);
+    pool_[node].owner = owner;
+    pool_[node].done  = done;
+    if (req.op == OpType::CREDIT_ONLY) getOrCreateUser(req.userID).pendingGates += 1;
+
+    enqueueWork(req.userID, node, now);
+    return node;
+}
+
+void CreditScheduler::submit(Request* req)
+{
+    // admin 不經 credit，交給基底類別的批次事件
+    if (req->userID == 0) {
+        Scheduler::submit(req);
+        return;
+    }
+
+    Tick now = SimpleSSD::getTick();
+    submitAt(*req, now, req);
+    tick(now);
+}
+
+// 切換排程器：交出 submit() 的請求，其餘工作留著照常派發
+void CreditScheduler::drain(RequestList& out)
+{
+    const uint64_t now = SimpleSSD::getTick();
+
+    for (uint32_t slot = 0; slot < table_.size(); ++slot) {
+        auto &acc = table_[slot];
+        bool changed = false;
+
+        for (uint32_t p = 0; p < NumPrio; ++p) {
+            auto &list = acc.lists[p];
+            uint32_t prev = NIL;
+
+            for (uint32_t n = list.head; n != NIL;) {
+                uint32_t next = pool_[n].next;
+                Request *owner = pool_[n].owner;
+
+                if (!owner) {
+                    prev = n;
+                    n = next;
+                    continue;
+                }
+
+                if (prev == NIL) list.head = next;
+                else             pool_[prev].next = next;
+                if (list.tail == n) list.tail = prev;
+
+                if (pool_[n].op == OpType::CREDIT_ONLY && acc.pendingGates)
+                    acc.pendingGates -= 1;
+                acc.pendingCount -= 1;
+                acc.pendingPages -= pool_[n].pages;
+                freeWork(n);
+                out.push(owner);
+                changed = true;
+                n = next;
             }
         }
+
+        // 最前端可能換了：ring_ 中的照常（派發時會檢查），睡著的重新決定醒來時間
+        if (changed && !acc.inRing) place(slot, now);
+        if (changed && acc.pendingCount == 0 && acc.isActive)
+            idleTimers_.push({now + IdleGracePeriods * periodTicks_, slot, ++acc.idleGen});
+    }
+
+    armWake(now);
+
+    Scheduler::drain(out);
+}
+
+// submit() 以外的工作只有這個排程器知道怎麼完成
+bool CreditScheduler::holdsWork() const
+{
+    if (!adminQueue.empty()) return true;
+    for (const auto &acc : table_) {
+        if (acc.pendingCount == 0) continue;
+        for (uint32_t p = 0; p < NumPrio; ++p)
+            for (uint32_t n = acc.lists[p].head; n != NIL; n = pool_[n].next)
+                if (!pool_[n].owner) return true;
     }
+    return false;
+}
+
+// HOST / GATE 派發後：通知等待的 processUntil 或完成 submit() 的請求
+void CreditScheduler::finishWork(Work& w, uint64_t tick)
+{
+    if (w.done)
+        *w.done = tick;
+    if (w.owner)
+        complete(w.owner, tick + applyLatency(CPU::CREDIT_SCHEDULER, CPU::SCHEDULE));
+}
+
+// 用戶佇列中排在 node 之前（含 node）的頁數
+uint64_t CreditScheduler::pagesAhead(const UserAccount& acc, uint32_t node) const
+{
+    uint64_t pages = 0;
+    for (uint32_t p = 0; p < NumPrio; ++p) {
+        for (uint32_t n = acc.lists[p].head; n != NIL; n = pool_[n].next) {
+            pages += pool_[n].pages;
+            if (n == node) return pages;
+        }
+    }
+    return pages;
+}
+
+void CreditScheduler::enqueueWork(uint32_t uid, uint32_t node, uint64_t now)
+{
+    uint32_t slot = slotOf(uid);
+    auto &acc = table_[slot];
+    auto &w   = pool_[node];
+    w.deferTime = now;
+
+    auto &list = acc.lists[prioOf(w.type)];
+    if (list.tail == NIL) list.head = node;
+    else                  pool_[list.tail].next = node;
+    list.tail = node;
+    acc.pendingCount += 1;
+    acc.pendingPages += w.pages;
+
+    activate(slot, now);
+    if (!acc.inRing) place(slot, now);  // 新工作可能換了最前端，重新決定醒來時間
+
+    debugprint(LOG_HIL_CREDIT_SCHEDULER,
+               "enqueue: uid=%u type=%d pages=%" PRIu64 " pending=%" PRIu64 " (%" PRIu64
+               " pages) credit=%" PRIu64,
+               uid, int(w.type), w.pages, acc.pendingCount, acc.pendingPages,
+               tokensAt(acc, now) / ticksPerSec_);
+}
+
+// ------------ 工作節點 ------------------------------------------------------
+uint32_t CreditScheduler::allocWork(WorkType type, uint64_t pages)
+{
+    uint32_t node;
+    if (!freeWork_.empty()) {
+        node = freeWork_.back();
+        freeWork_.pop_back();
+        pool_[node] = Work();
+    } else {
+        node = static_cast<uint32_t>(pool_.size());
+        pool_.emplace_back();
+    }
+    pool_[node].type  = type;
+    pool_[node].pages = pages;
+    return node;
+}
 
+// 只留 ICL 需要的欄位，Request 本身仍由呼叫端擁有
+uint32_t CreditScheduler::allocHostWork(WorkType type, const Request& req)
+{
+    uint32_t node = allocWork(type, (req.length + PageSz - 1) / PageSz);
+    pool_[node].op     = req.op;
+    pool_[node].iclReq = ICL::Request(req);
+    return node;
+}
+
+void CreditScheduler::freeWork(uint32_t node)
+{
+    freeWork_.push_back(node);
+}
+
+// 依優先級取第一個非空 FIFO 的頭
+uint32_t CreditScheduler::headOf(const UserAccount& acc) const
+{
+    for (uint32_t p = 0; p < NumPrio; ++p)
+        if (acc.lists[p].head != NIL) return acc.lists[p].head;
+    return NIL;
+}
+
+uint32_t CreditScheduler::popHead(UserAccount& acc)
+{
+    for (uint32_t p = 0; p < NumPrio; ++p) {
+        auto &list = acc.lists[p];
+        if (list.head == NIL) continue;
+
+        uint32_t node = list.head;
+        list.head = pool_[node].next;
+        if (list.head == NIL) list.tail = NIL;
+        pool_[node].next = NIL;
+        acc.pendingCount -= 1;
+        acc.pendingPages -= pool_[node].pages;
+        return node;
+    }
+    return NIL;
 }
 
 // ───────── tryDispatchWithCredit ─────────
@@ -138,20 +550,13 @@ bool CreditScheduler::tryDispatchWithCredit(Request& req, Tick &now)
     uint64_t pages = (req.length + PageSz - 1) / PageSz;
     auto &acc = getOrCreateUser(req.userID);
 
-    if (acc.credit < pages) {
-        DeferredRequest dr;
-        dr.req       = req;
-        dr.pages     = pages;
-        dr.deferTime = now;
-        deferredQueue.push(dr);
-
-        debugprint(LOG_HIL_CREDIT_SCHEDULER,
-                   "defer: uid=%u needs %" PRIu64 " pages, only has %" PRIu64 " weight=%" PRIu64 " cap=%" PRIu64 " consumed=%" PRIu64,
-                   req.userID, pages, acc.credit, acc.weight, acc.creditCap, acc.totalConsumed);
+    // 前面還有人在等就不插隊
+    if (acc.pendingCount != 0 || !charge(acc, pages, now)) {
+        uint32_t node = allocHostWork(WorkType::HOST, req);
+        enqueueWork(req.userID, node, now);
         return false;
     }
 
-    acc.credit        -= pages;
     acc.totalConsumed += pages;
     // READ/WRITE 視為 HOST 類，其它保留給 ISC 類（若有）
     if (req.op == OpType::READ || req.op == OpType::WRITE)
@@ -165,53 +570,35 @@ bool CreditScheduler::tryDispatchWithCredit(Request& req, Tick &now)
 // ------------ processEvent --------------------------------------------------
 void CreditScheduler::processEvent(uint64_t now)
 {
-    debugprint(LOG_HIL_CREDIT_SCHEDULER, "timer: now=%" PRIu64, now);
-    tick(now);
-    SimpleSSD::schedule(refillEvent, lastGlobalRefillTick_);
+    debugprint(LOG_HIL_CREDIT_SCHEDULER, "wake: now=%" PRIu64, now);
+    Tick t = now;
+    tick(t);
 }
 
 void CreditScheduler::ensureActiveUser(uint32_t uid)
 {
-    auto &acc = getOrCreateUser(uid);
-    if (!acc.isActive) {
-        acc.isActive       = true;
-        acc.credit         = 0;
-        acc.idlePeriods    = 0;
-        acc.lastRefillTick = SimpleSSD::getTick();
-        debugprint(LOG_HIL_CREDIT_SCHEDULER,
-                   "ensureActiveUser: user[%u] activated at tick=%" PRIu64,
-                   uid, acc.lastRefillTick);
-
-        if (!timerStarted) {
-            auto first = SimpleSSD::getTick() + periodTicks_;
-            lastGlobalRefillTick_ = first;
-            debugprint(LOG_HIL_CREDIT_SCHEDULER,
-                       "ensureActiveUser: starting timer, first refill at tick=%" PRIu64,
-                       first);
-            SimpleSSD::schedule(refillEvent, first);
-            timerStarted = true;
-        }
-    }
+    activate(slotOf(uid), SimpleSSD::getTick());
 }
 
 // ---- 外部登記 ISC 延遲（只等信用 -> 扣款 -> 呼叫 resume()）----
 void CreditScheduler::submitISCDeferred(uint32_t uid, uint64_t pages, void* ctx,
                                         void (*cb)(void*, uint64_t))
 {
-    DeferredCustom dc;
-    dc.uid       = uid;
-    dc.pages     = pages;
-    dc.deferTime = SimpleSSD::getTick();
-    dc.ctx       = ctx;
-    dc.resume    = cb;
-    deferredISC_.push(dc);
+    uint32_t node = allocWork(WorkType::ISC_RESUME, pages);
+    pool_[node].ctx    = ctx;
+    pool_[node].resume = cb;
+    enqueueWork(uid, node, SimpleSSD::getTick());
     debugprint(LOG_HIL_CREDIT_SCHEDULER,
                "ISC-defer: uid=%u pages=%" PRIu64 " (enqueued)", uid, pages);
+
+    Tick now = SimpleSSD::getTick();
+    tick(now);
 }
 
 // ------------ tick()  -------------------------------------------------------
 void CreditScheduler::tick(Tick &now)
 {
+    // 工作回呼中再提交的工作只入列，由外層這一輪接著派發
     if (inTick) return;
     inTick = true;
 
@@ -226,9 +613,9 @@ void CreditScheduler::tick(Tick &now)
     if (now - lastStatTick >= ticksPerSec_) {
         double windowSec = (double)(now - lastStatTick) / (double)ticksPerSec_;
 
-        for (auto &kv : users) {
-            auto &acc = kv.second;
-            if (!acc.isActive || !acc.isSLO) continue;
+        for (uint32_t slot : active_) {
+            auto &acc = table_[slot];
+            if (!acc.isSLO) continue;
 
             // 计算实际 IOPS (4KiB 归一化)
             double measuredIOPS = (double)acc.winHostPages / windowSec;
@@ -236,7 +623,7 @@ void CreditScheduler::tick(Tick &now)
             debugprint(LOG_HIL_CREDIT_SCHEDULER,
                        "IOPS-window: uid=%u target=%.0f measured=%.0f "
                        "pages=%lu ios=%lu window=%.3fs",
-                       (unsigned)kv.first, acc.targetIOPS, measuredIOPS,
+                       (unsigned)acc.uid, acc.targetIOPS, measuredIOPS,
                        acc.winHostPages, acc.winHostIOs, windowSec);
 
             // 重置窗口
@@ -249,417 +636,188 @@ void CreditScheduler::tick(Tick &now)
     // (0) 先把 admin queue 派光
     size_t admin_dispatched = 0;
     while (!adminQueue.empty()) {
-        Request req = adminQueue.front();
+        uint32_t node = adminQueue.front();
         adminQueue.pop();
-        dispatchICL(req, now);
+        uint64_t t = now;  // 各自從 now 派發，ICL 延遲不累加到下一筆
+        dispatchICL(pool_[node], t);
+        finishWork(pool_[node], t);
+        freeWork(node);
         ++admin_dispatched;
         debugprint(LOG_HIL_CREDIT_SCHEDULER,
                    "tick:%" PRIu64 " admin-dispatched=%zu", now, admin_dispatched);
     }
 
-    // (1) 固定相位補發：逐期補齊所有到期的 period（SLO 先分、剩餘給 BE）
-    while (timerStarted && now >= lastGlobalRefillTick_) {
-        uint64_t activeWAll = 0, activeWSLO = 0, activeWBE = 0;
-        // Idle 寬限期：queue 暫空但尚在寬限內仍計入分母；超過寬限則暫停發放
-        for (auto &kv : users) {
-            auto &acc = kv.second;
-            bool emptyQ = acc.queue.empty() && acc.queueISC.empty();
-            if (acc.isActive) {
-                if (emptyQ) {
-                    if (acc.idlePeriods < UINT32_MAX) acc.idlePeriods++;
-                } else {
-                    acc.idlePeriods = 0;
-                }
-            }
-            if (acc.isActive) {
-                activeWAll += acc.weight;
-                if (acc.isSLO) activeWSLO += acc.weight; else activeWBE += acc.weight;
-            }
-        }
-
-        debugprint(LOG_HIL_CREDIT_SCHEDULER,
-                   "refill-phase: t=%" PRIu64 " activeW(all=%" PRIu64 ", slo=%" PRIu64 ", be=%" PRIu64 ")",
-                   lastGlobalRefillTick_, activeWAll, activeWSLO, activeWBE);
-
-        // 相位內彙總（便於 CREDSTAT）：只針對常見 UID 1001/1002（若不存在則為 0）
-        uint64_t add1001 = 0, add1002 = 0;
-
-        // SLO 先分配：若 SLO 有活躍者，整個 phase 的配額都屬於 SLO。
-        // 僅因 SLO 用戶達 cap 無法發放的部分才溢出給 BE；四捨五入的小數留在 SLO 的 carry，不外溢。
-        double phaseBudget = pagesPerPeriod_;
-        double spillToBE = 0.0;
-
-        if (activeWSLO > 0) {
-            // ★ Phase 2: Demand-Driven SLO Allocation (需求驱动分配)
-            // 根据 IOPS 目标计算需求，而非固定权重比例
-
-            // 计算周期时长 (秒)
-            double periodSec = static_cast<double>(periodTicks_) / static_cast<double>(ticksPerSec_);
-
-            // SLO 需求结构
-            struct SLODemand {
-                uint32_t uid;
-                uint64_t demand;     // 本期需要的 pages
-                uint64_t headroom;   // 可用空间 (cap - credit)
-                uint64_t grant;      // 实际分配量
-            };
-            std::vector<SLODemand> sloUsers;
-            uint64_t totalDemand = 0;
-            std::map<uint32_t, double> pendingCarry;
-
-            // === 第一轮: 计算每个 SLO 用户的需求 ===
-            for (auto &kv : users) {
-                auto &acc = kv.second;
-                if (!acc.isActive || !acc.isSLO) continue;
-
-                double demandRaw = 0.0;
-
-                if (acc.sloMode == UserAccount::SLOMode::IOPS_TARGET) {
-                    // IOPS 目标模式: targetIOPS * periodSec = 本期需求 pages
-                    demandRaw = acc.targetIOPS * periodSec;
-
-                } else if (acc.sloMode == UserAccount::SLOMode::TAIL_TARGET) {
-                    // Tail 模式 (Phase 3): 使用权重比例 * budgetBoost
-                    demandRaw = phaseBudget * static_cast<double>(acc.weight) /
-                                static_cast<double>(activeWSLO) * acc.budgetBoost;
-
-                } else {
-                    // NONE 模式: 退化为权重分配 (兼容现有用户)
-                    demandRaw = phaseBudget * static_cast<double>(acc.weight) /
-                                static_cast<double>(activeWSLO);
-                }
-
-                // 考虑 carry 累积
-                double sum = demandRaw + acc.carry;
-                uint64_t target = static_cast<uint64_t>(sum);          // 向下取整
-                double fractional = sum - std::floor(sum);              // 小数部分
-
-                uint64_t headroom = (acc.credit >= acc.creditCap) ?
-                                   0 : (acc.creditCap - acc.credit);
-
-                sloUsers.push_back({kv.first, target, headroom, 0});
-                totalDemand += target;
-                pendingCarry[kv.first] = fractional;
-
-                debugprint(LOG_HIL_CREDIT_SCHEDULER,
-                           "SLO-demand: uid=%u mode=%d demandRaw=%.2f target=%" PRIu64 " carry=%.4f",
-                           kv.first, static_cast<int>(acc.sloMode), demandRaw, target, fractional);
-            }
-
-            // === 第二轮: 根据总需求决定分配策略 ===
-            uint64_t totalGranted = 0;
-            uint64_t capacityInt = static_cast<uint64_t>(phaseBudget);
-
-            if (totalDemand <= capacityInt) {
-                // 情况A: 需求未满 → 满足所有 SLO，剩余给 BE
-                for (auto &sd : sloUsers) {
-                    sd.grant = std::min(sd.demand, sd.headroom);
-                    totalGranted += sd.grant;
-                }
-                spillToBE = static_cast<double>(capacityInt - totalGranted);
-
-                debugprint(LOG_HIL_CREDIT_SCHEDULER,
-                           "SLO-satisfied: totalDemand=%" PRIu64 " <= capacity=%" PRIu64
-                           ", totalGranted=%" PRIu64 ", spillToBE=%.0f",
-                           totalDemand, capacityInt, totalGranted, spillToBE);
-
-            } else {
-                // 情况B: 需求超载 → 按比例缩放 SLO，BE 得 0
-                double scale = (totalDemand > 0) ?
-                              static_cast<double>(capacityInt) / static_cast<double>(totalDemand) : 1.0;
-
-                for (auto &sd : sloUsers) {
-                    uint64_t scaled = static_cast<uint64_t>(std::floor(sd.demand * scale));
-                    sd.grant = std::min(scaled, sd.headroom);
-                    totalGranted += sd.grant;
-                }
-                spillToBE = 0.0;
-
-                debugprint(LOG_HIL_CREDIT_SCHEDULER,
-                           "SLO-overload: totalDemand=%" PRIu64 " > capacity=%" PRIu64
-                           ", scale=%.3f, totalGranted=%" PRIu64 ", BE gets 0",
-                           totalDemand, capacityInt, scale, totalGranted);
-            }
-
-            // === 第三轮: 实际分配 credit ===
-            for (auto &sd : sloUsers) {
-                auto &acc = users[sd.uid];
-                acc.credit += sd.grant;
-                acc.carry = pendingCarry[sd.uid];
-                acc.lastRefillTick = lastGlobalRefillTick_;
-
-                if (sd.grant > 0) {
-                    debugprint(LOG_HIL_CREDIT_SCHEDULER,
-                               "refill-SLO: uid=%u demand=%" PRIu64 " grant=%" PRIu64
-                               " carry=%.4f credit=%" PRIu64 " cap=%" PRIu64,
-                               sd.uid, sd.demand, sd.grant, acc.carry, acc.credit, acc.creditCap);
-
-                    if (sd.uid == 1001) add1001 += sd.grant;
-                    if (sd.uid == 1002) add1002 += sd.grant;
-                }
-            }
+    // (1) 閒置超過寬限的用戶退出，速率重分；每個控制窗口調整 tail boost
+    expireIdle(now);
+    if (now >= nextTailCheck_) {
+        tailControl(now);
+        nextTailCheck_ = now + TailWindowPeriods * periodTicks_;
+    }
 
-            // spillToBE 已在上面第二轮中计算完成
-        } else {
-            // 沒有 SLO 活躍者：全部配額可用於 BE
-            spillToBE = phaseBudget;
+    // (2) 睡到現在的用戶夠 credit 了，排進 ring_
+    wakeSleepers(now);
+
+    // (3) RR 交錯派發：每次從 ring_ 前端取一個用戶派 1 筆，還有工作就排回去
+    const size_t MAX_DISPATCH_PER_TICK = 4096; // 安全上限，避免無窮迴圈
+    const uint64_t grace = IdleGracePeriods * periodTicks_;
+    size_t dispatched = 0;
+
+    while (!ring_.empty() && dispatched < MAX_DISPATCH_PER_TICK) {
+        uint32_t slot = ring_.front();
+        ring_.pop_front();
+        auto &acc = table_[slot];
+        acc.inRing = false;
+
+        // 排進 ring_ 之後 credit 被外部扣走：改去睡
+        uint32_t head = headOf(acc);
+        if (head == NIL) continue;
+        if (!charge(acc, pool_[head].pages, now)) {
+            place(slot, now);
+            continue;
         }
 
-        // 將 SLO cap 溢出的部分給 BE（work-conserving）
-        if (spillToBE > 0.0 && activeWBE > 0) {
-            for (auto &kv : users) {
-                auto &acc = kv.second;
-                if (!acc.isActive || acc.isSLO) continue;
-
-                double exact   = spillToBE * (static_cast<double>(acc.weight) / static_cast<double>(activeWBE));
-                double sum     = exact + acc.carry;
-                uint64_t target   = static_cast<uint64_t>(sum);
-                uint64_t headroom = (acc.credit >= acc.creditCap) ? 0ULL : (acc.creditCap - acc.credit);
-                uint64_t add      = (target > headroom) ? headroom : target;
-                acc.carry  = sum - static_cast<double>(add);
-
-                acc.credit += add;
-                acc.lastRefillTick = lastGlobalRefillTick_;
-
-                if (add) {
-                    debugprint(LOG_HIL_CREDIT_SCHEDULER,
-                               "refill-BE: uid=%u add=%" PRIu64 " carry=%.4f credit=%" PRIu64 " cap=%" PRIu64 " w=%" PRIu64,
-                               (unsigned)kv.first, add, acc.carry, acc.credit, acc.creditCap, acc.weight);
-                }
-            }
+        uint32_t node = popHead(acc);
+        if (acc.pendingCount == 0) {
+            acc.idleSince = now;
+            idleTimers_.push({now + grace, slot, ++acc.idleGen});
+        } else {
+            place(slot, now);
         }
 
-        // 低噪音彙總：關心 1001/1002 的相位配額與目前 credit（若不存在則 0）
-        uint64_t c1 = 0, c2 = 0, w1 = 0, w2 = 0;
-        { auto it = users.find(1001); if (it != users.end()) { c1 = it->second.credit; w1 = it->second.weight; } }
-        { auto it = users.find(1002); if (it != users.end()) { c2 = it->second.credit; w2 = it->second.weight; } }
-        debugprint(LOG_HIL_CREDIT_SCHEDULER,
-                   "CREDSTAT: phase=%" PRIu64 " activeW=%" PRIu64 " pagesPerPeriod=%.2f add{1001}=%" PRIu64 " add{1002}=%" PRIu64
-                   " credit{1001}=%" PRIu64 " credit{1002}=%" PRIu64
-                   " expectedShare{1001}=%.3f expectedShare{1002}=%.3f",
-                   lastGlobalRefillTick_, activeWAll, pagesPerPeriod_, add1001, add1002, c1, c2,
-                   activeWAll > 0 ? static_cast<double>(w1) / activeWAll : 0.0,
-                   activeWAll > 0 ? static_cast<double>(w2) / activeWAll : 0.0);
-
-        // 推進到下一個固定相位
-        lastGlobalRefillTick_ += periodTicks_;
-    }
-    // (2) 先處理「一般延遲佇列」（deferredQueue）：credit 夠就扣、派發到 ICL
-    if (!deferredQueue.empty()) {
-        size_t n = deferredQueue.size();
-        for (size_t i = 0; i < n; ++i) {
-            DeferredRequest dr = deferredQueue.front();
-            deferredQueue.pop();
-            auto& acc = getOrCreateUser(dr.req.userID);
-            if (acc.credit >= dr.pages) {
-                acc.credit        -= dr.pages;
-                acc.totalConsumed += dr.pages;
-                if (dr.req.op == OpType::READ || dr.req.op == OpType::WRITE)
-                    acc.consumedHost += dr.pages;
-                else
-                    acc.consumedISC  += dr.pages;
-                // 允許 re-entrant
-                inTick = false;
-                dispatchICL(dr.req, now);
-                inTick = true;
-                debugprint(LOG_HIL_CREDIT_SCHEDULER,
-                           "resume[Q]: uid=%u after %" PRIu64 " ticks (pages=%" PRIu64 ") credit-left=%" PRIu64 " weight=%" PRIu64 " consumed=%" PRIu64,
-                           dr.req.userID, now - dr.deferTime, dr.pages, acc.credit, acc.weight, acc.totalConsumed);
-            } else {
-                deferredQueue.push(dr);
-            }
-        }
-    }
- 
-    // (2) 先處理「自訂 ISC 延遲回呼」：credit 夠就扣、呼叫上層 resume()
-    if (!deferredISC_.empty()) {
-        size_t n = deferredISC_.size();
-        for (size_t i = 0; i < n; ++i) {
-            DeferredCustom dc = deferredISC_.front();
-            deferredISC_.pop();
-            auto& acc = getOrCreateUser(dc.uid);
-            if (acc.credit >= dc.pages) {
-                acc.credit        -= dc.pages;
-                acc.totalConsumed += dc.pages;
-                acc.consumedISC   += dc.pages;
-                debugprint(LOG_HIL_CREDIT_SCHEDULER,
-                           "ISC-resume: uid=%u after %" PRIu64 " ticks (pages=%" PRIu64 ", credit-left=%" PRIu64 ")",
-                           dc.uid, now - dc.deferTime, dc.pages, acc.credit);
-                if (dc.resume) {
-                    // 避免回呼內部又觸發 tick() 造成 re-entrant 卡住
-                    inTick = false;
-                    dc.resume(dc.ctx, now);
-                    inTick = true;
-                }
-            } else {
-                deferredISC_.push(dc);
-            }
-        }
+        runWork(slot, pool_[node], now);
+        freeWork(node);
+        ++dispatched;
     }
-    
-    // (2.5) 處理延遲的 ICL 請求 - 已移除，改為FTL層直接執行
-
-    // ★ (2.6) NEW: 處理Non-blocking ISC Request Queue
-    processISCRequests(now);
-
-    // (3) 真正 RR 交錯派發：每輪最多派發 1 筆，再從 lastChosenUid 的下一位重啟
-    if (!users.empty()) {
-        const size_t MAX_DISPATCH_PER_TICK = 4096; // 安全上限，避免無窮迴圈
-        size_t rounds = 0;
-
-        auto try_dispatch_class = [&](bool isc)->bool {
-            uint32_t &last = isc ? lastChosenUidISC : lastChosenUid;
-            auto it = users.find(last);
-            if (it == users.end() || ++it == users.end()) it = users.begin();
-
-            size_t visited = 0;
-            while (visited++ < users.size()) {
-                if (it == users.end()) it = users.begin();
-                UserAccount &acc = it->second;
-                auto &Q = isc ? acc.queueISC : acc.queue;
-                if (!Q.empty()) {
-                    Request front = Q.front();
-                    if (!isc) {
-                        // Host 類請求：用 helper 以 credit 派發；不足時直接移入延遲佇列
-                        if (tryDispatchWithCredit(front, now)) {
-                            last = it->first;
-                            Q.pop();
-                            inTick = false;
-                            dispatchICL(front, now);
-                            inTick = true;
-                            debugprint(LOG_HIL_CREDIT_SCHEDULER,
-                                       "dispatch[HOST]: uid=%u pages=%" PRIu64 " credit-left=%" PRIu64
-                                       " totalConsumed=%" PRIu64 " weight=%" PRIu64 " Qsize=%zu cap=%" PRIu64,
-                                       (unsigned)last, (front.length + PageSz - 1) / PageSz, acc.credit, acc.totalConsumed, acc.weight, Q.size(), acc.creditCap);
-                            return true;
-                        } else {
-                            // 已放入 deferredQueue，不阻塞 RR
-                            Q.pop();
-                            debugprint(LOG_HIL_CREDIT_SCHEDULER,
-                                       "deferred[HOST]: uid=%u pages=%" PRIu64 " credit=%" PRIu64 " weight=%" PRIu64 " queued; Qsize=%zu",
-                                       (unsigned)it->first, (front.length + PageSz - 1) / PageSz, acc.credit, acc.weight, Q.size());
-                        }
-                    } else {
-                        // 保留原 ISC 分支（若仍有 gate 類工作流）
-                        uint64_t need = (front.length + PageSz - 1) / PageSz;
-                        if (acc.credit >= need) {
-                            acc.credit        -= need;
-                            acc.totalConsumed += need;
-                            acc.consumedISC   += need;
-                            last = it->first;
-                            Q.pop();
-                            debugprint(LOG_HIL_CREDIT_SCHEDULER,
-                                       "dispatch[ISC]: uid=%u need=%" PRIu64 " credit-left=%" PRIu64
-                                       " totalConsumed=%" PRIu64 " Qsize=%zu",
-                                       (unsigned)last, need, acc.credit, acc.totalConsumed, Q.size());
-                            return true;
-                        } else {
-                            // 若需要，也可改為移入延遲佇列；這裡一併統一
-                            DeferredRequest dr{front, need, now};
-                            deferredQueue.push(dr);
-                            Q.pop();
-                            debugprint(LOG_HIL_CREDIT_SCHEDULER,
-                                       "deferred[ISC]: uid=%u need=%" PRIu64 " credit=%" PRIu64,
-                                       (unsigned)it->first, need, acc.credit);
-                        }
-                    }
-                }
-                ++it;
-            }
-            return false;
-        };
 
+    // (4) 還有人在等：排下一次喚醒
+    armWake(now);
+
+    inTick = false;
+}
 
-        for (; rounds < MAX_DISPATCH_PER_TICK; ++rounds) {
-            bool dispatched = false;
-            // ★ 策略位：若要 normal-first，調換呼叫順序即可
-            dispatched = try_dispatch_class(/*isc=*/true)
-                      || try_dispatch_class(/*isc=*/false);
-            if (!dispatched) break;
+// ------------ 執行已扣款的工作 ----------------------------------------------
+// 每筆從 now 的副本派發：同一次喚醒放行的工作在各通道重疊，不互相墊高延遲
+void CreditScheduler::runWork(uint32_t slot, Work& w, uint64_t now)
+{
+    auto &acc = table_[slot];
+    acc.totalConsumed += w.pages;
+    uint64_t done = now;
+
+    switch (w.type) {
+        case WorkType::HOST:
+            // READ/WRITE 視為 HOST 類，其它保留給 ISC 類（若有）
+            if (w.op == OpType::READ || w.op == OpType::WRITE)
+                acc.consumedHost += w.pages;
+            else
+                acc.consumedISC  += w.pages;
+            dispatchICL(w, done);
+            finishWork(w, done);
+            break;
+        case WorkType::GATE:
+            acc.consumedISC += w.pages;
+            if (w.op == OpType::CREDIT_ONLY && acc.pendingGates)
+                acc.pendingGates -= 1;
+            finishWork(w, now);
+            break;
+        case WorkType::ISC_RESUME:
+            acc.consumedISC += w.pages;
+            if (w.resume) w.resume(w.ctx, now);
+            break;
+        case WorkType::ICL_READ: {
+            acc.consumedISC += w.pages;
+            uint64_t executionTick = std::max(w.tick, (uint64_t)now);
+            pICL->read(w.iclReq, executionTick);
+            done = executionTick;
+            break;
         }
     }
 
-    inTick = false;
+    // Host 記到 ICL 完成；ISC 的完成在上層，這裡記到扣款執行為止
+    if (done > w.deferTime) {
+        acc.latency.record(done - w.deferTime);
+        if (acc.sloMode == UserAccount::SLOMode::TAIL_TARGET)
+            acc.tailWindow.record(done - w.deferTime);
+    }
+
+    debugprint(LOG_HIL_CREDIT_SCHEDULER,
+               "dispatch: uid=%u type=%d pages=%" PRIu64 " waited=%" PRIu64
+               " credit-left=%" PRIu64 " totalConsumed=%" PRIu64 " pending=%" PRIu64,
+               acc.uid, int(w.type), w.pages, (uint64_t)now - w.deferTime,
+               acc.tokens / ticksPerSec_, acc.totalConsumed, acc.pendingCount);
 }
 
 // ------------ dispatch 到 ICL ----------------------------------------------
-void CreditScheduler::dispatchICL(const Request& req, Tick &t)
+void CreditScheduler::dispatchICL(Work& w, Tick &t)
 {
-    // ICL::Request 需要「非 const 參考」：建立可變副本避免 const 轉換錯誤
-    Request req_mut = req;
-    ICL::Request iclReq(req_mut);
+    auto &iclReq = w.iclReq;
 
     debugprint(LOG_HIL_CREDIT_SCHEDULER,
                "ICL: t=%" PRIu64 " uid=%u op=%d len=%" PRIu64,
-               (uint64_t)t, req.userID, int(req.op), (uint64_t)req.length);
+               (uint64_t)t, iclReq.userID, int(w.op), (uint64_t)iclReq.length);
 
-    switch (req.op) {
+    switch (w.op) {
         case OpType::READ:  pICL->read (iclReq, t); break;
         case OpType::WRITE: pICL->write(iclReq, t); break;
         default:            /* 管理/ISC 可自行擴充 */  break;
     }
 
     // === Phase 2: 累积 Host I/O 统计 (用于 IOPS 测量窗口) ===
-    if (req.op == OpType::READ || req.op == OpType::WRITE) {
-        auto &acc = getOrCreateUser(req.userID);
-        uint64_t pages = (req.length + PageSz - 1) / PageSz;
+    if (w.op == OpType::READ || w.op == OpType::WRITE) {
+        auto &acc = getOrCreateUser(iclReq.userID);
+        uint64_t pages = (iclReq.length + PageSz - 1) / PageSz;
         acc.winHostPages += pages;
         acc.winHostIOs += 1;
     }
 }
 
 // ------------ User 管理 ------------------------------------------------------
-CreditScheduler::UserAccount&
-CreditScheduler::getOrCreateUser(uint32_t uid)
+// uid 只在入口查一次 slotOf_，之後都用 slot 直接索引 table_
+uint32_t CreditScheduler::slotOf(uint32_t uid)
 {
-    auto it = users.find(uid);
-    if (it != users.end()) return it->second;
+    auto it = slotOf_.find(uid);
+    if (it != slotOf_.end()) return it->second;
 
-    UserAccount acc;
+    uint32_t slot = static_cast<uint32_t>(table_.size());
+    table_.emplace_back();
+    slotOf_.emplace(uid, slot);
 
     // 所有使用者一視同仁：weight = 1，視為 best-effort
-    acc.weight = 1;
-    acc.isSLO = false;
-    acc.sloMode = UserAccount::SLOMode::NONE;
-    acc.targetIOPS = 0.0;
-    acc.tailPercentile = 0.0;
-    acc.tailTargetUs = 0;
-
-    // 仍保留 credit cap 來限制累積
+    auto &acc = table_.back();
+    acc.uid = uid;
+
+    // 仍保留 credit cap 來限制累積（cap * ticksPerSec_ 個 token 不可溢位）
     acc.creditCap = static_cast<uint64_t>(pagesPerPeriod_ * 2000);
     if (acc.creditCap < 50) acc.creditCap = 50;
+    acc.creditCap = std::min(acc.creditCap, UINT64_MAX / ticksPerSec_);
 
     acc.winStartTick = SimpleSSD::getTick();
+    acc.lastRefillTick = acc.winStartTick;
 
-    users.emplace(uid, acc);
-
-    totalWeight_ = 0;
-    for (auto &kv : users) {
-        totalWeight_ += kv.second.weight;
-    }
+    totalWeight_ += acc.weight;
     debugprint(LOG_HIL_CREDIT_SCHEDULER,
-               "user created: uid=%u weight=%" PRIu64 " totalWeight=%" PRIu64,
-               uid, acc.weight, totalWeight_);
+               "user created: uid=%u slot=%u weight=%" PRIu64 " totalWeight=%" PRIu64,
+               uid, slot, acc.weight, totalWeight_);
 
-    return users[uid];
+    return slot;
+}
+
+const CreditScheduler::UserAccount*
+CreditScheduler::findUser(uint32_t uid) const
+{
+    auto it = slotOf_.find(uid);
+    return it == slotOf_.end() ? nullptr : &table_[it->second];
 }
 
 // ───────── Scheduler 統計介面（per-user credit）─────────
+// 用戶數不固定：總數之後登記 StatSlots 組 per-user 欄位，每次取值時依 statOrder()
+// 重新填入（活躍且工作最多的用戶在前），各組以 uid 欄位標示用戶，沒用到的 slot 值為 0
 void CreditScheduler::getStatList(std::vector<Stats> &list, std::string prefix) {
   Stats s;
-  
-  // (1) 總消耗
+
+  // (1) 總消耗與類別總體統計（Host / ISC）
   s.name = prefix + "credit.total.consumed";
   s.desc = "Total credit consumed (pages)";
   list.push_back(s);
-  
-  // (2) 每 user 消耗（固定順序：constructor 初始化的 statUsers_）
-  for (uint32_t uid : statUsers_) {
-    s.name = prefix + "credit.user.uid" + std::to_string(uid) + ".consumed";
-    s.desc = "Per-user credit consumed (pages)";
-    list.push_back(s);
-  }
-  // (2.5) 類別總體統計（Host / ISC）
   s.name = prefix + "credit.host.total.consumed";
   s.desc = "Total HOST-class credit consumed (pages)";
   list.push_back(s);
@@ -667,235 +825,309 @@ void CreditScheduler::getStatList(std::vector<Stats> &list, std::string prefix)
   s.desc = "Total ISC-class credit consumed (pages)";
   list.push_back(s);
 
-  // (2.6) 每 user 類別消耗（Host / ISC）
-  for (uint32_t uid : statUsers_) {
-    s.name = prefix + "credit.user.uid" + std::to_string(uid) + ".consumed.host";
+  // (2) 總體統計
+  s.name = prefix + "credit.pending";
+  s.desc = "Total requests awaiting credit";
+  list.push_back(s);
+  s.name = prefix + "credit.ready";
+  s.desc = "Total requests ready to dispatch";
+  list.push_back(s);
+  s.name = prefix + "credit.users.active";
+  s.desc = "Users currently holding a refill rate";
+  list.push_back(s);
+  s.name = prefix + "credit.users.registered";
+  s.desc = "Users ever seen by the scheduler";
+  list.push_back(s);
+
+  // (3) 每 slot：uid、消耗、隊列、完成延迟百分位（us）與 tail boost
+  static const char *pct[] = {"p50", "p99", "p999"};
+  for (uint32_t i = 0; i < StatSlots; ++i) {
+    std::string user = prefix + "credit.user." + std::to_string(i);
+
+    s.name = user + ".uid";
+    s.desc = "User ID in this slot (0 if unused)";
+    list.push_back(s);
+    s.name = user + ".consumed";
+    s.desc = "Per-user credit consumed (pages)";
+    list.push_back(s);
+    s.name = user + ".consumed.host";
     s.desc = "Per-user HOST-class credit consumed (pages)";
     list.push_back(s);
-  }
-  for (uint32_t uid : statUsers_) {
-    s.name = prefix + "credit.user.uid" + std::to_string(uid) + ".consumed.isc";
+    s.name = user + ".consumed.isc";
     s.desc = "Per-user ISC-class credit consumed (pages)";
     list.push_back(s);
-  }
-  // (3) 每 user 隊列中的請求數量
-  for (uint32_t uid : statUsers_) {
-    s.name = prefix + "credit.user.uid" + std::to_string(uid) + ".queue_size";
+    s.name = user + ".queue_size";
     s.desc = "Per-user pending requests in queue";
     list.push_back(s);
+    for (auto p : pct) {
+      s.name = user + ".latency." + p;
+      s.desc = std::string("Per-user ") + p + " completion latency (us)";
+      list.push_back(s);
+    }
+    s.name = user + ".budget_boost";
+    s.desc = "Per-user tail SLO budget boost";
+    list.push_back(s);
   }
-  
-  // (4) 總體統計
-  s.name = prefix + "credit.pending";
-  s.desc = "Total requests awaiting credit";
-  list.push_back(s);
-  
-  s.name = prefix + "credit.ready";
-  s.desc = "Total requests ready to dispatch";
-  list.push_back(s);
 }
 
 void CreditScheduler::getStatValues(std::vector<double>& val) {
+    const uint64_t now = SimpleSSD::getTick();
+
     // (1) 總消耗
     uint64_t consumed_total = 0;
     uint64_t consumed_host_total = 0;
     uint64_t consumed_isc_total  = 0;
-    for (auto const& kv : users){
-        consumed_total      += kv.second.totalConsumed;
-        consumed_host_total += kv.second.consumedHost;
-        consumed_isc_total  += kv.second.consumedISC;
+    for (auto const& acc : table_) {
+        consumed_total      += acc.totalConsumed;
+        consumed_host_total += acc.consumedHost;
+        consumed_isc_total  += acc.consumedISC;
     }
     val.push_back(static_cast<double>(consumed_total));
-
-    // (2) 每 user 消耗（若該 user 尚未建立，值為 0）
-    for (uint32_t uid : statUsers_) {
-        auto it = users.find(uid);
-        double v = (it == users.end()) ? 0.0 : static_cast<double>(it->second.totalConsumed);
-        val.push_back(v);
-    }
-    // (2.5) 類別總體統計（Host / ISC）
     val.push_back(static_cast<double>(consumed_host_total));
     val.push_back(static_cast<double>(consumed_isc_total));
 
-    // (2.6) 每 user 類別消耗
-    for (uint32_t uid : statUsers_) {
-        auto it = users.find(uid);
-        double hostv = (it == users.end()) ? 0.0 : static_cast<double>(it->second.consumedHost);
-        val.push_back(hostv);
-    }
-    for (uint32_t uid : statUsers_) {
-        auto it = users.find(uid);
-        double iscv = (it == users.end()) ? 0.0 : static_cast<double>(it->second.consumedISC);
-        val.push_back(iscv);
-    }
-     
-    // (3) 每 user 隊列中的請求數量（Host + ISC 總和）
-    for (uint32_t uid : statUsers_) {
-        auto it = users.find(uid);
-        double queueSize = 0.0;
-        if (it != users.end()) queueSize = static_cast<double>(it->second.queue.size() + it->second.queueISC.size());
-        val.push_back(queueSize);
-    }
-
-    // (4) 掃描所有 queue（含 ISC），估算 pending / ready
-    uint64_t pending = static_cast<uint64_t>(deferredQueue.size() + deferredISC_.size()); // 延遲請求也算等待中
+    // (2) 依派發順序估算 pending / ready：最前端夠 credit 的算 ready，之後全部視為欠 token
+    uint64_t pending = 0;
     uint64_t ready   = adminQueue.size();     // admin I/O 視為 ready
-    for (auto const& kv : users) {
-        const auto& acc = kv.second;
-        if (acc.queue.empty() && acc.queueISC.empty()) continue;
-        std::queue<Request> tmpA = acc.queueISC; // 先估 ISC
-        std::queue<Request> tmpB = acc.queue;    // 再估 Host
-        uint64_t creditLeft = acc.credit;
-        auto consume = [&](std::queue<Request>& tmpQ)->bool{
-          while (!tmpQ.empty()) {
-            const Request& rq = tmpQ.front();
-            uint64_t need = (rq.length + PageSz - 1) / PageSz;
-            if (creditLeft >= need) {
+    for (uint32_t slot : active_) {
+        const auto& acc = table_[slot];
+        if (acc.pendingCount == 0) continue;
+
+        uint64_t tokensLeft = tokensAt(acc, now);
+        bool short_ = false;
+        for (uint32_t p = 0; p < NumPrio; ++p) {
+            for (uint32_t n = acc.lists[p].head; n != NIL; n = pool_[n].next) {
+                uint64_t need = std::min(pool_[n].pages, acc.creditCap) * ticksPerSec_;
+                if (short_ || tokensLeft < need) {
+                    short_ = true;
+                    ++pending;
+                    continue;
+                }
+                tokensLeft -= need;
                 ++ready;
-                creditLeft -= need;
-                tmpQ.pop();
-            } else {
-                pending += tmpQ.size();   // 剩餘全部視為欠 token
-                return false;
             }
-          }
-          return true;
-        };
-        if (!consume(tmpA)) continue;
-            consume(tmpB);
-
+        }
     }
     val.push_back(static_cast<double>(pending));
     val.push_back(static_cast<double>(ready));
+    val.push_back(static_cast<double>(active_.size()));
+    val.push_back(static_cast<double>(table_.size()));
+
+    // (3) 每 slot 的用戶
+    const double ticksPerUs = static_cast<double>(ticksPerSec_) / 1e6;
+    std::vector<uint32_t> order = statOrder();
+    for (uint32_t i = 0; i < StatSlots; ++i) {
+        if (i >= order.size()) {
+            for (int k = 0; k < 8; ++k) val.push_back(0.0);
+            val.push_back(1.0);
+            continue;
+        }
 
+        const auto &acc = table_[order[i]];
+        val.push_back(static_cast<double>(acc.uid));
+        val.push_back(static_cast<double>(acc.totalConsumed));
+        val.push_back(static_cast<double>(acc.consumedHost));
+        val.push_back(static_cast<double>(acc.consumedISC));
+        val.push_back(static_cast<double>(acc.pendingCount));
+        for (double q : {0.5, 0.99, 0.999})
+            val.push_back(static_cast<double>(acc.latency.percentile(q)) / ticksPerUs);
+        val.push_back(acc.budgetBoost);
+    }
 }
+
+// 挑出要匯出的用戶：活躍用戶優先，其次等待中的工作多、已消耗多的；
+// 活躍用戶不足 StatSlots 時用閒置用戶補滿，同分依 uid 排序讓位置穩定
+std::vector<uint32_t> CreditScheduler::statOrder() const {
+    std::vector<uint32_t> order;
+    order.reserve(table_.size());
+    order.insert(order.end(), active_.begin(), active_.end());
+    for (uint32_t slot = 0; slot < table_.size(); ++slot)
+        if (table_[slot].activeIdx == NIL) order.push_back(slot);
+
+    auto busier = [this](uint32_t a, uint32_t b) {
+        const auto &x = table_[a];
+        const auto &y = table_[b];
+        bool xa = x.activeIdx != NIL;
+        bool ya = y.activeIdx != NIL;
+        if (xa != ya) return xa;
+        if (x.pendingCount != y.pendingCount) return x.pendingCount > y.pendingCount;
+        if (x.totalConsumed != y.totalConsumed) return x.totalConsumed > y.totalConsumed;
+        return x.uid < y.uid;
+    };
+
+    size_t n = std::min<size_t>(StatSlots, order.size());
+    std::partial_sort(order.begin(), order.begin() + n, order.end(), busier);
+    order.resize(n);
+    return order;
+}
+
 void CreditScheduler::resetStatValues() {
     debugprint(LOG_HIL_CREDIT_SCHEDULER, "stats: reset");
-    for (auto& kv : users) {
-        auto& acc = kv.second;
-        acc.credit         = 0;
-        acc.carry          = 0.0;
+    const uint64_t now = SimpleSSD::getTick();
+    // 只清統計與 token；等待中的工作仍保留，之後照常派發
+    // （ring_ 中的用戶派發時 credit 不夠會自己改去睡）
+    for (auto& acc : table_) {
+        acc.tokens         = 0;
         acc.totalConsumed  = 0;
         acc.consumedHost   = 0;
         acc.consumedISC    = 0;
-        acc.isActive       = false;
-        acc.lastRefillTick = SimpleSSD::getTick();
-        acc.pendingGates  = 0;
-        while (!acc.queueISC.empty()) acc.queueISC.pop();
+        acc.lastRefillTick = now;
+        acc.latency.reset();
+        acc.tailWindow.reset();
     }
-    while (!adminQueue.empty()) adminQueue.pop();
-    lastChosenUid = 0;
-    // 相位重置：下次啟動時再設定
-    lastGlobalRefillTick_ = 0;
+    rebalance(now);  // token 清空，睡著的用戶重算醒來時間
 }
 
 // ========= 外部查詢/扣款 API =========
 
 bool CreditScheduler::pendingForUser(uint32_t uid) const {
-    auto it = users.find(uid);
-    if (it == users.end()) return false;
-    return it->second.pendingGates != 0;  // 現在：只等「自己」塞的 gate 被吃掉
+    const UserAccount *acc = findUser(uid);
+    if (!acc) return false;
+    return acc->pendingGates != 0;  // 現在：只等「自己」塞的 gate 被吃掉
 }
 
 bool CreditScheduler::checkCredit(uint32_t uid, size_t need) const {
-    auto it = users.find(uid);
-    if (it == users.end()) {
+    const UserAccount *found = findUser(uid);
+    if (!found) {
         // Bootstrap: first sight of a user -> allow first request to flow into submitRequest()
-        // submitRequest() will create the account and start the timer/phase.
+        // submitRequest() will create the account and activate it.
         debugprint(LOG_HIL_CREDIT_SCHEDULER, "checkCredit: uid=%u NOT FOUND -> ALLOW bootstrap", uid);
         return true;
     }
-    
-    const auto &acc = it->second;
-    
+
+    const auto &acc = *found;
+    uint64_t credit = tokensAt(acc, SimpleSSD::getTick()) / ticksPerSec_;
+
     // 如果有足夠credit，允許
-    if (acc.credit >= need) {
-        debugprint(LOG_HIL_CREDIT_SCHEDULER, "checkCredit: uid=%u ALLOW (credit=%" PRIu64 " >= need=%zu)", 
-                   uid, acc.credit, need);
+    if (credit >= need) {
+        debugprint(LOG_HIL_CREDIT_SCHEDULER, "checkCredit: uid=%u ALLOW (credit=%" PRIu64 " >= need=%zu)",
+                   uid, credit, need);
         return true;
     }
-    
-    // 對於已初始化但還沒refill過的用戶（creditCap>0但credit=0），
-    // 允許第一個請求以啟動refill機制
-    if (acc.credit == 0 && acc.creditCap > 0 && acc.totalConsumed == 0) {
-        debugprint(LOG_HIL_CREDIT_SCHEDULER, "checkCredit: uid=%u ALLOW first request (credit=0, cap=%" PRIu64 ", consumed=%" PRIu64 ")", 
+
+    // 對於已初始化但還沒用過的用戶（credit=0），允許第一個請求以啟動 refill
+    if (credit == 0 && acc.creditCap > 0 && acc.totalConsumed == 0) {
+        debugprint(LOG_HIL_CREDIT_SCHEDULER, "checkCredit: uid=%u ALLOW first request (credit=0, cap=%" PRIu64 ", consumed=%" PRIu64 ")",
                    uid, acc.creditCap, acc.totalConsumed);
         return true;  // 允許第一個請求觸發refill
     }
-    
-    debugprint(LOG_HIL_CREDIT_SCHEDULER, "checkCredit: uid=%u REJECT (credit=%" PRIu64 " < need=%zu, consumed=%" PRIu64 ")", 
-               uid, acc.credit, need, acc.totalConsumed);
+
+    debugprint(LOG_HIL_CREDIT_SCHEDULER, "checkCredit: uid=%u REJECT (credit=%" PRIu64 " < need=%zu, consumed=%" PRIu64 ")",
+               uid, credit, need, acc.totalConsumed);
     return false;
 }
 
 void CreditScheduler::useCredit(uint32_t uid, size_t used) {
-    auto &acc = const_cast<CreditScheduler*>(this)->getOrCreateUser(uid);
-    uint64_t take = (used > acc.credit) ? acc.credit : used;
-    acc.credit        -= take;
+    auto &acc = getOrCreateUser(uid);
+    settle(acc, SimpleSSD::getTick());
+    uint64_t take = std::min<uint64_t>(used, acc.tokens / ticksPerSec_);
+    acc.tokens        -= take * ticksPerSec_;
     acc.totalConsumed += take;
 }
 
 void CreditScheduler::useCreditISC(uint32_t uid, size_t used) {
-    auto &acc = const_cast<CreditScheduler*>(this)->getOrCreateUser(uid);
-    uint64_t take = (used > acc.credit) ? acc.credit : used;
-    acc.credit        -= take;
+    auto &acc = getOrCreateUser(uid);
+    settle(acc, SimpleSSD::getTick());
+    uint64_t take = std::min<uint64_t>(used, acc.tokens / ticksPerSec_);
+    acc.tokens        -= take * ticksPerSec_;
     acc.totalConsumed += take;
     acc.consumedISC   += take;   // ★ 把 FTL 端直接扣款歸到 ISC
     debugprint(LOG_HIL_CREDIT_SCHEDULER,
                "charge[ISC]: uid=%u used=%" PRIu64 " credit-left=%" PRIu64
                " consumedISC=%" PRIu64 " totalConsumed=%" PRIu64,
-               uid, (uint64_t)used, acc.credit, acc.consumedISC, acc.totalConsumed);
+               uid, (uint64_t)used, acc.tokens / ticksPerSec_, acc.consumedISC,
+               acc.totalConsumed);
+}
+
+// slet 在自己的 simTick 上讀取，getTick() 整個指令期間不變，所以全部以 at 為準。
+// 欠款以 lastRefillTick 往後推表示：推過去的這段時間 bucket 不補充
+uint64_t CreditScheduler::chargeISCAt(uint32_t uid, uint64_t pages, uint64_t at) {
+    auto &acc = getOrCreateUser(uid);
+
+    // 沒有速率（SLO 吃滿）時等不到，照現有 token 扣，不擋讀取
+    uint64_t when = readyTick(acc, pages, at);
+    if (when == UINT64_MAX) when = at;
+
+    settle(acc, when);
+    uint64_t need = pages * ticksPerSec_;
+    if (acc.tokens >= need) {
+        acc.tokens -= need;
+    } else {
+        uint64_t debt = need - acc.tokens;
+        acc.tokens = 0;
+        if (acc.rate)
+            acc.lastRefillTick = std::max(acc.lastRefillTick, when) +
+                                 (debt + acc.rate - 1) / acc.rate;
+    }
+    acc.totalConsumed += pages;
+    acc.consumedISC   += pages;
+
+    debugprint(LOG_HIL_CREDIT_SCHEDULER,
+               "charge[ISC]: uid=%u pages=%" PRIu64 " at=%" PRIu64 " -> %" PRIu64
+               " refill-from=%" PRIu64 " consumedISC=%" PRIu64,
+               uid, pages, at, when, acc.lastRefillTick, acc.consumedISC);
+    return when;
 }
 
-// （選用）小工具
 // ------------ processUntil - 同步處理直到完成 --------------------------------
+// HIL 走 submit()；這裡給仍需同步結果的呼叫端。credit 不足時不逐步推進：由 token
+// 速率算出排在這筆之前（含）的工作都夠 credit 的時間，直接在該時間 tick 一次；
+// 只有速率在期間改變（有人加入）時才再算一次。完成時間只算這筆自己的派發。
 void CreditScheduler::processUntil(Request& req, uint64_t& completionTick) {
     debugprint(LOG_HIL_CREDIT_SCHEDULER,
                "processUntil: uid=%u op=%d len=%" PRIu64 " at=%" PRIu64,
                req.userID, int(req.op), req.length, completionTick);
 
-    // 提交到 scheduler
-    submitRequest(req);
-    
-    // 持續 tick 直到這個 request 被處理完
-    uint64_t maxIterations = 1000000; // 防止無限迴圈
-    uint64_t iterations = 0;
-    
-    while (iterations++ < maxIterations) {
-        tick(completionTick);
-        
-        // 檢查是否還有 pending requests for this user
-        bool hasPending = false;
-        auto it = users.find(req.userID);
-        if (it != users.end()) {
-            hasPending = !it->second.queue.empty() || !it->second.queueISC.empty();
-        }
-        hasPending = hasPending || !deferredQueue.empty() || !deferredISC_.empty();
-        
-        if (!hasPending) {
+    // 提交到 scheduler，並在當下嘗試派發
+    uint64_t done = UINT64_MAX;
+    uint32_t node = submitAt(req, completionTick, nullptr, &done);
+    tick(completionTick);
+
+    const uint32_t maxWakeups = 64;  // 防止速率為 0 之類永遠等不到的情況
+    uint32_t wakeups = 0;
+
+    // admin（node 為 NIL）已在 tick() 中派發
+    while (done == UINT64_MAX && node != NIL) {
+        const auto &acc = table_[slotOf(req.userID)];
+        if (wakeups++ >= maxWakeups) {
             debugprint(LOG_HIL_CREDIT_SCHEDULER,
-                       "processUntil: completed after %" PRIu64 " iterations", iterations);
+                       "processUntil: WARNING - uid=%u still short of %" PRIu64
+                       " pages after %u wakeups",
+                       req.userID, pagesAhead(acc, node), maxWakeups);
+            // 留在佇列的工作之後照常派發，不再回報到這裡
+            pool_[node].done = nullptr;
             break;
         }
-        
-        // 推進時間一點點，讓 credit refill 有機會發生
-        completionTick += periodTicks_ / 10;
-    }
-    
-    if (iterations >= maxIterations) {
+
+        // 超過 cap 的總量算不出來時，至少等到最前端的工作夠 credit
+        uint64_t ahead = pagesAhead(acc, node);
+        uint64_t at = predictCreditTick(req.userID, ahead, completionTick);
+        if (at <= completionTick)
+            at = predictCreditTick(req.userID, pool_[headOf(acc)].pages, completionTick);
+        if (at <= completionTick)
+            at = completionTick + 1;
+
         debugprint(LOG_HIL_CREDIT_SCHEDULER,
-                   "processUntil: WARNING - max iterations reached");
+                   "processUntil: uid=%u wait %" PRIu64 " pages until %" PRIu64
+                   " (+%" PRIu64 " ticks)",
+                   req.userID, ahead, at, at - completionTick);
+
+        completionTick = at;
+        tick(completionTick);
     }
+
+    if (done != UINT64_MAX)
+        completionTick = done;
 }
 
 void CreditScheduler::chargeUserCredit(uint32_t uid, uint64_t pages) { useCredit(uid, pages); }
 uint64_t CreditScheduler::getUserCredit(uint32_t uid) const {
-    auto it = users.find(uid);
-    return (it == users.end()) ? 0 : it->second.credit;
+    const UserAccount *acc = findUser(uid);
+    return acc ? tokensAt(*acc, SimpleSSD::getTick()) / ticksPerSec_ : 0;
 }
 uint64_t CreditScheduler::getUserWeight(uint32_t uid) const {
-    auto it = users.find(uid);
-    return (it == users.end()) ? 1 : it->second.weight;
+    const UserAccount *acc = findUser(uid);
+    return acc ? acc->weight : 1;
 }
 
 // ============================================================================
@@ -913,203 +1145,34 @@ uint64_t CreditScheduler::predictICLLatency(const ICL::Request& req, uint64_t) {
     return pagesLatency;
 }
 
-void CreditScheduler::submitICLDeferred(const ICL::Request& req, uint32_t uid, 
-                                      uint64_t tick, uint64_t latency, uint64_t pages) {
-    DeferredICLRequest deferredReq;
-    deferredReq.iclReq = req;
-    deferredReq.uid = uid;
-    deferredReq.tick = tick;
-    deferredReq.predictedLatency = latency;
-    deferredReq.pages = pages;
-    deferredReq.deferTime = SimpleSSD::getTick();
-    
-    deferredICL_.push(deferredReq);
-    
-    // debugprint removed to prevent log explosion
-}
+void CreditScheduler::submitICLDeferred(const ICL::Request& req, uint32_t uid,
+                                      uint64_t tick, uint64_t, uint64_t pages) {
+    uint32_t node = allocWork(WorkType::ICL_READ, pages);
+    pool_[node].iclReq = req;
+    pool_[node].tick   = tick;
+    enqueueWork(uid, node, SimpleSSD::getTick());
 
-void CreditScheduler::processDeferredICL(uint64_t) {
-    // 處理延遲的 ICL 請求：檢查是否有足夠 credit 可以執行
-    std::queue<DeferredICLRequest> remainingRequests;
-    
-    while (!deferredICL_.empty()) {
-        DeferredICLRequest& deferredReq = deferredICL_.front();
-        deferredICL_.pop();
-        
-        // 檢查用戶是否有足夠的 credit
-        if (checkCredit(deferredReq.uid, deferredReq.pages)) {
-            // 有足夠 credit，立即執行 ICL 請求
-            useCreditISC(deferredReq.uid, deferredReq.pages);
-            
-            debugprint(LOG_HIL_CREDIT_SCHEDULER,
-                       "processDeferredICL: EXECUTING uid=%u, pages=%" PRIu64 ", tick=%" PRIu64,
-                       deferredReq.uid, deferredReq.pages, deferredReq.tick);
-            
-            // 執行實際的 ICL 操作
-            uint64_t executionTick = deferredReq.tick;
-            pICL->read(deferredReq.iclReq, executionTick);
-            
-        } else {
-            // 仍無足夠 credit，重新放回佇列
-            remainingRequests.push(deferredReq);
-            // debugprint removed to prevent log explosion
-        }
-    }
-    
-    // 將仍無法執行的請求放回佇列
-    deferredICL_ = std::move(remainingRequests);
+    Tick now = SimpleSSD::getTick();
+    this->tick(now);
 }
 
-// ============================================================================
-// ★ NEW: Non-blocking ISC Request Queue Implementation
-// ============================================================================
-
-bool CreditScheduler::submitISCRequest(uint32_t uid, uint64_t pages, void* iscContext) {
-    debugprint(LOG_HIL_CREDIT_SCHEDULER,
-               "submitISCRequest: ENTRY uid=%u pages=%lu ctx=%p",
-               uid, pages, iscContext);
-
-    if (!iscContext) {
-        debugprint(LOG_HIL_CREDIT_SCHEDULER,
-                   "submitISCRequest: ERROR - null context!");
-        return false;
-    }
-
-    // 確保用戶已啟動，並且計時器在跑（供ISC路徑使用）
-    ensureActiveUser(uid);
+// 此用戶已在等的工作加上 pages 都夠 credit 還要多久
+uint64_t CreditScheduler::predictISCLatency(uint32_t uid, uint64_t pages, uint64_t waitStartTime) {
     auto &acc = getOrCreateUser(uid);
-
-    debugprint(LOG_HIL_CREDIT_SCHEDULER,
-               "submitISCRequest: uid=%u has credit=%lu, needs=%lu",
-               uid, acc.credit, pages);
-
-    if (acc.credit >= pages) {
-        // ★ Case 1: 有足夠credit - 立即執行
-        acc.credit -= pages;
-        acc.totalConsumed += pages;
-        acc.consumedISC += pages;
-
-        debugprint(LOG_HIL_CREDIT_SCHEDULER,
-                   "ISC-immediate: uid=%u pages=%lu credit-left=%lu, executing now",
-                   uid, pages, acc.credit);
-
-        // 立即執行，時間就是當前時間
-        uint64_t executionTick = getTick();
-        executeISCRequest(iscContext, executionTick);
-        return true;
-
-    } else {
-        // ★ Case 2: Credit不足 - 進入deferred queue
-        ISCDeferredRequest deferred{
-            .uid = uid,
-            .pagesNeeded = pages,
-            .iscContext = iscContext,
-            .submitTick = getTick(),
-            .estimatedLatency = predictISCLatency(pages, getTick())
-        };
-
-        deferredISCRequests_.push(deferred);
-
-        debugprint(LOG_HIL_CREDIT_SCHEDULER,
-                   "ISC-deferred: uid=%u pages=%lu queue_size=%zu estimated_wait=%lu",
-                   uid, pages, deferredISCRequests_.size(), deferred.estimatedLatency);
-
-        return true; // 成功提交到queue，非阻塞
-    }
+    uint64_t at = predictCreditTick(uid, acc.pendingPages + pages, waitStartTime);
+    return at > waitStartTime ? at - waitStartTime : 0;
 }
 
-void CreditScheduler::processISCRequests(uint64_t currentTick) {
-    std::queue<ISCDeferredRequest> remainingRequests;
-
-    while (!deferredISCRequests_.empty()) {
-        ISCDeferredRequest req = deferredISCRequests_.front();
-        deferredISCRequests_.pop();
-
-        auto &acc = getOrCreateUser(req.uid);
-
-        if (acc.credit >= req.pagesNeeded) {
-            // ★ Credit現在足夠 - 執行請求
-            acc.credit -= req.pagesNeeded;
-            acc.totalConsumed += req.pagesNeeded;
-            acc.consumedISC += req.pagesNeeded;
-
-            // ★ 關鍵：計算包含等待時間的執行時間
-            uint64_t waitTime = currentTick - req.submitTick;
-            uint64_t executionTick = req.submitTick + waitTime;
-
-            debugprint(LOG_HIL_CREDIT_SCHEDULER,
-                       "ISC-resume: uid=%u pages=%lu waited=%lu_ticks exec_at=%lu",
-                       req.uid, req.pagesNeeded, waitTime, executionTick);
-
-            executeISCRequest(req.iscContext, executionTick);
-
-        } else {
-            // ★ 仍無足夠credit - 放回queue繼續等待
-            remainingRequests.push(req);
-        }
-    }
-
-    deferredISCRequests_ = std::move(remainingRequests);
-}
-
-void CreditScheduler::executeISCRequest(void* iscContext, uint64_t executionTick) {
-    debugprint(LOG_HIL_CREDIT_SCHEDULER,
-               "executeISCRequest: ENTRY ctx=%p tick=%lu",
-               iscContext, executionTick);
-
-    if (!iscContext) {
-        debugprint(LOG_HIL_CREDIT_SCHEDULER,
-                   "executeISCRequest: ERROR - null context!");
-        return;
-    }
-
-    // ★ 將void*轉換回ISCRequestContext* (需要include FTL header)
-    auto* ctx = static_cast<SimpleSSD::ISC::SIM::ISCRequestContext*>(iscContext);
-
-    debugprint(LOG_HIL_CREDIT_SCHEDULER,
-               "executeISCRequest: ctx converted successfully, about to call callback");
-
-    try {
-        // ★ 使用新的function pointer callback機制
-        if (ctx->callback) {
-            debugprint(LOG_HIL_CREDIT_SCHEDULER,
-                       "executeISCRequest: calling callback with tick=%lu userData=%p",
-                       executionTick, ctx->callbackUserData);
-            ctx->callback(executionTick, ctx->callbackUserData);
-            debugprint(LOG_HIL_CREDIT_SCHEDULER,
-                       "executeISCRequest: callback completed successfully");
-        } else {
-            debugprint(LOG_HIL_CREDIT_SCHEDULER,
-                       "executeISCRequest: WARNING - callback is null!");
-        }
-    } catch (...) {
-        debugprint(LOG_HIL_CREDIT_SCHEDULER,
-                   "executeISCRequest: EXCEPTION caught during callback execution!");
-    }
-
-    // ★ 清理context資源
-    debugprint(LOG_HIL_CREDIT_SCHEDULER,
-               "executeISCRequest: deleting context %p", ctx);
-    delete ctx;
-    debugprint(LOG_HIL_CREDIT_SCHEDULER,
-               "executeISCRequest: context deleted, EXIT");
-}
-
-uint64_t CreditScheduler::predictISCLatency(uint64_t pages, uint64_t waitStartTime) {
-    (void)waitStartTime; // Suppress unused parameter warning
-
-    // 基於當前credit狀況預測等待時間
-    uint64_t refillPeriod = 10000000; // 10M ticks per refill cycle
-    uint64_t avgRefillAmount = 100;   // 平均每次refill的credit數量
-
-    // 估算需要多少refill cycles才能滿足請求
-    uint64_t estimatedCycles = (pages + avgRefillAmount - 1) / avgRefillAmount;
-    uint64_t estimatedWaitTime = estimatedCycles * refillPeriod;
+uint64_t CreditScheduler::predictCreditTick(uint32_t uid, uint64_t pages, uint64_t now) const {
+    const UserAccount *acc = findUser(uid);
+    if (!acc)
+        return now;
 
-    // 基於當前queue長度調整
-    uint64_t queuePenalty = deferredISCRequests_.size() * refillPeriod / 2;
+    // 由目前的 token 與 rate 直接算出（與 tick() 用同一個 bucket）
+    uint64_t at = readyTick(*acc, pages, now);
 
-    return estimatedWaitTime + queuePenalty;
+    // 沒有速率（未啟用或 SLO 吃滿）：至少等一個週期再看
+    return at == UINT64_MAX ? now + periodTicks_ : at;
 }
 
 // ============================================================================
@@ -1118,9 +1181,11 @@ uint64_t CreditScheduler::predictISCLatency(uint64_t pages, uint64_t waitStartTi
 
 void CreditScheduler::setUserIopsTarget(uint32_t uid, double iops) {
     auto &acc = getOrCreateUser(uid);
+    acc.isSLO = true;
     acc.sloMode = UserAccount::SLOMode::IOPS_TARGET;
     acc.targetIOPS = iops;
     acc.winStartTick = SimpleSSD::getTick();
+    if (acc.isActive) rebalance(acc.winStartTick);
 
     debugprint(LOG_HIL_CREDIT_SCHEDULER,
                "SLO-config: uid=%u mode=IOPS_TARGET target=%.0f IOPS",
@@ -1129,10 +1194,13 @@ void CreditScheduler::setUserIopsTarget(uint32_t uid, double iops) {
 
 void CreditScheduler::setUserTailTarget(uint32_t uid, double percentile, uint64_t target_us) {
     auto &acc = getOrCreateUser(uid);
+    acc.isSLO = true;
     acc.sloMode = UserAccount::SLOMode::TAIL_TARGET;
+    acc.budgetBoost = 1.0;
     acc.tailPercentile = percentile;
     acc.tailTargetUs = target_us;
     acc.winStartTick = SimpleSSD::getTick();
+    if (acc.isActive) rebalance(acc.winStartTick);
 
     debugprint(LOG_HIL_CREDIT_SCHEDULER,
                "SLO-config: uid=%u mode=TAIL_TARGET p%.2f target=%luus",
@@ -4,9 +4,11 @@
 
 #include "hil/scheduler/scheduler.hh"
 #include "sim/simulator.hh"      // SimpleSSD 的事件抽象（allocate/schedule/...）
+#include "util/histogram.hh"     // per-user latency histogram
 #include <unordered_map>
 #include <queue>
-#include <deque>  // Phase 2: for latSamples
+#include <deque>
+#include <functional>  // std::greater
 #include <vector>
 #include <cstdint>
 #include <cstddef>
@@ -21,15 +23,19 @@ using Tick = uint64_t;
 class CreditScheduler : public Scheduler
 {
   public:
-    // period_ticks：事件週期（tick）
-    // ticks_per_sec：每秒 tick 數（用來把「每秒頁數」換成「每 tick 的配額」）
+    // period_ticks：閒置寬限與 credit cap 的時間單位（tick）
+    // ticks_per_sec：每秒 tick 數（用來把「每秒頁數」換成 token）
     explicit CreditScheduler(ICL::ICL* icl, uint64_t period_ticks, uint64_t ticks_per_sec);
     ~CreditScheduler();
 
     // 對外唯一 API
     void submitRequest(Request& req) override;     // HIL 呼叫
-    void processEvent(uint64_t now);               // 週期事件回呼（由建構子排好）
+    void processEvent(uint64_t now);               // 喚醒事件回呼（有人在等 credit 才排程）
     void processUntil(Request& req, uint64_t& completionTick);  // 同步處理直到完成
+    // 非同步：請求排進用戶佇列，喚醒事件在 credit 夠時派發，派發後 complete()
+    void submit(Request* req) override;
+    void drain(RequestList& out) override;
+    bool holdsWork() const override;
  
     /* --- 統計介面 --- */
     void getStatList (std::vector<Stats>& list, std::string prefix) override;
@@ -46,7 +52,7 @@ class CreditScheduler : public Scheduler
                            void (*cb)(void* /*ctx*/, uint64_t /*now*/));
 
 
-    // 新增：嘗試以使用者 credit 派發一筆請求；若不足，將請求移至延遲佇列。
+    // 嘗試以使用者 credit 扣款；若不足，將請求排入該用戶的等待佇列。
     // 回傳 true 表示已完成扣款、可立刻派發；false 表示已被延遲。
     bool tryDispatchWithCredit(Request& req, Tick& now);
     
@@ -56,23 +62,21 @@ class CreditScheduler : public Scheduler
     void useCredit(uint32_t uid, size_t used) override;
     void useCreditISC(uint32_t uid, size_t used) override;
     
-    // ★ NEW: ICL Deferred Execution Support
-    // These methods support strict credit control for ISC tasks via ICL
+    // ICL Deferred Execution Support：credit 足夠時以 pICL->read 執行
     uint64_t predictICLLatency(const ICL::Request& req, uint64_t tick);
     void submitICLDeferred(const ICL::Request& req, uint32_t uid,
                           uint64_t tick, uint64_t latency, uint64_t pages);
-    void processDeferredICL(uint64_t now);
-
-    // ★ NEW: Non-blocking ISC Request Queue Support
-    // These methods implement the new architecture for ISC credit control
-    bool submitISCRequest(uint32_t uid, uint64_t pages, void* iscContext);
-    void processISCRequests(uint64_t currentTick);
-    void executeISCRequest(void* iscContext, uint64_t executionTick);
-    uint64_t predictISCLatency(uint64_t pages, uint64_t waitStartTime);
+
+    uint64_t predictISCLatency(uint32_t uid, uint64_t pages, uint64_t waitStartTime);
+    // Predict the tick when uid will have enough credit for pages
+    uint64_t predictCreditTick(uint32_t uid, uint64_t pages, uint64_t now) const;
+    // ISC 讀取的 credit gate：在呼叫端的模擬時間 at 評估，等到夠 credit 的時間扣全額，
+    // 回傳扣款的 tick；超過 cap 的讀取讓 bucket 欠款，之後的補充先還債
+    uint64_t chargeISCAt(uint32_t uid, uint64_t pages, uint64_t at);
     
-    // Ensure a user is active and the refill timer is started
+    // Ensure a user is active (has a refill rate)
     void ensureActiveUser(uint32_t uid);
-    // Expose scheduler refill period (ticks)
+    // Expose scheduler period (ticks)
     uint64_t getPeriodTicks() const { return periodTicks_; }
     
     // （選用）小工具：若你要在別處查詢/扣款
@@ -88,23 +92,83 @@ class CreditScheduler : public Scheduler
 
   private:
     // ------------------------------------------------------------
+    // 等待 credit 的工作：Host/ISC 請求、ISC 回呼、ICL 讀取都走同一個每用戶佇列
+    enum class WorkType : uint8_t {
+        GATE,         // CREDIT_ONLY / ISC_RESULT：只扣款
+        ISC_RESUME,   // submitISCDeferred 的回呼
+        ICL_READ,     // submitICLDeferred 的 ICL 讀取
+        HOST,         // 一般 Host I/O（派發到 ICL）
+    };
+
+    static constexpr uint32_t NIL = UINT32_MAX;  // 空索引（pool_ / table_）
+
+    // 工作節點放在 pool_ 重複使用，以 next 串成每用戶每優先級的 FIFO
+    struct Work {
+        WorkType     type;
+        uint64_t     pages;
+        uint64_t     deferTime;
+        OpType       op = OpType::READ;  // HOST / GATE
+        ICL::Request iclReq;      // HOST / GATE / ICL_READ
+        uint64_t     tick = 0;    // ICL_READ 的最早執行時間
+        void*        ctx = nullptr;
+        void       (*resume)(void*, uint64_t) = nullptr;
+        Request*     owner = nullptr;  // HOST / GATE：submit() 交來的，派發後 complete()
+        uint64_t*    done = nullptr;   // HOST / GATE：processUntil 等的完成時間
+        uint32_t     next = NIL;
+    };
+
+    struct WorkList {
+        uint32_t head = NIL;
+        uint32_t tail = NIL;
+    };
+
+    // 優先級：0 Gate，1 ISC 類，2 Host；同優先級 FIFO
+    static constexpr uint32_t NumPrio = 3;
+    static uint32_t prioOf(WorkType t) {
+        return t == WorkType::GATE ? 0 : t == WorkType::HOST ? 2 : 1;
+    }
+
+    // 某時間點要處理的用戶（睡到 credit 夠 / 閒置到期）；gen 不符的是過期項目
+    struct Timer {
+        uint64_t at;
+        uint32_t slot;
+        uint32_t gen;
+        bool operator>(const Timer& o) const { return at > o.at; }
+    };
+    typedef std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>> TimerQueue;
+
     // 基本型別
     struct UserAccount {
-        // === 基础字段 (Phase 1) ===
+        uint32_t   uid            = 0;
+
+        // === Token bucket ===
+        // tokens 以「1/ticksPerSec_ 頁」為單位，用整數累積：
+        //   tokens(now) = min(cap, tokens + (now - lastRefillTick) * rate)
+        // 不需週期事件，也沒有浮點 carry
         uint64_t   weight         = 1;
         uint64_t   creditCap      = 0;        // page
-        uint64_t   credit         = 0;        // 可用 token（page）
-        double     carry          = 0.0;      // 小數餘量累積
+        uint64_t   tokens         = 0;        // 截至 lastRefillTick 的 token
+        uint64_t   rate           = 0;        // pages / sec，由 rebalance() 設定
+        uint64_t   lastRefillTick = 0;        // 上次結算時間（tick）
         uint64_t   totalConsumed  = 0;
         uint64_t   consumedHost   = 0;        // ★ host 類 I/O 消耗
         uint64_t   consumedISC    = 0;        // ★ ISC 類 I/O 消耗
         bool       isSLO          = false;    // ★ 是否屬於 SLO 組（true）或 BE 組（false）
         bool       isActive       = false;
-        uint64_t   lastRefillTick = 0;        // 上次補充時間（tick）
-        uint32_t   idlePeriods    = 0;
+        uint32_t   activeIdx      = NIL;      // 在 active_ 中的位置
+        uint64_t   idleSince      = 0;        // 佇列清空的時間（tick）
+        uint32_t   idleGen        = 0;
         uint64_t   pendingGates   = 0;
-        std::queue<Request> queue;
-        std::queue<Request> queueISC;
+
+        // 等待 credit 的工作（pool_ 中的節點）
+        WorkList   lists[NumPrio];
+        uint64_t   pendingCount   = 0;
+        uint64_t   pendingPages   = 0;        // 所有等待工作需要的 pages
+
+        // 有工作時，用戶不是在 ring_（最前端夠 credit）就是在 sleepers_（等 credit）
+        bool       inRing         = false;
+        bool       sleeping       = false;
+        uint32_t   sleepGen       = 0;
 
         // === Phase 2: SLO 目标与测量字段 ===
         enum class SLOMode {
@@ -122,14 +186,25 @@ class CreditScheduler : public Scheduler
         uint64_t   winHostPages   = 0;        // 本窗口完成的 Host pages
         uint64_t   winHostIOs     = 0;        // 本窗口完成的 Host I/O 笔数
 
-        // Phase 3: Tail latency 保护 (预留)
+        // Phase 3: Tail latency 保护（tailControl() 调整 budgetBoost）
         double     tailPercentile = 0.99;     // p99
         uint64_t   tailTargetUs   = 0;        // 微秒, 例: 2000 = 2ms
         double     budgetBoost    = 1.0;      // 临时加码系数 (1.0-3.0)
-        std::deque<uint64_t> latSamples;      // 延迟样本 (ticks)
+
+        // 完成延迟 (ticks)：Host 到 ICL 完成、ISC 到扣款执行
+        LatencyHistogram latency;             // 累计，供 stats
+        LatencyHistogram tailWindow;          // 本控制窗口（只有 TAIL_TARGET 用户）
     };
 
     static constexpr uint32_t IdleGracePeriods = 100; // 增加寬限期以保持用戶在IO間隔期間active
+
+    // Tail 控制：每 TailWindowPeriods 個週期看一次窗口內的尾延迟
+    static constexpr uint32_t TailWindowPeriods = 100;
+    static constexpr uint64_t TailMinSamples    = 32;    // 样本太少不调整
+    static constexpr double   BoostMax          = 3.0;
+    static constexpr double   BoostUp           = 1.25;  // 超标时乘上
+    static constexpr double   BoostDown         = 0.95;  // 低于 TailSlack 时乘上
+    static constexpr double   TailSlack         = 0.8;
     
     // ------------------------------------------------------------
     // 常數
@@ -141,84 +216,74 @@ class CreditScheduler : public Scheduler
     // 成員
     ICL::ICL* pICL = nullptr;
 
-    std::queue<Request> adminQueue;
-    std::unordered_map<uint32_t, UserAccount> users;
-
-    uint32_t        lastChosenUid = 0;
-    uint32_t        lastChosenUidISC  = 0; 
-    bool            inTick        = false;
-    bool            timerStarted  = false;
-
-    // 週期事件（走 SimpleSSD 的模擬器抽象）
-    SimpleSSD::Event refillEvent   = 0;
-    uint64_t         periodTicks_  = 0;   // 事件週期（tick）
-    uint64_t         ticksPerSec_  = 0;   // 每秒 tick 數
+    std::queue<uint32_t> adminQueue;      // pool_ 節點，不經 credit
 
-    // 發佈到 stats 的「固定 user 列表」（避免初始化時沒有 user 導致無法對齊）
-    std::vector<uint32_t> statUsers_;     // 預設 {1001, 1002}
-    
-    // throughput-based 批量發放新增成員
-    double           pagesPerPeriod_ = 0.0;  // 每週期應發放的總 pages
-    uint64_t         totalWeight_    = 0;    // 所有用戶權重總和
+    // 用戶表：slot 連續編號（deque 擴充時既有元素位址不變）；uid 只在入口查一次
+    std::deque<UserAccount> table_;
+    std::unordered_map<uint32_t, uint32_t> slotOf_;
+    std::vector<uint32_t> active_;        // 有 rate 的用戶 slot（rebalance 只看這些）
 
-    // —— 新增：全域上次補發時間（節流，只在到期補發）——
-    uint64_t         lastGlobalRefillTick_ = 0;
+    // 有工作的用戶：最前端夠 credit 的在 ring_ 輪流派發，其餘按夠 credit 的時間睡著
+    std::deque<uint32_t> ring_;
+    TimerQueue      sleepers_;
+    TimerQueue      idleTimers_;          // 閒置寬限到期
 
-    // Work-conserving with SLO-first 配置（骨架）
-    bool             shareIdleCapacity_ = true;   // 是否僅在活躍者間分配（true）
-    uint64_t         sloWindowTicks_    = 0;      // 可選：SLO 視窗（未啟用保證時僅佔位）
+    std::deque<Work>      pool_;          // 工作節點
+    std::vector<uint32_t> freeWork_;
 
+    bool            inTick        = false;
 
-    // ---- 一般請求的延遲佇列（Host/ISC 的 Request 直接排入等待扣款）----
-    struct DeferredRequest {
-        Request   req;
-        uint64_t  pages;
-        uint64_t  deferTime;
-    };
-    std::queue<DeferredRequest> deferredQueue;
+    // 喚醒事件：只在有人等 credit（或閒置寬限到期會改變速率）時排程
+    SimpleSSD::Event wakeEvent     = 0;
+    uint64_t         wakeAt_       = 0;
+    uint64_t         nextTailCheck_ = 0;
+    uint64_t         periodTicks_  = 0;   // 寬限 / cap 的時間單位（tick）
+    uint64_t         ticksPerSec_  = 0;   // 每秒 tick 數
 
+    // stats 固定登記 StatSlots 個 per-user 欄位，取值時由 statOrder() 挑用戶填入
+    static constexpr uint32_t StatSlots = 32;
 
-    // ---- 自訂 ISC 延遲工作（回呼）----
-    struct DeferredCustom {
-        uint32_t uid = 0;
-        uint64_t pages = 0;
-        uint64_t deferTime = 0;
-        void*    ctx = nullptr;
-        void   (*resume)(void*, uint64_t) = nullptr;
-    };
-    std::queue<DeferredCustom> deferredISC_;
-
-    // ---- ICL 延遲佇列（專門處理 ICL 請求的延遲執行）----
-    struct DeferredICLRequest {
-        ICL::Request iclReq;
-        uint32_t uid = 0;
-        uint64_t tick = 0;
-        uint64_t predictedLatency = 0;
-        uint64_t pages = 0;
-        uint64_t deferTime = 0;
-    };
-    std::queue<DeferredICLRequest> deferredICL_;
-
-    // ---- Non-blocking ISC Request Queue ----
-    struct ISCDeferredRequest {
-        uint32_t uid;
-        uint64_t pagesNeeded;
-        void* iscContext;       // Points to ISCRequestContext from FTL layer
-        uint64_t submitTick;    // When request was submitted
-        uint64_t estimatedLatency; // Predicted processing latency
-    };
-    std::queue<ISCDeferredRequest> deferredISCRequests_;
+    double           pagesPerPeriod_ = 0.0;  // 每週期的總 pages（決定 credit cap）
+    uint64_t         totalWeight_    = 0;    // 所有用戶權重總和
 
     // ------------------------------------------------------------
     // 核心流程
-    void tick(Tick &now);                 // 補 token + RR 發 I/O
-    void dispatchICL(const Request& req, Tick &tickNow);
+    void tick(Tick &now);                 // 結算 + RR 發 I/O
+    void dispatchICL(Work& w, Tick &tickNow);
+    void runWork(uint32_t slot, Work& w, uint64_t now);
+    uint32_t submitAt(Request& req, uint64_t now, Request* owner = nullptr,
+                      uint64_t* done = nullptr);
+    void finishWork(Work& w, uint64_t tick);
+    uint64_t pagesAhead(const UserAccount& acc, uint32_t node) const;
+    void enqueueWork(uint32_t uid, uint32_t node, uint64_t now);
+
+    // 工作節點
+    uint32_t allocWork(WorkType type, uint64_t pages);
+    uint32_t allocHostWork(WorkType type, const Request& req);
+    void     freeWork(uint32_t node);
+    uint32_t headOf(const UserAccount& acc) const;
+    uint32_t popHead(UserAccount& acc);
+
+    // Token bucket
+    uint64_t tokensAt(const UserAccount& acc, uint64_t now) const;
+    void     settle(UserAccount& acc, uint64_t now);
+    bool     charge(UserAccount& acc, uint64_t pages, uint64_t now);
+    uint64_t readyTick(const UserAccount& acc, uint64_t pages, uint64_t now) const;
+
+    // 活躍集合、ring 與速率
+    void activate(uint32_t slot, uint64_t now);
+    void place(uint32_t slot, uint64_t now);
+    void wakeSleepers(uint64_t now);
+    void expireIdle(uint64_t now);
+    void rebalance(uint64_t now);
+    void armWake(uint64_t now);
+    void tailControl(uint64_t now);
 
     // 工具
-    UserAccount& getOrCreateUser(uint32_t uid);
-
-
-    
+    uint32_t slotOf(uint32_t uid);        // 不存在就建立
+    const UserAccount* findUser(uint32_t uid) const;
+    std::vector<uint32_t> statOrder() const;  // 匯出 stats 的用戶 slot
+    UserAccount& getOrCreateUser(uint32_t uid) { return table_[slotOf(uid)]; }
 };
 
 }  // namespace HIL
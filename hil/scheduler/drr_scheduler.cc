@@ -0,0 +1,500 @@
+/*
+ * Copyright (C) 2024
+ *
+ * This file is part of SimpleSSD.
+ *
+ * SimpleSSD is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * SimpleSSD is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with SimpleSSD.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "hil/scheduler/drr_scheduler.hh"
+
+#include <algorithm>
+#include <cinttypes>
+
+#include "util/algorithm.hh"
+#include "util/def.hh"
+
+namespace SimpleSSD {
+
+namespace HIL {
+
+#define PR_SECTION LOG_HIL_DRR_SCHEDULER
+
+DRRScheduler::DRRScheduler(ICL::ICL *icl, uint64_t tps)
+    : pICL(icl),
+      ticksPerSec(tps),
+      ticksPerByte((double)tps / (double)(PagesPerSec * PageSz)),
+      carry(0.0),
+      busyUntil(0),
+      inRun(false),
+      wakeAt(0) {
+  wakeEvent = SimpleSSD::allocate([this](uint64_t now) { run(now); });
+
+  debugprint(LOG_HIL_DRR_SCHEDULER,
+             "init: %" PRIu64 " pages/s, quantum %" PRIu64 " bytes",
+             PagesPerSec, QuantumBytes);
+}
+
+DRRScheduler::~DRRScheduler() {
+  if (SimpleSSD::scheduled(wakeEvent, nullptr))
+    SimpleSSD::deschedule(wakeEvent);
+  SimpleSSD::deallocate(wakeEvent);
+}
+
+uint32_t DRRScheduler::getSlot(uint32_t uid) {
+  auto it = slotOf.find(uid);
+  if (it != slotOf.end())
+    return it->second;
+
+  uint32_t slot = (uint32_t)table.size();
+  table.emplace_back();
+  table.back().uid = uid;
+  slotOf.emplace(uid, slot);
+
+  debugprint(LOG_HIL_DRR_SCHEDULER, "user created: uid=%u slot=%u", uid,
+             slot);
+
+  return slot;
+}
+
+void DRRScheduler::setUserWeight(uint32_t uid, uint64_t weight) {
+  table[getSlot(uid)].weight = weight ? weight : 1;
+}
+
+uint64_t DRRScheduler::getUserWeight(uint32_t uid) const {
+  auto it = slotOf.find(uid);
+
+  return it == slotOf.end() ? 1 : table[it->second].weight;
+}
+
+bool DRRScheduler::pendingForUser(uint32_t uid) const {
+  auto it = slotOf.find(uid);
+
+  return it != slotOf.end() && !table[it->second].queue.empty();
+}
+
+void DRRScheduler::enqueue(uint32_t uid, Work &w) {
+  uint32_t slot = getSlot(uid);
+  auto &acc = table[slot];
+
+  acc.queue.push_back(w);
+  if (!acc.inRing) {
+    acc.inRing = true;
+    acc.granted = false;
+    ring.push_back(slot);
+  }
+
+  debugprint(LOG_HIL_DRR_SCHEDULER,
+             "enqueue: uid=%u op=%d cost=%" PRIu64 " queue=%zu deficit=%" PRId64,
+             uid, (int)w.op, w.cost, acc.queue.size(), acc.deficit);
+}
+
+void DRRScheduler::submitRequest(Request &req) {
+  uint64_t now = SimpleSSD::getTick();
+
+  // admin commands are not shared between users
+  if (req.userID == 0) {
+    ICL::Request iclReq(req);
+
+    if (req.op == OpType::READ)
+      pICL->read(iclReq, now);
+    else if (req.op == OpType::WRITE)
+      pICL->write(iclReq, now);
+
+    return;
+  }
+
+  Work w;
+
+  w.cost = req.length;
+  w.pages = (req.length + PageSz - 1) / PageSz;
+  w.arrival = now;
+  w.op = req.op;
+  w.iclReq = ICL::Request(req);
+  w.owner = nullptr;
+  w.done = nullptr;
+
+  enqueue(req.userID, w);
+  run(now);
+}
+
+void DRRScheduler::processUntil(Request &req, uint64_t &completionTick) {
+  debugprint(LOG_HIL_DRR_SCHEDULER,
+             "processUntil: uid=%u op=%d len=%" PRIu64 " at=%" PRIu64,
+             req.userID, (int)req.op, req.length, completionTick);
+
+  if (req.userID == 0) {
+    ICL::Request iclReq(req);
+
+    if (req.op == OpType::READ)
+      pICL->read(iclReq, completionTick);
+    else if (req.op == OpType::WRITE)
+      pICL->write(iclReq, completionTick);
+
+    completionTick += applyLatency(CPU::DRR_SCHEDULER, CPU::SCHEDULE);
+
+    return;
+  }
+
+  uint64_t done = UINT64_MAX;
+  uint64_t now = completionTick;
+  Work w;
+
+  w.cost = req.length;
+  w.pages = (req.length + PageSz - 1) / PageSz;
+  w.arrival = now;
+  w.op = req.op;
+  w.iclReq = ICL::Request(req);
+  w.owner = nullptr;
+  w.done = &done;
+
+  enqueue(req.userID, w);
+  run(now);
+
+  // the request is still queued only while the server is busy: follow the
+  // server to each point it frees up, the others are served in turn meanwhile
+  while (done == UINT64_MAX && !inRun) {
+    now = std::max(now + 1, busyUntil);
+    run(now);
+  }
+
+  if (done == UINT64_MAX) {
+    // called back from a dispatch, the outer run() serves it later and must
+    // not report to this frame any more
+    warn("DRR: nested processUntil for uid %u", req.userID);
+
+    for (auto &q : table[getSlot(req.userID)].queue) {
+      if (q.done == &done)
+        q.done = nullptr;
+    }
+
+    done = now;
+  }
+
+  completionTick = done + applyLatency(CPU::DRR_SCHEDULER, CPU::SCHEDULE);
+}
+
+void DRRScheduler::submit(Request *req) {
+  // admin commands skip the turns, the base class runs them in a batch
+  if (req->userID == 0) {
+    Scheduler::submit(req);
+
+    return;
+  }
+
+  Work w;
+
+  w.cost = req->length;
+  w.pages = (req->length + PageSz - 1) / PageSz;
+  w.arrival = SimpleSSD::getTick();
+  w.op = req->op;
+  w.iclReq = ICL::Request(*req);
+  w.owner = req;
+  w.done = nullptr;
+
+  enqueue(req->userID, w);
+  run(w.arrival);
+}
+
+void DRRScheduler::drain(RequestList &out) {
+  for (auto &acc : table) {
+    std::deque<Work> keep;
+
+    for (auto &w : acc.queue) {
+      if (w.owner)
+        out.push(w.owner);
+      else
+        keep.push_back(w);
+    }
+
+    acc.queue.swap(keep);
+  }
+
+  std::deque<uint32_t> left;
+
+  for (uint32_t slot : ring) {
+    if (table[slot].queue.empty()) {
+      table[slot].inRing = false;
+      table[slot].granted = false;
+    }
+    else {
+      left.push_back(slot);
+    }
+  }
+
+  ring.swap(left);
+  armWake();
+
+  Scheduler::drain(out);
+}
+
+bool DRRScheduler::holdsWork() const {
+  for (auto &acc : table) {
+    for (auto &w : acc.queue) {
+      if (!w.owner)
+        return true;
+    }
+  }
+
+  return false;
+}
+
+void DRRScheduler::useCreditISC(uint32_t uid, size_t pages) {
+  if (uid == 0 || pages == 0)
+    return;
+
+  auto &acc = table[getSlot(uid)];
+  uint64_t bytes = pages * PageSz;
+
+  // the work already happened: pay for it from the next turns
+  acc.deficit -= (int64_t)bytes;
+  acc.consumedISC += pages;
+  acc.bytesISC += bytes;
+  occupy(bytes, SimpleSSD::getTick());
+
+  debugprint(LOG_HIL_DRR_SCHEDULER,
+             "charge[ISC]: uid=%u pages=%zu deficit=%" PRId64, uid, pages,
+             acc.deficit);
+}
+
+void DRRScheduler::occupy(uint64_t bytes, uint64_t now) {
+  double t = (double)bytes * ticksPerByte + carry;
+  uint64_t ticks = (uint64_t)t;
+
+  carry = t - (double)ticks;
+  busyUntil = std::max(busyUntil, now) + ticks;
+}
+
+void DRRScheduler::run(uint64_t now) {
+  // work submitted from a dispatch callback is only queued, this loop
+  // reaches it
+  if (inRun)
+    return;
+
+  inRun = true;
+
+  while (!ring.empty() && busyUntil <= now) {
+    uint32_t slot = ring.front();
+    auto &acc = table[slot];
+
+    if (!acc.granted) {
+      acc.deficit += (int64_t)(acc.weight * QuantumBytes);
+      acc.granted = true;
+    }
+
+    if ((int64_t)acc.queue.front().cost > acc.deficit) {
+      // turn is over, the deficit is kept for the next one
+      acc.granted = false;
+      ring.pop_front();
+      ring.push_back(slot);
+
+      continue;
+    }
+
+    Work w = acc.queue.front();
+
+    acc.queue.pop_front();
+    acc.deficit -= (int64_t)w.cost;
+
+    if (acc.queue.empty()) {
+      // an idle user does not bank its quantum, but keeps any debt
+      acc.deficit = std::min<int64_t>(acc.deficit, 0);
+      acc.inRing = false;
+      acc.granted = false;
+      ring.pop_front();
+    }
+
+    occupy(w.cost, now);
+    dispatch(acc, w, now);
+  }
+
+  armWake();
+
+  inRun = false;
+}
+
+void DRRScheduler::dispatch(UserAccount &acc, Work &w, uint64_t now) {
+  acc.waitTicks += now - std::min(now, w.arrival);
+  acc.dispatched++;
+
+  debugprint(LOG_HIL_DRR_SCHEDULER,
+             "dispatch: uid=%u op=%d cost=%" PRIu64 " waited=%" PRIu64
+             " deficit=%" PRId64 " busyUntil=%" PRIu64,
+             acc.uid, (int)w.op, w.cost, now - std::min(now, w.arrival),
+             acc.deficit, busyUntil);
+
+  // READ/WRITE are host I/O, anything else is accounted to ISC
+  uint64_t tick = now;
+
+  switch (w.op) {
+    case OpType::READ:
+      pICL->read(w.iclReq, tick);
+      break;
+    case OpType::WRITE:
+      pICL->write(w.iclReq, tick);
+      break;
+    default:
+      break;
+  }
+
+  if (w.op == OpType::READ || w.op == OpType::WRITE) {
+    acc.consumedHost += w.pages;
+    acc.bytesHost += w.cost;
+  }
+  else {
+    acc.consumedISC += w.pages;
+    acc.bytesISC += w.cost;
+  }
+
+  if (w.done)
+    *w.done = tick;
+  if (w.owner)
+    complete(w.owner, tick + applyLatency(CPU::DRR_SCHEDULER, CPU::SCHEDULE));
+}
+
+void DRRScheduler::armWake() {
+  bool armed = SimpleSSD::scheduled(wakeEvent, nullptr);
+
+  if (ring.empty()) {
+    if (armed)
+      SimpleSSD::deschedule(wakeEvent);
+
+    return;
+  }
+
+  uint64_t when = std::max(busyUntil, SimpleSSD::getTick());
+
+  if (armed) {
+    if (wakeAt == when)
+      return;
+
+    SimpleSSD::deschedule(wakeEvent);
+  }
+
+  SimpleSSD::schedule(wakeEvent, when);
+  wakeAt = when;
+}
+
+void DRRScheduler::getStatList(std::vector<Stats> &list, std::string prefix) {
+  Stats s;
+
+  s.name = prefix + "drr.total.consumed.host";
+  s.desc = "Total host pages dispatched";
+  list.push_back(s);
+
+  s.name = prefix + "drr.total.consumed.isc";
+  s.desc = "Total ISC pages charged";
+  list.push_back(s);
+
+  s.name = prefix + "drr.backlog";
+  s.desc = "Work items waiting for their turn";
+  list.push_back(s);
+
+  s.name = prefix + "drr.users.registered";
+  s.desc = "Users ever seen by the scheduler";
+  list.push_back(s);
+
+  // slots follow the order users are first seen, unused ones stay 0
+  for (uint32_t i = 0; i < StatSlots; i++) {
+    std::string user = prefix + "drr.user." + std::to_string(i);
+
+    s.name = user + ".uid";
+    s.desc = "User ID in this slot (0 if unused)";
+    list.push_back(s);
+
+    s.name = user + ".weight";
+    s.desc = "Per-user DRR weight";
+    list.push_back(s);
+
+    s.name = user + ".consumed.host";
+    s.desc = "Per-user host pages dispatched";
+    list.push_back(s);
+
+    s.name = user + ".consumed.isc";
+    s.desc = "Per-user ISC pages charged";
+    list.push_back(s);
+
+    s.name = user + ".bytes.host";
+    s.desc = "Per-user host bytes dispatched";
+    list.push_back(s);
+
+    s.name = user + ".bytes.isc";
+    s.desc = "Per-user ISC bytes charged";
+    list.push_back(s);
+
+    s.name = user + ".queue_size";
+    s.desc = "Per-user work items waiting";
+    list.push_back(s);
+
+    s.name = user + ".wait_avg";
+    s.desc = "Per-user average queueing delay (us)";
+    list.push_back(s);
+  }
+}
+
+void DRRScheduler::getStatValues(std::vector<double> &values) {
+  uint64_t host = 0;
+  uint64_t isc = 0;
+  uint64_t backlog = 0;
+
+  for (auto &acc : table) {
+    host += acc.consumedHost;
+    isc += acc.consumedISC;
+    backlog += acc.queue.size();
+  }
+
+  values.push_back((double)host);
+  values.push_back((double)isc);
+  values.push_back((double)backlog);
+  values.push_back((double)table.size());
+
+  const double ticksPerUs = (double)ticksPerSec / 1e6;
+
+  for (uint32_t i = 0; i < StatSlots; i++) {
+    if (i >= table.size()) {
+      values.insert(values.end(), 8, 0.0);
+
+      continue;
+    }
+
+    auto &acc = table[i];
+
+    values.push_back((double)acc.uid);
+    values.push_back((double)acc.weight);
+    values.push_back((double)acc.consumedHost);
+    values.push_back((double)acc.consumedISC);
+    values.push_back((double)acc.bytesHost);
+    values.push_back((double)acc.bytesISC);
+    values.push_back((double)acc.queue.size());
+    values.push_back(acc.dispatched ? (double)acc.waitTicks /
+                                          (double)acc.dispatched / ticksPerUs
+                                    : 0.0);
+  }
+}
+
+void DRRScheduler::resetStatValues() {
+  // queued work and deficits are scheduling state, only counters are reset
+  for (auto &acc : table) {
+    acc.consumedHost = 0;
+    acc.consumedISC = 0;
+    acc.bytesHost = 0;
+    acc.bytesISC = 0;
+    acc.waitTicks = 0;
+    acc.dispatched = 0;
+  }
+}
+
+}  // namespace HIL
+
+}  // namespace SimpleSSD
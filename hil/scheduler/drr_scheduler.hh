@@ -0,0 +1,131 @@
+/*
+ * Copyright (C) 2024
+ *
+ * This file is part of SimpleSSD.
+ *
+ * SimpleSSD is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * SimpleSSD is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with SimpleSSD.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __HIL_SCHEDULER_DRR_SCHEDULER__
+#define __HIL_SCHEDULER_DRR_SCHEDULER__
+
+#include <deque>
+#include <unordered_map>
+#include <vector>
+
+#include "hil/scheduler/scheduler.hh"
+#include "sim/simulator.hh"
+
+namespace SimpleSSD {
+
+namespace HIL {
+
+// Deficit round robin over users, in front of a device modeled as a server
+// draining PagesPerSec pages per second.
+//
+// Every user owns one FIFO of host I/O and a deficit counted in bytes. When a
+// user gets its turn the deficit grows by weight * QuantumBytes, and requests
+// are dispatched while the head fits in the deficit, each costing its exact
+// length in bytes. ISC reads are synchronous and only known in pages, they are
+// charged by useCreditISC() at pages * PageSz, which leaves the deficit in debt
+// until later turns pay it.
+//
+// Unlike the credit scheduler there is no refill: a backlogged user is served
+// as soon as the server frees up, so idle capacity is never held back.
+//
+// Requests handed over by submit() are dispatched from run() and completed
+// through the base class; processUntil() remains for synchronous callers.
+class DRRScheduler : public Scheduler {
+ public:
+  DRRScheduler(ICL::ICL *icl, uint64_t ticksPerSec);
+  ~DRRScheduler() override;
+
+  void submitRequest(Request &req) override;
+  void processUntil(Request &req, uint64_t &completionTick) override;
+  void submit(Request *req) override;
+  void drain(RequestList &out) override;
+  bool holdsWork() const override;
+
+  // ISC work done outside the queue (synchronous reads, result transfer)
+  void useCreditISC(uint32_t uid, size_t pages) override;
+
+  void setUserWeight(uint32_t uid, uint64_t weight);
+  uint64_t getUserWeight(uint32_t uid) const;
+
+  bool pendingForUser(uint32_t uid) const override;
+
+  void getStatList(std::vector<Stats> &, std::string) override;
+  void getStatValues(std::vector<double> &) override;
+  void resetStatValues() override;
+
+ private:
+  struct Work {
+    uint64_t cost;  // bytes
+    uint64_t pages;
+    uint64_t arrival;
+    OpType op;
+    ICL::Request iclReq;
+    Request *owner;  // from submit(): completed once dispatched
+    uint64_t *done;  // from processUntil: set to the ICL completion
+  };
+
+  struct UserAccount {
+    uint32_t uid = 0;
+    uint64_t weight = 1;
+    int64_t deficit = 0;  // bytes, negative while paying off ISC debt
+    bool inRing = false;
+    bool granted = false;  // quantum already added for the current turn
+
+    std::deque<Work> queue;
+
+    uint64_t consumedHost = 0;  // pages
+    uint64_t consumedISC = 0;   // pages
+    uint64_t bytesHost = 0;
+    uint64_t bytesISC = 0;
+    uint64_t waitTicks = 0;  // summed queueing delay of dispatched work
+    uint64_t dispatched = 0;
+  };
+
+  static constexpr uint64_t PageSz = 4096;
+  static constexpr uint64_t PagesPerSec = 12000;  // same device model as credit
+  static constexpr uint64_t QuantumBytes = 128 * 1024;
+  static constexpr uint32_t StatSlots = 32;
+
+  ICL::ICL *pICL;
+  uint64_t ticksPerSec;
+  double ticksPerByte;
+  double carry;  // fraction of a tick left from the last service time
+
+  std::deque<UserAccount> table;
+  std::unordered_map<uint32_t, uint32_t> slotOf;
+  std::deque<uint32_t> ring;  // slots with queued work, head has the turn
+
+  uint64_t busyUntil;  // server is occupied up to this tick
+  bool inRun;
+  Event wakeEvent;
+  uint64_t wakeAt;
+
+  uint32_t getSlot(uint32_t uid);
+  void enqueue(uint32_t uid, Work &w);
+  void run(uint64_t now);
+  void dispatch(UserAccount &acc, Work &w, uint64_t now);
+  void occupy(uint64_t bytes, uint64_t now);
+  void armWake();
+};
+
+}  // namespace HIL
+
+}  // namespace SimpleSSD
+
+#endif
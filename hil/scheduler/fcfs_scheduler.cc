@@ -41,7 +41,7 @@ FCFSScheduler::~FCFSScheduler() {
 
 void FCFSScheduler::submitRequest(Request &req) {
   auto &acc = getOrCreateUser(req.userID);
-  acc.queue.push(req);
+  acc.queue.emplace(req);
   acc.isActive = true;
   
   debugprint(LOG_HIL,
@@ -51,7 +51,7 @@ void FCFSScheduler::submitRequest(Request &req) {
 
 void FCFSScheduler::submitRequestISC(uint32_t uid, Request &req) {
   auto &acc = getOrCreateUser(uid);
-  acc.queueISC.push(req);
+  acc.queueISC.emplace(req);
   acc.isActive = true;
   
   debugprint(LOG_HIL,
@@ -93,14 +93,14 @@ bool FCFSScheduler::tryDispatchHost() {
     
     UserAccount &acc = it->second;
     if (!acc.queue.empty()) {
-      Request req = acc.queue.front();
+      Work w = acc.queue.front();
       acc.queue.pop();
       
       lastChosenUid = it->first;
-      dispatchRequest(req, acc, false); // Host I/O
+      dispatchRequest(w, acc, false); // Host I/O
       
       FCFS_DBG("FCFS dispatch[HOST]: uid=%u reqID=%lu pages=%lu hostQueue=%zu",
-               lastChosenUid, req.reqID, (req.length + PageSz - 1) / PageSz, acc.queue.size());
+               lastChosenUid, w.req.reqID, (w.req.length + PageSz - 1) / PageSz, acc.queue.size());
       return true;
     }
     ++it;
@@ -123,14 +123,14 @@ bool FCFSScheduler::tryDispatchISC() {
     
     UserAccount &acc = it->second;
     if (!acc.queueISC.empty()) {
-      Request req = acc.queueISC.front();
+      Work w = acc.queueISC.front();
       acc.queueISC.pop();
       
       lastChosenUidISC = it->first;
-      dispatchRequest(req, acc, true); // ISC
+      dispatchRequest(w, acc, true); // ISC
       
       FCFS_DBG("FCFS dispatch[ISC]: uid=%u reqID=%lu pages=%lu iscQueue=%zu",
-               lastChosenUidISC, req.reqID, (req.length + PageSz - 1) / PageSz, acc.queueISC.size());
+               lastChosenUidISC, w.req.reqID, (w.req.length + PageSz - 1) / PageSz, acc.queueISC.size());
       return true;
     }
     ++it;
@@ -138,13 +138,13 @@ bool FCFSScheduler::tryDispatchISC() {
   return false;
 }
 
-void FCFSScheduler::dispatchRequest(const Request& req, UserAccount&, bool) {
+void FCFSScheduler::dispatchRequest(Work& w, UserAccount&, bool) {
   // Calculate page consumption and record it (統一統計邏輯)
-  uint64_t pages = (req.length + PageSz - 1) / PageSz;
-  recordPageConsumptionByOpType(req.userID, pages, req.op);
+  uint64_t pages = (w.req.length + PageSz - 1) / PageSz;
+  recordPageConsumptionByOpType(w.req.userID, pages, w.op);
 
   // 使用統一的ICL調用方法 (模仿Credit Scheduler)
-  dispatchICL(req, currentTick);
+  dispatchICL(w, currentTick);
 }
 
 void FCFSScheduler::tick(uint64_t now) {
@@ -167,6 +167,15 @@ bool FCFSScheduler::pendingForUser(uint32_t uid) const {
   return false;
 }
 
+// nothing here comes from submit(), every queued entry stays with FCFS
+bool FCFSScheduler::holdsWork() const {
+  for (auto &it : users) {
+    if (!it.second.queue.empty() || !it.second.queueISC.empty())
+      return true;
+  }
+  return false;
+}
+
 FCFSScheduler::UserAccount& FCFSScheduler::getOrCreateUser(uint32_t uid) {
   auto it = users.find(uid);
   if (it == users.end()) {
@@ -209,24 +218,21 @@ void FCFSScheduler::recordPageConsumptionByOpType(uint32_t uid, uint64_t pages,
            static_cast<int>(op), acc.totalConsumed, acc.consumedHost, acc.consumedISC);
 }
 
-void FCFSScheduler::dispatchICL(const Request& req, uint64_t &tick) {
+void FCFSScheduler::dispatchICL(Work& w, uint64_t &tick) {
   // 與Credit Scheduler的dispatchICL完全相同的邏輯
-  Request reqCopy = req;
-  ICL::Request iclReq(reqCopy);
-  
   FCFS_DBG("FCFS ICL: t=%lu uid=%u op=%d len=%lu",
-           tick, req.userID, static_cast<int>(req.op), req.length);
+           tick, w.req.userID, static_cast<int>(w.op), w.req.length);
            
-  switch (req.op) {
+  switch (w.op) {
     case OpType::READ:
-      pICL->read(iclReq, tick);
+      pICL->read(w.req, tick);
       break;
     case OpType::WRITE:
-      pICL->write(iclReq, tick);
+      pICL->write(w.req, tick);
       break;
     default:
       // ISC tasks或其他OpType也能正確處理
-      FCFS_DBG("FCFS ICL: Unsupported OpType %d, skipping ICL call", static_cast<int>(req.op));
+      FCFS_DBG("FCFS ICL: Unsupported OpType %d, skipping ICL call", static_cast<int>(w.op));
       break;
   }
 }
@@ -4,6 +4,7 @@
 #include "hil/scheduler/scheduler.hh"
 #include <vector>
 #include <map>
+#include <queue>
 
 
 namespace SimpleSSD {
@@ -31,11 +32,20 @@ class FCFSScheduler : public Scheduler {
   void getStatValues(std::vector<double> &) override;
   void resetStatValues() override;
   bool pendingForUser(uint32_t uid) const override;
+  bool holdsWork() const override;
 
  protected:
   ICL::ICL* pICL;
   uint64_t currentTick = 0;
   
+  // Queued entry: ICL view of the request, the caller keeps the Request
+  struct Work {
+    ICL::Request req;
+    OpType op;
+
+    Work(const Request &r) : req(r), op(r.op) {}
+  };
+
   // Multi-User Architecture with ISC Support
   struct UserAccount {
     uint64_t totalConsumed = 0;
@@ -43,8 +53,8 @@ class FCFSScheduler : public Scheduler {
     uint64_t consumedISC = 0;     // ISC task consumption
     bool isActive = false;
     
-    std::queue<Request> queue;     // Host I/O requests (READ/WRITE)
-    std::queue<Request> queueISC;  // ISC task requests
+    std::queue<Work> queue;     // Host I/O requests (READ/WRITE)
+    std::queue<Work> queueISC;  // ISC task requests
   };
 
   // User management
@@ -71,8 +81,8 @@ class FCFSScheduler : public Scheduler {
   void reportPageConsumption();
   bool tryDispatchHost();
   bool tryDispatchISC();
-  void dispatchRequest(const Request& req, UserAccount&, bool);
-  void dispatchICL(const Request& req, uint64_t &tick);
+  void dispatchRequest(Work& w, UserAccount&, bool);
+  void dispatchICL(Work& w, uint64_t &tick);
 };
 
 }  // namespace HIL
@@ -0,0 +1,640 @@
+/*
+ * Copyright (C) 2024
+ *
+ * This file is part of SimpleSSD.
+ *
+ * SimpleSSD is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * SimpleSSD is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with SimpleSSD.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "hil/scheduler/flin_scheduler.hh"
+
+#include <algorithm>
+#include <cinttypes>
+
+#include "util/algorithm.hh"
+#include "util/def.hh"
+
+namespace SimpleSSD {
+
+namespace HIL {
+
+#define PR_SECTION LOG_HIL_FLIN_SCHEDULER
+
+constexpr uint32_t FLINScheduler::PrioWeight[];
+
+FLINScheduler::FLINScheduler(ICL::ICL *icl, uint64_t tps, uint64_t epoch,
+                             uint32_t intensity, double fairness,
+                             uint64_t writeWait)
+    : pICL(icl),
+      ticksPerSec(tps),
+      epochTicks(epoch),
+      intensityThreshold(intensity),
+      fairnessThreshold(fairness),
+      writeWaitLimit(writeWait),
+      epochEnd(epoch),
+      inRun(false),
+      wakeAt(0),
+      gcDeferred(0),
+      gcForced(0),
+      dieStalls(0) {
+  for (uint32_t c = 0; c < NumPrio; c++) {
+    for (uint32_t d = 0; d < NumDir; d++)
+      queues[c][d].firstHigh = queues[c][d].items.end();
+
+    turns[c] = PrioWeight[c];
+  }
+
+  serviceTicks[READ_QUEUE] = 0.0;
+  serviceTicks[WRITE_QUEUE] = 0.0;
+
+  wakeEvent = SimpleSSD::allocate([this](uint64_t now) { run(now); });
+
+  debugprint(LOG_HIL_FLIN_SCHEDULER,
+             "init: epoch %" PRIu64 " ticks, intensity %u, fairness %.2f, "
+             "write wait %" PRIu64 " ticks",
+             epochTicks, intensityThreshold, fairnessThreshold,
+             writeWaitLimit);
+}
+
+FLINScheduler::~FLINScheduler() {
+  if (SimpleSSD::scheduled(wakeEvent, nullptr))
+    SimpleSSD::deschedule(wakeEvent);
+  SimpleSSD::deallocate(wakeEvent);
+}
+
+uint32_t FLINScheduler::getSlot(uint32_t uid) {
+  auto it = slotOf.find(uid);
+  if (it != slotOf.end())
+    return it->second;
+
+  uint32_t slot = (uint32_t)table.size();
+  table.emplace_back();
+  table.back().uid = uid;
+  slotOf.emplace(uid, slot);
+
+  debugprint(LOG_HIL_FLIN_SCHEDULER, "user created: uid=%u slot=%u", uid,
+             slot);
+
+  return slot;
+}
+
+bool FLINScheduler::pendingForUser(uint32_t uid) const {
+  auto it = slotOf.find(uid);
+
+  return it != slotOf.end() && table[it->second].queued > 0;
+}
+
+void FLINScheduler::rollEpoch(uint64_t now) {
+  if (now < epochEnd)
+    return;
+
+  // a user silent for a whole epoch starts over as low intensity
+  bool stale = now >= epochEnd + epochTicks;
+
+  for (auto &f : table) {
+    f.high = !stale && f.epochArrivals > intensityThreshold;
+    f.epochArrivals = 0;
+  }
+
+  epochEnd = now + epochTicks;
+}
+
+double FLINScheduler::fairness(uint32_t &slowest) const {
+  double lo = 0.0;
+  double hi = 0.0;
+
+  slowest = UINT32_MAX;
+
+  for (uint32_t slot : backlog) {
+    double s = table[slot].slowdown;
+
+    if (slowest == UINT32_MAX || s > hi) {
+      hi = s;
+      slowest = slot;
+    }
+    if (lo == 0.0 || s < lo)
+      lo = s;
+  }
+
+  return backlog.size() < 2 ? 1.0 : lo / hi;
+}
+
+void FLINScheduler::enqueue(const Request &req, Request *owner,
+                            uint64_t *done, uint64_t now) {
+  rollEpoch(now);
+
+  uint32_t slot = getSlot(req.userID);
+  auto &f = table[slot];
+
+  // the class changes as soon as the epoch budget is exceeded
+  if (++f.epochArrivals > intensityThreshold && !f.high) {
+    f.high = true;
+
+    debugprint(LOG_HIL_FLIN_SCHEDULER, "uid=%u is high intensity", f.uid);
+  }
+
+  if (f.queued++ == 0) {
+    f.backlogIdx = (uint32_t)backlog.size();
+    backlog.push_back(slot);
+  }
+
+  uint32_t cls = std::min(req.prio, NumPrio - 1);
+  uint32_t dir = req.op == OpType::WRITE ? WRITE_QUEUE : READ_QUEUE;
+  auto &q = queues[cls][dir];
+  Work w;
+
+  w.iclReq = ICL::Request(req);
+  w.owner = owner;
+  w.slot = slot;
+  w.arrival = now;
+  w.done = done;
+
+  if (!f.high) {
+    // after all low-intensity work, ahead of every high-intensity one
+    q.items.insert(q.firstHigh, w);
+  }
+  else {
+    uint32_t slowest;
+
+    if (fairness(slowest) < fairnessThreshold && slowest == slot) {
+      q.firstHigh = q.items.insert(q.firstHigh, w);
+      f.boosted++;
+    }
+    else {
+      auto it = q.items.insert(q.items.end(), w);
+
+      if (q.firstHigh == q.items.end())
+        q.firstHigh = it;
+    }
+  }
+
+  debugprint(LOG_HIL_FLIN_SCHEDULER,
+             "enqueue: uid=%u prio=%u %s len=%" PRIu64 " high=%d queued=%" PRIu64,
+             f.uid, cls, dir == WRITE_QUEUE ? "W" : "R", req.length, f.high,
+             f.queued);
+}
+
+void FLINScheduler::submitRequest(Request &req) {
+  uint64_t now = SimpleSSD::getTick();
+
+  // admin commands are not shared between users
+  if (req.userID == 0) {
+    ICL::Request iclReq(req);
+
+    if (req.op == OpType::READ)
+      pICL->read(iclReq, now);
+    else if (req.op == OpType::WRITE)
+      pICL->write(iclReq, now);
+
+    return;
+  }
+
+  enqueue(req, nullptr, nullptr, now);
+  run(now);
+}
+
+void FLINScheduler::processUntil(Request &req, uint64_t &completionTick) {
+  debugprint(LOG_HIL_FLIN_SCHEDULER,
+             "processUntil: uid=%u op=%d len=%" PRIu64 " at=%" PRIu64,
+             req.userID, (int)req.op, req.length, completionTick);
+
+  if (req.userID == 0 ||
+      (req.op != OpType::READ && req.op != OpType::WRITE)) {
+    ICL::Request iclReq(req);
+
+    if (req.op == OpType::READ)
+      pICL->read(iclReq, completionTick);
+    else if (req.op == OpType::WRITE)
+      pICL->write(iclReq, completionTick);
+
+    completionTick += applyLatency(CPU::FLIN_SCHEDULER, CPU::SCHEDULE);
+
+    return;
+  }
+
+  uint64_t done = UINT64_MAX;
+  uint64_t now = completionTick;
+
+  enqueue(req, nullptr, &done, now);
+  run(now);
+
+  // still queued only while every die is busy: follow the dies until one
+  // frees up, queued work of others may go first
+  while (done == UINT64_MAX && !inRun) {
+    now = std::max(now + 1, wakeAt);
+    run(now);
+  }
+
+  if (done == UINT64_MAX) {
+    // called back from a dispatch, the outer run() serves it later and must
+    // not report to this frame any more
+    warn("FLIN: nested processUntil for uid %u", req.userID);
+
+    for (auto &q : queues[std::min(req.prio, NumPrio - 1)]) {
+      for (auto &w : q.items) {
+        if (w.done == &done)
+          w.done = nullptr;
+      }
+    }
+
+    done = now;
+  }
+
+  completionTick = done + applyLatency(CPU::FLIN_SCHEDULER, CPU::SCHEDULE);
+}
+
+void FLINScheduler::submit(Request *req) {
+  // admin and non-data commands do not compete for dies
+  if (req->userID == 0 ||
+      (req->op != OpType::READ && req->op != OpType::WRITE)) {
+    Scheduler::submit(req);
+
+    return;
+  }
+
+  uint64_t now = SimpleSSD::getTick();
+
+  enqueue(*req, req, nullptr, now);
+  run(now);
+}
+
+void FLINScheduler::drain(RequestList &out) {
+  for (uint32_t c = 0; c < NumPrio; c++) {
+    for (uint32_t d = 0; d < NumDir; d++) {
+      auto &q = queues[c][d];
+
+      for (auto it = q.items.begin(); it != q.items.end();) {
+        if (!it->owner) {
+          ++it;
+
+          continue;
+        }
+
+        auto &f = table[it->slot];
+
+        if (--f.queued == 0) {
+          uint32_t last = backlog.back();
+
+          backlog[f.backlogIdx] = last;
+          table[last].backlogIdx = f.backlogIdx;
+          backlog.pop_back();
+        }
+
+        out.push(it->owner);
+
+        if (it == q.firstHigh)
+          q.firstHigh++;
+        it = q.items.erase(it);
+      }
+    }
+  }
+
+  // what is left came from submitRequest(), let the next run() look at it
+  armWake(backlog.empty() ? UINT64_MAX : SimpleSSD::getTick());
+
+  Scheduler::drain(out);
+}
+
+bool FLINScheduler::holdsWork() const {
+  for (uint32_t c = 0; c < NumPrio; c++) {
+    for (uint32_t d = 0; d < NumDir; d++) {
+      for (auto &w : queues[c][d].items) {
+        if (!w.owner)
+          return true;
+      }
+    }
+  }
+
+  return false;
+}
+
+FLINScheduler::Queue &FLINScheduler::select(uint64_t now, bool gcPressure,
+                                            uint32_t &dir) {
+  // stage 2: weighted round robin over priority classes with work
+  uint32_t cls = NumPrio;
+
+  while (cls == NumPrio) {
+    for (uint32_t c = 0; c < NumPrio; c++) {
+      if (turns[c] > 0 && (!queues[c][READ_QUEUE].items.empty() ||
+                           !queues[c][WRITE_QUEUE].items.empty())) {
+        cls = c;
+
+        break;
+      }
+    }
+
+    if (cls == NumPrio) {
+      for (uint32_t c = 0; c < NumPrio; c++)
+        turns[c] = PrioWeight[c];
+    }
+  }
+
+  turns[cls]--;
+
+  // stage 3: read or write
+  auto &r = queues[cls][READ_QUEUE];
+  auto &w = queues[cls][WRITE_QUEUE];
+
+  if (r.items.empty() || w.items.empty()) {
+    dir = r.items.empty() ? WRITE_QUEUE : READ_QUEUE;
+  }
+  else {
+    uint64_t readWait = now - std::min(now, r.items.front().arrival);
+    uint64_t writeWait = now - std::min(now, w.items.front().arrival);
+
+    if (gcPressure) {
+      // writes bring GC closer and block reads behind it
+      if (writeWait >= writeWaitLimit) {
+        dir = WRITE_QUEUE;
+        gcForced++;
+      }
+      else {
+        dir = READ_QUEUE;
+        gcDeferred++;
+      }
+    }
+    else {
+      double readPW =
+          (double)readWait / std::max(serviceTicks[READ_QUEUE], 1.0);
+      double writePW =
+          (double)writeWait / std::max(serviceTicks[WRITE_QUEUE], 1.0);
+
+      dir = writePW > readPW ? WRITE_QUEUE : READ_QUEUE;
+    }
+  }
+
+  return queues[cls][dir];
+}
+
+void FLINScheduler::dispatch(Queue &q, uint32_t dir, uint64_t now) {
+  Work w = q.items.front();
+
+  if (q.firstHigh == q.items.begin())
+    q.firstHigh++;
+  q.items.pop_front();
+
+  auto &f = table[w.slot];
+
+  if (--f.queued == 0) {
+    uint32_t last = backlog.back();
+
+    backlog[f.backlogIdx] = last;
+    table[last].backlogIdx = f.backlogIdx;
+    backlog.pop_back();
+  }
+
+  uint64_t tick = now;
+  uint64_t pages = (w.iclReq.length + PageSz - 1) / PageSz;
+
+  if (dir == READ_QUEUE) {
+    pICL->read(w.iclReq, tick);
+    f.pagesRead += pages;
+  }
+  else {
+    pICL->write(w.iclReq, tick);
+    f.pagesWritten += pages;
+  }
+
+  double service = (double)std::max<uint64_t>(tick - now, 1);
+  double slowdown = (double)(tick - std::min(tick, w.arrival)) / service;
+
+  serviceTicks[dir] += Alpha * (service - serviceTicks[dir]);
+  f.slowdown += Alpha * (slowdown - f.slowdown);
+  f.waitTicks += now - std::min(now, w.arrival);
+  f.dispatched++;
+
+  debugprint(LOG_HIL_FLIN_SCHEDULER,
+             "dispatch: uid=%u %s waited=%" PRIu64 " service=%" PRIu64
+             " slowdown=%.2f",
+             f.uid, dir == WRITE_QUEUE ? "W" : "R",
+             now - std::min(now, w.arrival), tick - now, f.slowdown);
+
+  if (w.done)
+    *w.done = tick;
+  if (w.owner)
+    complete(w.owner, tick + applyLatency(CPU::FLIN_SCHEDULER, CPU::SCHEDULE));
+}
+
+void FLINScheduler::run(uint64_t now) {
+  // work submitted from a dispatch is only queued, this loop reaches it
+  if (inRun)
+    return;
+
+  inRun = true;
+
+  uint64_t next = UINT64_MAX;
+
+  while (!backlog.empty()) {
+    pICL->getFlashState(flash);
+
+    // without a die timeline from PAL, nothing holds work back
+    uint64_t idle = flash.dieBusyUntil.empty() ? UINT64_MAX : 0;
+
+    for (uint64_t busy : flash.dieBusyUntil) {
+      if (busy <= now)
+        idle++;
+      else
+        next = std::min(next, busy);
+    }
+
+    if (idle == 0) {
+      dieStalls++;
+
+      break;
+    }
+
+    bool gcPressure =
+        flash.freeBlockRatio < flash.gcThreshold * GCPressure;
+
+    for (; idle > 0 && !backlog.empty(); idle--) {
+      uint32_t dir;
+      auto &q = select(now, gcPressure, dir);
+
+      dispatch(q, dir, now);
+    }
+
+    next = UINT64_MAX;
+  }
+
+  armWake(backlog.empty() ? UINT64_MAX : next);
+
+  inRun = false;
+}
+
+void FLINScheduler::armWake(uint64_t when) {
+  bool armed = SimpleSSD::scheduled(wakeEvent, nullptr);
+
+  if (when == UINT64_MAX) {
+    if (armed)
+      SimpleSSD::deschedule(wakeEvent);
+
+    return;
+  }
+
+  when = std::max(when, SimpleSSD::getTick());
+
+  if (armed) {
+    if (wakeAt == when)
+      return;
+
+    SimpleSSD::deschedule(wakeEvent);
+  }
+
+  SimpleSSD::schedule(wakeEvent, when);
+  wakeAt = when;
+}
+
+void FLINScheduler::getStatList(std::vector<Stats> &list, std::string prefix) {
+  Stats s;
+
+  s.name = prefix + "flin.total.pages.read";
+  s.desc = "Total pages read";
+  list.push_back(s);
+
+  s.name = prefix + "flin.total.pages.write";
+  s.desc = "Total pages written";
+  list.push_back(s);
+
+  s.name = prefix + "flin.backlog";
+  s.desc = "Requests waiting for a die";
+  list.push_back(s);
+
+  s.name = prefix + "flin.users.registered";
+  s.desc = "Users ever seen by the scheduler";
+  list.push_back(s);
+
+  s.name = prefix + "flin.users.high";
+  s.desc = "Users classified as high intensity";
+  list.push_back(s);
+
+  s.name = prefix + "flin.fairness";
+  s.desc = "Min / max slowdown over backlogged users";
+  list.push_back(s);
+
+  s.name = prefix + "flin.gc.deferred";
+  s.desc = "Writes passed over for a read under GC pressure";
+  list.push_back(s);
+
+  s.name = prefix + "flin.gc.forced";
+  s.desc = "Writes released by the wait limit under GC pressure";
+  list.push_back(s);
+
+  s.name = prefix + "flin.die_stalls";
+  s.desc = "Scheduling attempts that found every die busy";
+  list.push_back(s);
+
+  // slots follow the order users are first seen, unused ones stay 0
+  for (uint32_t i = 0; i < StatSlots; i++) {
+    std::string user = prefix + "flin.user." + std::to_string(i);
+
+    s.name = user + ".uid";
+    s.desc = "User ID in this slot (0 if unused)";
+    list.push_back(s);
+
+    s.name = user + ".high";
+    s.desc = "Per-user high intensity flag";
+    list.push_back(s);
+
+    s.name = user + ".slowdown";
+    s.desc = "Per-user average turnaround / service time";
+    list.push_back(s);
+
+    s.name = user + ".queue_size";
+    s.desc = "Per-user requests waiting";
+    list.push_back(s);
+
+    s.name = user + ".pages.read";
+    s.desc = "Per-user pages read";
+    list.push_back(s);
+
+    s.name = user + ".pages.write";
+    s.desc = "Per-user pages written";
+    list.push_back(s);
+
+    s.name = user + ".wait_avg";
+    s.desc = "Per-user average queueing delay (us)";
+    list.push_back(s);
+
+    s.name = user + ".boosted";
+    s.desc = "Per-user requests queued ahead for fairness";
+    list.push_back(s);
+  }
+}
+
+void FLINScheduler::getStatValues(std::vector<double> &values) {
+  uint64_t read = 0;
+  uint64_t written = 0;
+  uint64_t queued = 0;
+  uint64_t high = 0;
+  uint32_t slowest;
+
+  for (auto &f : table) {
+    read += f.pagesRead;
+    written += f.pagesWritten;
+    queued += f.queued;
+    high += f.high ? 1 : 0;
+  }
+
+  values.push_back((double)read);
+  values.push_back((double)written);
+  values.push_back((double)queued);
+  values.push_back((double)table.size());
+  values.push_back((double)high);
+  values.push_back(fairness(slowest));
+  values.push_back((double)gcDeferred);
+  values.push_back((double)gcForced);
+  values.push_back((double)dieStalls);
+
+  const double ticksPerUs = (double)ticksPerSec / 1e6;
+
+  for (uint32_t i = 0; i < StatSlots; i++) {
+    if (i >= table.size()) {
+      values.insert(values.end(), 8, 0.0);
+
+      continue;
+    }
+
+    auto &f = table[i];
+
+    values.push_back((double)f.uid);
+    values.push_back(f.high ? 1.0 : 0.0);
+    values.push_back(f.slowdown);
+    values.push_back((double)f.queued);
+    values.push_back((double)f.pagesRead);
+    values.push_back((double)f.pagesWritten);
+    values.push_back(f.dispatched ? (double)f.waitTicks /
+                                        (double)f.dispatched / ticksPerUs
+                                  : 0.0);
+    values.push_back((double)f.boosted);
+  }
+}
+
+void FLINScheduler::resetStatValues() {
+  // queues, intensity and slowdown are scheduling state
+  for (auto &f : table) {
+    f.dispatched = 0;
+    f.pagesRead = 0;
+    f.pagesWritten = 0;
+    f.waitTicks = 0;
+    f.boosted = 0;
+  }
+
+  gcDeferred = 0;
+  gcForced = 0;
+  dieStalls = 0;
+}
+
+}  // namespace HIL
+
+}  // namespace SimpleSSD
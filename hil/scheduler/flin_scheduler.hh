@@ -0,0 +1,155 @@
+/*
+ * Copyright (C) 2024
+ *
+ * This file is part of SimpleSSD.
+ *
+ * SimpleSSD is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * SimpleSSD is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with SimpleSSD.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __HIL_SCHEDULER_FLIN_SCHEDULER__
+#define __HIL_SCHEDULER_FLIN_SCHEDULER__
+
+#include <deque>
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+#include "ftl/ftl.hh"
+#include "hil/scheduler/scheduler.hh"
+#include "sim/simulator.hh"
+
+namespace SimpleSSD {
+
+namespace HIL {
+
+// Flash-interference-aware scheduling after FLIN, in three stages:
+//
+//  1. Fairness-aware insertion. Users are classified per epoch as low or high
+//     intensity by arrival count. Work of low-intensity users is queued ahead
+//     of all high-intensity work, so a noisy neighbor cannot bury it. High
+//     intensity work goes to the tail, except for the most slowed-down user
+//     while fairness (min / max slowdown) is below fairnessThreshold.
+//  2. Priority-aware selection. Requests carry the priority class the host
+//     driver puts in command dword 2 (SQEntry::reserved1, 0 is the highest),
+//     and classes are served in weighted round robin.
+//  3. Wait-balancing and GC-aware dispatch. Within a class the read or write
+//     head with the larger wait relative to its expected service time goes
+//     first. While the FTL is close to its GC threshold, reads are preferred
+//     and writes only pass once they waited writeWaitLimit ticks.
+//
+// The HIL does not know where a request lands, so there is one device-wide
+// set of queues, and work is released only while PAL reports an idle die.
+// Requests handed over by submit() are dispatched from run() and completed
+// through the base class.
+class FLINScheduler : public Scheduler {
+ public:
+  FLINScheduler(ICL::ICL *icl, uint64_t ticksPerSec, uint64_t epochTicks,
+                uint32_t intensityThreshold, double fairnessThreshold,
+                uint64_t writeWaitLimit);
+  ~FLINScheduler() override;
+
+  void submitRequest(Request &req) override;
+  void processUntil(Request &req, uint64_t &completionTick) override;
+  void submit(Request *req) override;
+  void drain(RequestList &out) override;
+  bool holdsWork() const override;
+
+  bool pendingForUser(uint32_t uid) const override;
+
+  void getStatList(std::vector<Stats> &, std::string) override;
+  void getStatValues(std::vector<double> &) override;
+  void resetStatValues() override;
+
+ private:
+  enum { READ_QUEUE, WRITE_QUEUE, NumDir };
+
+  struct Work {
+    ICL::Request iclReq;
+    Request *owner;  // from submit(): completed once dispatched
+    uint32_t slot;
+    uint64_t arrival;
+    uint64_t *done;  // from processUntil: set to the ICL completion
+  };
+
+  struct Queue {
+    std::list<Work> items;
+    std::list<Work>::iterator firstHigh;  // items.end() if none queued
+  };
+
+  struct Flow {
+    uint32_t uid = 0;
+
+    // stage 1
+    uint64_t epochArrivals = 0;
+    bool high = false;
+    double slowdown = 1.0;  // EWMA of turnaround / service time
+    uint64_t queued = 0;
+    uint32_t backlogIdx = 0;
+
+    uint64_t dispatched = 0;
+    uint64_t pagesRead = 0;
+    uint64_t pagesWritten = 0;
+    uint64_t waitTicks = 0;
+    uint64_t boosted = 0;  // inserted ahead of other high-intensity work
+  };
+
+  static constexpr uint64_t PageSz = 4096;
+  static constexpr uint32_t NumPrio = 4;
+  static constexpr uint32_t PrioWeight[NumPrio] = {8, 4, 2, 1};
+  static constexpr double Alpha = 0.125;  // EWMA gain
+  static constexpr double GCPressure = 2.0;  // x GC threshold free ratio
+  static constexpr uint32_t StatSlots = 32;
+
+  ICL::ICL *pICL;
+  uint64_t ticksPerSec;
+  uint64_t epochTicks;
+  uint32_t intensityThreshold;
+  double fairnessThreshold;
+  uint64_t writeWaitLimit;
+
+  std::deque<Flow> table;
+  std::unordered_map<uint32_t, uint32_t> slotOf;
+  std::vector<uint32_t> backlog;  // slots with queued work
+
+  Queue queues[NumPrio][NumDir];
+  uint32_t turns[NumPrio];  // WRR turns left in this round
+
+  double serviceTicks[NumDir];  // EWMA of ICL latency
+  uint64_t epochEnd;
+  FTL::FlashState flash;
+
+  bool inRun;
+  Event wakeEvent;
+  uint64_t wakeAt;
+
+  uint64_t gcDeferred;  // writes passed over for a read under GC pressure
+  uint64_t gcForced;    // writes released by writeWaitLimit under GC pressure
+  uint64_t dieStalls;   // runs that found every die busy
+
+  uint32_t getSlot(uint32_t uid);
+  void rollEpoch(uint64_t now);
+  double fairness(uint32_t &slowest) const;
+  void enqueue(const Request &req, Request *owner, uint64_t *done,
+               uint64_t now);
+  void run(uint64_t now);
+  Queue &select(uint64_t now, bool gcPressure, uint32_t &dir);
+  void dispatch(Queue &q, uint32_t dir, uint64_t now);
+  void armWake(uint64_t when);
+};
+
+}  // namespace HIL
+
+}  // namespace SimpleSSD
+
+#endif
@@ -26,31 +26,55 @@ namespace SimpleSSD {
 namespace HIL {
 
 Scheduler::Scheduler() : currentTick(0) {
+  batchEvent =
+      SimpleSSD::allocate([this](uint64_t now) { processBatch(now); });
+
   debugprint(LOG_HIL, "Scheduler initialized");
 }
 
 Scheduler::~Scheduler() {
+  if (SimpleSSD::scheduled(batchEvent, nullptr))
+    SimpleSSD::deschedule(batchEvent);
+  SimpleSSD::deallocate(batchEvent);
+
   debugprint(LOG_HIL, "Scheduler destroyed");
 }
 
-void Scheduler::submitRequest(Request &req) {
-  debugprint(LOG_HIL, "Scheduler | Submit request %" PRIu64 " | Type %s | Size %" PRIu64,
-             req.reqID,
-             req.range.slpn == 0 ? "READ" : "WRITE",
-             req.length);
-  requestQueue.push(req);
+void Scheduler::submit(Request *req) {
+  pendingQueue.push(req);
+
+  // 同一 tick 送來的請求在同一個事件中處理
+  if (!SimpleSSD::scheduled(batchEvent, nullptr))
+    SimpleSSD::schedule(batchEvent, SimpleSSD::getTick());
 }
 
-void Scheduler::schedule() {
-  // 基本的 FCFS 排程
-  if (!requestQueue.empty()) {
-    Request req = requestQueue.front();
-    requestQueue.pop();
-    
-    debugprint(LOG_HIL, "Scheduler | Process request %" PRIu64 " | Type %s | Size %" PRIu64,
-               req.reqID,
-               req.range.slpn == 0 ? "READ" : "WRITE",
-               req.length);
+void Scheduler::processBatch(uint64_t now) {
+  RequestList batch;
+
+  // 處理中才送來的請求留給下一個事件
+  batch.splice(pendingQueue);
+
+  debugprint(LOG_HIL, "Scheduler | Batch of %" PRIu64 " requests at %" PRIu64,
+             batch.size(), now);
+
+  while (Request *req = batch.pop()) {
+    uint64_t tick = now;
+
+    processUntil(*req, tick);
+    complete(req, tick);
+  }
+}
+
+void Scheduler::drain(RequestList &out) {
+  out.splice(pendingQueue);
+}
+
+void Scheduler::complete(Request *req, uint64_t tick) {
+  if (completionFunction) {
+    completionFunction(req, tick);
+  }
+  else {
+    panic("Scheduler | No completion set for request %" PRIu64, req->reqID);
   }
 }
 
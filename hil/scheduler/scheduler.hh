@@ -20,31 +20,52 @@
 #ifndef __HIL_SCHEDULER_SCHEDULER__
 #define __HIL_SCHEDULER_SCHEDULER__
 
-#include <queue>
+#include <functional>
 #include <vector>
 #include "util/def.hh"
 #include "util/simplessd.hh"
 #include "icl/icl.hh"
+#include "sim/simulator.hh"
 
 namespace SimpleSSD {
 
 namespace HIL {
 
+// Called with a request handed over by submit() and its completion tick
+typedef std::function<void(Request *, uint64_t)> CompletionFunction;
+
 class Scheduler {
  protected:
-  std::queue<Request> requestQueue;
   uint64_t currentTick;
 
+  // 非同步介面：submit() 收到的請求，以 Request::next 串起，等批次事件處理
+  RequestList pendingQueue;
+  Event batchEvent;
+  CompletionFunction completionFunction;
+
+  void processBatch(uint64_t now);
+  void complete(Request *req, uint64_t tick);
+
  public:
   Scheduler();
   virtual ~Scheduler();
 
   // 基本排程器介面
-  virtual void submitRequest(Request &req);
-  virtual void schedule();
+  virtual void submitRequest(Request &req) = 0;
+  virtual void schedule() {}
   virtual void tick(uint64_t now);
   virtual void processUntil(Request &req, uint64_t &completionTick) = 0;
 
+  // 非同步介面：req 由呼叫端擁有，完成時以 completionFunction 交回
+  // 預設在批次事件中逐筆 processUntil；排程器可自行從事件派發
+  virtual void submit(Request *req);
+  void setCompletion(CompletionFunction f) { completionFunction = f; }
+  // 切換排程器時交出尚未派發的 submit() 請求
+  virtual void drain(RequestList &out);
+  // 還有 drain() 交不出去的工作（ISC 等 credit、processUntil 呼叫端）時為 true，
+  // 此時刪掉排程器會讓它們永遠完成不了
+  virtual bool holdsWork() const { return false; }
+
   // 取得統計資訊
   virtual void getStatList(std::vector<Stats> &, std::string) = 0;
   virtual void getStatValues(std::vector<double> &) = 0;
@@ -0,0 +1,147 @@
+/*
+ * Copyright (C) 2024
+ *
+ * This file is part of SimpleSSD.
+ *
+ * SimpleSSD is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * SimpleSSD is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with SimpleSSD.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __HIL_SCHEDULER_TEST_FAKE_SSD__
+#define __HIL_SCHEDULER_TEST_FAKE_SSD__
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "ftl/ftl.hh"
+#include "icl/icl.hh"
+#include "sim/cpu.hh"
+#include "sim/simulator.hh"
+#include "sim/trace.hh"
+
+/* -------------------------------------------------------------------------- */
+/*              the scheduler runs against an event queue and ICL             */
+/*            faked here, so no SSD is built for the test; include            */
+/*                     this once in each test executable                      */
+/* -------------------------------------------------------------------------- */
+
+using namespace SimpleSSD;
+
+class FakeSim : public Simulator {
+  uint64_t now = 0;
+  Event last = 0;
+  std::map<Event, EventFunction> funcs;
+  std::map<Event, uint64_t> when;
+
+ public:
+  uint64_t getCurrentTick() override { return now; }
+  Event allocateEvent(EventFunction f) override {
+    funcs[++last] = f;
+    return last;
+  }
+  void scheduleEvent(Event e, uint64_t t) override { when[e] = t; }
+  void descheduleEvent(Event e) override { when.erase(e); }
+  bool isScheduled(Event e, uint64_t *t) override {
+    auto it = when.find(e);
+    if (it != when.end() && t)
+      *t = it->second;
+    return it != when.end();
+  }
+  void deallocateEvent(Event e) override {
+    when.erase(e);
+    funcs.erase(e);
+  }
+
+  // move the clock without firing anything, for state read lazily at a tick
+  void setTick(uint64_t t) { now = t; }
+
+  // fire the earliest event, false once the queue is empty
+  bool step() {
+    if (when.empty())
+      return false;
+    auto next = when.begin();
+    for (auto it = when.begin(); it != when.end(); ++it)
+      if (it->second < next->second)
+        next = it;
+    Event e = next->first;
+    now = next->second;
+    when.erase(next);
+    funcs[e](now);
+    return true;
+  }
+};
+
+// bytes dispatched to the ICL per user, in dispatch order
+static std::vector<std::pair<uint32_t, uint64_t>> dispatched;
+
+// ticks the fake ICL takes for any request
+static uint64_t iclLatency = 1000;
+
+// the fake read/write never touch the ICL, any storage stands in for it
+static uint64_t iclStorage[sizeof(ICL::ICL) / sizeof(uint64_t) + 1];
+static ICL::ICL *const icl = reinterpret_cast<ICL::ICL *>(iclStorage);
+
+// what the FTL reports to FLIN, a dispatch keeps the first idle die busy
+static FTL::FlashState flash;
+
+static void occupyDie(uint64_t from, uint64_t until) {
+  for (auto &die : flash.dieBusyUntil) {
+    if (die <= from) {
+      die = until;
+      break;
+    }
+  }
+}
+
+namespace SimpleSSD {
+
+void debugprint(LOG_ID, const char *, ...) {}
+void panic(const char *, ...) { abort(); }
+void warn(const char *, ...) {}
+uint64_t applyLatency(CPU::NAMESPACE, CPU::FUNCTION) { return 0; }
+
+namespace ICL {
+
+void ICL::read(Request &req, uint64_t &tick) {
+  dispatched.push_back({req.userID, req.length});
+  occupyDie(tick, tick + iclLatency);
+  tick += iclLatency;
+}
+
+void ICL::write(Request &req, uint64_t &tick) {
+  dispatched.push_back({req.userID, req.length});
+  occupyDie(tick, tick + iclLatency);
+  tick += iclLatency;
+}
+
+void ICL::getFlashState(FTL::FlashState &state) { state = flash; }
+
+}  // namespace ICL
+
+}  // namespace SimpleSSD
+
+static const uint64_t TicksPerSec = 1000000000000ULL;
+
+inline double statOf(HIL::Scheduler &s, const std::string &name) {
+  std::vector<Stats> list;
+  std::vector<double> val;
+  s.getStatList(list, "");
+  s.getStatValues(val);
+  for (size_t i = 0; i < list.size(); ++i)
+    if (list[i].name == name)
+      return val[i];
+  return -1.0;
+}
+
+#endif
@@ -0,0 +1,292 @@
+/*
+ * Copyright (C) 2024
+ *
+ * This file is part of SimpleSSD.
+ *
+ * SimpleSSD is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * SimpleSSD is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with SimpleSSD.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+
+#include "hil/scheduler/credit_scheduler.hh"
+
+#include "hil/scheduler/test/fake_ssd.hh"
+
+/* -------------------------------------------------------------------------- */
+/*                 CreditScheduler on the fake event queue                  */
+/* -------------------------------------------------------------------------- */
+
+static const uint64_t PeriodTicks = 1000000000ULL;  // 1ms
+
+// ticks until a bucket refilled at rate pages/s holds the given pages
+static uint64_t refillTicks(uint64_t pages, uint64_t rate) {
+  return (pages * TicksPerSec + rate - 1) / rate;
+}
+
+#undef PR_SECTION
+#define PR_SECTION CreditWake
+TEST(CreditTest, PR_SECTION) {
+  FakeSim sim;
+  setSimulator(&sim);
+
+  // two users start at the same tick without credit and share 12000 pages/s
+  {
+    HIL::CreditScheduler s(icl, PeriodTicks, TicksPerSec);
+    std::map<uint32_t, uint64_t> doneAt;
+    s.setCompletion(
+        [&](HIL::Request *req, uint64_t tick) { doneAt[req->userID] = tick; });
+
+    dispatched.clear();
+    HIL::Request reqs[2];
+    for (uint32_t i = 0; i < 2; ++i) {
+      reqs[i].userID = 1001 + i;
+      reqs[i].length = 4096;
+      reqs[i].op = HIL::OpType::READ;
+      s.submit(&reqs[i]);
+    }
+    EXPECT_TRUE(dispatched.empty());
+
+    // a single wake event at the refill tick releases both, and each only
+    // pays its own ICL latency
+    ASSERT_TRUE(sim.step());
+    ASSERT_EQ(2u, dispatched.size());
+    uint64_t ready = refillTicks(1, 6000);
+    EXPECT_EQ(ready + 1000, doneAt[1001]);
+    EXPECT_EQ(ready + 1000, doneAt[1002]);
+
+    // nobody waits for credit, so no event is left behind
+    EXPECT_FALSE(sim.step());
+  }
+
+  setSimulator(nullptr);
+}
+
+#undef PR_SECTION
+#define PR_SECTION CreditBucket
+TEST(CreditTest, PR_SECTION) {
+  FakeSim sim;
+  setSimulator(&sim);
+
+  // the bucket of an active user is refilled in closed form, no event needed
+  {
+    HIL::CreditScheduler s(icl, PeriodTicks, TicksPerSec);
+    s.ensureActiveUser(1001);
+    EXPECT_EQ(0u, s.getUserCredit(1001));
+    EXPECT_FALSE(sim.step());
+
+    sim.setTick(refillTicks(100, 12000));
+    EXPECT_EQ(100u, s.getUserCredit(1001));
+
+    // enough credit: charged and dispatched at once
+    dispatched.clear();
+    HIL::Request req;
+    req.userID = 1001;
+    req.length = 4 * 4096;
+    req.op = HIL::OpType::READ;
+    s.submitRequest(req);
+    EXPECT_EQ(1u, dispatched.size());
+    EXPECT_EQ(96u, s.getUserCredit(1001));
+
+    // capped at 2000 periods of the device rate
+    sim.setTick(sim.getCurrentTick() + 10 * TicksPerSec);
+    EXPECT_EQ(12u * 2000, s.getUserCredit(1001));
+  }
+
+  // the rate is split among the active users
+  {
+    sim.setTick(0);
+    HIL::CreditScheduler s(icl, PeriodTicks, TicksPerSec);
+    s.ensureActiveUser(1001);
+    s.ensureActiveUser(1002);
+
+    sim.setTick(refillTicks(30, 6000));
+    EXPECT_EQ(30u, s.getUserCredit(1001));
+    EXPECT_EQ(30u, s.getUserCredit(1002));
+  }
+
+  setSimulator(nullptr);
+}
+
+#undef PR_SECTION
+#define PR_SECTION CreditRing
+TEST(CreditTest, PR_SECTION) {
+  FakeSim sim;
+  setSimulator(&sim);
+
+  {
+    const uint32_t users = 2000;
+    HIL::CreditScheduler s(icl, PeriodTicks, TicksPerSec);
+    std::map<uint64_t, size_t> doneAt;  // completions per tick
+    s.setCompletion([&](HIL::Request *, uint64_t tick) { ++doneAt[tick]; });
+
+    // every tenant queues two reads at tick 0
+    dispatched.clear();
+    std::vector<HIL::Request> reqs(2 * users);
+    for (uint32_t i = 0; i < 2 * users; ++i) {
+      reqs[i].userID = 2000 + i % users;
+      reqs[i].length = 4096;
+      reqs[i].op = HIL::OpType::READ;
+      s.submit(&reqs[i]);
+    }
+    EXPECT_EQ(users, statOf(s, "credit.users.active"));
+    EXPECT_EQ(2 * users, statOf(s, "credit.pending"));
+
+    while (sim.step()) {
+    }
+    ASSERT_EQ(2u * users, dispatched.size());
+
+    // each wake event serves every tenant exactly once
+    for (uint32_t round = 0; round < 2; ++round) {
+      std::vector<bool> seen(users);
+      for (uint32_t i = round * users; i < (round + 1) * users; ++i)
+        seen[dispatched[i].first - 2000] = true;
+      EXPECT_EQ(users, (uint32_t)std::count(seen.begin(), seen.end(), true));
+    }
+    ASSERT_EQ(2u, doneAt.size());
+    EXPECT_EQ(users, doneAt[refillTicks(1, 6) + 1000]);
+    EXPECT_EQ(users, doneAt[refillTicks(2, 6) + 1000]);
+
+    // idle tenants leave the active set once their grace period expires
+    sim.setTick(sim.getCurrentTick() + 200 * PeriodTicks);
+    HIL::Request req;
+    req.userID = 9999;
+    req.length = 4096;
+    req.op = HIL::OpType::READ;
+    s.submitRequest(req);
+    EXPECT_EQ(1, statOf(s, "credit.users.active"));
+    EXPECT_EQ(users + 1, statOf(s, "credit.users.registered"));
+  }
+
+  setSimulator(nullptr);
+}
+
+#undef PR_SECTION
+#define PR_SECTION CreditISCGate
+TEST(CreditTest, PR_SECTION) {
+  FakeSim sim;
+  setSimulator(&sim);
+
+  // back-to-back gated ISC reads advance the slet's own tick by the refill
+  // time of each read, the event queue never moves while the slet runs
+  for (uint64_t pages : {(uint64_t)12, (uint64_t)30000}) {  // below and above the cap
+    HIL::CreditScheduler s(icl, PeriodTicks, TicksPerSec);
+    const uint64_t n = 10;
+
+    s.ensureActiveUser(1001);
+    uint64_t simTick = 0;
+    for (uint64_t i = 0; i < n; ++i)
+      simTick = s.chargeISCAt(1001, pages, simTick);
+
+    // the last read is charged once the bucket has refilled n * pages; a
+    // read above the cap goes once the bucket is full and leaves a debt
+    uint64_t refilled = (n - 1) * pages + std::min<uint64_t>(pages, 12 * 2000);
+    EXPECT_NEAR((double)refillTicks(refilled, 12000), (double)simTick, n);
+    EXPECT_EQ(n * pages, statOf(s, "credit.isc.total.consumed"));
+    EXPECT_EQ(0u, sim.getCurrentTick());
+  }
+
+  setSimulator(nullptr);
+}
+
+#undef PR_SECTION
+#define PR_SECTION CreditHoldsWork
+TEST(CreditTest, PR_SECTION) {
+  FakeSim sim;
+  setSimulator(&sim);
+
+  {
+    HIL::CreditScheduler s(icl, PeriodTicks, TicksPerSec);
+    s.setCompletion([](HIL::Request *, uint64_t) {});
+
+    // requests from submit() are handed over by drain()
+    HIL::Request req;
+    req.userID = 1001;
+    req.length = 4096;
+    req.op = HIL::OpType::READ;
+    s.submit(&req);
+    EXPECT_FALSE(s.holdsWork());
+
+    // a deferred ISC resume only this scheduler can run
+    bool resumed = false;
+    s.submitISCDeferred(1001, 1, &resumed,
+                        [](void *ctx, uint64_t) { *(bool *)ctx = true; });
+    EXPECT_TRUE(s.holdsWork());
+
+    HIL::RequestList out;
+    s.drain(out);
+    EXPECT_EQ(&req, out.pop());
+    EXPECT_TRUE(s.holdsWork());
+
+    while (sim.step()) {
+    }
+    EXPECT_TRUE(resumed);
+    EXPECT_FALSE(s.holdsWork());
+  }
+
+  setSimulator(nullptr);
+}
+
+#undef PR_SECTION
+#define PR_SECTION CreditTailControl
+TEST(CreditTest, PR_SECTION) {
+  FakeSim sim;
+  setSimulator(&sim);
+
+  // each control window sees 40 completions of the given latency, spaced so
+  // the user never idles out of the active set
+  auto window = [&](HIL::CreditScheduler &s, uint64_t latency) {
+    uint64_t start = sim.getCurrentTick();
+    iclLatency = latency;
+    for (uint64_t i = 0; i < 40; ++i) {
+      sim.setTick(start + i * 2 * PeriodTicks);
+      HIL::Request req;
+      req.userID = 1001;
+      req.length = 4096;
+      req.op = HIL::OpType::READ;
+      s.submitRequest(req);
+    }
+    sim.setTick(start + 100 * PeriodTicks);
+  };
+
+  {
+    HIL::CreditScheduler s(icl, PeriodTicks, TicksPerSec);
+    s.setUserTailTarget(1001, 0.99, 1);  // p99 at most 1us
+
+    // a window is checked at the first request of the next one: above the
+    // target the boost rises by 1.25 per window up to 3.0
+    double boost = 1.0;
+    for (uint32_t w = 0; w < 8; ++w) {
+      window(s, 10000000);
+      if (w > 0)
+        boost = std::min(boost * 1.25, 3.0);
+      EXPECT_NEAR(boost, statOf(s, "credit.user.0.budget_boost"), 1e-9);
+    }
+    EXPECT_EQ(3.0, statOf(s, "credit.user.0.budget_boost"));
+    EXPECT_NEAR(10.0, statOf(s, "credit.user.0.latency.p99"), 10.0 / 32);
+
+    // well below it the boost decays by 0.95 per window back to 1.0
+    for (uint32_t w = 0; w < 30; ++w) {
+      window(s, 1000);
+      if (w > 0)
+        boost = std::max(boost * 0.95, 1.0);
+      EXPECT_NEAR(boost, statOf(s, "credit.user.0.budget_boost"), 1e-9);
+    }
+    EXPECT_EQ(1.0, statOf(s, "credit.user.0.budget_boost"));
+  }
+  iclLatency = 1000;
+
+  setSimulator(nullptr);
+}
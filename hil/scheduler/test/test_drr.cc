@@ -0,0 +1,102 @@
+/*
+ * Copyright (C) 2024
+ *
+ * This file is part of SimpleSSD.
+ *
+ * SimpleSSD is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * SimpleSSD is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with SimpleSSD.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gtest/gtest.h"
+
+#include "hil/scheduler/drr_scheduler.hh"
+
+#include "hil/scheduler/test/fake_ssd.hh"
+
+/* -------------------------------------------------------------------------- */
+/*                   DRRScheduler on the fake event queue                   */
+/* -------------------------------------------------------------------------- */
+
+static void submitReads(HIL::DRRScheduler &s, uint32_t uid, uint64_t length,
+                        size_t count) {
+  for (size_t i = 0; i < count; ++i) {
+    HIL::Request req;
+    req.userID = uid;
+    req.length = length;
+    req.op = HIL::OpType::READ;
+    s.submitRequest(req);
+  }
+}
+
+// bytes of uid among the first n dispatches
+static uint64_t bytesOf(uint32_t uid, size_t n) {
+  uint64_t bytes = 0;
+  for (size_t i = 0; i < n && i < dispatched.size(); ++i)
+    if (dispatched[i].first == uid)
+      bytes += dispatched[i].second;
+  return bytes;
+}
+
+#undef PR_SECTION
+#define PR_SECTION WeightedShare
+TEST(DrrTest, PR_SECTION) {
+  FakeSim sim;
+  setSimulator(&sim);
+
+  // 1:3 weights, same request size
+  {
+    HIL::DRRScheduler s(icl, 1000000000000ULL);
+    s.setUserWeight(1002, 3);
+    ASSERT_EQ(1u, s.getUserWeight(1001));
+    ASSERT_EQ(3u, s.getUserWeight(1002));
+
+    dispatched.clear();
+    submitReads(s, 1001, 4096, 400);
+    submitReads(s, 1002, 4096, 400);
+    while (sim.step()) {
+    }
+    ASSERT_EQ(800u, dispatched.size());
+
+    // a round is 32 + 96 dispatches of 128KB quanta, both users stay
+    // backlogged for the first 4 rounds
+    double share = (double)bytesOf(1002, 4 * 128) / bytesOf(1001, 4 * 128);
+    EXPECT_NEAR(3.0, share, 0.1);
+  }
+
+  // 2:1 weights, the heavier user sends 16x larger requests
+  {
+    HIL::DRRScheduler s(icl, 1000000000000ULL);
+    s.setUserWeight(1001, 2);
+
+    dispatched.clear();
+    submitReads(s, 1001, 65536, 64);
+    submitReads(s, 1002, 4096, 1024);
+    while (sim.step()) {
+    }
+    ASSERT_EQ(64u + 1024u, dispatched.size());
+
+    // a round is 4 + 32 dispatches, both users stay backlogged for 8 rounds;
+    // the first request goes out before any round, so the share is a bit off
+    double share = (double)bytesOf(1001, 8 * 36) / bytesOf(1002, 8 * 36);
+    EXPECT_NEAR(2.0, share, 0.1);
+  }
+
+  // a zero weight is clamped so the user is never starved
+  {
+    HIL::DRRScheduler s(icl, 1000000000000ULL);
+    s.setUserWeight(1001, 0);
+    EXPECT_EQ(1u, s.getUserWeight(1001));
+  }
+
+  setSimulator(nullptr);
+}
@@ -0,0 +1,202 @@
+/*
+ * Copyright (C) 2024
+ *
+ * This file is part of SimpleSSD.
+ *
+ * SimpleSSD is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * SimpleSSD is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with SimpleSSD.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gtest/gtest.h"
+
+#include "hil/scheduler/flin_scheduler.hh"
+
+#include "hil/scheduler/test/fake_ssd.hh"
+
+/* -------------------------------------------------------------------------- */
+/*         FLINScheduler against the fake ICL and a single-die FTL state      */
+/* -------------------------------------------------------------------------- */
+
+static void submitFlin(HIL::FLINScheduler &s, uint32_t uid, HIL::OpType op,
+                       uint64_t length, uint32_t prio, size_t count) {
+  for (size_t i = 0; i < count; ++i) {
+    HIL::Request req;
+    req.userID = uid;
+    req.length = length;
+    req.op = op;
+    req.prio = prio;
+    s.submitRequest(req);
+  }
+}
+
+// uids of the first n dispatches
+static std::vector<uint32_t> uidsOf(size_t n) {
+  std::vector<uint32_t> uids;
+  for (size_t i = 0; i < n && i < dispatched.size(); ++i)
+    uids.push_back(dispatched[i].first);
+  return uids;
+}
+
+// one die busy for the given ticks from now, no GC pressure
+static void resetFlash(uint64_t busy) {
+  flash.dieBusyUntil.assign(1, SimpleSSD::getTick() + busy);
+  flash.freeBlockRatio = 0.5f;
+  flash.gcThreshold = 0.05f;
+}
+
+#undef PR_SECTION
+#define PR_SECTION FlinInsertion
+TEST(FlinTest, PR_SECTION) {
+  FakeSim sim;
+  setSimulator(&sim);
+
+  // low-intensity work goes ahead of every high-intensity request
+  {
+    HIL::FLINScheduler s(icl, TicksPerSec, UINT64_MAX / 2, 4, 0.0, 0);
+    resetFlash(1000000);
+
+    dispatched.clear();
+    submitFlin(s, 1001, HIL::OpType::READ, 4096, 0, 8);
+    submitFlin(s, 1002, HIL::OpType::READ, 4096, 0, 2);
+    EXPECT_EQ(1, statOf(s, "flin.users.high"));
+
+    while (sim.step()) {
+    }
+    std::vector<uint32_t> order = {1001, 1001, 1001, 1001, 1002,
+                                   1002, 1001, 1001, 1001, 1001};
+    EXPECT_EQ(order, uidsOf(10));
+  }
+
+  // a high-intensity user far behind the others is boosted ahead of them,
+  // each boosted request ahead of the one before
+  for (double fairness : {0.0, 0.9}) {
+    HIL::FLINScheduler s(icl, TicksPerSec, UINT64_MAX / 2, 1, fairness, 0);
+
+    // 1002 waits 1000x its service time once
+    resetFlash(1000000);
+    submitFlin(s, 1002, HIL::OpType::READ, 4096, 0, 1);
+    while (sim.step()) {
+    }
+    EXPECT_GT(statOf(s, "flin.user.0.slowdown"), 100.0);
+
+    resetFlash(1000000);
+    dispatched.clear();
+    submitFlin(s, 1001, HIL::OpType::READ, 4096, 0, 3);
+    submitFlin(s, 1002, HIL::OpType::READ, 8192, 0, 2);
+    while (sim.step()) {
+    }
+    ASSERT_EQ(5u, dispatched.size());
+
+    if (fairness == 0.0) {
+      std::vector<uint32_t> order = {1001, 1001, 1001, 1002, 1002};
+      EXPECT_EQ(order, uidsOf(5));
+      EXPECT_EQ(0, statOf(s, "flin.user.0.boosted"));
+    }
+    else {
+      std::vector<uint32_t> order = {1001, 1002, 1002, 1001, 1001};
+      EXPECT_EQ(order, uidsOf(5));
+      EXPECT_EQ(2, statOf(s, "flin.user.0.boosted"));
+    }
+  }
+
+  setSimulator(nullptr);
+}
+
+#undef PR_SECTION
+#define PR_SECTION FlinPriority
+TEST(FlinTest, PR_SECTION) {
+  FakeSim sim;
+  setSimulator(&sim);
+
+  // classes 0 and 3 are served 8:1, the class is told apart by size
+  {
+    HIL::FLINScheduler s(icl, TicksPerSec, UINT64_MAX / 2, 1000, 0.0, 0);
+    resetFlash(1000000);
+
+    dispatched.clear();
+    submitFlin(s, 1001, HIL::OpType::READ, 4096, 0, 40);
+    submitFlin(s, 1001, HIL::OpType::READ, 8192, 3, 40);
+    while (sim.step()) {
+    }
+    ASSERT_EQ(80u, dispatched.size());
+
+    for (size_t round = 0; round < 4; ++round) {
+      for (size_t i = 0; i < 9; ++i)
+        EXPECT_EQ(i < 8 ? 4096u : 8192u, dispatched[round * 9 + i].second);
+    }
+  }
+
+  // a class out of range is served as the lowest one
+  {
+    HIL::FLINScheduler s(icl, TicksPerSec, UINT64_MAX / 2, 1000, 0.0, 0);
+    resetFlash(1000000);
+
+    dispatched.clear();
+    submitFlin(s, 1001, HIL::OpType::READ, 8192, 7, 2);
+    submitFlin(s, 1001, HIL::OpType::READ, 4096, 0, 16);
+    while (sim.step()) {
+    }
+    ASSERT_EQ(18u, dispatched.size());
+    EXPECT_EQ(8192u, dispatched[8].second);
+  }
+
+  setSimulator(nullptr);
+}
+
+#undef PR_SECTION
+#define PR_SECTION FlinGCPressure
+TEST(FlinTest, PR_SECTION) {
+  FakeSim sim;
+  setSimulator(&sim);
+
+  // close to the GC threshold, reads go first until the write head has
+  // waited writeWaitLimit, then the writes are forced out
+  {
+    HIL::FLINScheduler s(icl, TicksPerSec, UINT64_MAX / 2, 1000, 0.0, 5000);
+    resetFlash(10000);
+    flash.freeBlockRatio = 0.08f;
+
+    dispatched.clear();
+    submitFlin(s, 1001, HIL::OpType::READ, 4096, 0, 10);
+    sim.setTick(sim.getCurrentTick() + 9000);
+    submitFlin(s, 1001, HIL::OpType::WRITE, 8192, 0, 3);
+    while (sim.step()) {
+    }
+    ASSERT_EQ(13u, dispatched.size());
+
+    // dispatches at 10000..13000 are reads, the write head reaches its
+    // limit at 14000
+    for (size_t i = 0; i < 13; ++i)
+      EXPECT_EQ(i >= 4 && i < 7 ? 8192u : 4096u, dispatched[i].second);
+    EXPECT_EQ(4, statOf(s, "flin.gc.deferred"));
+    EXPECT_EQ(3, statOf(s, "flin.gc.forced"));
+  }
+
+  // without GC pressure nothing is deferred or forced
+  {
+    HIL::FLINScheduler s(icl, TicksPerSec, UINT64_MAX / 2, 1000, 0.0, 5000);
+    resetFlash(10000);
+
+    dispatched.clear();
+    submitFlin(s, 1001, HIL::OpType::READ, 4096, 0, 10);
+    sim.setTick(sim.getCurrentTick() + 9000);
+    submitFlin(s, 1001, HIL::OpType::WRITE, 8192, 0, 3);
+    while (sim.step()) {
+    }
+    ASSERT_EQ(13u, dispatched.size());
+    EXPECT_EQ(0, statOf(s, "flin.gc.deferred"));
+    EXPECT_EQ(0, statOf(s, "flin.gc.forced"));
+  }
+
+  setSimulator(nullptr);
+}
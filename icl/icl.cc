@@ -180,6 +180,10 @@ uint64_t ICL::getUsedPageCount(uint64_t lcaBegin, uint64_t lcaEnd) {
   return pFTL->getUsedPageCount(lcaBegin / ratio, lcaEnd / ratio) * ratio;
 }
 
+void ICL::getFlashState(FTL::FlashState &state) {
+  pFTL->getFlashState(state);
+}
+
 void ICL::getStatList(std::vector<Stats> &list, std::string prefix) {
   pCache->getStatList(list, prefix + "icl.");
   pDRAM->getStatList(list, prefix + "dram.");
@@ -53,6 +53,7 @@ class ICL : public StatObject {
 
   void getLPNInfo(uint64_t &, uint32_t &);
   uint64_t getUsedPageCount(uint64_t, uint64_t);
+  void getFlashState(FTL::FlashState &);
 
   void getStatList(std::vector<Stats> &, std::string) override;
   void getStatValues(std::vector<double> &) override;
@@ -124,6 +124,11 @@ int setOpt(uint32_t id, nvme_config_t config, const char *key, void *data,
 }
 
 int getResult(uint32_t id, nvme_config_t config, void *data, size_t dlen) {
+  return getResultAt(id, config, 0, data, dlen);
+}
+
+int getResultAt(uint32_t id, nvme_config_t config, uint64_t ofs, void *data,
+                size_t dlen) {
   config.opcode = ISC_OPCODE_GET;
   config.slba = 0;
   config.nlb = 7;
@@ -135,6 +140,8 @@ int getResult(uint32_t id, nvme_config_t config, void *data, size_t dlen) {
 
   setupSubcmd(&config.slba, ISC_SUBCMD_SLET_RES, id);
   config.cdw03 = getuid();
+  config.cdw13 = (uint32_t)ofs;
+  config.cdw14 = (uint32_t)(ofs >> 32);
 
   if (!config.data) {
     perrno("malloc failed");
@@ -242,5 +249,30 @@ int setScheduler(nvme_config_t cfg, uint32_t type)
     return ret;
 }
 
+int setSchedulerWeight(nvme_config_t cfg, uint16_t uid, uint16_t weight)
+{
+    cfg.opcode       = ISC_OPCODE_SET;
+    cfg.data_len     = NVME_LBA_SIZE;
+    cfg.nlb          = 0;
+    cfg.metadata_len = 0;
+    cfg.metadata     = nullptr;
+    cfg.slba         = 0;
+
+    setupSubcmd(&cfg.slba, ISC_SUBCMD_SCHEDULER_WEIGHT,
+                (uint32_t)uid << 16 | weight);
+
+    char *buffer = (char *)aligned_alloc(HOST_PAGE_SIZE, cfg.data_len);
+    if (!buffer) {
+      perr("Buffer allocation failed");
+      return -ENOMEM;
+    }
+    memset(buffer, 0, cfg.data_len);
+    cfg.data = buffer;
+
+    int ret = send_passthru(cfg);
+    free(buffer);
+    return ret;
+}
+
 }  // namespace ISC
 }  // namespace SimpleSSD
\ No newline at end of file
@@ -104,9 +104,13 @@ extern int send_passthru(nvme_config_t);
 extern int initRuntime(nvme_config_t);
 extern int setOpt(uint32_t id, nvme_config_t, const char *, void *, size_t);
 extern int getResult(uint32_t id, nvme_config_t, void *, size_t);
+// a chunk of the result from the offset, bytes before it are released
+extern int getResultAt(uint32_t id, nvme_config_t, uint64_t, void *, size_t);
 extern int getResultSize(uint32_t id, nvme_config_t, size_t *);
 extern int startSlet(uint32_t id, nvme_config_t);
 extern int setScheduler(nvme_config_t, uint32_t);
+// DRR weight of a uid, kept by the device across scheduler switches
+extern int setSchedulerWeight(nvme_config_t, uint16_t uid, uint16_t weight);
 
 }  // namespace ISC
 }  // namespace SimpleSSD
@@ -48,9 +48,17 @@ struct NameiNode {
   static constexpr size_t size() { return szKey1 + szKey2 + szVal; }
 };
 
+struct ExtNode {
+  ino_t number;  // key
+  uint32_t flags;
+  size_t bytes;
+  size_t len;
+  Ext4::Ext exts[Ext4::EXT_CACHE_EXTS];
+};
+
 Ext4::Ext4(_SIM_PARAMS) {
-  this->setOpt("name", strdup("Ext4"));
-  this->setOpt("cwd", strdup("/"));
+  this->setOpt(keyName, strdup("Ext4"));
+  this->setOpt(keyCwd, strdup("/"));
 
   this->sb = this->getSuper(_sim_params);
   simApplyLatency(CPU::ISC__FSA__EXT4, CPU::ISC__INIT);
@@ -64,7 +72,7 @@ Ext4::Ext4(_SIM_PARAMS) {
       std::max((size_t)this->sb->s_inode_size, sizeof(Ext4::inode));
 
   this->lruInoCache = DRAM::alloc(
-      256, ICacheNode::szKey + ICacheNode::szVal, DRAM::TYPES::LRU_CACHE,
+      256, ICacheNode::szKey + ICacheNode::szVal, DRAM::TYPES::HASH_LRU_CACHE,
       [](const void *a, const void *b, size_t) -> int {
         auto aIno = ((ICacheNode *)a)->number;
         auto bIno = ((ICacheNode *)b)->number;
@@ -81,11 +89,12 @@ Ext4::Ext4(_SIM_PARAMS) {
         memcpy(&b->number, mem, ICacheNode::szKey);
         memcpy(b->inode, (char *)mem + ICacheNode::szKey, ICacheNode::szVal);
         return buf;
-      });
+      },
+      [](const void *buf) -> uint64_t { return ((ICacheNode *)buf)->number; });
 
   // allocate namei cache
   this->NameiCache = DRAM::alloc(
-      10000, NameiNode::size(), DRAM::TYPES::LRU_CACHE,
+      10000, NameiNode::size(), DRAM::TYPES::HASH_LRU_CACHE,
       [](const void *a, const void *b, size_t) -> int {
         auto akey1 = ((NameiNode *)a)->diri;
         auto bkey1 = ((NameiNode *)b)->diri;
@@ -111,8 +120,26 @@ Ext4::Ext4(_SIM_PARAMS) {
         memcpy(b->name, m->name, NameiNode::szKey2);
         b->inode = m->inode;
         return buf;
+      },
+      [](const void *buf) -> uint64_t {  // FNV-1a of the dir and name
+        auto b = (const NameiNode *)buf;
+        uint64_t h = 14695981039346656037ULL ^ b->diri;
+        for (size_t i = 0; i < NameiNode::szKey2 && b->name[i]; ++i)
+          h = (h ^ (uint8_t)b->name[i]) * 1099511628211ULL;
+        return h;
       });
 
+  // allocate extent cache, only the inode number is compared
+  this->extCache = DRAM::alloc(
+      Ext4::EXT_CACHE_NUM, sizeof(ExtNode), DRAM::TYPES::HASH_LRU_CACHE,
+      [](const void *a, const void *b, size_t) -> int {
+        auto aIno = ((ExtNode *)a)->number;
+        auto bIno = ((ExtNode *)b)->number;
+        return aIno == bIno ? 0 : (aIno < bIno ? -1 : 1);
+      },
+      memcpy, memcpy,
+      [](const void *buf) -> uint64_t { return ((ExtNode *)buf)->number; });
+
   // calculate some important info
   auto sb = this->sb;
   auto iBlk0 = sb->s_first_data_block;
@@ -160,6 +187,7 @@ Ext4::~Ext4() {
   DRAM::dealloc(this->grpCache);
   DRAM::dealloc(this->lruInoCache);
   DRAM::dealloc(this->NameiCache);
+  DRAM::dealloc(this->extCache);
 }
 
 /* -------------------------------------------------------------------------- */
@@ -571,6 +599,58 @@ Ext4::Ext *Ext4::getExtent(ino_t inoNum, size_t *len,
   return res;
 }
 
+/**
+ * @brief Get the extent list of a file through the extent cache
+ *
+ * Files with no more than Ext4::EXT_CACHE_EXTS extents are cached by their
+ * inode numbers, so a hit skips both the inode and the extent tree walk.
+ *
+ * @param inoNum The inode number
+ * @param flags The buffer where i_flags of the inode will be copied into if
+ * not NULL
+ * @return GenericFSA::ExtList The extent list, exts is nullptr if failed;
+ * otherwise it is malloc'd and shall be explicitly free'd after use.
+ */
+GenericFSA::ExtList Ext4::getExtList(ino_t inoNum,
+                                     uint32_t *flags _ADD_SIM_PARAMS) {
+  ExtList list;
+
+  ExtNode node;
+  node.number = inoNum;
+  if (-ENOENT != this->extCache->read(0, 0, &node _add_sim_params)) {
+    pr("Ino[%lu]: extent cache hit", inoNum);
+    list.exts = (Ext *)malloc(std::max<size_t>(node.len, 1) * sizeof(Ext));
+    if (!list.exts) {
+      perr("exts malloc failed");
+      return list;
+    }
+    memcpy(list.exts, node.exts, node.len * sizeof(Ext));
+    list.len = node.len;
+    list.bytes = node.bytes;
+    if (flags)
+      *flags = node.flags;
+    return list;
+  }
+
+  inode ino;
+  list.exts = getExtent(inoNum, &list.len, &ino _add_sim_params);
+  if (!list.exts)
+    return list;
+
+  list.bytes = CAT3232(ino.i_size_high, ino.i_size_lo);
+  if (flags)
+    *flags = ino.i_flags;
+
+  if (list.len <= Ext4::EXT_CACHE_EXTS) {
+    node.flags = ino.i_flags;
+    node.bytes = list.bytes;
+    node.len = list.len;
+    memcpy(node.exts, list.exts, list.len * sizeof(Ext));
+    this->extCache->write(0, 0, &node _add_sim_params);
+  }
+  return list;
+}
+
 /**
  * @brief Get the parent (dotdot) inode number of the given inode number
  *
@@ -588,16 +668,17 @@ Ext4::ino_t Ext4::getParentInode(ino_t curIno _ADD_SIM_PARAMS) {
       return Ext4::ROOT_INO;
 
     // first 4B of data block is parent inode
-    size_t szExt;
-    auto exts = this->getExtent(curIno, &szExt, nullptr _add_sim_params);
-    if (!exts) {
+    auto list = this->getExtList(curIno, nullptr _add_sim_params);
+    if (!list.exts || !list.len) {
       pr("Ino[%lu]: extent not found", curIno);
+      free(list.exts);
       return Ext4::ERROR_INO;
     }
 
     char buf[Ext4::BLK_SIZE];
-    FTL::read(buf, exts[0].slbn, Ext4::BLK_SIZE _add_sim_params);
-    free(exts);
+    auto ofsData = list.exts[0].slbn * Ext4::BLK_SIZE;
+    FTL::read(buf, ofsData, Ext4::BLK_SIZE _add_sim_params);
+    free(list.exts);
 
     dx_root *dx = (dx_root *)buf;
     pr("\tparent inode: %u", dx->dotdot.inode);
@@ -609,10 +690,397 @@ Ext4::ino_t Ext4::getParentInode(ino_t curIno _ADD_SIM_PARAMS) {
   return res;
 }
 
+/**
+ * @brief Read all blocks of a directory into a buffer of DRAM to iterate
+ *
+ * @param dirIno The inode number of the directory
+ * @param dir The extent list of the directory
+ * @return Ext4::DirIter* return nullptr if failed; otherwise shall be deleted
+ * after use.
+ */
+Ext4::DirIter *Ext4::openDir(ino_t dirIno,
+                             const ExtList &dir _ADD_SIM_PARAMS) {
+  size_t szBuf = 0;
+  for (size_t ie = 0; ie < dir.len; ++ie)
+    szBuf += dir.exts[ie].len * Ext4::BLK_SIZE;
+  pr("\tbuffer size: %lu", szBuf);
+
+  auto it = new DirIter(dirIno, szBuf);
+  for (size_t ie = 0, ofsBuf = 0; ie < dir.len; ++ie) {
+    auto ofsData = dir.exts[ie].slbn * Ext4::BLK_SIZE;
+    auto szData = dir.exts[ie].len * Ext4::BLK_SIZE;
+    FTL::read(&it->data[ofsBuf], ofsData, szData _add_sim_params);
+    ofsBuf += szData;
+  }
+  return it;
+}
+
+bool Ext4::DirIter::next(Dirent *d) {
+  while (ofs + sizeof(fake_dirent) <= size) {
+    auto node = (dx_node *)&data[ofs];
+    auto rlen = node->fake.rec_len;
+
+    if (rlen < sizeof(fake_dirent))  // broken entry, don't go further
+      break;
+    ofs += rlen;
+
+    // unused entry or checksum tail of a block
+    if (!node->fake.inode)
+      continue;
+
+    d->name = &node->data;
+    d->nameLen = node->fake.name_len;
+    d->ino = node->fake.inode;
+    d->type = node->fake.file_type;
+    return true;
+  }
+
+  ofs = size;
+  return false;
+}
+
+/* -------------------------------------------------------------------------- */
+/*                        htree (dir_index) hash functions                    */
+/* -------------------------------------------------------------------------- */
+
+namespace {
+
+inline uint32_t rol32(uint32_t x, int s) { return (x << s) | (x >> (32 - s)); }
+
+void teaTransform(uint32_t buf[4], const uint32_t in[4]) {
+  uint32_t sum = 0, b0 = buf[0], b1 = buf[1];
+  uint32_t a = in[0], b = in[1], c = in[2], d = in[3];
+
+  for (int n = 0; n < 16; ++n) {
+    sum += 0x9E3779B9;
+    b0 += ((b1 << 4) + a) ^ (b1 + sum) ^ ((b1 >> 5) + b);
+    b1 += ((b0 << 4) + c) ^ (b0 + sum) ^ ((b0 >> 5) + d);
+  }
+  buf[0] += b0;
+  buf[1] += b1;
+}
+
+#define F(x, y, z) ((z) ^ ((x) & ((y) ^ (z))))
+#define G(x, y, z) (((x) & (y)) + (((x) ^ (y)) & (z)))
+#define H(x, y, z) ((x) ^ (y) ^ (z))
+#define ROUND(f, a, b, c, d, x, s) (a += f(b, c, d) + (x), a = rol32(a, s))
+
+void halfMD4Transform(uint32_t buf[4], const uint32_t in[8]) {
+  const uint32_t K2 = 013240474631U, K3 = 015666365641U;
+  uint32_t a = buf[0], b = buf[1], c = buf[2], d = buf[3];
+
+  ROUND(F, a, b, c, d, in[0], 3);
+  ROUND(F, d, a, b, c, in[1], 7);
+  ROUND(F, c, d, a, b, in[2], 11);
+  ROUND(F, b, c, d, a, in[3], 19);
+  ROUND(F, a, b, c, d, in[4], 3);
+  ROUND(F, d, a, b, c, in[5], 7);
+  ROUND(F, c, d, a, b, in[6], 11);
+  ROUND(F, b, c, d, a, in[7], 19);
+
+  ROUND(G, a, b, c, d, in[1] + K2, 3);
+  ROUND(G, d, a, b, c, in[3] + K2, 5);
+  ROUND(G, c, d, a, b, in[5] + K2, 9);
+  ROUND(G, b, c, d, a, in[7] + K2, 13);
+  ROUND(G, a, b, c, d, in[0] + K2, 3);
+  ROUND(G, d, a, b, c, in[2] + K2, 5);
+  ROUND(G, c, d, a, b, in[4] + K2, 9);
+  ROUND(G, b, c, d, a, in[6] + K2, 13);
+
+  ROUND(H, a, b, c, d, in[3] + K3, 3);
+  ROUND(H, d, a, b, c, in[7] + K3, 9);
+  ROUND(H, c, d, a, b, in[2] + K3, 11);
+  ROUND(H, b, c, d, a, in[6] + K3, 15);
+  ROUND(H, a, b, c, d, in[1] + K3, 3);
+  ROUND(H, d, a, b, c, in[5] + K3, 9);
+  ROUND(H, c, d, a, b, in[0] + K3, 11);
+  ROUND(H, b, c, d, a, in[4] + K3, 15);
+
+  buf[0] += a;
+  buf[1] += b;
+  buf[2] += c;
+  buf[3] += d;
+}
+
+#undef F
+#undef G
+#undef H
+#undef ROUND
+
+// chars are signed or unsigned by the hash version, as the kernel on x86 did
+template <typename C>
+uint32_t legacyHash(const char *name, size_t len) {
+  uint32_t hash, hash0 = 0x12a3fe2d, hash1 = 0x37abe8f9;
+
+  for (size_t i = 0; i < len; ++i) {
+    hash = hash1 + (hash0 ^ (uint32_t)((int)(C)name[i] * 7152373));
+    if (hash & 0x80000000)
+      hash -= 0x7fffffff;
+    hash1 = hash0;
+    hash0 = hash;
+  }
+  return hash0 << 1;
+}
+
+template <typename C>
+void str2hashbuf(const char *msg, size_t len, uint32_t *buf, int num) {
+  uint32_t pad = (uint32_t)len | ((uint32_t)len << 8), val;
+  pad |= pad << 16;
+
+  val = pad;
+  len = std::min(len, (size_t)num * 4);
+  for (size_t i = 0; i < len; ++i) {
+    val = (uint32_t)(int)(C)msg[i] + (val << 8);
+    if (i % 4 == 3) {
+      *buf++ = val;
+      val = pad;
+      num--;
+    }
+  }
+  if (--num >= 0)
+    *buf++ = val;
+  while (--num >= 0)
+    *buf++ = pad;
+}
+
+// physical block of the logical block of a file, 0 if it is a hole
+size_t lblk2slbn(const GenericFSA::ExtList &list, size_t lblk) {
+  for (size_t ie = 0; ie < list.len; ++ie) {
+    auto &e = list.exts[ie];
+    if (e.block <= lblk && lblk < e.block + e.len)
+      return e.slbn + lblk - e.block;
+  }
+  return 0;
+}
+
+}  // namespace
+
+/**
+ * @brief Hash a file name as the htree index of ext4 does (ext4fs_dirhash)
+ *
+ * @param name The file name
+ * @param len The length of the file name
+ * @param version The hash version (DX_HASH_*)
+ * @param seed The hash seed in superblock, the default seed if all zero
+ * @return uint32_t The major hash, the lowest bit is always clear
+ */
+uint32_t Ext4::dirHash(const char *name, size_t len, int version,
+                       const uint32_t *seed) {
+  uint32_t hash, in[8];
+  uint32_t buf[4] = {0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476};
+
+  if (seed && (seed[0] || seed[1] || seed[2] || seed[3]))
+    memcpy(buf, seed, sizeof(buf));
+
+  switch (version) {
+    case DX_HASH_LEGACY:
+      hash = legacyHash<signed char>(name, len);
+      break;
+    case DX_HASH_LEGACY_UNSIGNED:
+      hash = legacyHash<unsigned char>(name, len);
+      break;
+    case DX_HASH_HALF_MD4:
+    case DX_HASH_HALF_MD4_UNSIGNED:
+      for (size_t ofs = 0; ofs < len; ofs += 32) {
+        if (version == DX_HASH_HALF_MD4)
+          str2hashbuf<signed char>(&name[ofs], len - ofs, in, 8);
+        else
+          str2hashbuf<unsigned char>(&name[ofs], len - ofs, in, 8);
+        halfMD4Transform(buf, in);
+      }
+      hash = buf[1];
+      break;
+    case DX_HASH_TEA:
+    case DX_HASH_TEA_UNSIGNED:
+      for (size_t ofs = 0; ofs < len; ofs += 16) {
+        if (version == DX_HASH_TEA)
+          str2hashbuf<signed char>(&name[ofs], len - ofs, in, 4);
+        else
+          str2hashbuf<unsigned char>(&name[ofs], len - ofs, in, 4);
+        teaTransform(buf, in);
+      }
+      hash = buf[0];
+      break;
+    default:
+      pr("Unknown dir hash version %d", version);
+      return 0;
+  }
+
+  hash &= ~1U;
+  if (hash == (0x7fffffffU << 1))  // reserved for the end of htree
+    hash = (0x7fffffffU - 1) << 1;
+  return hash;
+}
+
+/**
+ * @brief Find the inode number of the file in the given dir by its htree
+ *
+ * Index blocks are binary searched from dx_root down to the leaf block,
+ * which is the only dirent block scanned unless the hash collides across
+ * leaf blocks.
+ *
+ * @param tgName The target file name (name only, not path)
+ * @param tgNameLen The length of the target file name
+ * @param dirIno The inode number of the directory to find the file
+ * @param dir The extent list of the directory
+ * @param ino The inode number found, Ext4::ERROR_INO if not found
+ * @return bool false if the htree is not supported, or the file is not found
+ * but may be beyond the index entries kept, search linearly instead
+ */
+bool Ext4::dxSearchFile(const char *tgName, size_t tgNameLen, ino_t dirIno,
+                        const ExtList &dir, ino_t *ino _ADD_SIM_PARAMS) {
+  char buf[Ext4::BLK_SIZE];
+
+  auto readBlock = [&](size_t lblk _ADD_SIM_PARAMS) -> bool {
+    auto slbn = lblk2slbn(dir, lblk);
+    if (!slbn) {
+      pr("DirIno[%lu]: block %lu not mapped", dirIno, lblk);
+      return false;
+    }
+    FTL::read(buf, slbn * Ext4::BLK_SIZE, Ext4::BLK_SIZE _add_sim_params);
+    return true;
+  };
+
+  if (!readBlock(0 _add_sim_params))
+    return false;
+
+  auto root = (dx_root *)buf;
+  int version = root->info.hash_version;
+  size_t levels = root->info.indirect_levels;
+  if (root->info.reserved_zero || root->info.info_length != 8 ||
+      version > DX_HASH_TEA || levels >= EXT4_HTREE_LEVEL) {
+    pr("dirent: htree root not supported (hash %d, levels %lu)", version,
+       levels);
+    return false;
+  }
+  if (this->sb->s_flags & EXT2_FLAGS_UNSIGNED_HASH)
+    version += DX_HASH_LEGACY_UNSIGNED;
+
+  // '.' and '..' are only in the root, not in any leaf
+  if (tgNameLen <= 2 && !strncmp(tgName, "..", tgNameLen)) {
+    *ino = tgNameLen == 1 ? root->dot.inode : root->dotdot.inode;
+    return true;
+  }
+
+  auto hash = dirHash(tgName, tgNameLen, version, this->sb->s_hash_seed);
+  pr("DirIno[%lu]: htree hash %08x (version %d)", dirIno, hash, version);
+
+  // entries after the one taken at each level, in case the hash continues in
+  // their blocks, like the frames of ext4_htree_next_block; only a few are
+  // kept, the hash may continue past them which only the linear search reaches
+  const size_t MAX_NEXT = 4;
+  struct Frame {
+    dx_entry next[MAX_NEXT];
+    size_t nNext, iNext;
+    bool more;  // entries past next[] in the index block, not kept
+  } frames[EXT4_HTREE_LEVEL];
+
+  // walk down index blocks from the given level to the leaf block, taking the
+  // last entry whose hash <= target, entries[0] has no hash (the count/limit)
+  auto descend = [&](dx_entry *entries, size_t level,
+                     size_t *lblk _ADD_SIM_PARAMS) -> bool {
+    for (;; ++level) {
+      auto cl = (dx_countlimit *)entries;
+      size_t count = cl->count;
+      if (!count || count > cl->limit ||
+          (char *)&entries[count] > &buf[Ext4::BLK_SIZE]) {
+        pr("dirent: invalid htree count/limit %u/%u", cl->count, cl->limit);
+        return false;
+      }
+
+      size_t lo = 1, hi = count;
+      while (lo < hi) {
+        auto mid = lo + (hi - lo) / 2;
+        if (entries[mid].hash > hash)
+          hi = mid;
+        else
+          lo = mid + 1;
+      }
+      *lblk = entries[lo - 1].block & 0x0fffffff;
+
+      auto &f = frames[level];
+      f.nNext = std::min(MAX_NEXT, count - lo);
+      f.iNext = 0;
+      f.more = count - lo > MAX_NEXT;
+      memcpy(f.next, &entries[lo], f.nNext * sizeof(dx_entry));
+
+      if (level == levels)
+        return true;
+      if (!readBlock(*lblk _add_sim_params))
+        return false;
+      entries = (dx_entry *)&((dx_node *)buf)->data;
+    }
+  };
+
+  size_t lblk = 0;
+  if (!descend((dx_entry *)((char *)&root->info + root->info.info_length), 0,
+               &lblk _add_sim_params))
+    return false;
+
+  // search the leaf block, and the next ones if the hash continues there
+  *ino = Ext4::ERROR_INO;
+  for (;;) {
+    if (!readBlock(lblk _add_sim_params))
+      return false;
+
+    for (size_t ofs = 0; ofs < Ext4::BLK_SIZE;) {
+      auto node = (dx_node *)&buf[ofs];
+      auto nlen = node->fake.name_len;
+      auto rlen = node->fake.rec_len;
+
+      if (rlen < sizeof(fake_dirent))
+        break;
+      ofs += rlen;
+      if (!node->fake.inode)
+        continue;
+
+      NameiNode tmp(dirIno, &node->data, nlen, node->fake.inode);
+      this->NameiCache->write(0, 0, &tmp _add_sim_params);
+
+      if (tgNameLen == nlen && !strncmp(&node->data, tgName, tgNameLen))
+        *ino = node->fake.inode;
+    }
+
+    if (*ino != Ext4::ERROR_INO)
+      return true;
+
+    // the next entry of the deepest index block not run out
+    size_t level = levels + 1;
+    do {
+      auto &f = frames[--level];
+      if (f.iNext < f.nNext)
+        break;
+      if (f.more) {
+        pr("DirIno[%lu]: hash may continue past the index, search linearly",
+           dirIno);
+        return false;
+      }
+    } while (level);
+
+    auto &f = frames[level];
+    if (f.iNext == f.nNext)  // the end of htree
+      return true;
+
+    // a set low bit marks the entry continues the hash of the previous one
+    auto &e = f.next[f.iNext++];
+    if (e.hash != (hash | 1))
+      return true;
+    pr("DirIno[%lu]: hash collision, continue to next block", dirIno);
+
+    // down to the first leaf under it, as no hash below it is <= target the
+    // search takes entries[0] at each level
+    lblk = e.block & 0x0fffffff;
+    if (level < levels &&
+        (!readBlock(lblk _add_sim_params) ||
+         !descend((dx_entry *)&((dx_node *)buf)->data, level + 1,
+                  &lblk _add_sim_params)))
+      return false;
+  }
+}
+
 /**
  * @brief Find the inode number of the specified file in the given dir
  *
- * @todo Support htree (dir_index feature)
  * @todo Add dir_entry cache
  *
  * @param tgName The target file name (name only, not path)
@@ -631,8 +1099,7 @@ Ext4::ino_t Ext4::dirSearchFile(const char *tgName, size_t tgNameLen,
     }
     pr("DirIno[%lu]: searching file '%s'(+%lu)", dirIno, tgName, tgNameLen);
 
-    inode ino;
-    size_t szExts;
+    uint32_t flags = 0;
 
     // namei cache to speed up
     NameiNode cache(dirIno, tgName, tgNameLen, Ext4::ERROR_INO);
@@ -644,74 +1111,48 @@ Ext4::ino_t Ext4::dirSearchFile(const char *tgName, size_t tgNameLen,
     }
     pr("NameiCache miss");
 
-    auto exts = this->getExtent(dirIno, &szExts, &ino _add_sim_params);
-    if (!exts) {
+    auto dir = this->getExtList(dirIno, &flags _add_sim_params);
+    if (!dir.exts || !dir.len) {
       pr("ERROR!! Ino[%lu]: extent not found", dirIno);
+      free(dir.exts);
       return Ext4::ERROR_INO;
     }
-    assert(szExts > 0);
 
-    size_t szBuf = 0;
-    for (size_t ie = 0; ie < szExts; ++ie)
-      szBuf += exts[ie].len * Ext4::BLK_SIZE;
-    pr("\tbuffer size: %lu", szBuf);
-
-    char *buf = (char *)malloc(szBuf);
-    if (!buf) {
-      perr("extent malloc fail");
-      free(exts);
-      return Ext4::ERROR_INO;
+    // this dir use htree, only a few blocks are read
+    if ((flags & EXT4_INDEX_FL) &&
+        this->dxSearchFile(tgName, tgNameLen, dirIno, dir,
+                           &cache.inode _add_sim_params)) {
+      free(dir.exts);
+      return cache.inode;
     }
 
-    for (size_t ie = 0; ie < szExts; ++ie) {
-      auto ofsBuf = ie * Ext4::BLK_SIZE;
-      auto ofsData = exts[ie].slbn * Ext4::BLK_SIZE;
-      auto szData = exts[ie].len * Ext4::BLK_SIZE;
-      FTL::read(&buf[ofsBuf], ofsData, szData _add_sim_params);
-    }
+    auto it = this->openDir(dirIno, dir _add_sim_params);
 
-    // search dir entries
+    // search dir entries linearly, index blocks of htree look like empty ones
+    Dirent d;
     cache.inode = Ext4::ERROR_INO;
-    if (ino.i_flags & EXT4_INDEX_FL) {
-      // this dir use htree
-      pr("dirent: htree struct not supported");
-    }
-    else {
-      // simple linear struct
-      for (size_t ie [[maybe_unused]] = 0, ofs = 0; ofs < szBuf; ++ie) {
-        auto node = (dx_node *)&buf[ofs];
-        auto ino = node->fake.inode;
-        auto nlen = node->fake.name_len;
-        auto rlen = node->fake.rec_len;
-        auto name = &node->data;
-
-        if (!ino && rlen < sizeof(fake_dirent))  // ino 0 indicates last entry
-          break;
-
-        if (tgNameLen == nlen && !strncmp(name, tgName, tgNameLen)) {
-          // don't break immediately, add all to cache
-          cache.inode = ino;
-        }
-
-        // cache all namei ever seen, not the target only
-        NameiNode tmp(dirIno, name, nlen, ino);
-        pr("NameiCache add %lu::'%s'", tmp.diri, tmp.name);
-        this->NameiCache->write(0, 0, &tmp _add_sim_params);
-
-        ofs += rlen;
+    while (it->next(&d)) {
+      if (tgNameLen == d.nameLen && !strncmp(d.name, tgName, tgNameLen)) {
+        // don't break immediately, add all to cache
+        cache.inode = d.ino;
       }
+
+      // cache all namei ever seen, not the target only
+      NameiNode tmp(dirIno, d.name, d.nameLen, d.ino);
+      pr("NameiCache add %lu::'%s'", tmp.diri, tmp.name);
+      this->NameiCache->write(0, 0, &tmp _add_sim_params);
     }
 
     if (cache.inode == Ext4::ERROR_INO) {
       pr("component '%s' not found...| szExts = %lu | tgNameLen = %lu", tgName,
-         szExts, tgNameLen);
+         dir.len, tgNameLen);
     }
     else {
       pr("component found: Ino[%lu]", cache.inode);
     }
 
-    free(exts);
-    free(buf);
+    free(dir.exts);
+    delete it;
     return cache.inode;
   };
 
@@ -797,22 +1238,143 @@ Ext4::ino_t Ext4::namei(const char *p _ADD_SIM_PARAMS) {
 
 GenericFSA::ExtList Ext4::builtin_getExt(const char *p _ADD_SIM_PARAMS) {
   ExtList list;
-
-  inode ino;
   ino_t inoNum = namei(p _add_sim_params);
 
-  if (inoNum != Ext4::ERROR_INO) {
-    list.exts = getExtent(inoNum, &list.len, &ino _add_sim_params);
-    list.bytes = CAT3232(ino.i_size_high, ino.i_size_lo);
-  }
+  if (inoNum != Ext4::ERROR_INO)
+    list = getExtList(inoNum, nullptr _add_sim_params);
   else
     pr("File '%s' not found...", p);
   return list;
 }
 
+GenericFSA::DirIter *Ext4::builtin_openDir(const char *p _ADD_SIM_PARAMS) {
+  auto doit = [this](const char *p _ADD_SIM_PARAMS) -> DirIter * {
+    ino_t dirIno = namei(p _add_sim_params);
+    if (dirIno == Ext4::ERROR_INO) {
+      pr("Dir '%s' not found...", p);
+      return nullptr;
+    }
+
+    auto dir = this->getExtList(dirIno, nullptr _add_sim_params);
+    if (!dir.exts) {
+      pr("ERROR!! Ino[%lu]: extent not found", dirIno);
+      return nullptr;
+    }
+
+    auto it = this->openDir(dirIno, dir _add_sim_params);
+    free(dir.exts);
+    return it;
+  };
+
+  auto res = doit(p _add_sim_params);
+  simApplyLatency(CPU::ISC__FSA__EXT4, CPU::ISC__GET_EXTENT);
+  return res;
+}
+
+/**
+ * @brief Get extents of all files in the given dir by one pass of its entries
+ *
+ * The entries are all cached by the namei cache as dirSearchFile does, and
+ * the extents of files are from the extent cache when possible, so neither a
+ * path walk nor a dir search is needed per file.
+ */
+std::vector<GenericFSA::ExtList> Ext4::builtin_getExtsForDir(
+    const char *p, bool regOnly _ADD_SIM_PARAMS) {
+  auto doit = [this](const char *p, bool regOnly _ADD_SIM_PARAMS) {
+    std::vector<ExtList> files;
+
+    auto it = this->builtin_openDir(p _add_sim_params);
+    if (!it)
+      return files;
+
+    Dirent d;
+    while (it->next(&d)) {
+      NameiNode tmp(it->getIno(), d.name, d.nameLen, d.ino);
+      this->NameiCache->write(0, 0, &tmp _add_sim_params);
+
+      if (d.type == 2 /* dir */ || (regOnly && d.type != 1 /* regular */))
+        continue;
+
+      pr("[%lu]: '%s'", files.size(), tmp.name);
+      files.push_back(getExtList(d.ino, nullptr _add_sim_params));
+    }
+
+    delete it;
+    return files;
+  };
+
+  auto res = doit(p, regOnly _add_sim_params);
+  simApplyLatency(CPU::ISC__FSA__EXT4, CPU::ISC__DIR_SEARCH_FILE);
+  return res;
+}
+
 void *Ext4::builtin_getInode(uint64_t ino _ADD_SIM_PARAMS) {
   return Ext4::getInode(ino _add_sim_params);
 }
 
+/**
+ * @brief Get inodes into an array of Ext4::inode by blocks of inode table
+ *
+ * A run of inodes in the same group and within Ext4::INODE_BATCH_BLKS blocks
+ * of the inode table is read by one request, so sorted inode numbers, e.g.,
+ * entries of a dir created together, take a few reads for many inodes.
+ */
+size_t Ext4::builtin_getInodes(const uint64_t *inos, size_t n,
+                               void *out _ADD_SIM_PARAMS) {
+  size_t runs = 0;
+  auto doit = [this, &runs](const uint64_t *inos, size_t n,
+                            inode *out _ADD_SIM_PARAMS) -> size_t {
+    auto ipg = this->sb->s_inodes_per_group;
+    size_t szIno = this->sb->s_inode_size;
+    size_t szCopy = std::min(szIno, sizeof(inode));
+
+    auto buf = (byte *)malloc(Ext4::INODE_BATCH_BLKS * Ext4::BLK_SIZE);
+    if (!buf) {
+      perr("inode table buffer malloc fail");
+      return 0;
+    }
+
+    size_t i = 0;
+    while (i < n && inos[i]) {
+      grp_t iGrp = (inos[i] - 1) / ipg;
+      group_desc *gd = this->getGrpDesc(iGrp _add_sim_params);
+      if (!gd) {
+        pr("gd malloc fail");
+        break;
+      }
+      blk_t baseITab = CAT3232U(gd->bg_inode_table_hi, gd->bg_inode_table_lo);
+      free(gd);
+
+      // blocks of the run, relative to the inode table
+      size_t iBlk0 = (inos[i] - 1) % ipg * szIno / Ext4::BLK_SIZE;
+      size_t nBlks = 0, j = i;
+      for (; j < n && inos[j] && (inos[j] - 1) / ipg == iGrp; ++j) {
+        size_t iBlk = (inos[j] - 1) % ipg * szIno / Ext4::BLK_SIZE;
+        if (iBlk < iBlk0 || iBlk >= iBlk0 + Ext4::INODE_BATCH_BLKS)
+          break;
+        nBlks = std::max(nBlks, iBlk - iBlk0 + 1);
+      }
+
+      pr("Group[%lu]: read %lu inodes in %lu blocks", iGrp, j - i, nBlks);
+      FTL::read(buf, (baseITab + iBlk0) * Ext4::BLK_SIZE,
+                nBlks * Ext4::BLK_SIZE _add_sim_params);
+      ++runs;
+
+      for (; i < j; ++i) {
+        size_t ofs = (inos[i] - 1) % ipg * szIno - iBlk0 * Ext4::BLK_SIZE;
+        memcpy(&out[i], &buf[ofs], szCopy);
+        memset((byte *)&out[i] + szCopy, 0, sizeof(inode) - szCopy);
+      }
+    }
+
+    free(buf);
+    return i;
+  };
+
+  auto res = doit(inos, n, (inode *)out _add_sim_params);
+  simApplyManyLatency(CPU::ISC__FSA__EXT4, CPU::ISC__GET_INODE, runs);
+  return res;
+}
+
 }  // namespace ISC
 }  // namespace SimpleSSD
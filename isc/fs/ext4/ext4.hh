@@ -25,6 +25,15 @@ namespace ISC {
 #define EXT4_EXTENTS_FL 0x00080000 /* Inode uses extents */
 #define EXT4_EXTENT_HEADER_MAGIC 0xF30A
 
+#define EXT2_FLAGS_UNSIGNED_HASH 0x0002 /* Unsigned dirhash in use */
+#define DX_HASH_LEGACY 0
+#define DX_HASH_HALF_MD4 1
+#define DX_HASH_TEA 2
+#define DX_HASH_LEGACY_UNSIGNED 3
+#define DX_HASH_HALF_MD4_UNSIGNED 4
+#define DX_HASH_TEA_UNSIGNED 5
+#define EXT4_HTREE_LEVEL 3
+
 class Ext4 final : public GenericFSA {
  public:
   Ext4(_SIM_PARAMS);
@@ -300,11 +309,30 @@ class Ext4 final : public GenericFSA {
     __u8 file_type;
   };
 
+  struct dx_root_info {
+    __le32 reserved_zero;
+    __u8 hash_version;
+    __u8 info_length; /* 8 */
+    __u8 indirect_levels;
+    __u8 unused_flags;
+  };
+
   struct dx_root {
     struct fake_dirent dot;
     char dot_name[4];
     struct fake_dirent dotdot;
     char dotdot_name[4];
+    struct dx_root_info info;
+  };
+
+  struct dx_countlimit {
+    __le16 limit;
+    __le16 count;
+  };
+
+  struct dx_entry {
+    __le32 hash;
+    __le32 block;
   };
 
   struct dx_node {
@@ -322,8 +350,26 @@ class Ext4 final : public GenericFSA {
   static const ino_t ROOT_INO = 2;
   static const ino_t FIRST_INO = 12;
 
+  // files with more extents than this are not kept in the extent cache
+  static const size_t EXT_CACHE_NUM = 4096;
+  static const size_t EXT_CACHE_EXTS = 4;
+
   ExtList builtin_getExt(const char *_ADD_SIM_PARAMS) override;
+  std::vector<ExtList> builtin_getExtsForDir(const char *,
+                                             bool _ADD_SIM_PARAMS) override;
   void *builtin_getInode(uint64_t _ADD_SIM_PARAMS) override;
+  size_t builtin_getInodes(const uint64_t *, size_t,
+                           void *_ADD_SIM_PARAMS) override;
+  GenericFSA::DirIter *builtin_openDir(const char *_ADD_SIM_PARAMS) override;
+
+  // dir entries in blocks, index blocks of htree are skipped as empty ones
+  class DirIter : public GenericFSA::DirIter {
+   public:
+    DirIter(ino_t ino, size_t sz) : GenericFSA::DirIter(ino, sz) {}
+    bool next(Dirent *) override;
+
+    friend class Ext4;  // read blocks into data
+  };
 
 #ifdef ISC_TEST
  public:
@@ -334,6 +380,7 @@ class Ext4 final : public GenericFSA {
   SIM::DRAM::Region *grpCache;
   SIM::DRAM::Region *lruInoCache;
   SIM::DRAM::Region *NameiCache;
+  SIM::DRAM::Region *extCache;
 
   size_t szBlk;
   size_t nrBlks;
@@ -345,6 +392,8 @@ class Ext4 final : public GenericFSA {
   size_t szITab;
   size_t blksITab;
 
+  // max inode table blocks read at once by builtin_getInodes
+  static const size_t INODE_BATCH_BLKS = 16;
   static const size_t INODE_PREFETCH_NUM = 128;
   static const size_t INODE_PREFETCH_THRESHOLD = 16;
   ino_t lastIno = 0;
@@ -358,6 +407,7 @@ class Ext4 final : public GenericFSA {
   bitmap_t getInoMap(ino_t _ADD_SIM_PARAMS);
   inode *getInode(ino_t _ADD_SIM_PARAMS);
   Ext *getExtent(ino_t, size_t *, inode *_ADD_SIM_PARAMS);
+  ExtList getExtList(ino_t, uint32_t *_ADD_SIM_PARAMS);
   ino_t namei(const char *_ADD_SIM_PARAMS);
 
   static inline bool testIMap(const bitmap_t bm, ino_t ino,
@@ -369,7 +419,11 @@ class Ext4 final : public GenericFSA {
   static void extractExtents(blk_t, byte *, Ext *, size_t, size_t,
                              size_t *_ADD_SIM_PARAMS);
 
+  DirIter *openDir(ino_t, const ExtList &_ADD_SIM_PARAMS);
   ino_t dirSearchFile(const char *, size_t, ino_t _ADD_SIM_PARAMS);
+  bool dxSearchFile(const char *, size_t, ino_t, const ExtList &,
+                    ino_t *_ADD_SIM_PARAMS);
+  static uint32_t dirHash(const char *, size_t, int, const uint32_t *);
   ino_t getParentInode(ino_t _ADD_SIM_PARAMS);
 };
 
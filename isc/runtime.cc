@@ -2,7 +2,10 @@
 
 using namespace SimpleSSD::ISC::SIM;
 
+#include <algorithm>
 #include <cstring>
+#include <deque>
+#include <vector>
 
 #include "runtime.hh"
 #include "types.hh"
@@ -16,11 +19,130 @@ namespace ISC {
 /*                          init static class members                         */
 /* -------------------------------------------------------------------------- */
 
+std::mutex Runtime::lock;
 ISC_STS_SLET_ID Runtime::nextSletId = 0;
 ISC_STS_SLET_ID Runtime::nextFSAId = 0;
 
-list<pair<ISC_STS_SLET_ID, GenericSlet *>> Runtime::lSlet;
-list<pair<ISC_STS_SLET_ID, GenericFSA *>> Runtime::lFSA;
+std::vector<std::shared_ptr<GenericSlet>> Runtime::vSlet;
+std::vector<std::shared_ptr<GenericFSA>> Runtime::vFSA;
+Runtime::MountTable Runtime::mounts;
+size_t Runtime::curCore = 0;
+
+/* -------------------------------------------------------------------------- */
+/*                                 mount table                                */
+/* -------------------------------------------------------------------------- */
+
+void Runtime::MountTable::insert(const char *path, ISC_STS_SLET_ID id) {
+  auto node = &root;
+
+  while (*path) {
+    auto child = std::find_if(
+        node->children.begin(), node->children.end(),
+        [path](const std::unique_ptr<Node> &c) { return c->edge[0] == *path; });
+    if (child == node->children.end()) {
+      node->children.emplace_back(new Node(path, id));
+      return;
+    }
+
+    // split the edge at the end of common prefix
+    auto &edge = (*child)->edge;
+    size_t len = 0;
+    while (len < edge.size() && edge[len] == path[len])
+      ++len;
+    if (len < edge.size()) {
+      std::unique_ptr<Node> mid(new Node(edge.substr(0, len), ISC_STS_EID));
+      edge.erase(0, len);
+      mid->children.push_back(std::move(*child));
+      *child = std::move(mid);
+    }
+
+    path += len;
+    node = child->get();
+  }
+
+  // the first FSA mounted at a path keeps it
+  if (node->id == ISC_STS_EID)
+    node->id = id;
+}
+
+ISC_STS_SLET_ID Runtime::MountTable::lookup(const char *path) const {
+  auto node = &root;
+  auto id = root.id;
+
+  while (*path) {
+    auto child = std::find_if(
+        node->children.begin(), node->children.end(),
+        [path](const std::unique_ptr<Node> &c) { return c->edge[0] == *path; });
+    if (child == node->children.end() ||
+        strncmp(path, (*child)->edge.c_str(), (*child)->edge.size()))
+      break;
+
+    path += (*child)->edge.size();
+    node = child->get();
+    if (node->id != ISC_STS_EID)
+      id = node->id;
+  }
+  return id;
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                  registry                                  */
+/* -------------------------------------------------------------------------- */
+
+ISC_STS_SLET_ID Runtime::add(GenericSlet *slet) {
+  std::lock_guard<std::mutex> guard(lock);
+  auto id = ISC_STS_EID;
+
+  if (auto fsa = dynamic_cast<GenericFSA *>(slet)) {
+    id = ++nextFSAId;
+    vFSA.resize(id + 1);
+    vFSA[id].reset(fsa);
+    auto cwd = fsa->getOpt<const char>(GenericSlet::keyCwd);
+    if (cwd)
+      mounts.insert(cwd, id);
+    pr("FSA id %d mounted at '%s'", id, cwd ? cwd : "(none)");
+  }
+  else if (dynamic_cast<GenericAPP *>(slet)) {
+    id = ++nextSletId;
+    vSlet.resize(id + 1);
+    vSlet[id].reset(slet);
+  }
+  else {
+    delete slet;
+    pr("WARN!!! not expected to be here, compiler should complain");
+  }
+  return id;
+}
+
+std::shared_ptr<GenericSlet> Runtime::findSlet(ISC_STS_SLET_ID id) {
+  std::lock_guard<std::mutex> guard(lock);
+  if (id <= 0 || (size_t)id >= vSlet.size())
+    return nullptr;
+  return vSlet[id];
+}
+
+std::shared_ptr<GenericFSA> Runtime::findFSA(const char *path) {
+  std::lock_guard<std::mutex> guard(lock);
+  auto id = mounts.lookup(path);
+  if (id == ISC_STS_EID)
+    return nullptr;
+  return vFSA[id];
+}
+
+void Runtime::destory() {
+  std::lock_guard<std::mutex> guard(lock);
+  for (size_t id = 0; id < vSlet.size(); ++id) {
+    if (vSlet[id])
+      pr("APP id %lu deleted", id);
+  }
+  vSlet.clear();
+  for (size_t id = 0; id < vFSA.size(); ++id) {
+    if (vFSA[id])
+      pr("FSA id %lu deleted", id);
+  }
+  vFSA.clear();
+  mounts.clear();
+}
 
 /* -------------------------------------------------------------------------- */
 /*                       major function implementations                       */
@@ -28,28 +150,19 @@ list<pair<ISC_STS_SLET_ID, GenericFSA *>> Runtime::lFSA;
 
 ISC_STS Runtime::delSlet(ISC_STS_SLET_ID id) {
   pr("Del slet %d", id);
+  std::lock_guard<std::mutex> guard(lock);
 
-  size_t nRemoved = 0;
-  lSlet.remove_if(
-      [id, &nRemoved](pair<ISC_STS_SLET_ID, GenericSlet *> _slet) mutable {
-        if (_slet.first == id) {
-          nRemoved++;
-          delete _slet.second;
-          pr("Slet[%d] deleted", id);
-          return true;
-        }
-        return false;
-      });
-
-  pr("%ld slets are removed", nRemoved);
-  pr("Remains %lu slets", lSlet.size());
+  if (id > 0 && (size_t)id < vSlet.size() && vSlet[id]) {
+    vSlet[id].reset();
+    pr("Slet[%d] deleted", id);
+  }
   return ISC_STS_OK;
 }
 
 ISC_STS Runtime::startSlet(ISC_STS_SLET_ID id _ADD_SIM_PARAMS) {
   auto doit = [](ISC_STS_SLET_ID id _ADD_SIM_PARAMS) -> ISC_STS {
     pr("Start slet %d", id);
-    GenericSlet *slet = Runtime::findSlet(id);
+    auto slet = Runtime::findSlet(id);
     if (!slet) {
       pr("Slet %d: not found", id);
       return ISC_STS_EID;
@@ -62,17 +175,68 @@ ISC_STS Runtime::startSlet(ISC_STS_SLET_ID id _ADD_SIM_PARAMS) {
   return res;
 }
 
+#ifndef ISC_TEST
+ISC_STS Runtime::startSletAsync(ISC_STS_SLET_ID id,
+                                const GenericSlet::DoneFunc &done
+                                    _ADD_SIM_PARAMS) {
+  auto slet = Runtime::findSlet(id);
+  if (!slet || !slet->getOpt(GenericSlet::keyAsync))
+    return ISC_STS_EFUNC;
+
+  pr("Start slet %d by events", id);
+  auto res = slet->builtin_startAsync(
+      [slet, done](ISC_STS sts, uint64_t endAt) {
+        // held here until it ends, even if deleted meanwhile
+        pr("Slet %s ended at %lu: %d",
+           slet->getOpt<const char>(GenericSlet::keyName), endAt, sts);
+        endAt += applyLatency(CPU::ISC__RUNTIME, CPU::ISC__START_SLET);
+        done(sts, endAt);
+      } _add_sim_params);
+  if (res == ISC_STS_EFUNC)
+    pr("Slet %d: can't run by events", id);
+  return res;
+}
+#endif
+
 GenericFSA::ExtList Runtime::getExts(const char *path _ADD_SIM_PARAMS) {
-  // search all FSA and find the mount point
   auto doit = [](const char *path _ADD_SIM_PARAMS) -> GenericFSA::ExtList {
-    for (auto &fsa : lFSA) {
-      const char *cwd = (char *)fsa.second->getOpt("cwd");
-      if (!strncmp(path, cwd, strlen(cwd))) {
-        return fsa.second->builtin_getExt(path _add_sim_params);
-      }
+    auto fsa = Runtime::findFSA(path);
+    if (!fsa) {
+      pr("No appropriate FSA found for '%s'", path);
+      return GenericFSA::ExtList();
     }
-    pr("No appropriate FSA found for '%s'", path);
-    return GenericFSA::ExtList();
+    return fsa->builtin_getExt(path _add_sim_params);
+  };
+
+  auto res = doit(path _add_sim_params);
+  simApplyLatency(CPU::ISC__RUNTIME, CPU::ISC__GET_EXTENT);
+  return res;
+}
+
+std::vector<GenericFSA::ExtList> Runtime::getExtsForDir(
+    const char *path, bool regOnly _ADD_SIM_PARAMS) {
+  auto doit = [](const char *path, bool regOnly _ADD_SIM_PARAMS) {
+    auto fsa = Runtime::findFSA(path);
+    if (!fsa) {
+      pr("No appropriate FSA found for '%s'", path);
+      return std::vector<GenericFSA::ExtList>();
+    }
+    return fsa->builtin_getExtsForDir(path, regOnly _add_sim_params);
+  };
+
+  auto res = doit(path, regOnly _add_sim_params);
+  simApplyLatency(CPU::ISC__RUNTIME, CPU::ISC__GET_EXTENT);
+  return res;
+}
+
+GenericFSA::DirIter *Runtime::openDir(const char *path _ADD_SIM_PARAMS) {
+  auto doit = [](const char *path _ADD_SIM_PARAMS) -> GenericFSA::DirIter * {
+    auto fsa = Runtime::findFSA(path);
+    if (!fsa) {
+      pr("No appropriate FSA found for '%s'", path);
+      return nullptr;
+    }
+    return fsa->builtin_openDir(path _add_sim_params);
   };
 
   auto res = doit(path _add_sim_params);
@@ -82,14 +246,12 @@ GenericFSA::ExtList Runtime::getExts(const char *path _ADD_SIM_PARAMS) {
 
 void *Runtime::getInode(const char *path, uint64_t ino _ADD_SIM_PARAMS) {
   auto doit = [](const char *path, uint64_t ino _ADD_SIM_PARAMS) -> void * {
-    for (auto &fsa : lFSA) {
-      const char *cwd = (char *)fsa.second->getOpt("cwd");
-      if (!strncmp(path, cwd, strlen(cwd))) {
-        return fsa.second->builtin_getInode(ino _add_sim_params);
-      }
+    auto fsa = Runtime::findFSA(path);
+    if (!fsa) {
+      pr("No appropriate FSA found for '%s'", path);
+      return nullptr;
     }
-    pr("No appropriate FSA found for '%s'", path);
-    return nullptr;
+    return fsa->builtin_getInode(ino _add_sim_params);
   };
 
   auto res = doit(path, ino _add_sim_params);
@@ -97,24 +259,48 @@ void *Runtime::getInode(const char *path, uint64_t ino _ADD_SIM_PARAMS) {
   return res;
 }
 
-ISC_STS Runtime::setOpt(ISC_STS_SLET_ID id, const char *k,
+size_t Runtime::getInodes(const char *path, const uint64_t *inos, size_t n,
+                          void *out _ADD_SIM_PARAMS) {
+  auto doit = [](const char *path, const uint64_t *inos, size_t n,
+                 void *out _ADD_SIM_PARAMS) -> size_t {
+    auto fsa = Runtime::findFSA(path);
+    if (!fsa) {
+      pr("No appropriate FSA found for '%s'", path);
+      return 0;
+    }
+    return fsa->builtin_getInodes(inos, n, out _add_sim_params);
+  };
+
+  auto res = doit(path, inos, n, out _add_sim_params);
+  simApplyLatency(CPU::ISC__RUNTIME, CPU::ISC__GET_INODE);
+  return res;
+}
+
+ISC_STS Runtime::setOpt(ISC_STS_SLET_ID id, const SletKey &k,
                         void *v _ADD_SIM_PARAMS) {
-  auto doit = [](ISC_STS_SLET_ID id, const char *k, void *v _ADD_SIM_PARAMS) {
+  return setOpt(id, k, v, 0 _add_sim_params);
+}
+
+ISC_STS Runtime::setOpt(ISC_STS_SLET_ID id, const SletKey &k, void *v,
+                        size_t len _ADD_SIM_PARAMS) {
+  auto doit = [](ISC_STS_SLET_ID id, const SletKey &k, void *v,
+                 size_t len _ADD_SIM_PARAMS) {
     auto slet = Runtime::findSlet(id);
     if (!slet) {
       pr("Slet %d not found", id);
       return ISC_STS_FAIL;
     }
-    return slet->setOpt(k, v);
+    return slet->setOpt(k, v, len);
   };
 
-  auto res = doit(id, k, v _add_sim_params);
+  auto res = doit(id, k, v, len _add_sim_params);
   simApplyLatency(CPU::ISC__RUNTIME, CPU::ISC__SET_OPT);
   return res;
 }
 
-void *Runtime::getOpt(ISC_STS_SLET_ID id, const char *k _ADD_SIM_PARAMS) {
-  auto doit = [](ISC_STS_SLET_ID id, const char *k _ADD_SIM_PARAMS) -> void * {
+void *Runtime::getOpt(ISC_STS_SLET_ID id, const SletKey &k _ADD_SIM_PARAMS) {
+  auto doit = [](ISC_STS_SLET_ID id,
+                 const SletKey &k _ADD_SIM_PARAMS) -> void * {
     auto slet = Runtime::findSlet(id);
     if (!slet) {
       pr("Slet %d not found", id);
@@ -127,5 +313,114 @@ void *Runtime::getOpt(ISC_STS_SLET_ID id, const char *k _ADD_SIM_PARAMS) {
   return res;
 }
 
+size_t Runtime::getResult(ISC_STS_SLET_ID id, uint64_t ofs, void *buf,
+                          size_t len _ADD_SIM_PARAMS) {
+  auto doit = [](ISC_STS_SLET_ID id, uint64_t ofs, void *buf,
+                 size_t len _ADD_SIM_PARAMS) -> size_t {
+    auto app = std::dynamic_pointer_cast<GenericAPP>(Runtime::findSlet(id));
+    if (!app) {
+      pr("Slet %d not found", id);
+      return 0;
+    }
+    return app->getResult(ofs, buf, len _add_sim_params);
+  };
+  auto res = doit(id, ofs, buf, len _add_sim_params);
+  simApplyLatency(CPU::ISC__RUNTIME, CPU::ISC__GET_OPT);
+  return res;
+}
+
+size_t Runtime::getResultSize(ISC_STS_SLET_ID id, bool *done _ADD_SIM_PARAMS) {
+  auto doit = [](ISC_STS_SLET_ID id, bool *done) -> size_t {
+    auto app = std::dynamic_pointer_cast<GenericAPP>(Runtime::findSlet(id));
+    if (!app) {
+      pr("Slet %d not found", id);
+      *done = true;
+      return 0;
+    }
+    return app->getResultSize(done);
+  };
+  auto res = doit(id, done);
+  simApplyLatency(CPU::ISC__RUNTIME, CPU::ISC__GET_OPT);
+  return res;
+}
+
+/**
+ * Tasks are split into contiguous ranges, one per core, so neighbouring files
+ * stay on the same core. A core runs its tasks from the front, and once idle,
+ * steals from the back of the core with the most tasks left. Each core has its
+ * own clock starting from the caller's; the core with the earliest clock always
+ * goes next, and the caller resumes at the latest clock of them (join).
+ */
+ISC_STS Runtime::runTasks(size_t n, const Task &task _ADD_SIM_PARAMS) {
+  struct core_t {
+    std::deque<size_t> tasks;
+    uint64_t clock;
+    size_t numRun;
+    size_t numStolen;
+  };
+
+  auto numCores = std::max<size_t>(1, std::min(SIM::numCores(), n));
+  std::vector<core_t> cores(numCores);
+
+  for (size_t c = 0; c < numCores; ++c) {
+    for (size_t i = c * n / numCores; i < (c + 1) * n / numCores; ++i)
+      cores[c].tasks.push_back(i);
+#ifdef ISC_TEST
+    cores[c].clock = 0;
+#else
+    cores[c].clock = simTick;
+#endif
+    cores[c].numRun = cores[c].numStolen = 0;
+  }
+
+  auto res = ISC_STS_OK;
+  for (size_t left = n; left && res == ISC_STS_OK; --left) {
+    auto core = std::min_element(
+        cores.begin(), cores.end(),
+        [](const core_t &a, const core_t &b) { return a.clock < b.clock; });
+
+    size_t iTask;
+    if (core->tasks.size()) {
+      iTask = core->tasks.front();
+      core->tasks.pop_front();
+    }
+    else {
+      auto victim = std::max_element(cores.begin(), cores.end(),
+                                     [](const core_t &a, const core_t &b) {
+                                       return a.tasks.size() < b.tasks.size();
+                                     });
+      iTask = victim->tasks.back();
+      victim->tasks.pop_back();
+      core->numStolen++;
+#ifndef ISC_TEST
+      core->clock += applyLatency(CPU::ISC__RUNTIME, CPU::ISC__TASK2);
+#endif
+    }
+
+    curCore = core - cores.begin();
+    core->numRun++;
+#ifdef ISC_TEST
+    res = task(iTask);
+    core->clock++;  // no simulated time, tasks take one unit each
+#else
+    core->clock += applyLatency(CPU::ISC__RUNTIME, CPU::ISC__TASK1);
+    res = task(iTask, core->clock, simCtx);
+#endif
+    if (res != ISC_STS_OK)
+      pr("Task %lu failed on core %lu: %d", iTask, curCore, res);
+  }
+  curCore = 0;
+
+  for (auto &core : cores) {
+    pr("Core %lu: %lu tasks run, %lu stolen, until %lu",
+       (size_t)(&core - cores.data()), core.numRun, core.numStolen,
+       core.clock);
+#ifndef ISC_TEST
+    simTick = std::max(simTick, core.clock);
+#endif
+  }
+  return res;
+}
+
 }  // namespace ISC
 }  // namespace SimpleSSD
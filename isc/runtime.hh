@@ -1,6 +1,12 @@
 #ifndef __SIMPLESSD_ISC_RUNTIME_HH__
 #define __SIMPLESSD_ISC_RUNTIME_HH__
 
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
 #include "sims/cpu.hh"
 
 #include "types.hh"
@@ -13,10 +19,43 @@ namespace ISC {
 class Runtime {  // make this class semantically static
 
  private:
+  /**
+   * @brief Mount points of FSAs, the longest prefix of a path wins
+   *
+   * A radix trie on the bytes of mount points, so a lookup costs the length
+   * of the path no matter how many FSAs there are.
+   */
+  class MountTable {
+   public:
+    MountTable() : root("", ISC_STS_EID) {}
+
+    void insert(const char *, ISC_STS_SLET_ID);
+    ISC_STS_SLET_ID lookup(const char *) const;
+    void clear() { root.children.clear(); }
+
+   private:
+    struct Node {
+      std::string edge;    // label from the parent
+      ISC_STS_SLET_ID id;  // FSA mounted here, or ISC_STS_EID
+      std::vector<std::unique_ptr<Node>> children;
+
+      Node(const std::string &e, ISC_STS_SLET_ID i) : edge(e), id(i) {}
+    };
+
+    Node root;
+  };
+
+  // the registry is shared by all hosts, lookups only hold the lock to copy
+  // the slet out, and slets deleted while running are freed after they end
+  static std::mutex lock;
   static ISC_STS_SLET_ID nextSletId;
   static ISC_STS_SLET_ID nextFSAId;
-  static list<pair<ISC_STS_SLET_ID, GenericSlet *>> lSlet;
-  static list<pair<ISC_STS_SLET_ID, GenericFSA *>> lFSA;
+  static std::vector<std::shared_ptr<GenericSlet>> vSlet;  // indexed by id
+  static std::vector<std::shared_ptr<GenericFSA>> vFSA;    // indexed by id
+  static MountTable mounts;
+  static size_t curCore;
+
+  static ISC_STS_SLET_ID add(GenericSlet *);
 
  public:
   Runtime() = delete;
@@ -25,18 +64,7 @@ class Runtime {  // make this class semantically static
   /**
    * @brief delete all slets in the runtime
    */
-  static void destory() {
-    for (auto &s : lSlet) {
-      pr("APP id %d deleted", s.first);
-      delete s.second;
-    }
-    lSlet.clear();
-    for (auto &s : lFSA) {
-      pr("FSA id %d deleted", s.first);
-      delete s.second;
-    }
-    lFSA.clear();
-  }
+  static void destory();
 
   template <class S>
   static ISC_STS_SLET_ID addSlet(_SIM_PARAMS) {
@@ -44,43 +72,81 @@ class Runtime {  // make this class semantically static
         std::is_base_of<GenericAPP, S>() || std::is_base_of<GenericFSA, S>(),
         "Make sure your slet class is based on Generic(APP|FSA)");
 
-    const char *type;
-    auto slet = new S(_sim_params);
-    auto id = ISC_STS_EID;
-
-    if (dynamic_cast<GenericFSA *>(slet)) {
-      type = "FSA";
-      id = ++nextFSAId;
-      lFSA.push_back({id, (GenericFSA *)slet});
-    }
-    else if (dynamic_cast<GenericAPP *>(slet)) {
-      type = "APP";
-      id = ++nextSletId;
-      lSlet.push_back({id, slet});
-    }
-    else {
-      delete slet;
-      pr("WARN!!! not expected to be here, compiler should complain");
-    }
-
-    pr("Assign id %d to %s: %s (mangled name)", id, type, typeid(S).name());
+    auto id = add(new S(_sim_params));
+    pr("Assign id %d to %s (mangled name)", id, typeid(S).name());
     return id;
   }
   static ISC_STS delSlet(ISC_STS_SLET_ID id);
   static ISC_STS startSlet(ISC_STS_SLET_ID _ADD_SIM_PARAMS);
-  static ISC_STS setOpt(ISC_STS_SLET_ID, const char *, void *_ADD_SIM_PARAMS);
-  static void *getOpt(ISC_STS_SLET_ID, const char *_ADD_SIM_PARAMS);
+#ifndef ISC_TEST
+  /**
+   * @brief Start a slet driven by the event queue, if the host asked for it
+   *
+   * See GenericSlet::builtin_startAsync(), the slet is kept until it ends.
+   * The sim params are of the request which waits for the slet, so it shall
+   * not complete before the function is called.
+   *
+   * @return ISC_STS ISC_STS_EFUNC if keyAsync is not set or the slet can't run
+   * so, start it by startSlet() then
+   */
+  static ISC_STS startSletAsync(ISC_STS_SLET_ID,
+                                const GenericSlet::DoneFunc &_ADD_SIM_PARAMS);
+#endif
+  static ISC_STS setOpt(ISC_STS_SLET_ID, const SletKey &,
+                        void *_ADD_SIM_PARAMS);
+  // the same, telling the slet how many bytes the value has
+  static ISC_STS setOpt(ISC_STS_SLET_ID, const SletKey &, void *,
+                        size_t _ADD_SIM_PARAMS);
+  static void *getOpt(ISC_STS_SLET_ID, const SletKey &_ADD_SIM_PARAMS);
+
+  /**
+   * @brief Copy bytes of the result of a slet from the given offset
+   *
+   * A ring slet produces more of the result here, so the sim params shall be
+   * of the request which pulls it (the HIL::Request of the ISC-GET).
+   *
+   * @return size_t bytes copied, see GenericAPP::getResult
+   */
+  static size_t getResult(ISC_STS_SLET_ID, uint64_t, void *,
+                          size_t _ADD_SIM_PARAMS);
+  /**
+   * @brief Bytes of the result of a slet so far
+   *
+   * @param done set to whether the result is complete
+   */
+  static size_t getResultSize(ISC_STS_SLET_ID, bool *_ADD_SIM_PARAMS);
 
   static GenericFSA::ExtList getExts(const char *_ADD_SIM_PARAMS);
+  static std::vector<GenericFSA::ExtList> getExtsForDir(const char *,
+                                                        bool _ADD_SIM_PARAMS);
+  static GenericFSA::DirIter *openDir(const char *_ADD_SIM_PARAMS);
   static void *getInode(const char *, uint64_t _ADD_SIM_PARAMS);
+  static size_t getInodes(const char *, const uint64_t *, size_t,
+                          void *_ADD_SIM_PARAMS);
+
+  /**
+   * @brief A task of slet, the index of task is given
+   *
+   * Tasks are run one by one on the host, so they may read the slet without
+   * locks, but each task should only write its own part of the result.
+   */
+  typedef std::function<ISC_STS(size_t _ADD_SIM_PARAMS)> Task;
+
+  /**
+   * @brief Run tasks [0, n) on all ISC cores and join them
+   *
+   * @return ISC_STS the first failure of tasks, no task is started after it
+   */
+  static ISC_STS runTasks(size_t n, const Task & _ADD_SIM_PARAMS);
+
+  /**
+   * @brief The ISC core of the running task, 0 when out of runTasks
+   */
+  static size_t taskCore() { return curCore; }
 
  protected:
-  static inline GenericSlet *findSlet(ISC_STS_SLET_ID id) {
-    for (auto &s : lSlet)
-      if (s.first == id)
-        return s.second;
-    return nullptr;
-  }
+  static std::shared_ptr<GenericSlet> findSlet(ISC_STS_SLET_ID);
+  static std::shared_ptr<GenericFSA> findFSA(const char *);
 };
 
 #undef PR_SECTION
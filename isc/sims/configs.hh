@@ -6,7 +6,7 @@
 namespace SimpleSSD {
 namespace ISC {
 
-#define NUM_ISC_CORES 1
+#define NUM_ISC_CORES 1  // ISC cores of ISC_TEST, see ISCCoreCount in the config
 
 #define ISC_SUBCMD_MASK 0xFFFF00000000
 #define ISC_SUBCMD(slba) ((ISC_SUBCMD_MASK & (slba)) >> 32)
@@ -24,6 +24,12 @@ namespace ISC {
 #define ISC_SUBCMD_SCHEDULER_FCFS 0x0001
 #define ISC_SUBCMD_SCHEDULER_CREDIT 0x0002
 #define ISC_SUBCMD_SCHEDULER_FLIN 0x0003
+#define ISC_SUBCMD_SCHEDULER_DRR 0x0004
+
+// option = uid << 16 | weight, kept by the HIL across scheduler switches
+#define ISC_SUBCMD_SCHEDULER_WEIGHT 0x0011
+#define ISC_WEIGHT_UID(opt) (((opt) >> 16) & 0xFFFF)
+#define ISC_WEIGHT_VAL(opt) ((opt)&0xFFFF)
 
 #define ISC_SUBCMD_OPT_MASK 0x0000FFFFFFFF
 #define ISC_SUBCMD_OPT(slba) (ISC_SUBCMD_OPT_MASK & (slba))
@@ -34,6 +40,9 @@ namespace ISC {
 #define ISC_KEY_NAME "name"
 #define ISC_KEY_RESULT "result"
 #define ISC_KEY_RESULT_SIZE "result-size"
+#define ISC_KEY_RESULT_RING "result-ring"
+#define ISC_KEY_CODEC "codec"
+#define ISC_KEY_ASYNC "async"
 
 #define ISC_OPCODE_SET 0xC1
 #define ISC_OPCODE_GET 0xC2
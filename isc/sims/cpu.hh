@@ -6,6 +6,7 @@
 #ifdef ISC_TEST
 #include <functional>
 
+#include "sims/configs.hh"
 #include "utils/debug.hh"
 #else
 #include "cpu/def.hh"
@@ -47,10 +48,14 @@ typedef enum : uint16_t {
   ISC__SLET__MD5,
   ISC__SLET__STATS32,
   ISC__SLET__STATS64,
+  ISC__SLET__HASH,
+  ISC__SLET__SCAN,
 
   //Scheduler
   CREDIT_SCHEDULER,
   FCFS_SCHEDULER,
+  DRR_SCHEDULER,
+  FLIN_SCHEDULER,
 
   // add before this
   NS_COUNT,
@@ -83,12 +88,17 @@ typedef enum : uint16_t {
   ISC__TASK3,
   ISC__TASK4,
   ISC__TASK5,
+  ISC__VTASK1,  // vectorized tasks, one 128-bit vector step per call
   ISC__ADD_SLET__EXT4,
   ISC__ADD_SLET__GREP,
   ISC__ADD_SLET__STATDIR,
   ISC__ADD_SLET__MD5,
   ISC__ADD_SLET__STATS32,
   ISC__ADD_SLET__STATS64,
+  ISC__ADD_SLET__HASH,
+  ISC__ADD_SLET__SCAN,
+  ISC__DECODE_LZ4,   // decoding of streams, per 64 bytes output
+  ISC__DECODE_ZSTD,
   
   //Scheduler
   SCHEDULE,
@@ -114,6 +124,16 @@ typedef enum : uint16_t {
 static inline void execute(CPU::NS, CPU::FCT, DMA &, void *, uint64_t);
 static inline void applyLatency(CPU::NS, CPU::FCT, size_t = 0) {}
 
+/**
+ * @brief Number of ISC cores which run the tasks of a slet
+ *
+ * There is no config for testing, tests may assign it to model more cores.
+ */
+inline size_t &numCores() {
+  static size_t n = NUM_ISC_CORES;
+  return n;
+}
+
 #define simTick
 #define simCtx
 #define _sim_params
@@ -136,6 +156,8 @@ typedef SimpleSSD::DMAFunction DMA;
 #define _ADD_SIM_PARAMS , _SIM_PARAMS
 #define _UNUSED_SIM_PARAMS unused_values(_sim_params)
 
+static inline size_t numCores() { return getISCCoreCount(); }
+
 #define simApplyLatency(ns, fct)                                               \
   do {                                                                         \
     auto old = simTick;                                                        \
@@ -5,10 +5,12 @@ using DRAM_SIM = SimpleSSD::DRAM::AbstractDRAM;
 #endif
 
 #include <cerrno>
+#include <cstdint>
 #include <cstdlib>
 
 #include <algorithm>
 #include <list>
+#include <vector>
 
 #include "sims/dram.hh"
 #include "utils/debug.hh"
@@ -55,10 +57,12 @@ class LRURegion : public BaseRegion {
         ofsLRU.remove(ofs);
         ofsLRU.push_front(ofs);
         pr("Found data at offset: %lu", ofs);
+        stat.hits++;
         return BaseRegion::read(ofs, unit, dat _add_sim_params);
       }
     }
     pr("Required data not exists or already be evicted");
+    stat.misses++;
     return -ENOENT;
   }
 
@@ -82,6 +86,7 @@ class LRURegion : public BaseRegion {
       ofsLRU.pop_back();
       ofsLRU.push_front(ofs);
       pr("Evict data at offset %lu", ofs);
+      stat.evictions++;
     }
     else {
       assert(ofsFree.size() > 0);
@@ -94,6 +99,118 @@ class LRURegion : public BaseRegion {
   }
 };
 
+/**
+ * @brief LRU cache with a hash index on the key of entries
+ *
+ * Slots are linked by index into a doubly linked LRU list and into singly
+ * linked hash chains, so get, put and evict are O(1) on average.
+ */
+class HashLRURegion : public BaseRegion {
+  static const size_t NIL = SIZE_MAX;
+
+  struct Slot {
+    size_t prev, next;  // LRU list, head is the most recently used
+    size_t chain;       // next slot in the same bucket
+    uint64_t key;
+  };
+
+  Key_t keyOf;
+  std::vector<Slot> slots;
+  std::vector<size_t> buckets;
+  size_t mask;
+  size_t head, tail;
+  size_t used;  // slots [0, used) have been taken
+
+  size_t find(uint64_t key, const void *dat) {
+    for (auto i = buckets[key & mask]; i != NIL; i = slots[i].chain) {
+      if (slots[i].key == key && !cmp(addr + i * unit, dat, unit))
+        return i;
+    }
+    return NIL;
+  }
+
+  void unlink(size_t i) {
+    auto &s = slots[i];
+    (s.prev == NIL ? head : slots[s.prev].next) = s.next;
+    (s.next == NIL ? tail : slots[s.next].prev) = s.prev;
+  }
+
+  void pushFront(size_t i) {
+    slots[i].prev = NIL;
+    slots[i].next = head;
+    (head == NIL ? tail : slots[head].prev) = i;
+    head = i;
+  }
+
+  void unhash(size_t i) {
+    auto *p = &buckets[slots[i].key & mask];
+    while (*p != i)
+      p = &slots[*p].chain;
+    *p = slots[i].chain;
+  }
+
+ public:
+  HashLRURegion(void *a, size_t n, size_t u, Cmp_t c, Cpy_t cpi, Cpy_t cpo,
+                Key_t k)
+      : BaseRegion(a, n, u, c, cpi, cpo),
+        keyOf(k),
+        slots(n),
+        head(NIL),
+        tail(NIL),
+        used(0) {
+    size_t nbucket = 1;
+    while (nbucket < n)
+      nbucket <<= 1;
+    buckets.assign(nbucket, (size_t)NIL);
+    mask = nbucket - 1;
+  }
+
+  virtual int read(size_t, size_t, void *dat _ADD_SIM_PARAMS) override {
+    auto i = find(keyOf(dat), dat);
+    if (i == NIL) {
+      pr("Required data not exists or already be evicted");
+      stat.misses++;
+      return -ENOENT;
+    }
+
+    unlink(i);
+    pushFront(i);
+    pr("Found data at offset: %lu", i * unit);
+    stat.hits++;
+    return BaseRegion::read(i * unit, unit, dat _add_sim_params);
+  }
+
+  virtual int write(size_t, size_t, void *dat _ADD_SIM_PARAMS) override {
+    auto key = keyOf(dat);
+    auto i = find(key, dat);
+
+    if (i != NIL) {
+      unlink(i);
+      pr("Overwrite data at offset: %lu", i * unit);
+    }
+    else {
+      // evict if full
+      if (used == nmem) {
+        i = tail;
+        unlink(i);
+        unhash(i);
+        pr("Evict data at offset %lu", i * unit);
+        stat.evictions++;
+      }
+      else {
+        i = used++;
+        pr("Take unused offset: %lu", i * unit);
+      }
+
+      slots[i].key = key;
+      slots[i].chain = buckets[key & mask];
+      buckets[key & mask] = i;
+    }
+    pushFront(i);
+    return BaseRegion::write(i * unit, unit, dat _add_sim_params);
+  }
+};
+
 /* -------------------------------------------------------------------------- */
 /*                             init static members                            */
 /* -------------------------------------------------------------------------- */
@@ -104,6 +221,7 @@ void *DRAM::pDRAM;
 
 static size_t szUsed, szPeakUsed;
 static std::list<BaseRegion *> regions;
+static DRAM::Region::Stat statFreed;  // of the dealloc'ed regions
 
 /* -------------------------------------------------------------------------- */
 /*                          function implementations                          */
@@ -111,7 +229,7 @@ static std::list<BaseRegion *> regions;
 
 DRAM::Region *DRAM::alloc(size_t nmem, size_t unit, TYPES type,
                           Region::Cmp_t cmp, Region::Cpy_t cpi,
-                          Region::Cpy_t cpo) {
+                          Region::Cpy_t cpo, Region::Key_t key) {
   auto addr = calloc(nmem, unit);
   if (!addr) {
     panic("Unabled to allocate memory...");
@@ -128,6 +246,13 @@ DRAM::Region *DRAM::alloc(size_t nmem, size_t unit, TYPES type,
     case TYPES::LRU_CACHE:
       reg = new LRURegion(addr, nmem, unit, cmp, cpi, cpo);
       break;
+    case TYPES::HASH_LRU_CACHE:
+      if (!key) {
+        panic("Key function is required by a hash LRU region");
+        assert(0);
+      }
+      reg = new HashLRURegion(addr, nmem, unit, cmp, cpi, cpo, key);
+      break;
     default:
       reg = new BaseRegion(addr, nmem, unit, cmp, cpi, cpo);
   }
@@ -138,6 +263,11 @@ DRAM::Region *DRAM::alloc(size_t nmem, size_t unit, TYPES type,
 void DRAM::dealloc(DRAM::Region *reg) {
   auto it = std::find(regions.begin(), regions.end(), reg);
   if (it != regions.end()) {
+    auto &stat = reg->getStat();
+    statFreed.hits += stat.hits;
+    statFreed.misses += stat.misses;
+    statFreed.evictions += stat.evictions;
+
     szUsed -= (*it)->getSize();
     regions.erase(it);
     delete reg;
@@ -152,6 +282,44 @@ void DRAM::destroy() {
   regions.clear();
 }
 
+#ifndef ISC_TEST
+void DRAM::getStatList(std::vector<Stats> &list, std::string prefix) {
+  Stats temp;
+
+  temp.name = prefix + "cache.hits";
+  temp.desc = "Lookups hit in the cache regions";
+  list.push_back(temp);
+
+  temp.name = prefix + "cache.misses";
+  temp.desc = "Lookups missed in the cache regions";
+  list.push_back(temp);
+
+  temp.name = prefix + "cache.evictions";
+  temp.desc = "Entries evicted from the cache regions";
+  list.push_back(temp);
+}
+
+void DRAM::getStatValues(std::vector<double> &values) {
+  auto total = statFreed;
+  for (auto &reg : regions) {
+    auto &stat = reg->getStat();
+    total.hits += stat.hits;
+    total.misses += stat.misses;
+    total.evictions += stat.evictions;
+  }
+
+  values.push_back(total.hits);
+  values.push_back(total.misses);
+  values.push_back(total.evictions);
+}
+
+void DRAM::resetStatValues() {
+  statFreed = {0, 0, 0};
+  for (auto &reg : regions)
+    reg->resetStat();
+}
+#endif
+
 // Wrappers for external managed memory
 void DRAM::read(void *data, size_t sz _ADD_SIM_PARAMS) {
 #ifdef ISC_TEST
@@ -7,6 +7,13 @@
 #include <cstdlib>
 #include <cstring>
 
+#ifndef ISC_TEST
+#include <string>
+#include <vector>
+
+#include "sim/statistics.hh"
+#endif
+
 #include "sims/cpu.hh"
 
 namespace SimpleSSD {
@@ -28,12 +35,22 @@ class DRAM {
   enum TYPES {
     NORMAL,
     LRU_CACHE,
+    HASH_LRU_CACHE,  // LRU_CACHE indexed by the key of Region::Key_t
   };
 
   class Region {
    public:
     typedef int (*Cmp_t)(const void *, const void *, size_t);
     typedef void *(*Cpy_t)(void *, const void *, size_t);
+    // hash of the key in the buffer given to read/write, entries of the same
+    // key hash are still told apart by Cmp_t
+    typedef uint64_t (*Key_t)(const void *);
+
+    struct Stat {
+      uint64_t hits;
+      uint64_t misses;
+      uint64_t evictions;
+    };
 
    protected:
     char *addr;
@@ -44,6 +61,8 @@ class DRAM {
     Cmp_t cmp;
     Cpy_t cpin, cpout;
 
+    Stat stat;
+
    public:
     virtual ~Region() { free(addr); }
     Region(void *a, size_t n, size_t u, Cmp_t cm, Cpy_t cpi, Cpy_t cpo)
@@ -53,10 +72,16 @@ class DRAM {
           size(n * u),
           cmp(cm),
           cpin(cpi),
-          cpout(cpo) {}
+          cpout(cpo),
+          stat{0, 0, 0} {}
     Region() : Region(nullptr, 0, 0, nullptr, memcpy, memcpy) {}
 
     size_t getSize() { return size; }
+    // raw memory of the region, e.g., as the DMA target of flash reads
+    char *getAddr() { return addr; }
+    // lookups and evictions of cache regions
+    const Stat &getStat() { return stat; }
+    void resetStat() { stat = {0, 0, 0}; }
 
     virtual int read(size_t, size_t sz, void *data _ADD_SIM_PARAMS) = 0;
     virtual int write(size_t, size_t sz, void *data _ADD_SIM_PARAMS) = 0;
@@ -66,9 +91,16 @@ class DRAM {
 
   static Region *alloc(size_t, size_t, TYPES = TYPES::NORMAL,
                        Region::Cmp_t = memcmp, Region::Cpy_t = memcpy,
-                       Region::Cpy_t = memcpy);
+                       Region::Cpy_t = memcpy, Region::Key_t = nullptr);
   static void dealloc(Region *);
 
+#ifndef ISC_TEST
+  // cache stats of all regions, including the dealloc'ed ones
+  static void getStatList(std::vector<Stats> &, std::string);
+  static void getStatValues(std::vector<double> &);
+  static void resetStatValues();
+#endif
+
   static inline void read(void *data, size_t sz _ADD_SIM_PARAMS);
   static inline void write(void *data, size_t sz _ADD_SIM_PARAMS);
 };
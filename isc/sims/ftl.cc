@@ -1,22 +1,27 @@
+#include <algorithm>
 #include <cmath>
 #include <fcntl.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <unistd.h>
 
+#include <queue>
+#include <vector>
 
 #ifndef ISC_TEST
-#include "hil/hil.hh"
+#include "hil/hil.hh"  // for gScheduler
 #include "hil/nvme/subsystem.hh"
 #include "icl/icl.hh"
 #include "hil/scheduler/scheduler.hh"
 #include "hil/scheduler/credit_scheduler.hh"
+#include "sim/simulator.hh"
 #endif
 
 #include "sims/ftl.hh"
 
 #include "utils/debug.hh"
 #include "utils/math.hh"
-#include "hil/hil.hh"  // for gScheduler
 
 #define PR_SECTION LOG_ISC_UTIL_FTL
 
@@ -35,7 +40,9 @@ namespace SIM {
 
 static constexpr double ISC_PAGE_FACTOR = 1.15;  // derived from 500MB/4610ms experiment
 
+#ifndef ISC_TEST
 using SimpleSSD::HIL::Request;   // for convenience
+#endif
 
 
 /* -------------------------------------------------------------------------- */
@@ -46,132 +53,316 @@ size_t FTL::lbaSize;
 char *FTL::pathFilesystemImg;
 void *FTL::cache;
 
+int FTL::fdImg = -1;
+char *FTL::mapImg;
+size_t FTL::szImg;
+
+#ifndef ISC_TEST
+// reads of submitBatch() issued to the ICL, the earliest completion on top
+struct LaterDone {
+  bool operator()(const ISCRequestContext *a,
+                  const ISCRequestContext *b) const {
+    return a->doneAt > b->doneAt;
+  }
+};
+static std::priority_queue<ISCRequestContext *,
+                           std::vector<ISCRequestContext *>, LaterDone>
+    inflight;
+static Event completionEvent = 0;  // allocated by the first submitBatch()
+#endif
+
 /* -------------------------------------------------------------------------- */
 /*                             impl util functions                            */
 /* -------------------------------------------------------------------------- */
 
-void FTL::setImage(const char *p, size_t bsz) {
-  if (pathFilesystemImg)
-    free(pathFilesystemImg);
+void FTL::setImage(const char *p, size_t bsz, BACKEND backend) {
+  FTL::destory();
   pathFilesystemImg = strdup(p);
-
   FTL::lbaSize = bsz;
-  pr("Setup disk image: '%s'", p);
+
+#ifdef ISC_TEST
+  // allow switching the backend without rebuilding tests (see `make bench`)
+  auto env = getenv("ISC_TEST_FTL_BACKEND");
+  if (env && !strcmp(env, "pread"))
+    backend = PREAD;
+  else if (env && !strcmp(env, "mmap"))
+    backend = MMAP;
+#endif
+
+  struct stat st;
+  if ((fdImg = open(p, O_RDONLY)) == -1) {
+    perr("open() fail");
+    return;
+  }
+  if (fstat(fdImg, &st) == -1) {
+    perr("fstat() fail");
+    return;
+  }
+  szImg = st.st_size;
+
+  if (backend == MMAP && szImg) {
+    auto map = mmap(nullptr, szImg, PROT_READ, MAP_SHARED, fdImg, 0);
+    if (map == MAP_FAILED)
+      perr("mmap() fail, fallback to pread()");
+    else
+      mapImg = (char *)map;
+  }
+
+  pr("Setup disk image: '%s' (%lu bytes, %s)", p, szImg,
+     mapImg ? "mmap" : "pread");
 }
 
+void FTL::destory() {
+  if (mapImg)
+    munmap(mapImg, szImg);
+  if (fdImg != -1)
+    close(fdImg);
+  mapImg = nullptr;
+  fdImg = -1;
+  szImg = 0;
+
+  free(pathFilesystemImg);
+  pathFilesystemImg = nullptr;
+
 #ifndef ISC_TEST
-// for functions not apply the SimpleSSD-styled latency handling
-void FTL::read(void *buf, size_t ofs, size_t sz) {
+  // reads still waiting for the credit scheduler are left to it
+  for (; !inflight.empty(); inflight.pop()) {
+    delete (Request *)inflight.top()->originalSimCtx;
+    delete inflight.top();
+  }
+  if (completionEvent)
+    SimpleSSD::deallocate(completionEvent);
+  completionEvent = 0;
+#endif
+}
+
+// copy image data to buffer, by the mapped image if possible
+void FTL::hostRead(void *buf, size_t ofs, size_t sz) {
   pr("Read (ofs,sz=%lu,%lu) to %p", ofs, sz, buf);
-  // open and read the pathFilesystemImage to buffer
-  int fd;
   ssize_t szRead;
 
   if (!buf) {
     pr("buffer is null!!");
-    goto out;
+    return;
   }
-  if ((fd = open(FTL::pathFilesystemImg, O_RDONLY)) == -1) {
-    perr("open() fail");
-    goto out;
+  if (mapImg && ofs + sz <= szImg) {
+    memcpy(buf, &mapImg[ofs], sz);
+    return;
+  }
+  if (fdImg == -1) {
+    perr("image is not opened");
+    return;
   }
 
-  if ((szRead = pread(fd, buf, sz, ofs)) == -1)
+  if ((szRead = pread(fdImg, buf, sz, ofs)) == -1)
     perr("pread() fail");
   else if ((size_t)szRead != sz)
     pr("Expect %lu bytes read, but got %ld", sz, szRead);
-
-  close(fd);
-out:
-  return;
 }
-#endif
-
-void FTL::read(void *buf, size_t ofs, size_t sz _ADD_SIM_PARAMS) {
-  auto doit = [](void *buf, size_t ofs, size_t sz _ADD_SIM_PARAMS) {
-    pr("Read (ofs,sz=%lu,%lu) to %p", ofs, sz, buf);
-    // open and read the pathFilesystemImage to buffer
-    int fd;
-    ssize_t szRead;
-
-    if (!buf) {
-      pr("buffer is null!!");
-      goto out;
-    }
-    if ((fd = open(FTL::pathFilesystemImg, O_RDONLY)) == -1) {
-      perr("open() fail");
-      goto out;
-    }
 
-    if ((szRead = pread(fd, buf, sz, ofs)) == -1)
-      perr("pread() fail");
-    else if ((size_t)szRead != sz)
-      pr("Expect %lu bytes read, but got %ld", sz, szRead);
-
-    close(fd);
-  out:
-    return;
-  };
+#ifndef ISC_TEST
+void FTL::setCache(void *pICL) {
+  FTL::cache = pICL;
+}
 
-  /* ---------- SimpleSSD Fast Path  ---------- */
+// number of credits (pages) charged for reading the converted request
+static uint64_t creditPages(ICL::Request &cReq) {
+  uint64_t basePages = cReq.range.nlp ? cReq.range.nlp : 1;  // true number of LPNs
+  double weighted = static_cast<double>(basePages) * ISC_PAGE_FACTOR;
+  uint64_t pages =
+      static_cast<uint64_t>(std::ceil(weighted));  // effective credit charge
+  return pages ? pages : 1;
+}
 
-#ifndef ISC_TEST
-  auto hReq = *(HIL::Request *)simCtx;
+// convert the byte range to the LBA range of the ISC request
+void FTL::convertRequest(void *req, size_t ofs, size_t sz) {
+  auto &hReq = *(HIL::Request *)req;
   auto ns = (HIL::NVMe::Namespace *)hReq.ns;
-    
+
   size_t slba = ofs / FTL::lbaSize;
   size_t nlblk = (sz + FTL::lbaSize - 1) / FTL::lbaSize;
   ns->pParent->convertUnit(ns, slba, nlblk, hReq);
+}
+
+// pass the request through ICL for timing, charge ISC credits if needed
+void FTL::simRead(size_t ofs, size_t sz _ADD_SIM_PARAMS) {
+  auto hReq = ((HIL::Request *)simCtx)->clone();
+  convertRequest(&hReq, ofs, sz);
 
   ICL::Request cReq(hReq);
   pr("Changed cReq: {slpn,nlp}={%lu,%lu} | ofs,len=%lu,%lu", cReq.range.slpn,
      cReq.range.nlp, cReq.offset, cReq.length);
 
-  // ★ Credit gate (blocking): ensure credit before proceeding
-  if (gScheduler) {
-    uint64_t basePages = cReq.range.nlp ? cReq.range.nlp : 1;  // true number of LPNs
-    double weighted = static_cast<double>(basePages) * ISC_PAGE_FACTOR;
-    uint64_t pages =
-        static_cast<uint64_t>(std::ceil(weighted));  // effective credit charge
-    if (pages == 0) pages = 1;
-    auto *cs = dynamic_cast<SimpleSSD::HIL::CreditScheduler*>(gScheduler);
-    if (cs) {
-      if (hReq.userID == 0) {
-        // ★ Admin user (uid=0) bypass - 系統初始化不受credit限制
-        pr("FTL: Admin user (uid=0) bypass credit check - pages=%lu", pages);
-      } else {
-        // ★ 正常用戶走credit檢查流程
-        // 確保用戶與timer啟動
-        cs->ensureActiveUser(hReq.userID);
-
-        // 等待直到有足夠credit：推進模擬時間並觸發refill
-        uint64_t period = cs->getPeriodTicks();
-        if (period == 0) period = 10000000ULL; // 安全預設：10M ticks
-
-        size_t guard = 100000; // 防止無限迴圈
-        while (!cs->checkCredit(hReq.userID, pages) && guard--) {
-          // 推進時間到下一個可能的refill相位，並手動觸發一次補發處理
-          simTick += period;
-          cs->processEvent(simTick);
-        }
-
-        // 最後一次檢查（保險），若仍不足則不阻塞避免卡死
-        if (cs->checkCredit(hReq.userID, pages)) {
-          cs->useCreditISC(hReq.userID, pages);
-        } else {
-          pr("FTL: WARNING credit gate not satisfied after waits, continue without charge (uid=%u pages=%lu)",
-             hReq.userID, pages);
-        }
-      }
+  // ★ Credit gate: wait (in simulated time) until the credit is refilled
+  auto *cs = dynamic_cast<SimpleSSD::HIL::CreditScheduler *>(gScheduler);
+  if (cs) {
+    uint64_t pages = creditPages(cReq);
+    if (hReq.userID == 0) {
+      // ★ Admin user (uid=0) bypass - 系統初始化不受credit限制
+      pr("FTL: Admin user (uid=0) bypass credit check - pages=%lu", pages);
+    }
+    else {
+      // 確保用戶與timer啟動
+      cs->ensureActiveUser(hReq.userID);
+
+      // the slet runs ahead of the event queue, so the bucket is evaluated
+      // and charged at simTick: this read is deferred to the predicted
+      // refill and then takes the full charge
+      auto readyAt = cs->chargeISCAt(hReq.userID, pages, simTick);
+      if (readyAt > simTick)
+        pr("FTL: credit gate defer uid=%u pages=%lu %lu -> %lu", hReq.userID,
+           pages, simTick, readyAt);
+      simTick = readyAt;
     }
   }
+  else if (gScheduler && hReq.userID != 0) {
+    // other schedulers only account the read, it is not held back
+    gScheduler->useCreditISC(hReq.userID, creditPages(cReq));
+  }
 
   // FTL latencies should already handled inside
-  ((SimpleSSD::ICL::ICL *)cache)->read(cReq, simTick);
+  ((SimpleSSD::ICL::ICL *)FTL::cache)->read(cReq, simTick);
+}
+
+// for functions not apply the SimpleSSD-styled latency handling
+void FTL::read(void *buf, size_t ofs, size_t sz) {
+  hostRead(buf, ofs, sz);
+}
+#endif
+
+void FTL::read(void *buf, size_t ofs, size_t sz _ADD_SIM_PARAMS) {
+  /* ---------- SimpleSSD Fast Path  ---------- */
+
+#ifndef ISC_TEST
+  simRead(ofs, sz _add_sim_params);
+#endif
+
+  hostRead(buf, ofs, sz);
+}
+
+uint64_t FTL::readBatch(BatchRead *reqs, size_t n _ADD_SIM_PARAMS) {
+  uint64_t endAt = 0;
+
+  for (size_t i = 0; i < n; ++i) {
+    auto &req = reqs[i];
+    req.doneAt = 0;
+
+#ifndef ISC_TEST
+    // all reads are issued at the same tick, the ICL decides the parallelism
+    req.doneAt = simTick;
+    simRead(req.offset, req.size, req.doneAt, simCtx);
+#endif
+
+    if (req.buffer)
+      hostRead(req.buffer, req.offset, req.size);
+    else if (mapImg && req.offset + req.size <= szImg)
+      req.buffer = &mapImg[req.offset];  // zero-copy
+    endAt = std::max(endAt, req.doneAt);
+  }
 
+  return endAt;
+}
+
+#ifndef ISC_TEST
+void FTL::submitBatch(BatchRead *reqs, size_t n, ISCCallbackFunc func,
+                      void *data _ADD_SIM_PARAMS) {
+  auto *cs = dynamic_cast<SimpleSSD::HIL::CreditScheduler *>(gScheduler);
+
+  if (!completionEvent)
+    completionEvent =
+        SimpleSSD::allocate([](uint64_t now) { completeReads(now); });
+
+  for (size_t i = 0; i < n; ++i) {
+    auto &req = reqs[i];
+
+    if (req.buffer)
+      hostRead(req.buffer, req.offset, req.size);
+    else if (mapImg && req.offset + req.size <= szImg)
+      req.buffer = &mapImg[req.offset];  // zero-copy
+
+    auto rc = new ISCRequestContext();
+    auto hReq = new Request(((Request *)simCtx)->clone());
+    convertRequest(hReq, req.offset, req.size);
+
+    rc->buffer = req.buffer;
+    rc->offset = req.offset;
+    rc->size = req.size;
+    rc->requestStartTick = simTick;
+    rc->originalSimCtx = hReq;
+    rc->callback = func;
+    rc->callbackUserData = data;
+
+    ICL::Request cReq(*hReq);
+    auto pages = creditPages(cReq);
+    if (cs && hReq->userID != 0) {
+      // issued by the scheduler once the bucket has the credit, the slet
+      // goes on by the callback instead of waiting here
+      cs->ensureActiveUser(hReq->userID);
+      cs->submitISCDeferred(hReq->userID, pages, rc, issueRead);
+      continue;
+    }
+    if (gScheduler && hReq->userID != 0)
+      gScheduler->useCreditISC(hReq->userID, pages);
+    issueRead(rc, simTick);
+  }
+}
+
+// the credit is charged, pass the read through ICL for timing
+void FTL::issueRead(void *ctx, uint64_t tick) {
+  auto rc = (ISCRequestContext *)ctx;
+  ICL::Request cReq(*(Request *)rc->originalSimCtx);
+
+  // the slet may run ahead of the event queue, never issue before it did
+  rc->doneAt = std::max(tick, rc->requestStartTick);
+  if (rc->doneAt > rc->requestStartTick)
+    pr("FTL: credit gate defer uid=%u %lu -> %lu", cReq.userID,
+       rc->requestStartTick, rc->doneAt);
+  ((SimpleSSD::ICL::ICL *)FTL::cache)->read(cReq, rc->doneAt);
+
+  inflight.push(rc);
+  armCompletion();
+}
+
+// call back the reads completed by now, in the order of completion
+void FTL::completeReads(uint64_t now) {
+  while (!inflight.empty() && inflight.top()->doneAt <= now) {
+    auto rc = inflight.top();
+    inflight.pop();
+
+    // the callback may submit more reads
+    rc->callback(rc->doneAt, rc->callbackUserData);
+    delete (Request *)rc->originalSimCtx;
+    delete rc;
+  }
+  armCompletion();
+}
+
+// keep the event at the earliest completion
+void FTL::armCompletion() {
+  if (inflight.empty())
+    return;
+
+  uint64_t at = std::max(inflight.top()->doneAt, SimpleSSD::getTick());
+  uint64_t when;
+  if (SimpleSSD::scheduled(completionEvent, &when)) {
+    if (when <= at)
+      return;
+    SimpleSSD::deschedule(completionEvent);
+  }
+  SimpleSSD::schedule(completionEvent, at);
+}
+#endif
+
+const void *FTL::view(size_t ofs, size_t sz _ADD_SIM_PARAMS) {
+  if (!mapImg || ofs + sz > szImg)
+    return nullptr;
+
+#ifndef ISC_TEST
+  simRead(ofs, sz _add_sim_params);
 #endif
 
-  doit(buf, ofs, sz _add_sim_params);
+  pr("View (ofs,sz=%lu,%lu)", ofs, sz);
+  return &mapImg[ofs];
 }
 
 }  // namespace SIM
@@ -19,49 +19,108 @@ namespace SimpleSSD {
 namespace ISC {
 namespace SIM {
 
-// ★ Forward declaration to avoid circular includes
-struct ISCRequestContext;
+// called by the event of the simulator when a read of FTL::submitBatch()
+// completes, with the tick of completion
+typedef void (*ISCCallbackFunc)(uint64_t completionTick, void *userData);
 
-// ★ Simple callback function type - 避免std::function的複雜性
-typedef void (*ISCCallbackFunc)(uint64_t completionTick, void* userData);
-
-// ★ ISC請求Context結構 - 用於非阻塞執行
+// a read of FTL::submitBatch() in flight, owned by the FTL until its callback
 struct ISCRequestContext {
-  void *buffer;              // 目標buffer
-  size_t offset;             // 檔案偏移
-  size_t size;               // 讀取大小
-  uint64_t requestStartTick; // 請求開始時間
-  void *originalSimCtx;      // 原始模擬器context
-  ISCCallbackFunc callback;  // 簡單的function pointer
-  void *callbackUserData;    // callback的用戶數據
-
-  // ★ 構造函數確保初始化
-  ISCRequestContext() : buffer(nullptr), offset(0), size(0),
-                       requestStartTick(0), originalSimCtx(nullptr),
-                       callback(nullptr), callbackUserData(nullptr) {}
+  void *buffer;               // data of the read, copied at the submission
+  size_t offset;              // byte offset in the image
+  size_t size;                // bytes to read
+  uint64_t requestStartTick;  // simTick of the submission
+  uint64_t doneAt;            // tick the read completes, once it is issued
+  void *originalSimCtx;       // HIL::Request of the read, converted to LBAs
+  ISCCallbackFunc callback;
+  void *callbackUserData;
+
+  ISCRequestContext()
+      : buffer(nullptr),
+        offset(0),
+        size(0),
+        requestStartTick(0),
+        doneAt(0),
+        originalSimCtx(nullptr),
+        callback(nullptr),
+        callbackUserData(nullptr) {}
 };
 
 class FTL {
+ public:
+  // how the filesystem image is accessed on the host side
+  enum BACKEND {
+    PREAD,  // keep the image fd opened, serve reads by pread()
+    MMAP,   // map the whole image read-only, serve reads by memcpy()
+  };
+
  protected:
   static size_t lbaSize;
   static char *pathFilesystemImg;
   static void *cache;
 
+  // image opened once in setImage(), released in destory()
+  static int fdImg;
+  static char *mapImg;
+  static size_t szImg;
+
+  static void hostRead(void *, size_t, size_t);
+#ifndef ISC_TEST
+  static void convertRequest(void *, size_t, size_t);  // HIL::Request
+  static void simRead(size_t, size_t _ADD_SIM_PARAMS);
+
+  // reads of submitBatch(), issued to the ICL and completed by events
+  static void issueRead(void *, uint64_t);  // ISCRequestContext
+  static void completeReads(uint64_t);
+  static void armCompletion();
+#endif
+
  public:
   FTL() = delete;
 
-  static void setImage(const char *p, size_t = 512);
-  static void setCache(void *pICL) { FTL::cache = pICL; }
+  static void setImage(const char *p, size_t = 512, BACKEND = MMAP);
+#ifndef ISC_TEST
+  static void setCache(void *pICL);
+#endif
+
+  static void destory();
 
-  static void destory() {
-    free(pathFilesystemImg);
-    pathFilesystemImg = nullptr;
-  }
+  // one read of readBatch(), doneAt is set to the tick its data arrives
+  struct BatchRead {
+    void *buffer = nullptr;
+    size_t offset = 0;
+    size_t size = 0;
+    uint64_t doneAt = 0;
+  };
+
+  static BACKEND getBackend() { return mapImg ? MMAP : PREAD; }
 void  setCurrentUid(uint32_t uid);
 #ifndef ISC_TEST
   static void read(void *, size_t, size_t);
 #endif
   static void read(void *, size_t, size_t _ADD_SIM_PARAMS);
+
+  // timestamped batch read: the data is copied before returning, while the
+  // simulated reads are all issued at simTick and complete in parallel. Each
+  // read gets its own completion tick, the last one is returned and simTick
+  // is left untouched, so the caller can overlap its compute with the reads.
+  // A read without buffer is zero-copy, its buffer is set to the mapped
+  // image data (or left null if the range is not mapped)
+  static uint64_t readBatch(BatchRead *, size_t _ADD_SIM_PARAMS);
+
+#ifndef ISC_TEST
+  // event-driven batch read: the data is copied (or mapped) as readBatch()
+  // does before returning, but the caller does not wait for the reads in
+  // simulated time. Each read is issued at simTick, or when the credit
+  // scheduler releases the credit of its user (see
+  // CreditScheduler::submitISCDeferred()), and the callback of it is called
+  // by an event at the tick it completes. simTick is left untouched
+  static void submitBatch(BatchRead *, size_t, ISCCallbackFunc,
+                          void *_ADD_SIM_PARAMS);
+#endif
+
+  // zero-copy read, return the mapped image data or nullptr if the range is
+  // not mapped (caller should fallback to read())
+  static const void *view(size_t, size_t _ADD_SIM_PARAMS);
 };
   void setCurrentUid(uint32_t uid);
   
@@ -1,12 +1,16 @@
+#include <algorithm>
+#include <memory>
+#include <string>
+
 #include "sims/cpu.hh"
 #include "sims/ftl.hh"
 
 #include "slet/grep.hh"
 
-#include "fs/ext4/ext4.hh"
 #include "runtime.hh"
 
 #include "sims/configs.hh"
+#include "utils/math.hh"
 
 #define PR_SECTION LOG_ISC_SLET_GREP
 
@@ -21,37 +25,117 @@ using namespace SIM;
 
 using SIM::FTL;
 
-const char *GrepAPP::keyNumFiles = "numfiles";
-const char *GrepAPP::keyFileSizes = "filesizes";
-const char *GrepAPP::keyExts = "exts";
-
-const char *GrepAPP::keyPath = "path";
-const char *GrepAPP::keyPatt = "pattern";
-const char *GrepAPP::keyResult = ISC_KEY_RESULT;
-const char *GrepAPP::keyResultSize = ISC_KEY_RESULT_SIZE;
+const SletKey GrepAPP::keyPatt = "pattern";
+const SletKey GrepAPP::keyFormat = "format";
+const SletKey GrepAPP::keyMaxCount = "maxcount";
 
 GrepAPP::GrepAPP(_SIM_PARAMS) {
   this->opt.name = strdup("GrepAPP");
   this->opt.cwd = strdup("/");
 }
 
-char badChar[256] = {};
-
 #define GREP_TASK1_GREP CPU::ISC__TASK1
 #define GREP_TASK2_STRSTR CPU::ISC__TASK2
+#define GREP_TASK3_AC CPU::ISC__TASK3
+#define GREP_VTASK1_LINES CPU::ISC__VTASK1
+
+// bytes in a vector of the simulated ISC core (128-bit)
+#define GREP_SIM_VBYTES 16
+
+#define AC_NONE UINT32_MAX
+
+ISC_STS GrepAPP::Matcher::compile(const char *patterns) {
+  pats.clear();
+  delta.clear();
+  outLen.clear();
+
+  // patterns are separated by '\n', empty ones are ignored
+  for (auto p = patterns; *p;) {
+    auto e = strchrnul(p, '\n');
+    if (e > p)
+      pats.emplace_back(p, e - p);
+    p = *e ? e + 1 : e;
+  }
+  if (pats.empty()) {
+    pr("ERROR! No pattern is given");
+    return ISC_STS_EARGS;
+  }
+
+  szMin = SIZE_MAX;
+  for (auto &pat : pats)
+    szMin = std::min(szMin, pat.size());
+
+  if (pats.size() == 1) {
+    auto &pat = pats[0];
+    for (size_t i = 0; i < 256; ++i)
+      badChar[i] = -1;
+    for (size_t i = 0; i < pat.size(); ++i)
+      badChar[(uint8_t)pat[i]] = i;
+    return ISC_STS_OK;
+  }
+
+  // build the trie, state 0 is the root
+  delta.assign(256, AC_NONE);
+  outLen.assign(1, 0);
+  for (auto &pat : pats) {
+    uint32_t s = 0;
+    for (auto ch : pat) {
+      auto &t = delta[s * 256 + (uint8_t)ch];
+      if (t == AC_NONE) {
+        t = outLen.size();
+        outLen.push_back(0);
+        delta.resize(delta.size() + 256, AC_NONE);
+      }
+      s = delta[s * 256 + (uint8_t)ch];
+    }
+    outLen[s] = pat.size();
+  }
+
+  // turn it into a DFA by following the failure links in BFS order
+  std::vector<uint32_t> fail(outLen.size(), 0), queue;
+  for (size_t c = 0; c < 256; ++c) {
+    auto &t = delta[c];
+    if (t == AC_NONE)
+      t = 0;
+    else
+      queue.push_back(t);
+  }
+  for (size_t i = 0; i < queue.size(); ++i) {
+    auto r = queue[i];
+    if (!outLen[r])
+      outLen[r] = outLen[fail[r]];
+
+    for (size_t c = 0; c < 256; ++c) {
+      auto &t = delta[r * 256 + c];
+      auto f = delta[fail[r] * 256 + c];
+      if (t == AC_NONE) {
+        t = f;
+      }
+      else {
+        fail[t] = f;
+        queue.push_back(t);
+      }
+    }
+  }
+
+  pr("Compiled %lu patterns into %lu states", pats.size(), outLen.size());
+  return ISC_STS_OK;
+}
 
 // LeetCode 28
-int GrepAPP::strstr(const char *s, size_t slen, const char *t,
-                    size_t tlen _ADD_SIM_PARAMS) {
+ssize_t GrepAPP::Matcher::findBM(const char *s, size_t slen
+                                     _ADD_SIM_PARAMS) const {
+  auto &t = pats[0];
+  auto tlen = t.size();
   size_t count = 0;
-  auto doit = [&count](const uint8_t *s, size_t slen, const char *t,
-                       size_t tlen _ADD_SIM_PARAMS) -> int {
+
+  auto doit = [&](const uint8_t *s) -> ssize_t {
     size_t shift = 0;
     while (shift <= (slen - tlen)) {
       ++count;
       int notmatch = tlen - 1;
 
-      while (notmatch >= 0 && t[notmatch] == s[shift + notmatch])
+      while (notmatch >= 0 && t[notmatch] == (char)s[shift + notmatch])
         notmatch--;
 
       if (notmatch < 0)
@@ -61,253 +145,207 @@ int GrepAPP::strstr(const char *s, size_t slen, const char *t,
     return -1;
   };
 
-  auto res = doit((const uint8_t *)s, slen, t, tlen _add_sim_params);
+  auto res = doit((const uint8_t *)s);
   simApplyManyLatency(CPU::ISC__SLET__GREP, GREP_TASK2_STRSTR, count);
   return res;
 }
 
-ISC_STS
-GrepAPP::grep(const char *src, size_t slen, const char *pat,
-              void *result _ADD_SIM_PARAMS) {
-  auto doit = [this](const char *src, size_t slen, const char *pat,
-                     void *result _ADD_SIM_PARAMS) {
-    auto res = (result_t *)result;
-    auto tlen = strlen(pat);
-
-    if (!src || (slen < tlen)) {
-      pr("ERROR! The source string is null or shorter than the pattern");
-      res->line = nullptr;
-      return ISC_STS_EARGS;
-    }
-
-    memset(badChar, 0xff, 256);
-    for (size_t i = 0; i < tlen; ++i)
-      badChar[(uint8_t)pat[i]] = i;
-
-    // get the first match pattern offset
-    auto ofs = this->strstr(src, slen, pat, strlen(pat) _add_sim_params);
-    pr("Find pattern at %d", ofs);
-
-    const char *line;
-    for (line = &src[ofs], res->len = tlen; line > src && *(line - 1) != '\n';
-         ++res->len, --line)
-      ;  // find \n of prev line
+ssize_t GrepAPP::Matcher::findAC(const char *s, size_t slen
+                                     _ADD_SIM_PARAMS) const {
+  size_t i = 0;
 
-    for (auto ch = &src[ofs + tlen]; *ch != '\n' && ch < &src[slen];
-         ++ch, ++res->len)
-      ;  // find \n of this line
-
-    res->line = (char *)calloc(res->len + 1, 1);
-    memcpy(res->line, line, res->len);
-    return ISC_STS_OK;
+  auto doit = [&](const uint8_t *s) -> ssize_t {
+    for (uint32_t st = 0; i < slen; ++i) {
+      st = delta[st * 256 + s[i]];
+      if (outLen[st])
+        return i + 1 - outLen[st];
+    }
+    return -1;
   };
-  auto res = doit(src, slen, pat, result _add_sim_params);
-  simApplyLatency(CPU::ISC__SLET__GREP, GREP_TASK1_GREP);
+
+  auto res = doit((const uint8_t *)s);
+  simApplyManyLatency(CPU::ISC__SLET__GREP, GREP_TASK3_AC,
+                      std::min(i + 1, slen));
   return res;
 }
 
-ISC_STS GrepAPP::builtin_startup(_SIM_PARAMS) {
-  auto doit = [this](_SIM_PARAMS) -> ISC_STS {
-    auto sts = ISC_STS_OK;
+ssize_t GrepAPP::Matcher::find(const char *src, size_t slen
+                                   _ADD_SIM_PARAMS) const {
+  if (!src || slen < szMin)
+    return -1;
+  if (pats.size() == 1)
+    return findBM(src, slen _add_sim_params);
+  return findAC(src, slen _add_sim_params);
+}
 
-    // get options
-    GenericFSA::ExtList *fileExtLists = nullptr;
-    auto exts = (GenericFSA::Ext *)this->getOpt(keyExts);
-    auto numFiles = (size_t *)this->getOpt(keyNumFiles);
-    auto fileSizes = (size_t *)this->getOpt(keyFileSizes);
-    auto nofsa = exts && numFiles && fileSizes;
-
-    auto path = (const char *)this->getOpt(keyPath);
-    auto pattern = (const char *)this->getOpt(GrepAPP::keyPatt);
-    auto isdir = path[strlen(path) - 1] == '/';
-
-    // allocate result size buffer
-    char *bufOut = NULL;
-    auto bufOutSz = (size_t *)calloc(1, sizeof(size_t));
-    if (!bufOutSz)
-      return ISC_STS_FAIL;
-    *bufOutSz = 0;
-
-    size_t nFiles = 0, iFile = 0, oBufDir = 0, szBufDir = 0, oBufOut = 0;
-    char pathFile[512] = {0};
-
-    // get numFiles and filename list
-    char *bufDir = nullptr;
-    Ext4::fake_dirent *dirent;
-    if (isdir && !nofsa) {
-      auto dirExtList = Runtime::getExts(path _add_sim_params);
-      for (size_t ie = 0; ie < dirExtList.len; ++ie)
-        szBufDir += dirExtList.exts[ie].len * BLK_SIZE;
-
-      // read dir entries
-      bufDir = (char *)calloc(1, szBufDir);
-      if (!bufDir) {
-        free(dirExtList.exts);
-        sts = ISC_STS_FAIL;
-        goto out_free_ressize;
-      }
-      for (size_t ie = 0, ofsBuf = 0; ie < dirExtList.len; ++ie) {
-        auto ofsData = dirExtList.exts[ie].slbn * BLK_SIZE;
-        auto szData = dirExtList.exts[ie].len * BLK_SIZE;
-        SIM::FTL::read(&bufDir[ofsBuf], ofsData, szData _add_sim_params);
-        ofsBuf += szData;
-      }
+// append a matched line to the result stream
+ISC_STS GrepAPP::emit(scan_t *scan, const char *line, size_t len) {
+  size_t szHdr = stream ? sizeof(match_t) : sizeof(size_t);
+  size_t szEntry = szHdr + ALIGN_UP(len, sizeof(size_t));
 
-      // check number of files
-      for (oBufDir = 0; oBufDir < szBufDir; oBufDir += dirent->rec_len) {
-        dirent = (Ext4::fake_dirent *)&bufDir[oBufDir];
-
-        if (dirent->inode == 0) {
-          // skip 1 dummy tail dent (checksum)
-          if (dirent->file_type == 0xde) {
-            pr("End of directory block (+%d)", dirent->rec_len);
-            continue;
-          }
-          break;
-        }
-
-        if (dirent->file_type != 2 /* dir */) {
-          char name[256] = {0};
-          strncpy(name, &bufDir[oBufDir + sizeof(*dirent)], dirent->name_len);
-
-          ++nFiles;
-          pr("[+%lu]: '%s'", oBufDir, name);
-        }
-      }
-      free(dirExtList.exts);
-    }
-    else if (!nofsa) {
-      strncpy(pathFile, path, 255);
-      nFiles = 1;
-    }
-    else {
-      // convert exts to ExtList
-      fileExtLists =
-          (GenericFSA::ExtList *)calloc(*numFiles, sizeof(GenericFSA::ExtList));
-
-      for (size_t i = 0, ie = 0; i < *numFiles; ++i, ++ie) {
-        fileExtLists[i].bytes = fileSizes[i];
-
-        // exts is separated by 'block == UINT64_MAX'
-        fileExtLists[i].exts = &exts[ie];
-        // exts is separated by 'block == UINT64_MAX'
-        fileExtLists[i].exts = &exts[ie];
-        fileExtLists[i].len = 0;
-        for (; exts[ie].block != UINT64_MAX; ++ie)
-          fileExtLists[i].len++;
-      }
-      nFiles = *numFiles;
-      if (!isdir)
-        strncpy(pathFile, path, 255);
+  if (scan->szOut + szEntry > scan->capOut) {
+    auto cap = std::max(scan->capOut * 2, scan->szOut + szEntry);
+    auto out = (char *)realloc(scan->out, cap);
+    if (!out) {
+      pr("Failed to realloc bufOut size");
+      return ISC_STS_FAIL;
     }
+    scan->out = out;
+    scan->capOut = cap;
+  }
+
+  auto entry = &scan->out[scan->szOut];
+  if (stream) {
+    match_t m = {scan->offset + (line - scan->base), scan->lineno + 1,
+                 scan->file, (uint32_t)len};
+    memcpy(entry, &m, sizeof(m));
+  }
+  else {
+    memcpy(entry, &len, sizeof(size_t));
+  }
+  memcpy(&entry[szHdr], line, len);
+  memset(&entry[szHdr + len], 0, szEntry - szHdr - len);
+
+  scan->szOut += szEntry;
+  scan->matches++;
+  return ISC_STS_OK;
+}
 
-    if (!isdir)
-      goto readfile;
+// search complete lines in src, the last line may miss '\n' at the file end
+ISC_STS
+GrepAPP::grep(const char *src, size_t slen, void *scanState _ADD_SIM_PARAMS) {
+  auto doit = [this](const char *src, size_t slen, scan_t *scan
+                         _ADD_SIM_PARAMS) -> ISC_STS {
+    auto limit = stream ? maxCount : 1;
+    size_t pos = 0;
+    scan->base = src;
+
+    while (pos < slen && (!limit || scan->matches < limit)) {
+      auto ofs = matcher.find(&src[pos], slen - pos _add_sim_params);
+      if (ofs < 0)
+        break;
 
-    pr("Num files: %lu %s", nFiles, isdir ? "(dir)" : "");
-    for (oBufDir = 0; iFile < nFiles; ++iFile) {
-      // find next file
-      if (nofsa) {
-        // we don't know the exact filename, give it a symbolic name
-        snprintf(pathFile, 255, "%s[%lu]", path, iFile);
-        goto readfile;
-      }
+      // locate the line of the match
+      auto hit = &src[pos + ofs];
+      auto beg = (const char *)memrchr(&src[pos], '\n', hit - &src[pos]);
+      beg = beg ? beg + 1 : &src[pos];
+      auto end = (const char *)memchr(hit, '\n', &src[slen] - hit);
+      end = end ? end : &src[slen];
 
-      for (char name[256]; oBufDir < szBufDir; oBufDir += dirent->rec_len) {
-        dirent = (Ext4::fake_dirent *)&bufDir[oBufDir];
+      scan->lineno += std::count(&src[pos], beg, '\n');
+      pr("Find pattern at line %lu (+%lu)", scan->lineno + 1,
+         scan->offset + (beg - src));
 
-        if (dirent->file_type != 1 /* reg file */)
-          continue;
+      auto sts = emit(scan, beg, end - beg);
+      simApplyLatency(CPU::ISC__SLET__GREP, GREP_TASK1_GREP);
+      if (sts != ISC_STS_OK)
+        return sts;
 
-        memset(name, 0, 256);
-        strncpy(name, &bufDir[oBufDir + sizeof(*dirent)], dirent->name_len);
+      scan->lineno++;
+      pos = end - src + 1;
+    }
 
-        pr("[+%lu]: Find file %s", oBufDir, name);
-        snprintf(pathFile, 511, "%s%s", path, name);
-        oBufDir += dirent->rec_len;
-        break;
-      }
+    // count lines of the remaining part
+    if (pos < slen)
+      scan->lineno += std::count(&src[pos], &src[slen], '\n');
+    scan->offset += slen;
 
-      // read data of the path
-    readfile:
-      pr("File[%lu]: %s", iFile, pathFile);
-
-      auto szBufFile = 0;
-      GenericFSA::ExtList fileExtList;
-      if (nofsa)
-        fileExtList = fileExtLists[iFile];
-      else
-        fileExtList = Runtime::getExts(pathFile _add_sim_params);
-
-      for (size_t ie = 0; ie < fileExtList.len; ++ie)
-        szBufFile += fileExtList.exts[ie].len * BLK_SIZE;
-
-      // read file data
-      auto bufFile = (char *)calloc(1, szBufFile);
-      if (!bufFile) {
-        sts = ISC_STS_FAIL;
-        goto out_free_fileExt;
-      }
-      for (size_t ie = 0, ofsBuf = 0; ie < fileExtList.len; ++ie) {
-        auto ofsData = fileExtList.exts[ie].slbn * BLK_SIZE;
-        auto szData = fileExtList.exts[ie].len * BLK_SIZE;
-        SIM::FTL::read(&bufFile[ofsBuf], ofsData, szData _add_sim_params);
-        ofsBuf += szData;
-      }
+    simApplyManyLatency(CPU::ISC__SLET__GREP, GREP_VTASK1_LINES,
+                        DIV64_CEIL(slen, GREP_SIM_VBYTES));
+    return ISC_STS_OK;
+  };
+  return doit(src, slen, (scan_t *)scanState _add_sim_params);
+}
 
-      // do task on this file
-      result_t res;
-      sts = grep(bufFile, fileExtList.bytes, pattern, &res _add_sim_params);
-      pr("Find target line: (%lu) '%s'", res.len, res.line);
-
-      {
-        // the put the all the result and their size together,
-        int szResEntry = sizeof(size_t) + ALIGN_UP(res.len, sizeof(size_t));
-
-        oBufOut = *bufOutSz;
-        *bufOutSz += szResEntry;
-        pr("Update output size to %lu", *bufOutSz);
-
-        char *bufOutNew = (char *)realloc(bufOut, *bufOutSz);
-        if (!bufOutNew) {
-          pr("Failed to realloc bufOut size");
-          sts = ISC_STS_FAIL;
-          goto out_free_fileExt;
-        }
-
-        // switch to new buffer
-        bufOut = bufOutNew;
-        memcpy(&bufOut[oBufOut], &res.len, sizeof(size_t));
-        oBufOut += sizeof(size_t);
-        memcpy(&bufOut[oBufOut], res.line, res.len);
-      }
-      free(res.line);
+/**
+ * Only complete lines are searched, the partial line at the end of a chunk is
+ * carried to the next one.
+ */
+ISC_STS GrepAPP::grepFile(const GenericFSA::ExtList &file,
+                          scan_t *scan _ADD_SIM_PARAMS) {
+  auto sts = ISC_STS_OK;
+  Stream stream(file, Stream::CHUNK_SIZE, 2, codec);
+  std::string carry;
+  const byte *chunk;
+  auto limit = this->stream ? maxCount : 1;
+  auto more = [&]() {
+    return sts == ISC_STS_OK && (!limit || scan->matches < limit);
+  };
 
-      free(bufFile);
-    out_free_fileExt:
-      if (!nofsa)
-        free(fileExtList.exts);
+  for (size_t len; more() && (len = stream.next(&chunk _add_sim_params));) {
+    auto src = (const char *)chunk;
+    auto eol = (const char *)memrchr(src, '\n', len);
+    if (!eol) {
+      carry.append(src, len);
+      continue;
+    }
 
-      if (sts != ISC_STS_OK)
-        goto out_free_result;
+    // complete the carried line with the head of this chunk
+    size_t ofs = 0;
+    if (!carry.empty()) {
+      ofs = (const char *)memchr(src, '\n', len) - src + 1;
+      carry.append(src, ofs);
+      sts = grep(carry.data(), carry.size(), scan _add_sim_params);
+      carry.clear();
     }
+    if (more())
+      sts = grep(&src[ofs], eol + 1 - &src[ofs], scan _add_sim_params);
+    carry.assign(eol + 1, &src[len] - (eol + 1));
+  }
+  if (sts == ISC_STS_OK)
+    sts = stream.getStatus();
+  if (more() && !carry.empty())
+    sts = grep(carry.data(), carry.size(), scan _add_sim_params);
+  pr("Find %lu lines in file[%u]", scan->matches, scan->file);
+
+  // the first line format keeps an empty entry for files without match
+  if (sts == ISC_STS_OK && !this->stream && !scan->matches) {
+    sts = emit(scan, "", 0);
+    scan->matches = 0;
+  }
+  return sts;
+}
+
+ISC_STS GrepAPP::builtin_startup(_SIM_PARAMS) {
+  auto doit = [this](_SIM_PARAMS) -> ISC_STS {
+    auto sts = ISC_STS_OK;
+
+    // get options
+    auto pattern = this->getOpt<const char>(GrepAPP::keyPatt);
+    auto format = this->getOpt<const char>(GrepAPP::keyFormat);
 
-    // set result
-    sts = this->setOpt(keyResultSize, bufOutSz);
-    if (sts == ISC_STS_OK)
-      sts = this->setOpt(keyResult, bufOut);
-
-  out_free_result:
-    if (sts != ISC_STS_OK)
-      free(bufOut);
-    if (isdir && !nofsa)
-      free(bufDir);
-    if (nofsa)
-      free(fileExtLists);
-  out_free_ressize:
-    if (sts != ISC_STS_OK)
-      free(bufOutSz);
-    return sts;
+    stream = format && !strcmp(format, "stream");
+    maxCount = this->getVal<size_t>(GrepAPP::keyMaxCount, 0);
+    if (!pattern || (sts = matcher.compile(pattern)) != ISC_STS_OK)
+      return ISC_STS_EARGS;
+    if ((sts = this->getCodec(&codec)) != ISC_STS_OK)
+      return sts;
+
+    std::vector<GenericFSA::ExtList> files;
+    if ((sts = this->resolveFiles(files, true _add_sim_params)) != ISC_STS_OK)
+      return sts;
+
+    // the extents are kept until the last file is searched, which may be
+    // after startup if the result is pulled from a ring
+    auto owned = std::shared_ptr<std::vector<GenericFSA::ExtList>>(
+        new std::vector<GenericFSA::ExtList>(std::move(files)),
+        [](std::vector<GenericFSA::ExtList> *files) {
+          freeFiles(*files);
+          delete files;
+        });
+
+    // files are searched by tasks on the ISC cores, each into its own stream
+    // which are joined in the order of files
+    return this->produce(
+        owned->size(),
+        [this, owned](size_t i, std::string *out _ADD_SIM_PARAMS) {
+          scan_t scan = {(uint32_t)i, 0, 0, 0, nullptr, nullptr, 0, 0};
+          auto sts = grepFile((*owned)[i], &scan _add_sim_params);
+          if (sts == ISC_STS_OK && scan.szOut)
+            out->assign(scan.out, scan.szOut);
+          free(scan.out);
+          return sts;
+        } _add_sim_params);
   };
 
   auto res = doit(_sim_params);
@@ -1,6 +1,11 @@
 #ifndef __SIMPLESSD_ISC_SLET_GREP_HH__
 #define __SIMPLESSD_ISC_SLET_GREP_HH__
 
+#include <sys/types.h>
+
+#include <string>
+#include <vector>
+
 #include "sims/cpu.hh"
 
 #include "types.hh"
@@ -18,25 +23,86 @@ class GrepAPP : public GenericAPP {
     size_t len;
   };
 
-  int strstr(const char *, size_t, const char *, size_t _ADD_SIM_PARAMS);
-  ISC_STS grep(const char *, size_t, const char *, void *_ADD_SIM_PARAMS);
-  ISC_STS builtin_startup(_SIM_PARAMS) override;
+  /**
+   * @brief A matched line in the result stream (format "stream")
+   *
+   * Records are packed back to back, each one is followed by the line (without
+   * '\n') padded to 8 bytes.
+   */
+  struct match_t {
+    uint64_t offset;  // byte offset of the line in the file
+    uint64_t lineno;  // line number in the file, from 1
+    uint32_t file;    // index of the file under the given path
+    uint32_t len;     // length of the line
+  };
+
+  /**
+   * @brief Multi-pattern matcher, each slet instance has its own tables
+   *
+   * Patterns are separated by '\n'. A single pattern is searched with
+   * Boyer-Moore (bad character rule), more patterns are matched at once with
+   * an Aho-Corasick automaton, so the text is scanned only once.
+   */
+  class Matcher {
+   public:
+    Matcher() : szMin(0) {}
 
-  static const char *keyNumFiles;
-  static const char *keyFileSizes;
-  static const char *keyExts;
+    ISC_STS compile(const char *patterns);
 
-  static const char *keyPath;
-  static const char *keyPatt;
-  static const char *keyResult;
-  static const char *keyResultSize;
+    /**
+     * @brief Find the first match of any pattern
+     *
+     * @return ssize_t offset of the first matched byte, -1 if not found
+     */
+    ssize_t find(const char *src, size_t slen _ADD_SIM_PARAMS) const;
+
+    size_t numPatterns() const { return pats.size(); }
+
+   protected:
+    ssize_t findBM(const char *, size_t _ADD_SIM_PARAMS) const;
+    ssize_t findAC(const char *, size_t _ADD_SIM_PARAMS) const;
+
+    std::vector<std::string> pats;
+    size_t szMin;
+
+    int32_t badChar[256];          // BM: last index of each char
+    std::vector<uint32_t> delta;   // AC: 256 transitions per state
+    std::vector<uint32_t> outLen;  // AC: length of a pattern ends at state
+  };
+
+  ISC_STS grep(const char *, size_t, void *_ADD_SIM_PARAMS);
+  ISC_STS builtin_startup(_SIM_PARAMS) override;
+
+  static const SletKey keyPatt;
+  static const SletKey keyFormat;
+  static const SletKey keyMaxCount;
 
   const size_t BLK_SIZE = 4096;
 
  protected:
+  // state of scanning a file, lines are always searched as a whole
+  struct scan_t {
+    uint32_t file;     // index of the file
+    uint64_t offset;   // file offset of the next byte to be searched
+    uint64_t lineno;   // lines before offset
+    size_t matches;    // matched lines of this file
+    const char *base;  // buffer being searched, starts at offset
+
+    char *out;  // result stream
+    size_t szOut;
+    size_t capOut;
+  };
+
+  ISC_STS emit(scan_t *, const char *, size_t);
+  ISC_STS grepFile(const GenericFSA::ExtList &, scan_t *_ADD_SIM_PARAMS);
+
+  Matcher matcher;
+  bool stream;               // report all matches as match_t, or first lines
+  size_t maxCount;           // max matched lines per file, 0 for no limit
+  Utils::Codec::Type codec;  // of files
 };
 
 }  // namespace ISC
 }  // namespace SimpleSSD
 
-#endif /* __SIMPLESSD_ISC_SLET_GREP_HH__ */
\ No newline at end of file
+#endif /* __SIMPLESSD_ISC_SLET_GREP_HH__ */
@@ -0,0 +1,680 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#include "sims/cpu.hh"
+#include "sims/ftl.hh"
+
+#include "slet/hash.hh"
+
+#include "runtime.hh"
+
+#include "sims/configs.hh"
+#include "utils/simd.hh"
+
+#define PR_SECTION LOG_ISC_SLET_HASH
+
+namespace SimpleSSD {
+namespace ISC {
+
+template ISC_STS_SLET_ID Runtime::addSlet<HashAPP>(_SIM_PARAMS);
+
+using namespace SIM;
+
+const SletKey HashAPP::keyAlgo = "algo";
+
+// the simulated core is charged per 64-byte block of input, whatever the host
+// kernel is, see cpu/cpu.cc for the instructions of each
+#define HASH_TASK_XXH64 CPU::ISC__TASK1
+#define HASH_TASK_CRC32C CPU::ISC__TASK2
+#define HASH_TASK_SHA256 CPU::ISC__TASK3
+#define HASH_TASK_FINAL CPU::ISC__TASK4
+
+#define HASH_BLK 64
+
+// blocks of input completed by an update of len bytes after total bytes
+#define HASH_BLKS(total, len) ((total + len) / HASH_BLK - (total) / HASH_BLK)
+
+// clang-format won't break after attribute, use this to make do that
+#if defined(__clang__)
+#define NO_SANS(...) __attribute__((no_sanitize(__VA_ARGS__)))
+#if __clang_major__ > 12
+#define NO_UINT_SANS NO_SANS("unsigned-shift-base", "unsigned-integer-overflow")
+#else
+#define NO_UINT_SANS NO_SANS("unsigned-integer-overflow")
+#endif
+#else
+#define NO_SANS(...)
+#define NO_UINT_SANS
+#endif
+
+#define ROTL64(x, n) (((x) << (n)) | ((x) >> (64 - (n))))
+#define ROTR32(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+
+static inline uint64_t load64(const uint8_t *p) {
+  uint64_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+static inline uint32_t load32(const uint8_t *p) {
+  uint32_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+static inline void storeBE(uint8_t *out, uint64_t v, size_t bytes) {
+  for (size_t i = 0; i < bytes; ++i)
+    out[i] = (uint8_t)(v >> (8 * (bytes - 1 - i)));
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                   xxHash64                                 */
+/* -------------------------------------------------------------------------- */
+
+class XXH64 : public HashAPP::Hasher {
+ public:
+  size_t digestSize() const override { return 8; }
+  void init() override;
+  void update(const uint8_t *, size_t _ADD_SIM_PARAMS) override;
+  void final(uint8_t *_ADD_SIM_PARAMS) override;
+
+ protected:
+  static constexpr uint64_t P1 = 0x9e3779b185ebca87ULL;
+  static constexpr uint64_t P2 = 0xc2b2ae3d27d4eb4fULL;
+  static constexpr uint64_t P3 = 0x165667b19e3779f9ULL;
+  static constexpr uint64_t P4 = 0x85ebca77c2b2ae63ULL;
+  static constexpr uint64_t P5 = 0x27d4eb2f165667c5ULL;
+
+  NO_UINT_SANS static uint64_t round(uint64_t acc, uint64_t in) {
+    acc += in * P2;
+    return ROTL64(acc, 31) * P1;
+  }
+
+  NO_UINT_SANS static uint64_t merge(uint64_t acc, uint64_t v) {
+    acc ^= round(0, v);
+    return acc * P1 + P4;
+  }
+
+  void stripe(const uint8_t *in) {
+    for (int i = 0; i < 4; ++i)
+      v[i] = round(v[i], load64(&in[i * 8]));
+  }
+
+  uint64_t v[4];
+  uint64_t total;
+  uint8_t buf[32];
+  size_t szBuf;
+};
+
+NO_UINT_SANS
+void XXH64::init() {
+  v[0] = P1 + P2;
+  v[1] = P2;
+  v[2] = 0;
+  v[3] = -P1;
+  total = 0;
+  szBuf = 0;
+}
+
+void XXH64::update(const uint8_t *in, size_t len _ADD_SIM_PARAMS) {
+  simApplyManyLatency(CPU::ISC__SLET__HASH, HASH_TASK_XXH64,
+                      HASH_BLKS(total, len));
+  total += len;
+
+  if (szBuf + len < sizeof(buf)) {
+    memcpy(&buf[szBuf], in, len);
+    szBuf += len;
+    return;
+  }
+  if (szBuf) {
+    size_t fill = sizeof(buf) - szBuf;
+    memcpy(&buf[szBuf], in, fill);
+    stripe(buf);
+    in += fill;
+    len -= fill;
+  }
+  for (; len >= sizeof(buf); in += sizeof(buf), len -= sizeof(buf))
+    stripe(in);
+  memcpy(buf, in, len);
+  szBuf = len;
+}
+
+NO_UINT_SANS
+void XXH64::final(uint8_t *out _ADD_SIM_PARAMS) {
+  uint64_t h;
+
+  if (total >= sizeof(buf)) {
+    h = ROTL64(v[0], 1) + ROTL64(v[1], 7) + ROTL64(v[2], 12) +
+        ROTL64(v[3], 18);
+    for (int i = 0; i < 4; ++i)
+      h = merge(h, v[i]);
+  }
+  else
+    h = P5;
+  h += total;
+
+  size_t i = 0;
+  for (; i + 8 <= szBuf; i += 8) {
+    h ^= round(0, load64(&buf[i]));
+    h = ROTL64(h, 27) * P1 + P4;
+  }
+  if (i + 4 <= szBuf) {
+    h ^= load32(&buf[i]) * P1;
+    h = ROTL64(h, 23) * P2 + P3;
+    i += 4;
+  }
+  for (; i < szBuf; ++i) {
+    h ^= buf[i] * P5;
+    h = ROTL64(h, 11) * P1;
+  }
+
+  h ^= h >> 33;
+  h *= P2;
+  h ^= h >> 29;
+  h *= P3;
+  h ^= h >> 32;
+
+  storeBE(out, h, sizeof(h));
+  simApplyLatency(CPU::ISC__SLET__HASH, HASH_TASK_FINAL);
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                    CRC32C                                  */
+/* -------------------------------------------------------------------------- */
+
+// slicing-by-8 tables of the reflected Castagnoli polynomial
+static const uint32_t (*crc32cTable())[256] {
+  static uint32_t table[8][256];
+  static bool inited = [] {
+    for (uint32_t i = 0; i < 256; ++i) {
+      uint32_t c = i;
+      for (int k = 0; k < 8; ++k)
+        c = (c >> 1) ^ (0x82f63b78 & -(c & 1));
+      table[0][i] = c;
+    }
+    for (uint32_t i = 0; i < 256; ++i)
+      for (int k = 1; k < 8; ++k)
+        table[k][i] = (table[k - 1][i] >> 8) ^ table[0][table[k - 1][i] & 0xff];
+    return true;
+  }();
+
+  (void)inited;
+  return table;
+}
+
+static uint32_t crc32cScalar(uint32_t crc, const uint8_t *in, size_t len) {
+  auto t = crc32cTable();
+
+  for (; len >= 8; in += 8, len -= 8) {
+    uint64_t w = load64(in) ^ crc;
+    crc = t[7][w & 0xff] ^ t[6][(w >> 8) & 0xff] ^ t[5][(w >> 16) & 0xff] ^
+          t[4][(w >> 24) & 0xff] ^ t[3][(w >> 32) & 0xff] ^
+          t[2][(w >> 40) & 0xff] ^ t[1][(w >> 48) & 0xff] ^ t[0][w >> 56];
+  }
+  for (; len; ++in, --len)
+    crc = t[0][(crc ^ *in) & 0xff] ^ (crc >> 8);
+  return crc;
+}
+
+#ifdef ISC_SIMD_X86
+SIMD_TARGET("sse4.2")
+static uint32_t crc32cSSE4(uint32_t crc, const uint8_t *in, size_t len) {
+  uint64_t c = crc;
+
+  for (; len >= 8; in += 8, len -= 8)
+    c = _mm_crc32_u64(c, load64(in));
+  crc = (uint32_t)c;
+  for (; len; ++in, --len)
+    crc = _mm_crc32_u8(crc, *in);
+  return crc;
+}
+#endif
+
+class CRC32C : public HashAPP::Hasher {
+ public:
+  size_t digestSize() const override { return 4; }
+  void init() override {
+    crc = 0xffffffff;
+    total = 0;
+  }
+  void update(const uint8_t *, size_t _ADD_SIM_PARAMS) override;
+  void final(uint8_t *_ADD_SIM_PARAMS) override;
+
+ protected:
+  uint32_t crc;
+  uint64_t total;
+};
+
+void CRC32C::update(const uint8_t *in, size_t len _ADD_SIM_PARAMS) {
+#ifdef ISC_SIMD_X86
+  if (Utils::SIMD::getISA() >= Utils::SIMD::SSE4)
+    crc = crc32cSSE4(crc, in, len);
+  else
+#endif
+    crc = crc32cScalar(crc, in, len);
+
+  simApplyManyLatency(CPU::ISC__SLET__HASH, HASH_TASK_CRC32C,
+                      HASH_BLKS(total, len));
+  total += len;
+}
+
+void CRC32C::final(uint8_t *out _ADD_SIM_PARAMS) {
+  storeBE(out, ~crc, sizeof(crc));
+  simApplyLatency(CPU::ISC__SLET__HASH, HASH_TASK_FINAL);
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                    SHA-256                                 */
+/* -------------------------------------------------------------------------- */
+
+static const uint32_t K256[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1,
+    0x923f82a4, 0xab1c5ed5, 0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+    0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174, 0xe49b69c1, 0xefbe4786,
+    0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147,
+    0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+    0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85, 0xa2bfe8a1, 0xa81a664b,
+    0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a,
+    0x5b9cca4f, 0x682e6ff3, 0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+    0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+
+NO_UINT_SANS
+static void sha256Scalar(uint32_t state[8], const uint8_t *in, size_t nblk) {
+  for (; nblk--; in += HASH_BLK) {
+    uint32_t w[64];
+    for (int i = 0; i < 16; ++i)
+      w[i] = __builtin_bswap32(load32(&in[i * 4]));
+    for (int i = 16; i < 64; ++i) {
+      uint32_t s0 =
+          ROTR32(w[i - 15], 7) ^ ROTR32(w[i - 15], 18) ^ (w[i - 15] >> 3);
+      uint32_t s1 =
+          ROTR32(w[i - 2], 17) ^ ROTR32(w[i - 2], 19) ^ (w[i - 2] >> 10);
+      w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+
+    uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+    uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+    for (int i = 0; i < 64; ++i) {
+      uint32_t S1 = ROTR32(e, 6) ^ ROTR32(e, 11) ^ ROTR32(e, 25);
+      uint32_t ch = (e & f) ^ (~e & g);
+      uint32_t t1 = h + S1 + ch + K256[i] + w[i];
+      uint32_t S0 = ROTR32(a, 2) ^ ROTR32(a, 13) ^ ROTR32(a, 22);
+      uint32_t maj = (a & b) ^ (a & c) ^ (b & c);
+
+      h = g;
+      g = f;
+      f = e;
+      e = d + t1;
+      d = c;
+      c = b;
+      b = a;
+      a = t1 + S0 + maj;
+    }
+
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+    state[4] += e;
+    state[5] += f;
+    state[6] += g;
+    state[7] += h;
+  }
+}
+
+#ifdef ISC_SIMD_X86
+// SHA extensions keep the state as ABEF and CDGH, 4 rounds per message vector
+SIMD_TARGET("sha,sse4.1")
+static void sha256SHANI(uint32_t state[8], const uint8_t *in, size_t nblk) {
+  const __m128i bswap =
+      _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+
+  __m128i tmp = _mm_shuffle_epi32(_mm_loadu_si128((__m128i *)&state[0]), 0xb1);
+  __m128i cdgh = _mm_shuffle_epi32(_mm_loadu_si128((__m128i *)&state[4]), 0x1b);
+  __m128i abef = _mm_alignr_epi8(tmp, cdgh, 8);
+  cdgh = _mm_blend_epi16(cdgh, tmp, 0xf0);
+
+  for (; nblk--; in += HASH_BLK) {
+    __m128i abefSaved = abef, cdghSaved = cdgh, msg[4];
+
+    for (int i = 0; i < 4; ++i)
+      msg[i] = _mm_shuffle_epi8(_mm_loadu_si128((__m128i *)&in[i * 16]), bswap);
+
+    for (int r = 0; r < 16; ++r) {
+      auto &w = msg[r % 4];
+      if (r >= 4) {
+        // w[t] = s1(w[t-2]) + w[t-7] + s0(w[t-15]) + w[t-16]
+        auto &w4 = msg[(r + 3) % 4], &w8 = msg[(r + 2) % 4];
+        tmp = _mm_sha256msg1_epu32(w, msg[(r + 1) % 4]);
+        tmp = _mm_add_epi32(tmp, _mm_alignr_epi8(w4, w8, 4));
+        w = _mm_sha256msg2_epu32(tmp, w4);
+      }
+
+      tmp = _mm_add_epi32(w, _mm_loadu_si128((__m128i *)&K256[r * 4]));
+      cdgh = _mm_sha256rnds2_epu32(cdgh, abef, tmp);
+      abef = _mm_sha256rnds2_epu32(abef, cdgh, _mm_shuffle_epi32(tmp, 0x0e));
+    }
+
+    abef = _mm_add_epi32(abef, abefSaved);
+    cdgh = _mm_add_epi32(cdgh, cdghSaved);
+  }
+
+  tmp = _mm_shuffle_epi32(abef, 0x1b);
+  cdgh = _mm_shuffle_epi32(cdgh, 0xb1);
+  _mm_storeu_si128((__m128i *)&state[0], _mm_blend_epi16(tmp, cdgh, 0xf0));
+  _mm_storeu_si128((__m128i *)&state[4], _mm_alignr_epi8(cdgh, tmp, 8));
+}
+#endif
+
+class SHA256 : public HashAPP::Hasher {
+ public:
+  size_t digestSize() const override { return 32; }
+  void init() override;
+  void update(const uint8_t *, size_t _ADD_SIM_PARAMS) override;
+  void final(uint8_t *_ADD_SIM_PARAMS) override;
+
+ protected:
+  static void blocks(uint32_t state[8], const uint8_t *in, size_t nblk) {
+#ifdef ISC_SIMD_X86
+    if (Utils::SIMD::hasSHA())
+      return sha256SHANI(state, in, nblk);
+#endif
+    sha256Scalar(state, in, nblk);
+  }
+
+  uint32_t state[8];
+  uint64_t total;
+  uint8_t buf[HASH_BLK];
+  size_t szBuf;
+};
+
+void SHA256::init() {
+  static const uint32_t iv[8] = {0x6a09e667, 0xbb67ae85, 0x3c6ef372,
+                                 0xa54ff53a, 0x510e527f, 0x9b05688c,
+                                 0x1f83d9ab, 0x5be0cd19};
+  memcpy(state, iv, sizeof(state));
+  total = 0;
+  szBuf = 0;
+}
+
+void SHA256::update(const uint8_t *in, size_t len _ADD_SIM_PARAMS) {
+  simApplyManyLatency(CPU::ISC__SLET__HASH, HASH_TASK_SHA256,
+                      HASH_BLKS(total, len));
+  total += len;
+
+  if (szBuf + len < sizeof(buf)) {
+    memcpy(&buf[szBuf], in, len);
+    szBuf += len;
+    return;
+  }
+  if (szBuf) {
+    size_t fill = sizeof(buf) - szBuf;
+    memcpy(&buf[szBuf], in, fill);
+    blocks(state, buf, 1);
+    in += fill;
+    len -= fill;
+  }
+  blocks(state, in, len / sizeof(buf));
+  in += len / sizeof(buf) * sizeof(buf);
+  szBuf = len % sizeof(buf);
+  memcpy(buf, in, szBuf);
+}
+
+void SHA256::final(uint8_t *out _ADD_SIM_PARAMS) {
+  // pad with 0x80, zeros and the length in bits
+  buf[szBuf++] = 0x80;
+  if (szBuf > sizeof(buf) - 8) {
+    memset(&buf[szBuf], 0, sizeof(buf) - szBuf);
+    blocks(state, buf, 1);
+    szBuf = 0;
+  }
+  memset(&buf[szBuf], 0, sizeof(buf) - 8 - szBuf);
+  storeBE(&buf[sizeof(buf) - 8], total << 3, 8);
+  blocks(state, buf, 1);
+
+  for (int i = 0; i < 8; ++i)
+    storeBE(&out[i * 4], state[i], 4);
+  simApplyLatency(CPU::ISC__SLET__HASH, HASH_TASK_SHA256);
+  simApplyLatency(CPU::ISC__SLET__HASH, HASH_TASK_FINAL);
+}
+
+/* -------------------------------------------------------------------------- */
+/*                            major function impls                            */
+/* -------------------------------------------------------------------------- */
+
+static const struct {
+  const char *name;
+  HashAPP::Hasher *(*create)();
+} hashers[] = {
+    {"xxh64", []() -> HashAPP::Hasher * { return new XXH64(); }},
+    {"crc32c", []() -> HashAPP::Hasher * { return new CRC32C(); }},
+    {"sha256", []() -> HashAPP::Hasher * { return new SHA256(); }},
+};
+
+HashAPP::Hasher *HashAPP::newHasher(const char *algo) {
+  for (auto &h : hashers) {
+    if (!strcmp(algo, h.name))
+      return h.create();
+  }
+  return nullptr;
+}
+
+HashAPP::HashAPP(_SIM_PARAMS) {
+  this->opt.name = strdup("HashAPP");
+  this->opt.cwd = strdup("/");
+}
+
+ISC_STS HashAPP::builtin_startup(_SIM_PARAMS) {
+  auto doit = [this](_SIM_PARAMS) -> ISC_STS {
+    auto sts = ISC_STS_OK;
+
+    auto algo = this->getOpt<const char>(keyAlgo);
+    auto hasher = newHasher(algo ? algo : "xxh64");
+    if (!hasher) {
+      pr("Unknown hash algorithm '%s'", algo);
+      return ISC_STS_EARGS;
+    }
+    auto szDigest = hasher->digestSize();
+
+    std::vector<GenericFSA::ExtList> files;
+    if ((sts = this->resolveFiles(files, false _add_sim_params)) != ISC_STS_OK) {
+      delete hasher;
+      return sts;
+    }
+
+    // allocate output buffer and start hashing
+    auto szOut = files.size() * szDigest;
+    auto bufOut = (uint8_t *)calloc(szOut + 1, sizeof(uint8_t));
+    if (!bufOut) {
+      freeFiles(files);
+      delete hasher;
+      return ISC_STS_FAIL;
+    }
+
+    // files are hashed by tasks on the ISC cores, chunk by chunk; a task runs
+    // to its end before the next, so they can share the hasher
+    sts = Runtime::runTasks(
+        files.size(),
+        [&](size_t i _ADD_SIM_PARAMS) {
+          Stream stream(files[i]);
+          const byte *chunk;
+
+          hasher->init();
+          for (size_t len; (len = stream.next(&chunk _add_sim_params));)
+            hasher->update(chunk, len _add_sim_params);
+          hasher->final(&bufOut[i * szDigest] _add_sim_params);
+          return ISC_STS_OK;
+        } _add_sim_params);
+    freeFiles(files);
+    delete hasher;
+
+    if (sts != ISC_STS_OK) {
+      free(bufOut);
+      return sts;
+    }
+    return this->publishResult(bufOut, szOut);
+  };
+
+  auto res = doit(_sim_params);
+  simApplyLatency(CPU::ISC__SLET__HASH, CPU::ISC__START_SLET);
+  return res;
+}
+
+#ifndef ISC_TEST
+namespace {
+
+struct HashRun;
+
+// a core of HashAPP::builtin_startAsync(), hashing a file at a time
+struct HashLane {
+  HashRun *run;
+  HashAPP::Hasher *hasher;
+  GenericAPP::Stream *stream;  // nullptr if the lane is idle
+  size_t iFile;
+  uint64_t clock;  // tick of the core
+};
+
+struct HashRun {
+  HashAPP *app;
+  std::vector<GenericFSA::ExtList> files;
+  uint8_t *bufOut;
+  size_t szDigest;
+  size_t iNext;    // file to be taken by the next idle lane
+  size_t numBusy;  // lanes not done yet
+  std::vector<HashLane> lanes;
+  ISC_STS sts;
+  void *ctx;  // request waiting for the slet
+  GenericSlet::DoneFunc done;
+};
+
+}  // namespace
+
+static void hashChunk(void *, const byte *, size_t, uint64_t);
+
+// all lanes are done, publish the digests and end the slet
+static void hashDone(HashRun *run) {
+  uint64_t tick = 0;
+  for (auto &lane : run->lanes) {
+    tick = std::max(tick, lane.clock);
+    delete lane.hasher;
+  }
+
+  auto szOut = run->files.size() * run->szDigest;
+  GenericAPP::freeFiles(run->files);
+  if (run->sts == ISC_STS_OK)
+    run->sts = run->app->publishResult(run->bufOut, szOut);
+  else
+    free(run->bufOut);
+
+  simApplyLatency(CPU::ISC__SLET__HASH, CPU::ISC__START_SLET);
+  run->done(run->sts, tick);
+  delete run;
+}
+
+// hash a chunk of the file of the lane, 0 bytes at the end of it
+static void hashData(HashLane &lane, const byte *chunk, size_t len) {
+  auto run = lane.run;
+  auto &tick = lane.clock;
+  auto ctx = run->ctx;
+
+  if (len) {
+    lane.hasher->update(chunk, len _add_sim_params);
+    return;
+  }
+
+  // the stream ends without reads in flight
+  lane.hasher->final(&run->bufOut[lane.iFile * run->szDigest] _add_sim_params);
+  if (run->sts == ISC_STS_OK)
+    run->sts = lane.stream->getStatus();
+  delete lane.stream;
+  lane.stream = nullptr;
+}
+
+// hash the chunks already read, return once the lane waits for reads
+static void hashLane(HashLane &lane) {
+  auto run = lane.run;
+  auto &tick = lane.clock;
+  auto ctx = run->ctx;
+
+  for (;;) {
+    if (!lane.stream) {
+      if (run->iNext == run->files.size() || run->sts != ISC_STS_OK) {
+        if (!--run->numBusy)
+          hashDone(run);
+        return;
+      }
+      lane.iFile = run->iNext++;
+      lane.stream = new GenericAPP::Stream(run->files[lane.iFile]);
+      lane.hasher->init();
+      tick += applyLatency(CPU::ISC__RUNTIME, CPU::ISC__TASK1);
+    }
+
+    const byte *chunk;
+    size_t len;
+    if (!lane.stream->nextAsync(&chunk, &len, hashChunk,
+                                &lane _add_sim_params))
+      return;  // hashChunk() goes on
+    hashData(lane, chunk, len);
+  }
+}
+
+// the chunk the lane waits for is read
+static void hashChunk(void *arg, const byte *chunk, size_t len,
+                      uint64_t readyAt) {
+  auto &lane = *(HashLane *)arg;
+
+  lane.clock = readyAt;
+  hashData(lane, chunk, len);
+  hashLane(lane);
+}
+
+ISC_STS HashAPP::builtin_startAsync(const DoneFunc &done _ADD_SIM_PARAMS) {
+  auto algo = this->getOpt<const char>(keyAlgo);
+  algo = algo ? algo : "xxh64";
+  auto hasher = newHasher(algo);
+  if (!hasher) {
+    pr("Unknown hash algorithm '%s'", algo);
+    return ISC_STS_EARGS;
+  }
+
+  auto run = new HashRun();
+  auto sts = this->resolveFiles(run->files, false _add_sim_params);
+  if (sts != ISC_STS_OK) {
+    delete hasher;
+    delete run;
+    return sts;
+  }
+
+  run->app = this;
+  run->szDigest = hasher->digestSize();
+  run->bufOut = (uint8_t *)calloc(run->files.size() * run->szDigest + 1, 1);
+  run->iNext = 0;
+  run->sts = ISC_STS_OK;
+  run->ctx = simCtx;
+  run->done = done;
+  delete hasher;
+  if (!run->bufOut) {
+    freeFiles(run->files);
+    delete run;
+    return ISC_STS_FAIL;
+  }
+
+  // the lanes go on by events, the last one ends the slet, which may be here
+  // if nothing is read
+  auto numLanes = std::min(SIM::numCores(), run->files.size());
+  run->lanes.resize(std::max<size_t>(numLanes, 1));
+  for (auto &lane : run->lanes)
+    lane = HashLane{run, newHasher(algo), nullptr, 0, simTick};
+  run->numBusy = run->lanes.size();
+  for (size_t i = 0, n = run->lanes.size(); i < n; ++i)
+    hashLane(run->lanes[i]);
+  return ISC_STS_OK;
+}
+#endif
+
+}  // namespace ISC
+}  // namespace SimpleSSD
@@ -0,0 +1,60 @@
+#ifndef __SIMPLESSD_ISC_SLET_HASH_HH__
+#define __SIMPLESSD_ISC_SLET_HASH_HH__
+
+#include "sims/cpu.hh"
+
+#include "types.hh"
+
+namespace SimpleSSD {
+namespace ISC {
+
+/**
+ * @brief Hash files for dedup and integrity scans, by the selected algorithm
+ *
+ * The result is the digests of the files packed back to back, in the order of
+ * files under the given path.
+ */
+class HashAPP : public GenericAPP {
+ public:
+  HashAPP(_SIM_PARAMS);
+  ~HashAPP() {}
+
+  /**
+   * @brief Interface of the hash algorithms
+   *
+   * Implement this and add it to the table in hash.cc for a new algorithm.
+   * Digests are in the canonical byte order of the algorithm, integers (xxh64,
+   * crc32c) are big-endian as printed by the command line tools.
+   */
+  class Hasher {
+   public:
+    virtual ~Hasher() {}
+
+    virtual size_t digestSize() const = 0;
+    virtual void init() = 0;
+    virtual void update(const uint8_t *, size_t _ADD_SIM_PARAMS) = 0;
+    virtual void final(uint8_t *_ADD_SIM_PARAMS) = 0;
+  };
+
+  /**
+   * @brief Create a hasher by the name of algorithm
+   *
+   * @return Hasher* nullptr if the algorithm is unknown
+   */
+  static Hasher *newHasher(const char *);
+
+  ISC_STS builtin_startup(_SIM_PARAMS) override;
+#ifndef ISC_TEST
+  // a lane of files per ISC core, a lane waits for its reads by events
+  ISC_STS builtin_startAsync(const DoneFunc &_ADD_SIM_PARAMS) override;
+#endif
+
+  static const SletKey keyAlgo;  // xxh64 (default), crc32c or sha256
+
+  static const size_t BLK_SIZE = 4096;
+};
+
+}  // namespace ISC
+}  // namespace SimpleSSD
+
+#endif /* __SIMPLESSD_ISC_SLET_HASH_HH__ */
@@ -14,10 +14,6 @@ class ListdirAPP : public GenericAPP {
   ~ListdirAPP() {}
 
   ISC_STS builtin_startup(_SIM_PARAMS) override;
-
-  static const char *keyPath;
-  static const char *keyResult;
-  static const char *keyResultSize;
 };
 
 }  // namespace ISC
@@ -1,15 +1,17 @@
+#include <algorithm>
 #include <cstdint>
 #include <cstdlib>
+#include <vector>
 
 #include <typeinfo>
 
 #include "sims/configs.hh"
 #include "sims/ftl.hh"
 
-#include "fs/ext4/ext4.hh"
 #include "runtime.hh"
 #include "slet/md5.hh"
 #include "utils/debug.hh"
+#include "utils/simd.hh"
 
 namespace SimpleSSD {
 namespace ISC {
@@ -20,14 +22,6 @@ using namespace SIM;
 
 #define ISC_APP_CLASS MD5APP
 
-const char *ISC_APP_CLASS::keyNumFiles = "numfiles";
-const char *ISC_APP_CLASS::keyFileSizes = "filesizes";
-const char *ISC_APP_CLASS::keyExts = "exts";
-
-const char *ISC_APP_CLASS::keyPath = "path";
-const char *ISC_APP_CLASS::keyResult = ISC_KEY_RESULT;
-const char *ISC_APP_CLASS::keyResultSize = ISC_KEY_RESULT_SIZE;
-
 template ISC_STS Runtime::addSlet<MD5APP>(_SIM_PARAMS);
 
 typedef struct {
@@ -89,10 +83,26 @@ static void MD5Update(MD5_CTX *, uint8_t *, uint32_t _ADD_SIM_PARAMS);
 static void __attribute__((noinline))
 Encode(uint8_t *, uint32_t *, uint32_t _ADD_SIM_PARAMS);
 
+// a file being hashed in a lane of MD5APP::md5Files()
+typedef struct {
+  MD5_CTX ctx;
+  GenericAPP::Stream *stream;  // nullptr if the lane is idle
+  const uint8_t *data;         // data of the chunk not hashed yet
+  size_t len;
+  size_t iFile;
+} MD5_LANE;
+
+static bool MD5Fill(MD5_LANE *_ADD_SIM_PARAMS);
+static void MD5TransformLanes(MD5_LANE *, size_t, size_t _ADD_SIM_PARAMS);
+
 #define MD5_TASK_SUM CPU::ISC__TASK1
 #define MD5_TASK_TRANSFORM CPU::ISC__TASK2
 #define MD5_TASK_UPDATE CPU::ISC__TASK3
 #define MD5_TASK_ENCODE CPU::ISC__TASK4
+#define MD5_VTASK_TRANSFORM CPU::ISC__VTASK1
+
+// lanes in a vector of the simulated ISC core (128-bit)
+#define MD5_SIM_LANES 4
 
 /* -------------------------------------------------------------------------- */
 /*                            major function impls                            */
@@ -102,214 +112,117 @@ ISC_APP_CLASS::ISC_APP_CLASS(_SIM_PARAMS) : GenericAPP() {
   this->opt.name = strdup(typeid(*this).name());
 }
 
-void ISC_APP_CLASS::md5sum(uint8_t *in, uint32_t inSz,
-                           uint32_t out[4] _ADD_SIM_PARAMS) {
-  MD5_CTX md5Ctx;
-
-  // MD5Init
-  md5Ctx.count[0] = md5Ctx.count[1] = 0;
-  md5Ctx.state[0] = 0x67452301;
-  md5Ctx.state[1] = 0xefcdab89;
-  md5Ctx.state[2] = 0x98badcfe;
-  md5Ctx.state[3] = 0x10325476;
-
-  MD5Update(&md5Ctx, in, inSz _add_sim_params);
+static void MD5Init(MD5_CTX *md5Ctx) {
+  md5Ctx->count[0] = md5Ctx->count[1] = 0;
+  md5Ctx->state[0] = 0x67452301;
+  md5Ctx->state[1] = 0xefcdab89;
+  md5Ctx->state[2] = 0x98badcfe;
+  md5Ctx->state[3] = 0x10325476;
+}
 
-  // MD5Final
+static void MD5Final(MD5_CTX *md5Ctx, uint32_t out[4] _ADD_SIM_PARAMS) {
   uint8_t bits[8];
-  Encode(bits, md5Ctx.count, 8 _add_sim_params);
+  Encode(bits, md5Ctx->count, 8 _add_sim_params);
 
-  uint32_t index = (uint32_t)((md5Ctx.count[0] >> 3) & 0x3f);
+  uint32_t index = (uint32_t)((md5Ctx->count[0] >> 3) & 0x3f);
   uint32_t padLen = (index < 56) ? (56 - index) : (120 - index);
-  MD5Update(&md5Ctx, PADDING, padLen _add_sim_params);
-  MD5Update(&md5Ctx, bits, 8 _add_sim_params);
-  Encode((uint8_t *)out, md5Ctx.state, 16 _add_sim_params);
-
-  simApplyLatency(CPU::ISC__SLET__MD5, MD5_TASK_SUM);
+  MD5Update(md5Ctx, PADDING, padLen _add_sim_params);
+  MD5Update(md5Ctx, bits, 8 _add_sim_params);
+  Encode((uint8_t *)out, md5Ctx->state, 16 _add_sim_params);
 }
 
-ISC_STS ISC_APP_CLASS::builtin_startup(_SIM_PARAMS) {
-  auto doit = [this](_SIM_PARAMS) -> ISC_STS {
-    auto sts = ISC_STS_OK;
-
-    // get options
-    GenericFSA::ExtList *fileExtLists = nullptr;
-    auto exts = (GenericFSA::Ext *)this->getOpt(keyExts);
-    auto numFiles = (size_t *)this->getOpt(keyNumFiles);
-    auto fileSizes = (size_t *)this->getOpt(keyFileSizes);
-    auto nofsa = exts && numFiles && fileSizes;
-
-    auto path = (const char *)this->getOpt(keyPath);
-    auto isdir = path[strlen(path) - 1] == '/';
-
-    // allocate result size buffer
-    auto bufOutSz = (size_t *)calloc(1, sizeof(size_t));
-    if (!bufOutSz)
-      return ISC_STS_FAIL;
+void ISC_APP_CLASS::md5sum(uint8_t *in, uint32_t inSz,
+                           uint32_t out[4] _ADD_SIM_PARAMS) {
+  MD5_CTX md5Ctx;
 
-    size_t iFile = 0, oBufDir = 0, szBufDir = 0;
-    char pathFile[512] = {0};
-
-    // determine output buffer size
-    uint32_t *bufOut;
-    char *bufDir = nullptr;
-    Ext4::fake_dirent *dirent;
-
-    if (isdir && !nofsa) {
-      auto dirExtList = Runtime::getExts(path _add_sim_params);
-      for (size_t ie = 0; ie < dirExtList.len; ++ie)
-        szBufDir += dirExtList.exts[ie].len * BLK_SIZE;
-
-      // read dir entries
-      bufDir = (char *)calloc(1, szBufDir);
-      if (!bufDir) {
-        free(dirExtList.exts);
-        sts = ISC_STS_FAIL;
-        goto out_free_ressize;
-      }
-      for (size_t ie = 0, ofsBuf = 0; ie < dirExtList.len; ++ie) {
-        auto ofsData = dirExtList.exts[ie].slbn * BLK_SIZE;
-        auto szData = dirExtList.exts[ie].len * BLK_SIZE;
-        SIM::FTL::read(&bufDir[ofsBuf], ofsData, szData _add_sim_params);
-        ofsBuf += szData;
-      }
+  MD5Init(&md5Ctx);
+  MD5Update(&md5Ctx, in, inSz _add_sim_params);
+  MD5Final(&md5Ctx, out _add_sim_params);
 
-      // check number of files
-      for (oBufDir = 0; oBufDir < szBufDir; oBufDir += dirent->rec_len) {
-        dirent = (Ext4::fake_dirent *)&bufDir[oBufDir];
+  simApplyLatency(CPU::ISC__SLET__MD5, MD5_TASK_SUM);
+}
 
-        if (dirent->inode == 0) {
-          // skip 1 dummy tail dent (checksum)
-          if (dirent->file_type == 0xde) {
-            pr("End of directory block (+%d)", dirent->rec_len);
-            continue;
-          }
-          break;
+void ISC_APP_CLASS::md5Files(const GenericFSA::ExtList *files, size_t numFiles,
+                             uint32_t *out _ADD_SIM_PARAMS) {
+  MD5_LANE lanes[LANES];
+  size_t iNext = 0;
+
+  for (auto &lane : lanes)
+    lane.stream = nullptr;
+
+  while (true) {
+    // keep a whole block in every lane, idle lanes take the next file
+    for (auto &lane : lanes) {
+      while (lane.stream || iNext < numFiles) {
+        if (!lane.stream) {
+          pr("Lane[%lu]: file[%lu]", (size_t)(&lane - lanes), iNext);
+          lane.iFile = iNext++;
+          lane.stream = new Stream(files[lane.iFile], LANE_CHUNK_SIZE);
+          lane.len = 0;
+          MD5Init(&lane.ctx);
         }
+        if (MD5Fill(&lane _add_sim_params))
+          break;
 
-        if (dirent->file_type != 2 /* dir */) {
-          char name[256] = {0};
-          strncpy(name, &bufDir[oBufDir + sizeof(*dirent)], dirent->name_len);
+        MD5Final(&lane.ctx, &out[lane.iFile * 4] _add_sim_params);
+        simApplyLatency(CPU::ISC__SLET__MD5, MD5_TASK_SUM);
 
-          *bufOutSz += BYTES_PER_RESULT;
-          pr("[+%lu]: '%s'", oBufDir, name);
-        }
-      }
-      free(dirExtList.exts);
-    }
-    else if (!nofsa) {
-      strncpy(pathFile, path, 255);
-      *bufOutSz = BYTES_PER_RESULT;
-    }
-    else {
-      // convert exts to ExtList
-      fileExtLists =
-          (GenericFSA::ExtList *)calloc(*numFiles, sizeof(GenericFSA::ExtList));
-
-      for (size_t i = 0, ie = 0; i < *numFiles; ++i, ++ie) {
-        fileExtLists[i].bytes = fileSizes[i];
-
-        // exts is separated by 'block == UINT64_MAX'
-        fileExtLists[i].exts = &exts[ie];
-        // exts is separated by 'block == UINT64_MAX'
-        fileExtLists[i].exts = &exts[ie];
-        fileExtLists[i].len = 0;
-        for (; exts[ie].block != UINT64_MAX; ++ie)
-          fileExtLists[i].len++;
+        delete lane.stream;
+        lane.stream = nullptr;
       }
-      *bufOutSz = *numFiles * BYTES_PER_RESULT;
-      if (!isdir)
-        strncpy(pathFile, path, 255);
     }
 
-    // allocate output buffer and start hashing
-    bufOut = (uint32_t *)calloc(*bufOutSz + 1, sizeof(uint8_t));
-    if (!bufOut) {
-      sts = ISC_STS_FAIL;
-      goto out_free_ressize;
-    }
-    if (!isdir)
-      goto readfile;
-
-    pr("Num files: %lu %s", *bufOutSz / BYTES_PER_RESULT, isdir ? "(dir)" : "");
-    for (oBufDir = 0; iFile < (*bufOutSz / 16); ++iFile) {
-      // find next file
-      if (nofsa) {
-        // we don't know the exact filename, give it a symbolic name
-        snprintf(pathFile, 255, "%s[%lu]", path, iFile);
-        goto readfile;
-      }
-
-      for (char name[256]; oBufDir < szBufDir; oBufDir += dirent->rec_len) {
-        dirent = (Ext4::fake_dirent *)&bufDir[oBufDir];
-
-        if (dirent->file_type == 2 /* dir */)
-          continue;
-
-        memset(name, 0, 256);
-        strncpy(name, &bufDir[oBufDir + sizeof(*dirent)], dirent->name_len);
-
-        pr("[+%lu]: Find file %s", oBufDir, name);
-        snprintf(pathFile, 511, "%s%s", path, name);
-        oBufDir += dirent->rec_len;
-        break;
+    // transform the blocks all busy lanes have
+    size_t numBlks = SIZE_MAX, numBusy = 0;
+    for (auto &lane : lanes) {
+      if (lane.stream) {
+        numBlks = std::min(numBlks, lane.len / 64);
+        numBusy++;
       }
+    }
+    if (!numBusy)
+      break;
 
-      // read data of the path
-    readfile:
-      pr("File[%lu]: %s", iFile, pathFile);
-
-      auto szBufFile = 0;
-      GenericFSA::ExtList fileExtList;
-      if (nofsa)
-        fileExtList = fileExtLists[iFile];
-      else
-        fileExtList = Runtime::getExts(pathFile _add_sim_params);
-
-      for (size_t ie = 0; ie < fileExtList.len; ++ie)
-        szBufFile += fileExtList.exts[ie].len * BLK_SIZE;
-
-      // read file data
-      auto bufFile = (uint8_t *)calloc(1, szBufFile);
-      if (!bufFile) {
-        sts = ISC_STS_FAIL;
-        goto out_free_fileExt;
-      }
-      for (size_t ie = 0, ofsBuf = 0; ie < fileExtList.len; ++ie) {
-        auto ofsData = fileExtList.exts[ie].slbn * BLK_SIZE;
-        auto szData = fileExtList.exts[ie].len * BLK_SIZE;
-        SIM::FTL::read(&bufFile[ofsBuf], ofsData, szData _add_sim_params);
-        ofsBuf += szData;
-      }
+    MD5TransformLanes(lanes, numBlks, numBusy _add_sim_params);
+  }
+}
 
-      // do md5 on this file
-      md5sum(bufFile, fileExtList.bytes, &bufOut[iFile * 4] _add_sim_params);
+ISC_STS ISC_APP_CLASS::builtin_startup(_SIM_PARAMS) {
+  auto doit = [this](_SIM_PARAMS) -> ISC_STS {
+    auto sts = ISC_STS_OK;
 
-      free(bufFile);
-    out_free_fileExt:
-      if (!nofsa)
-        free(fileExtList.exts);
+    std::vector<GenericFSA::ExtList> files;
+    if ((sts = this->resolveFiles(files, false _add_sim_params)) != ISC_STS_OK)
+      return sts;
 
-      if (sts != ISC_STS_OK)
-        goto out_free_result;
+    // allocate output buffer and start hashing
+    auto szOut = files.size() * BYTES_PER_RESULT;
+    auto bufOut = (uint32_t *)calloc(szOut + 1, sizeof(uint8_t));
+    if (!bufOut) {
+      freeFiles(files);
+      return ISC_STS_FAIL;
     }
 
-    // set result
-    sts = this->setOpt(keyResultSize, bufOutSz);
-    if (sts == ISC_STS_OK)
-      sts = this->setOpt(keyResult, bufOut);
-
-  out_free_result:
-    if (sts != ISC_STS_OK)
+    // groups of files are hashed by tasks on the ISC cores, a group is whole
+    // vectors of lanes and small enough to leave some tasks to steal
+    auto perTask = files.size() / (SIM::numCores() * 4);
+    perTask = std::max<size_t>(MD5_SIM_LANES, perTask);
+    perTask = std::min((size_t)LANES, perTask - perTask % MD5_SIM_LANES);
+    sts = Runtime::runTasks(
+        (files.size() + perTask - 1) / perTask,
+        [&](size_t iTask _ADD_SIM_PARAMS) {
+          auto iFirst = iTask * perTask;
+          md5Files(&files[iFirst], std::min(perTask, files.size() - iFirst),
+                   &bufOut[iFirst * 4] _add_sim_params);
+          return ISC_STS_OK;
+        } _add_sim_params);
+    freeFiles(files);
+
+    if (sts != ISC_STS_OK) {
       free(bufOut);
-    if (isdir && !nofsa)
-      free(bufDir);
-    if (nofsa)
-      free(fileExtLists);
-  out_free_ressize:
-    if (sts != ISC_STS_OK)
-      free(bufOutSz);
-    return sts;
+      return sts;
+    }
+    return this->publishResult(bufOut, szOut);
   };
 
   auto res = doit(_sim_params);
@@ -464,5 +377,218 @@ static void Encode(uint8_t *out, uint32_t *in, uint32_t len _ADD_SIM_PARAMS) {
   simApplyLatency(CPU::ISC__SLET__MD5, MD5_TASK_ENCODE);
 }
 
+NO_UINT_SANS
+static void MD5Count(MD5_CTX *context, uint64_t inSz) {
+  uint64_t bits = ((uint64_t)context->count[1] << 32) | context->count[0];
+
+  bits += inSz << 3;
+  context->count[0] = (uint32_t)bits;
+  context->count[1] = (uint32_t)(bits >> 32);
+}
+
+/**
+ * @brief Feed the lane until it has a whole block, or the file ends
+ *
+ * Chunks are multiples of blocks except the last one, a partial block is
+ * buffered into the context, and the next chunk (if any) is realigned.
+ *
+ * @return false if the file ends, the lane is ready to be finalized
+ */
+static bool MD5Fill(MD5_LANE *lane _ADD_SIM_PARAMS) {
+  while (lane->len < 64) {
+    if (lane->len) {
+      MD5Update(&lane->ctx, (uint8_t *)lane->data, lane->len _add_sim_params);
+      lane->len = 0;
+    }
+
+    const byte *chunk;
+    auto len = lane->stream->next(&chunk _add_sim_params);
+    if (!len)
+      return false;
+
+    size_t index = (lane->ctx.count[0] >> 3) & 0x3f;
+    size_t head = index ? std::min(len, 64 - index) : 0;
+    if (head)
+      MD5Update(&lane->ctx, (uint8_t *)chunk, head _add_sim_params);
+
+    lane->data = chunk + head;
+    lane->len = len - head;
+  }
+  return true;
+}
+
+#ifdef ISC_SIMD_X86
+typedef uint32_t u32x4_t __attribute__((vector_size(16)));
+typedef uint32_t u32x8_t __attribute__((vector_size(32)));
+typedef uint32_t u32x16_t __attribute__((vector_size(64)));
+
+/**
+ * @brief Transform blocks of N lanes at once, word i of the lanes is a vector
+ *
+ * Written with vector extensions, the same code is built into each ISA below.
+ */
+template <typename vec_t, size_t N = sizeof(vec_t) / sizeof(uint32_t)>
+NO_UINT_SANS static inline __attribute__((always_inline)) void
+MD5TransformN(uint32_t *const *state, const uint8_t *const *in, size_t nblk) {
+  static const uint8_t S[4][4] = {
+      {7, 12, 17, 22}, {5, 9, 14, 20}, {4, 11, 16, 23}, {6, 10, 15, 21}};
+
+  vec_t a, b, c, d, x[16];
+  for (size_t l = 0; l < N; ++l) {
+    a[l] = state[l][0];
+    b[l] = state[l][1];
+    c[l] = state[l][2];
+    d[l] = state[l][3];
+  }
+
+  for (size_t blk = 0; blk < nblk; ++blk) {
+    // transpose, x86 is little-endian as MD5
+    alignas(sizeof(vec_t)) uint32_t words[16][N];
+    for (size_t l = 0; l < N; ++l)
+      for (size_t i = 0; i < 16; ++i)
+        memcpy(&words[i][l], &in[l][blk * 64 + i * 4], sizeof(uint32_t));
+    memcpy(x, words, sizeof(x));
+
+    vec_t aa = a, bb = b, cc = c, dd = d;
+
+#define VSTEP(X, i, g)                                                         \
+  {                                                                            \
+    vec_t t = a + X(b, c, d) + x[g] + K[i];                                    \
+    t = ROTATE_LEFT(t, S[(i) / 16][(i) % 4]);                                  \
+    a = d;                                                                     \
+    d = c;                                                                     \
+    c = b;                                                                     \
+    b += t;                                                                    \
+  }
+    for (int i = 0; i < 16; ++i)
+      VSTEP(F, i, i);
+    for (int i = 16; i < 32; ++i)
+      VSTEP(G, i, (5 * i + 1) % 16);
+    for (int i = 32; i < 48; ++i)
+      VSTEP(H, i, (3 * i + 5) % 16);
+    for (int i = 48; i < 64; ++i)
+      VSTEP(I, i, (7 * i) % 16);
+#undef VSTEP
+
+    a += aa;
+    b += bb;
+    c += cc;
+    d += dd;
+  }
+
+  for (size_t l = 0; l < N; ++l) {
+    state[l][0] = a[l];
+    state[l][1] = b[l];
+    state[l][2] = c[l];
+    state[l][3] = d[l];
+  }
+}
+
+SIMD_TARGET("sse2")
+static void MD5TransformSSE4(uint32_t *const *state, const uint8_t *const *in,
+                             size_t nblk) {
+  MD5TransformN<u32x4_t>(state, in, nblk);
+}
+
+SIMD_TARGET("avx2")
+static void MD5TransformAVX2(uint32_t *const *state, const uint8_t *const *in,
+                             size_t nblk) {
+  MD5TransformN<u32x8_t>(state, in, nblk);
+}
+
+SIMD_AVX512_BEGIN
+SIMD_TARGET("avx512f")
+static void MD5TransformAVX512(uint32_t *const *state,
+                               const uint8_t *const *in, size_t nblk) {
+  MD5TransformN<u32x16_t>(state, in, nblk);
+}
+SIMD_AVX512_END
+#endif
+
+/**
+ * @brief Transform nblk blocks of every busy lane
+ *
+ * Host kernels take 4, 8 or 16 lanes by the ISA in use, idle lanes in a vector
+ * are fed with data of a busy lane and their states are dropped. The simulated
+ * core is charged per 4 lanes, a single busy lane goes through MD5Update().
+ */
+static void MD5TransformLanes(MD5_LANE *lanes, size_t nblk,
+                              size_t numBusy _ADD_SIM_PARAMS) {
+  const auto numLanes = MD5APP::LANES;
+
+  if (numBusy == 1) {
+    for (size_t l = 0; l < numLanes; ++l) {
+      if (lanes[l].stream) {
+        MD5Update(&lanes[l].ctx, (uint8_t *)lanes[l].data, nblk * 64
+                  _add_sim_params);
+        lanes[l].data += nblk * 64;
+        lanes[l].len -= nblk * 64;
+      }
+    }
+    return;
+  }
+
+  uint32_t *state[numLanes], dummy[numLanes][4] = {};
+  const uint8_t *in[numLanes], *busyData = nullptr;
+  for (size_t l = 0; l < numLanes; ++l) {
+    if (lanes[l].stream)
+      busyData = lanes[l].data;
+  }
+  for (size_t l = 0; l < numLanes; ++l) {
+    state[l] = lanes[l].stream ? lanes[l].ctx.state : dummy[l];
+    in[l] = lanes[l].stream ? lanes[l].data : busyData;
+  }
+
+  // host
+  size_t width = 1;
+#ifdef ISC_SIMD_X86
+  typedef void (*kernel_t)(uint32_t *const *, const uint8_t *const *, size_t);
+  static const kernel_t kernels[Utils::SIMD::ISA_COUNT] = {
+      nullptr, MD5TransformSSE4, MD5TransformAVX2, MD5TransformAVX512};
+  static const size_t widths[Utils::SIMD::ISA_COUNT] = {1, 4, 8, 16};
+
+  auto isa = Utils::SIMD::getISA();
+  width = widths[isa];
+#endif
+
+  size_t numGroups = 0;
+  for (size_t l = 0; l < numLanes; l += width) {
+    bool busy = false;
+    for (size_t i = l; i < l + width; ++i)
+      busy |= lanes[i].stream != nullptr;
+    if (!busy)
+      continue;
+
+#ifdef ISC_SIMD_X86
+    if (width > 1) {
+      kernels[isa](&state[l], &in[l], nblk);
+      continue;
+    }
+#endif
+    for (size_t blk = 0; blk < nblk; ++blk)
+      MD5Transform(state[l], (uint8_t *)&in[l][blk * 64]);
+  }
+
+  // simulated
+  for (size_t l = 0; l < numLanes; l += MD5_SIM_LANES) {
+    for (size_t i = l; i < l + MD5_SIM_LANES; ++i) {
+      if (lanes[i].stream) {
+        numGroups++;
+        break;
+      }
+    }
+  }
+  simApplyManyLatency(CPU::ISC__SLET__MD5, MD5_VTASK_TRANSFORM,
+                      nblk * numGroups);
+
+  for (size_t l = 0; l < numLanes; ++l) {
+    if (lanes[l].stream) {
+      lanes[l].data += nblk * 64;
+      lanes[l].len -= nblk * 64;
+      MD5Count(&lanes[l].ctx, nblk * 64);
+    }
+  }
+}
+
 }  // namespace ISC
-}  // namespace SimpleSSD
\ No newline at end of file
+}  // namespace SimpleSSD
@@ -19,17 +19,21 @@ class ISC_APP_CLASS : public GenericAPP {
   };
 
   void md5sum(uint8_t *, uint32_t, uint32_t[4] _ADD_SIM_PARAMS);
-  ISC_STS builtin_startup(_SIM_PARAMS) override;
-
-  static const char *keyNumFiles;
-  static const char *keyFileSizes;
-  static const char *keyExts;
 
-  static const char *keyPath;
-  static const char *keyResult;
-  static const char *keyResultSize;
+  /**
+   * @brief Hash the files in lanes, the digest of file i is at out[4 * i]
+   *
+   * Up to LANES files are hashed at once, an idle lane takes the next file.
+   * Blocks of the lanes are transformed together by the vector kernel of the
+   * host, the simulated core takes 4 lanes per vector.
+   */
+  void md5Files(const GenericFSA::ExtList *, size_t,
+                uint32_t * _ADD_SIM_PARAMS);
+  ISC_STS builtin_startup(_SIM_PARAMS) override;
 
   static const size_t BLK_SIZE = 4096;
+  static const size_t LANES = 16;
+  static const size_t LANE_CHUNK_SIZE = 64 << 10;
   static constexpr size_t BYTES_PER_RESULT = sizeof(result_t);
 
  protected:
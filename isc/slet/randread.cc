@@ -12,20 +12,18 @@ namespace ISC {
 
 using namespace SIM;
 
-const char *RandReadAPP::keyPath = "path";
-const char *RandReadAPP::keyOffsets = "offsets";
-const char *RandReadAPP::keyResult = "result";
-const char *RandReadAPP::keyConf = "conf";
+const SletKey RandReadAPP::keyOffsets = "offsets";
+const SletKey RandReadAPP::keyConf = "conf";
 
 RandReadAPP::RandReadAPP(_SIM_PARAMS) {
-  this->setOpt("name", strdup("RandReadAPP"));
+  this->setOpt(keyName, strdup("RandReadAPP"));
 }
 
 ISC_STS RandReadAPP::builtin_startup(_SIM_PARAMS) {
   // get required args
-  auto path = (const char *)this->getOpt(RandReadAPP::keyPath);
-  auto conf = (Work *)this->getOpt(RandReadAPP::keyConf);
-  auto offsets = (size_t *)this->getOpt(RandReadAPP::keyOffsets);
+  auto path = this->getOpt<const char>(GenericAPP::keyPath);
+  auto conf = this->getOpt<Work>(RandReadAPP::keyConf);
+  auto offsets = this->getOpt<size_t>(RandReadAPP::keyOffsets);
   if (!path || !conf || !offsets) {
     pr("some required input opts are missing!");
     return ISC_STS_EARGS;
@@ -79,7 +77,7 @@ ISC_STS RandReadAPP::builtin_startup(_SIM_PARAMS) {
   }
 
   free(extlist.exts);
-  this->setOpt(RandReadAPP::keyResult, result);
+  this->setOpt(GenericAPP::keyResult, result);
   return ISC_STS_OK;
 }
 
@@ -24,10 +24,8 @@ class RandReadAPP : public GenericAPP {
   RandReadAPP(_SIM_PARAMS);
   ISC_STS builtin_startup(_SIM_PARAMS) override;
 
-  static const char *keyPath;
-  static const char *keyOffsets;
-  static const char *keyResult;
-  static const char *keyConf;
+  static const SletKey keyOffsets;
+  static const SletKey keyConf;
 };
 
 }  // namespace ISC
@@ -0,0 +1,791 @@
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+#include "sims/cpu.hh"
+#include "sims/ftl.hh"
+
+#include "slet/scan.hh"
+
+#include "runtime.hh"
+
+#include "sims/configs.hh"
+#include "utils/math.hh"
+#include "utils/simd.hh"
+
+#define PR_SECTION LOG_ISC_SLET_SCAN
+
+namespace SimpleSSD {
+namespace ISC {
+
+template ISC_STS_SLET_ID Runtime::addSlet<ScanAPP>(_SIM_PARAMS);
+
+using namespace SIM;
+
+const SletKey ScanAPP::keyPlan = "plan";
+
+const size_t ScanAPP::MAX_PLAN;
+const size_t ScanAPP::BATCH;
+
+// the simulated core filters and aggregates by its 128-bit vectors, a word of
+// 64 rows is counted at once, and rows of BY or HIST go one by one
+#define SCAN_TASK_WORD CPU::ISC__TASK1
+#define SCAN_TASK_ROW CPU::ISC__TASK2
+#define SCAN_VTASK CPU::ISC__VTASK1
+
+#define SCAN_SIM_LANES(width) (16 / (width))
+
+#define SCAN_MAX_GROUPS (1 << 16)
+#define SCAN_MAX_RESULT (64 << 20)  // bytes of result, groups times bins
+
+// clang-format won't break after attribute, use this to make do that
+#if defined(__clang__)
+#define NO_SANS(...) __attribute__((no_sanitize(__VA_ARGS__)))
+#define NO_UINT_SANS NO_SANS("unsigned-integer-overflow")
+#else
+#define NO_SANS(...)
+#define NO_UINT_SANS
+#endif
+
+// call F<T> by the column type
+#define SCAN_DISPATCH(type, F, ...)                                            \
+  do {                                                                         \
+    switch (type) {                                                            \
+      case ScanAPP::I32:                                                       \
+        F<int32_t>(__VA_ARGS__);                                               \
+        break;                                                                 \
+      case ScanAPP::I64:                                                       \
+        F<int64_t>(__VA_ARGS__);                                               \
+        break;                                                                 \
+      case ScanAPP::F32:                                                       \
+        F<float>(__VA_ARGS__);                                                 \
+        break;                                                                 \
+      default:                                                                 \
+        F<double>(__VA_ARGS__);                                                \
+        break;                                                                 \
+    }                                                                          \
+  } while (0)
+
+typedef ScanAPP::Value Value;
+typedef ScanAPP::Plan Plan;
+typedef ScanAPP::State State;
+
+static const size_t typeWidth[ScanAPP::NUM_TYPES] = {4, 8, 4, 8};
+
+static inline bool isFloat(ScanAPP::Type t) {
+  return t == ScanAPP::F32 || t == ScanAPP::F64;
+}
+
+ScanAPP::ScanAPP(_SIM_PARAMS) {
+  this->opt.name = strdup("ScanAPP");
+  this->opt.cwd = strdup("/");
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                    Plan                                    */
+/* -------------------------------------------------------------------------- */
+
+ISC_STS ScanAPP::Plan::parse(const uint8_t *p, size_t len) {
+  size_t i = 0;
+  auto get = [&](void *dst, size_t sz) {
+    if (i + sz > len)
+      return false;
+    memcpy(dst, &p[i], sz);
+    i += sz;
+    return true;
+  };
+  auto getCol = [&](uint8_t *col) { return get(col, 1) && *col < cols.size(); };
+
+  *this = Plan();
+  groupRows = 0;
+  by = false;
+  byCol = 0;
+  byLo = 0;
+  numGroups = 1;
+
+  for (bool end = false; !end;) {
+    uint8_t op, type;
+    Pred pred;
+    Agg agg = {(Op)0, 0, {0}, {0}, 0};
+
+    if (!get(&op, 1))
+      goto bad_plan;
+
+    switch (op) {
+      case END:
+        end = true;
+        break;
+      case COL:
+        if (!get(&type, 1) || type >= NUM_TYPES || cols.size() >= UINT8_MAX)
+          goto bad_plan;
+        cols.push_back((Type)type);
+        break;
+      case ROWS:
+        if (!get(&groupRows, sizeof(groupRows)) || !groupRows)
+          goto bad_plan;
+        break;
+      case BETWEEN:
+        if (!getCol(&pred.col) || !get(&pred.lo, 8) || !get(&pred.hi, 8))
+          goto bad_plan;
+        preds.push_back(pred);
+        break;
+      case BY:
+        if (by || !getCol(&byCol) || isFloat(cols[byCol]) ||
+            !get(&byLo, sizeof(byLo)) || !get(&numGroups, sizeof(numGroups)) ||
+            !numGroups || numGroups > SCAN_MAX_GROUPS)
+          goto bad_plan;
+        by = true;
+        break;
+      case COUNT:
+        agg.op = COUNT;
+        aggs.push_back(agg);
+        break;
+      case SUM:
+      case MIN:
+      case MAX:
+        agg.op = (Op)op;
+        if (!getCol(&agg.col))
+          goto bad_plan;
+        aggs.push_back(agg);
+        break;
+      case HIST:
+        agg.op = HIST;
+        if (!getCol(&agg.col) || !get(&agg.lo, 8) || !get(&agg.hi, 8) ||
+            !get(&agg.nbins, sizeof(agg.nbins)) || !agg.nbins)
+          goto bad_plan;
+        if (isFloat(cols[agg.col]) ? !(agg.lo.f < agg.hi.f)
+                                   : !(agg.lo.i < agg.hi.i))
+          goto bad_plan;
+        aggs.push_back(agg);
+        break;
+      default:
+        goto bad_plan;
+    }
+  }
+
+  if (cols.empty() || aggs.empty())
+    goto bad_plan;
+
+  // the result and each partial state grow by groups times bins, which are
+  // bound together, not only one by one
+  {
+    size_t slots = 0;
+    for (auto &agg : aggs)
+      slots += agg.op == HIST ? agg.nbins : 1;
+    if (slots > SCAN_MAX_RESULT / sizeof(uint64_t) / numGroups)
+      goto bad_plan;
+  }
+
+  rowBytes = 0;
+  for (auto t : cols) {
+    offsets.push_back(rowBytes);
+    rowBytes += typeWidth[t];
+  }
+
+  // a single column is the same in any groups, otherwise a group shall fill
+  // blocks, so that the chunks of file are made of whole groups
+  if (cols.size() == 1)
+    groupRows = 0;
+  else if (!groupRows || groupRows * rowBytes % BLK_SIZE)
+    goto bad_plan;
+
+  return ISC_STS_OK;
+
+bad_plan:
+  pr("Bad plan at byte %lu", i);
+  return ISC_STS_EARGS;
+}
+
+size_t ScanAPP::Plan::resultSize() const {
+  size_t sz = 0;
+  for (auto &agg : aggs)
+    sz += agg.op == HIST ? agg.nbins * sizeof(uint64_t) : sizeof(uint64_t);
+  return sz * numGroups;
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                    State                                   */
+/* -------------------------------------------------------------------------- */
+
+ScanAPP::State::State(const Plan &plan) : numBins(0) {
+  for (auto &agg : plan.aggs) {
+    binStart.push_back(numBins);
+    if (agg.op == HIST)
+      numBins += agg.nbins;
+  }
+
+  Acc acc;
+  acc.count = 0;
+  accs.resize(plan.numGroups * plan.aggs.size());
+  for (size_t i = 0; i < accs.size(); ++i) {
+    auto &agg = plan.aggs[i % plan.aggs.size()];
+    if (agg.op != COUNT && isFloat(plan.cols[agg.col])) {
+      acc.sum.f = 0;
+      acc.min.f = INFINITY;
+      acc.max.f = -INFINITY;
+    }
+    else {
+      acc.sum.i = 0;
+      acc.min.i = INT64_MAX;
+      acc.max.i = INT64_MIN;
+    }
+    accs[i] = acc;
+  }
+  bins.resize(plan.numGroups * numBins, 0);
+}
+
+NO_UINT_SANS
+void ScanAPP::State::merge(const Plan &plan, const State &other) {
+  for (size_t i = 0; i < accs.size(); ++i) {
+    auto &agg = plan.aggs[i % plan.aggs.size()];
+    auto &a = accs[i];
+    auto &b = other.accs[i];
+
+    a.count += b.count;
+    if (agg.op != COUNT && isFloat(plan.cols[agg.col])) {
+      a.sum.f += b.sum.f;
+      a.min.f = std::min(a.min.f, b.min.f);
+      a.max.f = std::max(a.max.f, b.max.f);
+    }
+    else {
+      a.sum.i = (int64_t)((uint64_t)a.sum.i + (uint64_t)b.sum.i);
+      a.min.i = std::min(a.min.i, b.min.i);
+      a.max.i = std::max(a.max.i, b.max.i);
+    }
+  }
+  for (size_t i = 0; i < bins.size(); ++i)
+    bins[i] += other.bins[i];
+}
+
+void ScanAPP::State::output(const Plan &plan, uint8_t *out) const {
+  auto put = [&out](const void *v, size_t sz) {
+    memcpy(out, v, sz);
+    out += sz;
+  };
+
+  for (size_t g = 0; g < plan.numGroups; ++g) {
+    for (size_t a = 0; a < plan.aggs.size(); ++a) {
+      auto &acc = accs[g * plan.aggs.size() + a];
+      switch (plan.aggs[a].op) {
+        case COUNT:
+          put(&acc.count, sizeof(uint64_t));
+          break;
+        case SUM:
+          put(&acc.sum, sizeof(Value));
+          break;
+        case MIN:
+          put(&acc.min, sizeof(Value));
+          break;
+        case MAX:
+          put(&acc.max, sizeof(Value));
+          break;
+        default:
+          put(&bins[g * numBins + binStart[a]],
+              plan.aggs[a].nbins * sizeof(uint64_t));
+          break;
+      }
+    }
+  }
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                   Kernels                                  */
+/* -------------------------------------------------------------------------- */
+
+// rows are kept by bits of 64-bit words, bits of rows out of a batch are 0,
+// and columns may be unaligned when the last group of a file is short
+
+template <typename T>
+static inline T load(const byte *col, size_t row) {
+  T v;
+  memcpy(&v, &col[row * sizeof(T)], sizeof(T));
+  return v;
+}
+
+// the type of sums, mins and maxs of a column type
+template <typename T>
+struct Wide {
+  typedef int64_t W;
+  typedef uint64_t S;  // sums of integers wrap
+  static W &of(Value &v) { return v.i; }
+};
+
+template <>
+struct Wide<float> {
+  typedef double W;
+  typedef double S;
+  static W &of(Value &v) { return v.f; }
+};
+
+template <>
+struct Wide<double> : public Wide<float> {};
+
+// bounds of BETWEEN in the column type, false if no value is in them
+template <typename T>
+static bool bounds(const Value &lo, const Value &hi, T *l, T *h) {
+  if (lo.i > hi.i || lo.i > std::numeric_limits<T>::max() ||
+      hi.i < std::numeric_limits<T>::min())
+    return false;
+  *l = (T)std::max<int64_t>(lo.i, std::numeric_limits<T>::min());
+  *h = (T)std::min<int64_t>(hi.i, std::numeric_limits<T>::max());
+  return true;
+}
+
+template <>
+bool bounds<double>(const Value &lo, const Value &hi, double *l, double *h) {
+  *l = lo.f;
+  *h = hi.f;
+  return *l <= *h;
+}
+
+// the smallest float >= lo and the largest float <= hi
+template <>
+bool bounds<float>(const Value &lo, const Value &hi, float *l, float *h) {
+  auto toFloat = [](double v) {
+    return v > FLT_MAX ? INFINITY : v < -FLT_MAX ? -INFINITY : (float)v;
+  };
+
+  *l = toFloat(lo.f);
+  if (*l < lo.f)
+    *l = std::nextafter(*l, INFINITY);
+  *h = toFloat(hi.f);
+  if (*h > hi.f)
+    *h = std::nextafter(*h, -INFINITY);
+  return *l <= *h;
+}
+
+template <typename T>
+static inline uint64_t inBetween(const byte *col, size_t row, T lo, T hi) {
+  auto v = load<T>(col, row);
+  return (uint64_t)(v >= lo && v <= hi);
+}
+
+template <typename T>
+static void betweenScalar(const byte *col, size_t n, T lo, T hi,
+                          uint64_t *sel) {
+  for (size_t w = 0; w * 64 < n; ++w) {
+    if (!sel[w])
+      continue;
+
+    auto m = std::min<size_t>(64, n - w * 64);
+    uint64_t bits = 0;
+    for (size_t j = 0; j < m; ++j)
+      bits |= inBetween(col, w * 64 + j, lo, hi) << j;
+    sel[w] &= bits;
+  }
+}
+
+#ifdef ISC_SIMD_X86
+// bits of lanes in [lo, hi], NaN is never in them
+template <typename T>
+struct BetweenAVX2;
+
+template <>
+struct BetweenAVX2<int32_t> {
+  static const size_t LANES = 8;
+  __m256i lo, hi;
+
+  SIMD_TARGET("avx2")
+  BetweenAVX2(int32_t l, int32_t h)
+      : lo(_mm256_set1_epi32(l)), hi(_mm256_set1_epi32(h)) {}
+
+  SIMD_TARGET("avx2")
+  uint64_t bits(const byte *p) const {
+    __m256i v = _mm256_loadu_si256((const __m256i *)p);
+    __m256i out =
+        _mm256_or_si256(_mm256_cmpgt_epi32(lo, v), _mm256_cmpgt_epi32(v, hi));
+    return (uint64_t)(~_mm256_movemask_ps(_mm256_castsi256_ps(out)) & 0xFF);
+  }
+};
+
+template <>
+struct BetweenAVX2<int64_t> {
+  static const size_t LANES = 4;
+  __m256i lo, hi;
+
+  SIMD_TARGET("avx2")
+  BetweenAVX2(int64_t l, int64_t h)
+      : lo(_mm256_set1_epi64x(l)), hi(_mm256_set1_epi64x(h)) {}
+
+  SIMD_TARGET("avx2")
+  uint64_t bits(const byte *p) const {
+    __m256i v = _mm256_loadu_si256((const __m256i *)p);
+    __m256i out =
+        _mm256_or_si256(_mm256_cmpgt_epi64(lo, v), _mm256_cmpgt_epi64(v, hi));
+    return (uint64_t)(~_mm256_movemask_pd(_mm256_castsi256_pd(out)) & 0xF);
+  }
+};
+
+template <>
+struct BetweenAVX2<float> {
+  static const size_t LANES = 8;
+  __m256 lo, hi;
+
+  SIMD_TARGET("avx2")
+  BetweenAVX2(float l, float h)
+      : lo(_mm256_set1_ps(l)), hi(_mm256_set1_ps(h)) {}
+
+  SIMD_TARGET("avx2")
+  uint64_t bits(const byte *p) const {
+    __m256 v = _mm256_loadu_ps((const float *)p);
+    __m256 in = _mm256_and_ps(_mm256_cmp_ps(v, lo, _CMP_GE_OQ),
+                              _mm256_cmp_ps(v, hi, _CMP_LE_OQ));
+    return (uint64_t)_mm256_movemask_ps(in);
+  }
+};
+
+template <>
+struct BetweenAVX2<double> {
+  static const size_t LANES = 4;
+  __m256d lo, hi;
+
+  SIMD_TARGET("avx2")
+  BetweenAVX2(double l, double h)
+      : lo(_mm256_set1_pd(l)), hi(_mm256_set1_pd(h)) {}
+
+  SIMD_TARGET("avx2")
+  uint64_t bits(const byte *p) const {
+    __m256d v = _mm256_loadu_pd((const double *)p);
+    __m256d in = _mm256_and_pd(_mm256_cmp_pd(v, lo, _CMP_GE_OQ),
+                               _mm256_cmp_pd(v, hi, _CMP_LE_OQ));
+    return (uint64_t)_mm256_movemask_pd(in);
+  }
+};
+
+template <typename T>
+SIMD_TARGET("avx2")
+static void betweenAVX2(const byte *col, size_t n, T lo, T hi, uint64_t *sel) {
+  const BetweenAVX2<T> k(lo, hi);
+  const size_t lanes = BetweenAVX2<T>::LANES;
+
+  for (size_t w = 0; w * 64 < n; ++w) {
+    if (!sel[w])
+      continue;
+
+    auto base = &col[w * 64 * sizeof(T)];
+    auto m = std::min<size_t>(64, n - w * 64);
+    uint64_t bits = 0;
+    size_t j = 0;
+    for (; j + lanes <= m; j += lanes)
+      bits |= k.bits(&base[j * sizeof(T)]) << j;
+    for (; j < m; ++j)
+      bits |= inBetween(base, j, lo, hi) << j;
+    sel[w] &= bits;
+  }
+}
+#endif
+
+// there are AVX2 and scalar kernels of filters, AVX-512 hosts use AVX2 ones
+template <typename T>
+static void between(const byte *col, size_t n, const Plan::Pred &pred,
+                    uint64_t *sel) {
+  T lo, hi;
+  if (!bounds<T>(pred.lo, pred.hi, &lo, &hi)) {
+    memset(sel, 0, DIV64_CEIL(n, 64) * sizeof(uint64_t));
+    return;
+  }
+
+#ifdef ISC_SIMD_X86
+  if (Utils::SIMD::getISA() >= Utils::SIMD::AVX2) {
+    betweenAVX2<T>(col, n, lo, hi, sel);
+    return;
+  }
+#endif
+  betweenScalar<T>(col, n, lo, hi, sel);
+}
+
+// sum, min and max of kept rows, words of all rows kept go by a loop that
+// compilers vectorize
+template <typename T>
+NO_UINT_SANS static void accumulate(const byte *col, size_t n,
+                                    const uint64_t *sel, State::Acc *acc) {
+  typedef typename Wide<T>::W W;
+  typedef typename Wide<T>::S S;
+
+  S sum = (S)Wide<T>::of(acc->sum);
+  W mn = Wide<T>::of(acc->min), mx = Wide<T>::of(acc->max);
+  uint64_t cnt = 0;
+
+  for (size_t w = 0; w * 64 < n; ++w) {
+    auto base = &col[w * 64 * sizeof(T)];
+    auto bits = sel[w];
+
+    if (bits == UINT64_MAX) {
+      for (size_t j = 0; j < 64; ++j) {
+        auto v = load<T>(base, j);
+        sum += (S)v;
+        mn = std::min(mn, (W)v);
+        mx = std::max(mx, (W)v);
+      }
+      cnt += 64;
+      continue;
+    }
+
+    cnt += (uint64_t)__builtin_popcountll(bits);
+    for (; bits; bits &= bits - 1) {
+      auto v = load<T>(base, (size_t)__builtin_ctzll(bits));
+      sum += (S)v;
+      mn = std::min(mn, (W)v);
+      mx = std::max(mx, (W)v);
+    }
+  }
+
+  acc->count += cnt;
+  Wide<T>::of(acc->sum) = (W)sum;
+  Wide<T>::of(acc->min) = mn;
+  Wide<T>::of(acc->max) = mx;
+}
+
+// bin of a value in [lo, hi), exact for integers; the distances are taken
+// unsigned as a range may span all of int64_t
+template <typename T>
+NO_UINT_SANS static size_t binOf(T v, const Plan::Agg &agg) {
+  auto d = (uint64_t)(int64_t)v - (uint64_t)agg.lo.i;
+  auto r = (uint64_t)agg.hi.i - (uint64_t)agg.lo.i;
+  return (size_t)((unsigned __int128)d * agg.nbins / r);
+}
+
+template <>
+size_t binOf<double>(double v, const Plan::Agg &agg) {
+  auto b = (size_t)((v - agg.lo.f) / (agg.hi.f - agg.lo.f) * agg.nbins);
+  return std::min<size_t>(b, agg.nbins - 1);  // rounded up to hi
+}
+
+template <>
+size_t binOf<float>(float v, const Plan::Agg &agg) {
+  return binOf<double>(v, agg);
+}
+
+template <typename T>
+static bool inHist(T v, const Plan::Agg &agg) {
+  return (int64_t)v >= agg.lo.i && (int64_t)v < agg.hi.i;
+}
+
+template <>
+bool inHist<float>(float v, const Plan::Agg &agg) {
+  return v >= agg.lo.f && v < agg.hi.f;
+}
+
+template <>
+bool inHist<double>(double v, const Plan::Agg &agg) {
+  return v >= agg.lo.f && v < agg.hi.f;
+}
+
+template <typename T>
+static void hist(const byte *col, size_t n, const uint64_t *sel,
+                 const Plan::Agg &agg, uint64_t *bins) {
+  for (size_t w = 0; w * 64 < n; ++w) {
+    for (auto bits = sel[w]; bits; bits &= bits - 1) {
+      auto v = load<T>(col, w * 64 + (size_t)__builtin_ctzll(bits));
+      if (inHist(v, agg))
+        ++bins[binOf(v, agg)];
+    }
+  }
+}
+
+// aggregate a row into the accumulator or the bins of its group
+template <typename T>
+NO_UINT_SANS static void aggregateRow(const byte *col, size_t row,
+                                      const Plan::Agg &agg, State::Acc *acc,
+                                      uint64_t *bins) {
+  typedef typename Wide<T>::W W;
+  typedef typename Wide<T>::S S;
+
+  auto v = load<T>(col, row);
+  if (agg.op == ScanAPP::HIST) {
+    if (inHist(v, agg))
+      ++bins[binOf(v, agg)];
+    return;
+  }
+
+  ++acc->count;
+  Wide<T>::of(acc->sum) = (W)((S)Wide<T>::of(acc->sum) + (S)v);
+  Wide<T>::of(acc->min) = std::min(Wide<T>::of(acc->min), (W)v);
+  Wide<T>::of(acc->max) = std::max(Wide<T>::of(acc->max), (W)v);
+}
+
+template <typename T>
+static void keyOf(const byte *col, size_t row, int64_t *key) {
+  *key = (int64_t)load<T>(col, row);
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                   ScanAPP                                  */
+/* -------------------------------------------------------------------------- */
+
+ISC_STS ScanAPP::scan(const Plan &plan, const byte *data, size_t bytes,
+                      State *st _ADD_SIM_PARAMS) {
+  auto naggs = plan.aggs.size();
+  auto rowsMax = plan.groupRows ? plan.groupRows : bytes / plan.rowBytes;
+  size_t nVector = 0, nWord = 0, nRow = 0;  // simulated costs
+
+  uint64_t sel[BATCH / 64];
+  std::vector<const byte *> cols(plan.cols.size());
+
+  for (size_t ofs = 0; ofs + plan.rowBytes <= bytes;) {
+    auto rows = std::min(rowsMax, (bytes - ofs) / plan.rowBytes);
+    for (size_t c = 0; c < cols.size(); ++c)
+      cols[c] = &data[ofs + rows * plan.offsets[c]];
+    ofs += rows * plan.rowBytes;
+
+    for (size_t first = 0; first < rows; first += BATCH) {
+      auto n = std::min(BATCH, rows - first);
+      auto words = DIV64_CEIL(n, 64);
+      for (size_t w = 0; w < words; ++w)
+        sel[w] = UINT64_MAX;
+      if (n % 64)
+        sel[words - 1] = (1ULL << (n % 64)) - 1;
+
+      auto at = [&](uint8_t c) {
+        return cols[c] + first * typeWidth[plan.cols[c]];
+      };
+      auto vectors = [&](uint8_t c) {
+        return DIV64_CEIL(n, SCAN_SIM_LANES(typeWidth[plan.cols[c]]));
+      };
+
+      // WHERE
+      for (auto &pred : plan.preds) {
+        SCAN_DISPATCH(plan.cols[pred.col], between, at(pred.col), n, pred,
+                      sel);
+        nVector += vectors(pred.col);
+      }
+
+      // BY, rows go one by one to the accumulators of their groups
+      if (plan.by) {
+        for (size_t w = 0; w < words; ++w) {
+          for (auto bits = sel[w]; bits; bits &= bits - 1) {
+            auto row = w * 64 + (size_t)__builtin_ctzll(bits);
+            int64_t key;
+            SCAN_DISPATCH(plan.cols[plan.byCol], keyOf, at(plan.byCol), row,
+                          &key);
+
+            auto g = (uint64_t)key - (uint64_t)plan.byLo;
+            if (g >= plan.numGroups)
+              continue;
+            for (size_t a = 0; a < naggs; ++a) {
+              auto &agg = plan.aggs[a];
+              auto acc = &st->accs[g * naggs + a];
+              if (agg.op == COUNT)
+                ++acc->count;
+              else
+                SCAN_DISPATCH(plan.cols[agg.col], aggregateRow, at(agg.col),
+                              row, agg, acc,
+                              &st->bins[g * st->numBins + st->binStart[a]]);
+            }
+            nRow += naggs;
+          }
+        }
+        nWord += words;
+        continue;
+      }
+
+      for (size_t a = 0; a < naggs; ++a) {
+        auto &agg = plan.aggs[a];
+        auto acc = &st->accs[a];
+
+        if (agg.op == COUNT) {
+          for (size_t w = 0; w < words; ++w)
+            acc->count += (uint64_t)__builtin_popcountll(sel[w]);
+          nWord += words;
+        }
+        else if (agg.op == HIST) {
+          SCAN_DISPATCH(plan.cols[agg.col], hist, at(agg.col), n,
+                        sel, agg, &st->bins[st->binStart[a]]);
+          for (size_t w = 0; w < words; ++w)
+            nRow += (size_t)__builtin_popcountll(sel[w]);
+        }
+        else {
+          SCAN_DISPATCH(plan.cols[agg.col], accumulate, at(agg.col), n, sel,
+                        acc);
+          nVector += vectors(agg.col);
+        }
+      }
+    }
+  }
+
+  simApplyManyLatency(CPU::ISC__SLET__SCAN, SCAN_VTASK, nVector);
+  simApplyManyLatency(CPU::ISC__SLET__SCAN, SCAN_TASK_WORD, nWord);
+  simApplyManyLatency(CPU::ISC__SLET__SCAN, SCAN_TASK_ROW, nRow);
+  return ISC_STS_OK;
+}
+
+ISC_STS ScanAPP::builtin_startup(_SIM_PARAMS) {
+  auto doit = [this](_SIM_PARAMS) -> ISC_STS {
+    auto sts = ISC_STS_OK;
+
+    // the plan is parsed within the bytes the host sent, a truncated plan
+    // must not be read past its buffer
+    Plan plan;
+    auto bufPlan = this->getOpt<const uint8_t>(keyPlan);
+    auto lenPlan = std::min(this->getOptLen(keyPlan), MAX_PLAN);
+    if (!bufPlan || plan.parse(bufPlan, lenPlan) != ISC_STS_OK)
+      return ISC_STS_EARGS;
+    pr("Plan: %lu cols, %lu preds, %lu aggs, %u groups", plan.cols.size(),
+       plan.preds.size(), plan.aggs.size(), plan.numGroups);
+
+    Utils::Codec::Type codec;
+    if ((sts = this->getCodec(&codec)) != ISC_STS_OK)
+      return sts;
+
+    std::vector<GenericFSA::ExtList> files;
+    if ((sts = this->resolveFiles(files, false _add_sim_params)) != ISC_STS_OK)
+      return sts;
+
+    auto szOut = plan.resultSize();
+    auto bufOut = (uint8_t *)calloc(szOut + 1, sizeof(uint8_t));
+    if (!bufOut) {
+      freeFiles(files);
+      return ISC_STS_FAIL;
+    }
+
+    // files are scanned by tasks on the ISC cores, chunk by chunk, and chunks
+    // are made of whole row groups; a core keeps one partial state for all
+    // files it scans
+    auto numCores =
+        std::max<size_t>(1, std::min(SIM::numCores(), files.size()));
+    std::vector<State> states(numCores, State(plan));
+    sts = Runtime::runTasks(
+        files.size(),
+        [&](size_t i _ADD_SIM_PARAMS) {
+          auto szChunk = Stream::CHUNK_SIZE;
+          if (plan.groupRows) {
+            auto szGroup = plan.groupRows * plan.rowBytes;
+            szChunk = std::max<size_t>(1, szChunk / szGroup) * szGroup;
+          }
+
+          Stream stream(files[i], szChunk, 2, codec);
+          const byte *chunk;
+          auto sts = ISC_STS_OK;
+          for (size_t len; sts == ISC_STS_OK &&
+                           (len = stream.next(&chunk _add_sim_params));)
+            sts = scan(plan, chunk, len, &states[Runtime::taskCore()]
+                       _add_sim_params);
+          return sts == ISC_STS_OK ? stream.getStatus() : sts;
+        } _add_sim_params);
+
+    // sums of floats depend on which files a core got
+    if (sts == ISC_STS_OK) {
+      State total(plan);
+      for (auto &st : states)
+        total.merge(plan, st);
+      total.output(plan, bufOut);
+    }
+    freeFiles(files);
+
+    if (sts != ISC_STS_OK) {
+      free(bufOut);
+      return sts;
+    }
+    return this->publishResult(bufOut, szOut);
+  };
+
+  auto res = doit(_sim_params);
+  simApplyLatency(CPU::ISC__SLET__SCAN, CPU::ISC__START_SLET);
+  return res;
+}
+
+}  // namespace ISC
+}  // namespace SimpleSSD
@@ -0,0 +1,140 @@
+#ifndef __SIMPLESSD_ISC_SLET_SCAN_HH__
+#define __SIMPLESSD_ISC_SLET_SCAN_HH__
+
+#include <vector>
+
+#include "sims/cpu.hh"
+
+#include "types.hh"
+
+namespace SimpleSSD {
+namespace ISC {
+
+/**
+ * @brief Filter and aggregate fixed-width columns by a plan given by the host
+ *
+ * A file is a table of rows in groups of Plan::groupRows rows, and a group
+ * keeps its columns one after another (the last group may be short). A file
+ * of one column is just an array of it, e.g., the files of Stats32APP. All
+ * files under the given path are of the same columns, and only the
+ * aggregates of them all are returned.
+ *
+ * The plan is a string of ops, each is a one-byte Op and its operands in
+ * little-endian, and it ends by Op::END:
+ *
+ *   COL type:u8              declare the next column
+ *   ROWS rows:u32            rows of a group, for tables of many columns
+ *   BETWEEN col:u8 lo hi     keep rows of lo <= col <= hi (WHERE, ANDed)
+ *   BY col:u8 lo:i64 n:u32   aggregate by groups of integer keys [lo, lo+n),
+ *                            other rows are skipped
+ *   SUM|MIN|MAX col:u8       aggregates of the kept rows
+ *   COUNT                    number of the kept rows
+ *   HIST col:u8 lo hi n:u16  counts of n equal-width bins of [lo, hi), values
+ *                            out of it are not counted
+ *
+ * lo and hi are 8 bytes, an i64 for integer columns or an f64 for floating
+ * ones. The result has, for each group of BY (or the only one), the values of
+ * the aggregates in the order of the plan: 8 bytes for each of SUM, MIN and
+ * MAX (i64 or f64 by the column), a u64 for COUNT, and n u64 for HIST. SUM of
+ * integers wraps, MIN and MAX of no rows are the max and min of i64 (or inf
+ * and -inf). Plans of a result over 64MB are rejected.
+ */
+class ScanAPP : public GenericAPP {
+ public:
+  ScanAPP(_SIM_PARAMS);
+  ~ScanAPP() {}
+
+  enum Type : uint8_t { I32, I64, F32, F64, NUM_TYPES };
+
+  enum Op : uint8_t {
+    END = 0x00,
+    COL = 0x01,
+    ROWS = 0x02,
+    BETWEEN = 0x10,
+    BY = 0x20,
+    SUM = 0x30,
+    COUNT = 0x31,
+    MIN = 0x32,
+    MAX = 0x33,
+    HIST = 0x34,
+  };
+
+  union Value {
+    int64_t i;
+    double f;
+  };
+
+  struct Plan {
+    struct Pred {
+      uint8_t col;
+      Value lo, hi;
+    };
+
+    struct Agg {
+      Op op;
+      uint8_t col;
+      Value lo, hi;    // HIST only
+      uint16_t nbins;  // HIST only
+    };
+
+    std::vector<Type> cols;
+    std::vector<size_t> offsets;  // of columns in a row group, per row
+    size_t rowBytes;
+    uint32_t groupRows;
+
+    std::vector<Pred> preds;
+    std::vector<Agg> aggs;
+
+    bool by;
+    uint8_t byCol;
+    int64_t byLo;
+    uint32_t numGroups;  // of BY, or 1
+
+    /**
+     * @brief Decode a plan and check it against itself
+     *
+     * @return ISC_STS ISC_STS_EARGS if the plan is malformed
+     */
+    ISC_STS parse(const uint8_t *, size_t);
+
+    // bytes of the result
+    size_t resultSize() const;
+  };
+
+  /**
+   * @brief Partial aggregates of some rows, merged into the result at last
+   */
+  struct State {
+    struct Acc {
+      uint64_t count;
+      Value sum, min, max;
+    };
+
+    std::vector<Acc> accs;         // [group][agg]
+    std::vector<uint64_t> bins;    // [group][bin of all HISTs]
+    std::vector<size_t> binStart;  // of each agg in the bins of a group
+    size_t numBins;                // of a group
+
+    State(const Plan &);
+    void merge(const Plan &, const State &);
+    void output(const Plan &, uint8_t *) const;
+  };
+
+  /**
+   * @brief Scan whole row groups of a table in a buffer into the state
+   */
+  ISC_STS scan(const Plan &, const byte *, size_t, State *_ADD_SIM_PARAMS);
+
+  ISC_STS builtin_startup(_SIM_PARAMS) override;
+
+  static const SletKey keyPlan;
+
+  static const size_t BLK_SIZE = 4096;
+  static const size_t MAX_PLAN = 4096;  // bytes of a plan, END included
+  static const size_t BATCH = 1024;     // rows filtered and aggregated at once
+};
+
+}  // namespace ISC
+}  // namespace SimpleSSD
+
+#endif /* __SIMPLESSD_ISC_SLET_SCAN_HH__ */
@@ -13,16 +13,13 @@ namespace ISC {
 using namespace SIM;
 using SIM::FTL;
 
-const char *SeqReadAPP::keyPath = "path";
-const char *SeqReadAPP::keyResult = "result";
-
 SeqReadAPP::SeqReadAPP(_SIM_PARAMS) {
-  this->setOpt("name", strdup("SeqReadAPP"));
+  this->setOpt(keyName, strdup("SeqReadAPP"));
 }
 
 ISC_STS SeqReadAPP::builtin_startup(_SIM_PARAMS) {
   // get required args
-  auto path = (const char *)this->getOpt(SeqReadAPP::keyPath);
+  auto path = this->getOpt<const char>(GenericAPP::keyPath);
   pr("target file '%s'", path);
   if (!path) {
     pr("target path not set!");
@@ -52,7 +49,7 @@ ISC_STS SeqReadAPP::builtin_startup(_SIM_PARAMS) {
     ofs += SZ_BLK * extlist.exts[i].len;
   }
 
-  this->setOpt(SeqReadAPP::keyResult, buffer);
+  this->setOpt(GenericAPP::keyResult, buffer);
 
   free(extlist.exts);
   return ISC_STS_OK;
@@ -14,9 +14,6 @@ class SeqReadAPP : public GenericAPP {
   ~SeqReadAPP() {}
 
   ISC_STS builtin_startup(_SIM_PARAMS) override;
-
-  static const char* keyPath;
-  static const char* keyResult;
 };
 
 }  // namespace ISC
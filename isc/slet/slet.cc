@@ -2,17 +2,93 @@
 
 #include <cstring>  // for strcmp
 
+#include <algorithm>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "sims/configs.hh"
 #include "sims/dram.hh"
+#include "sims/ftl.hh"
+
+#include "runtime.hh"
 #include "types.hh"
+#include "utils/math.hh"
 
 using namespace SimpleSSD::ISC::SIM;
 #define DRAM SIM::DRAM  // shadow SimpleSSD::DRAM
 
+namespace Codec = SimpleSSD::Utils::Codec;
+
 #define PR_SECTION LOG_ISC_SLET
 
 namespace SimpleSSD {
 namespace ISC {
 
+/* -------------------------------------------------------------------------- */
+/*                                  SletKey                                   */
+/* -------------------------------------------------------------------------- */
+
+namespace {
+
+// names are kept for the lifetime of the process, ids index them
+struct KeyTable {
+  struct Hash {
+    size_t operator()(const char *s) const {
+      size_t h = 14695981039346656037ull;  // FNV-1a
+      for (; *s; ++s)
+        h = (h ^ (uint8_t)*s) * 1099511628211ull;
+      return h;
+    }
+  };
+  struct Equal {
+    bool operator()(const char *a, const char *b) const {
+      return !strcmp(a, b);
+    }
+  };
+
+  std::mutex lock;
+  std::deque<std::string> names;
+  std::unordered_map<const char *, size_t, Hash, Equal> ids;
+
+  size_t intern(const char *name, const char **stored) {
+    std::lock_guard<std::mutex> guard(lock);
+    auto it = ids.find(name);
+    if (it == ids.end()) {
+      names.emplace_back(name);
+      it = ids.insert({names.back().c_str(), names.size() - 1}).first;
+    }
+    *stored = it->first;
+    return it->second;
+  }
+
+  KeyTable() {
+    const char *stored;
+    intern("name", &stored);  // SletKey::NAME
+    intern("cwd", &stored);   // SletKey::CWD
+  }
+};
+
+KeyTable &keyTable() {
+  static KeyTable table;
+  return table;
+}
+
+}  // namespace
+
+size_t SletKey::intern(const char *name, const char **stored) {
+  return keyTable().intern(name, stored);
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                 GenericSlet                                */
+/* -------------------------------------------------------------------------- */
+
+const SletKey GenericSlet::keyName = "name";
+const SletKey GenericSlet::keyCwd = "cwd";
+const SletKey GenericSlet::keyAsync = ISC_KEY_ASYNC;
+
 GenericSlet::~GenericSlet() {
   // free options
   if (this->opt.name)
@@ -22,53 +98,56 @@ GenericSlet::~GenericSlet() {
   if (!this->opt.extents.empty())
     this->opt.extents.clear();
 
-  if (!this->opt.extra.empty()) {
-    for (auto &entry : this->opt.extra) {
-      free((char *)entry.first);
-      free(entry.second);
-    }
-    this->opt.extra.clear();
+  for (auto &slot : this->opt.extra) {
+    if (!slot.inl)
+      free(slot.ptr);
   }
+  this->opt.extra.clear();
 }
 
-ISC_STS GenericSlet::setOpt(const char *key, void *data) {
-  pr("Set option '%s'=(%p)'%s'", key, data, (char *)data);
+SletOpts::Slot &GenericSlet::getSlot(const SletKey &key) {
+  if (this->opt.extra.size() <= key.id)
+    this->opt.extra.resize(key.id + 1, SletOpts::Slot{nullptr, 0, 0, false});
+  return this->opt.extra[key.id];
+}
 
-  if (!strcmp(key, "name")) {
+ISC_STS GenericSlet::setOpt(const SletKey &key, void *data, size_t len) {
+  pr("Set option '%s'=(%p)'%s'", key.name, data, (char *)data);
+
+  if (key.id == SletKey::NAME) {
     if (this->opt.name)
       free(this->opt.name);
     this->opt.name = (char *)data;
   }
-  else if (!strcmp(key, "cwd")) {
+  else if (key.id == SletKey::CWD) {
     if (this->opt.cwd)
       free(this->opt.cwd);
     this->opt.cwd = (char *)data;
   }
   else {
-    auto it = this->opt.extra.find(key);
-    if (it != this->opt.extra.end()) {
-      free((char *)it->first);
-      free(it->second);
-      this->opt.extra.erase(it);
-    }
-    this->opt.extra.insert({strdup(key), data});
+    auto &slot = getSlot(key);
+    if (!slot.inl)
+      free(slot.ptr);
+    slot.ptr = data;
+    slot.len = len;
+    slot.inl = false;
   }
 
   return ISC_STS_OK;
 }
 
-void *GenericSlet::getOpt(const char *key) {
-  pr("Get option '%s'", key);
+void *GenericSlet::getOpt(const SletKey &key) {
+  pr("Get option '%s'", key.name);
 
   void *val = nullptr;
-  if (!strcmp(key, "name"))
+  if (key.id == SletKey::NAME)
     val = this->opt.name;
-  else if (!strcmp(key, "cwd"))
+  else if (key.id == SletKey::CWD)
     val = this->opt.cwd;
-
-  auto it = this->opt.extra.find(key);
-  if (it != this->opt.extra.end())
-    val = it->second;
+  else if (key.id < this->opt.extra.size()) {
+    auto &slot = this->opt.extra[key.id];
+    val = slot.inl ? &slot.val : slot.ptr;
+  }
 
   if (!val)
     pr("but option not found...");
@@ -77,5 +156,522 @@ void *GenericSlet::getOpt(const char *key) {
   return val;
 }
 
+size_t GenericSlet::getOptLen(const SletKey &key) {
+  if (key.id >= this->opt.extra.size())
+    return 0;
+  return this->opt.extra[key.id].len;
+}
+
+/* -------------------------------------------------------------------------- */
+/*                             GenericFSA::DirIter                            */
+/* -------------------------------------------------------------------------- */
+
+GenericFSA::DirIter::DirIter(uint64_t i, size_t sz)
+    : ino(i),
+      region(DRAM::alloc(1, sz)),
+      data(region->getAddr()),
+      size(sz),
+      ofs(0) {}
+
+GenericFSA::DirIter::~DirIter() { DRAM::dealloc(region); }
+
+/* -------------------------------------------------------------------------- */
+/*                                 GenericAPP                                 */
+/* -------------------------------------------------------------------------- */
+
+const SletKey GenericAPP::keyResult = ISC_KEY_RESULT;
+const SletKey GenericAPP::keyResultSize = ISC_KEY_RESULT_SIZE;
+const SletKey GenericAPP::keyResultRing = ISC_KEY_RESULT_RING;
+const SletKey GenericAPP::keyCodec = ISC_KEY_CODEC;
+const SletKey GenericAPP::keyPath = "path";
+const SletKey GenericAPP::keyNumFiles = "numfiles";
+const SletKey GenericAPP::keyFileSizes = "filesizes";
+const SletKey GenericAPP::keyExts = "exts";
+
+GenericAPP::~GenericAPP() { delete ring; }
+
+ISC_STS GenericAPP::getCodec(Codec::Type *codec) {
+  auto name = this->getOpt<const char>(keyCodec);
+  *codec = name ? Codec::fromName(name) : Codec::RAW;
+  if (*codec == Codec::CODEC_COUNT) {
+    pr("Unknown codec %s", name);
+    return ISC_STS_EARGS;
+  }
+  return ISC_STS_OK;
+}
+
+ISC_STS GenericAPP::produce(size_t n,
+                            const Producer &producer _ADD_SIM_PARAMS) {
+  delete ring;
+  ring = nullptr;
+
+  auto szRing = this->getVal<size_t>(keyResultRing, 0);
+  if (szRing) {
+    pr("Produce %lu items into a ring of %lu bytes", n, szRing);
+    ring = new ResultRing(szRing, n, producer);
+    return ring->pump(_sim_params);
+  }
+
+  std::vector<std::string> outs(n);
+  auto sts = Runtime::runTasks(
+      n,
+      [&](size_t i _ADD_SIM_PARAMS) {
+        return producer(i, &outs[i] _add_sim_params);
+      } _add_sim_params);
+  if (sts != ISC_STS_OK)
+    return sts;
+
+  size_t sz = 0;
+  for (auto &out : outs)
+    sz += out.size();
+
+  auto res = (char *)malloc(std::max(sz, (size_t)1));
+  if (!res)
+    return ISC_STS_FAIL;
+  sz = 0;
+  for (auto &out : outs) {
+    memcpy(&res[sz], out.data(), out.size());
+    sz += out.size();
+  }
+
+  return publishResult(res, sz);
+}
+
+ISC_STS GenericAPP::publishResult(void *buf, size_t sz) {
+  auto szRes = (size_t *)malloc(sizeof(size_t));
+  if (!szRes) {
+    free(buf);
+    return ISC_STS_FAIL;
+  }
+  *szRes = sz;
+
+  auto sts = this->setOpt(keyResultSize, szRes);
+  if (sts == ISC_STS_OK)
+    sts = this->setOpt(keyResult, buf);
+  else
+    free(buf);
+  return sts;
+}
+
+size_t GenericAPP::getResult(uint64_t ofs, void *buf,
+                             size_t len _ADD_SIM_PARAMS) {
+  if (ring)
+    return ring->pull(ofs, buf, len _add_sim_params);
+
+  auto res = this->getOpt<const char>(keyResult);
+  auto szRes = this->getOpt<size_t>(keyResultSize);
+  if (!res || !szRes || ofs >= *szRes)
+    return 0;
+
+  len = std::min(len, *szRes - ofs);
+  memcpy(buf, &res[ofs], len);
+  return len;
+}
+
+size_t GenericAPP::getResultSize(bool *done) {
+  if (ring) {
+    *done = ring->isDone();
+    return ring->getTail();
+  }
+
+  auto szRes = this->getOpt<size_t>(keyResultSize);
+  *done = true;
+  return szRes ? *szRes : 0;
+}
+
+std::vector<GenericFSA::ExtList> GenericAPP::splitExts(GenericFSA::Ext *exts,
+                                                       size_t numFiles,
+                                                       const size_t *sizes) {
+  std::vector<GenericFSA::ExtList> files(numFiles);
+
+  for (size_t i = 0, ie = 0; i < numFiles; ++i, ++ie) {
+    files[i].bytes = sizes[i];
+
+    // exts is separated by 'block == UINT64_MAX'
+    files[i].exts = &exts[ie];
+    for (; exts[ie].block != UINT64_MAX; ++ie)
+      files[i].len++;
+  }
+  return files;
+}
+
+ISC_STS GenericAPP::resolveFiles(std::vector<GenericFSA::ExtList> &files,
+                                 bool regOnly _ADD_SIM_PARAMS) {
+  auto exts = this->getOpt<GenericFSA::Ext>(keyExts);
+  auto numFiles = this->getOpt<size_t>(keyNumFiles);
+  auto fileSizes = this->getOpt<size_t>(keyFileSizes);
+  auto path = this->getOpt<const char>(keyPath);
+
+  files.clear();
+
+  // extents given by the host stay in the option, copy them so the caller
+  // owns all lists alike
+  if (exts && numFiles && fileSizes) {
+    for (auto &file : splitExts(exts, *numFiles, fileSizes)) {
+      auto copy = (GenericFSA::Ext *)malloc(
+          std::max(file.len, (size_t)1) * sizeof(GenericFSA::Ext));
+      if (!copy) {
+        freeFiles(files);
+        return ISC_STS_FAIL;
+      }
+      memcpy(copy, file.exts, file.len * sizeof(GenericFSA::Ext));
+      file.exts = copy;
+      files.push_back(file);
+    }
+    pr("Num files: %lu (no FSA)", files.size());
+    return ISC_STS_OK;
+  }
+
+  if (!path || !*path) {
+    pr("Neither path nor extents are given");
+    return ISC_STS_EARGS;
+  }
+
+  // a dir is resolved by one pass over its entries
+  auto isdir = path[strlen(path) - 1] == '/';
+  if (isdir)
+    files = Runtime::getExtsForDir(path, regOnly _add_sim_params);
+  else
+    files.push_back(Runtime::getExts(path _add_sim_params));
+  pr("Num files: %lu %s", files.size(), isdir ? "(dir)" : "");
+  return ISC_STS_OK;
+}
+
+void GenericAPP::freeFiles(std::vector<GenericFSA::ExtList> &files) {
+  for (auto &file : files)
+    free(file.exts);
+  files.clear();
+}
+
+/* -------------------------------------------------------------------------- */
+/*                              GenericAPP::Stream                            */
+/* -------------------------------------------------------------------------- */
+
+// output bytes of a step of decoding on the simulated core
+#define STREAM_SIM_DECODE_BYTES 64
+
+GenericAPP::Stream::Stream(const GenericFSA::ExtList &f, size_t sz, size_t n,
+                           Codec::Type c)
+    : file(f),
+      szChunk(DIV64_CEIL(std::max(sz, (size_t)BLK_SIZE), BLK_SIZE) * BLK_SIZE),
+      nbuf(std::max(n, (size_t)1)),
+      // one more buffer for the decoded data
+      region(DRAM::alloc(nbuf + (c != Codec::RAW), szChunk)),
+      chunks(nbuf, Chunk{nullptr, 0, 0, 0, this}),
+      iExt(0),
+      ofsExt(0),
+      szIssued(0),
+      iHead(0),
+      started(false),
+      codec(c),
+      decoder(Codec::Decoder::create(c)),
+      in(nullptr),
+      inLen(0),
+      eof(false),
+      sts(ISC_STS_OK) {
+  pr("Stream %lu bytes by %lu x %lu bytes chunks (%s)", file.bytes, nbuf,
+     szChunk, Codec::name(codec));
+}
+
+GenericAPP::Stream::~Stream() {
+  delete decoder;
+  DRAM::dealloc(region);
+}
+
+// issue reads of the next chunk into the given buffer
+void GenericAPP::Stream::fill(size_t iBuf _ADD_SIM_PARAMS) {
+  auto &chunk = chunks[iBuf];
+  auto buf = (byte *)region->getAddr() + iBuf * szChunk;
+
+  chunk.len = std::min(szChunk, file.bytes - szIssued);
+  chunk.data = buf;
+  chunk.readyAt = 0;
+  chunk.pending = 0;
+  if (!chunk.len)
+    return;
+
+  // split the chunk by extents
+  size_t ofsBuf = 0;
+  reqs.clear();
+  while (ofsBuf < chunk.len && iExt < file.len) {
+    auto &ext = file.exts[iExt];
+    auto sz = std::min(ext.len * BLK_SIZE - ofsExt, chunk.len - ofsBuf);
+
+    SIM::FTL::BatchRead req;
+    req.buffer = buf + ofsBuf;
+    req.offset = ext.slbn * BLK_SIZE + ofsExt;
+    req.size = sz;
+    reqs.push_back(req);
+
+    ofsBuf += sz;
+    ofsExt += sz;
+    if (ofsExt == ext.len * BLK_SIZE) {
+      ofsExt = 0;
+      ++iExt;
+    }
+  }
+
+  // no more extents (sparse tail), stop here
+  chunk.len = ofsBuf;
+  if (!chunk.len)
+    return;
+
+  // zero-copy if the chunk is contiguous in the mapped image
+  bool zeroCopy = reqs.size() == 1 && SIM::FTL::getBackend() == SIM::FTL::MMAP;
+  if (zeroCopy)
+    reqs[0].buffer = nullptr;
+
+#ifndef ISC_TEST
+  if (async) {
+    // the chunk is ready once all reads of it call back
+    chunk.pending = reqs.size();
+    SIM::FTL::submitBatch(reqs.data(), reqs.size(), chunkDone,
+                          &chunk _add_sim_params);
+  }
+  else
+    chunk.readyAt =
+        SIM::FTL::readBatch(reqs.data(), reqs.size() _add_sim_params);
+#else
+  chunk.readyAt = SIM::FTL::readBatch(reqs.data(), reqs.size() _add_sim_params);
+#endif
+  szIssued += chunk.len;
+
+  if (zeroCopy && reqs[0].buffer)
+    chunk.data = (const byte *)reqs[0].buffer;
+  else if (zeroCopy)
+    SIM::FTL::read(buf, reqs[0].offset, reqs[0].size);  // not mapped, copy it
+}
+
+size_t GenericAPP::Stream::next(const byte **data _ADD_SIM_PARAMS) {
+  if (codec == Codec::RAW || sts != ISC_STS_OK)
+    return sts == ISC_STS_OK ? read(data _add_sim_params) : 0;
+
+  // probe the codec by the first chunk, and pass raw files through
+  if (codec == Codec::AUTO) {
+    inLen = read(&in _add_sim_params);
+    codec = Codec::probe(in, inLen);
+    pr("Probe codec of the stream: %s", Codec::name(codec));
+    if (codec == Codec::RAW) {
+      *data = in;
+      return inLen;
+    }
+    decoder = Codec::Decoder::create(codec);
+  }
+  return decode(data _add_sim_params);
+}
+
+// decode the chunks read until the output buffer is full or no more input
+size_t GenericAPP::Stream::decode(const byte **data _ADD_SIM_PARAMS) {
+  auto buf = (byte *)region->getAddr() + nbuf * szChunk;
+  auto out = buf;
+  size_t outLen = szChunk;
+
+  while (outLen) {
+    if (!inLen && !eof)
+      eof = !(inLen = read(&in _add_sim_params));
+
+    auto szIn = inLen, szOut = outLen;
+    if (!decoder->decode(&in, &inLen, &out, &outLen)) {
+      pr("Failed to decode %s: %s", Codec::name(codec), decoder->error());
+      sts = ISC_STS_FAIL;
+      return 0;
+    }
+
+    // no progress, only when the input is drained
+    if (szIn == inLen && szOut == outLen) {
+      if (!eof) {
+        pr("Decoder of %s is stuck", Codec::name(codec));
+        sts = ISC_STS_FAIL;
+        return 0;
+      }
+      if (!decoder->atFrameEnd()) {
+        pr("Truncated %s frame", Codec::name(codec));
+        sts = ISC_STS_FAIL;
+        return 0;
+      }
+      break;
+    }
+  }
+
+  auto len = szChunk - outLen;
+  simApplyManyLatency(
+      CPU::ISC__SLET,
+      codec == Codec::LZ4 ? CPU::ISC__DECODE_LZ4 : CPU::ISC__DECODE_ZSTD,
+      DIV64_CEIL(len, STREAM_SIM_DECODE_BYTES));
+  *data = buf;
+  return len;
+}
+
+// the next chunk of the file as it is
+size_t GenericAPP::Stream::read(const byte **data _ADD_SIM_PARAMS) {
+  if (!started) {
+    for (size_t i = 0; i < nbuf; ++i)
+      fill(i _add_sim_params);
+    started = true;
+  }
+  else {
+    // the previous chunk is consumed, reuse its buffer for reading ahead
+    fill((iHead + nbuf - 1) % nbuf _add_sim_params);
+  }
+
+  auto &chunk = chunks[iHead];
+  if (!chunk.len)
+    return 0;
+
+#ifndef ISC_TEST
+  // wait for the data
+  simTick = std::max(simTick, chunk.readyAt);
+#endif
+
+  iHead = (iHead + 1) % nbuf;
+  *data = chunk.data;
+  return chunk.len;
+}
+
+#ifndef ISC_TEST
+bool GenericAPP::Stream::nextAsync(const byte **data, size_t *len,
+                                   ChunkFunc func, void *arg _ADD_SIM_PARAMS) {
+  if (codec != Codec::RAW) {
+    pr("Stream of %s can't be read by events", Codec::name(codec));
+    sts = ISC_STS_EFUNC;
+  }
+  if (sts != ISC_STS_OK) {
+    *len = 0;
+    return true;
+  }
+
+  if (!started) {
+    async = true;
+    for (size_t i = 0; i < nbuf; ++i)
+      fill(i _add_sim_params);
+    started = true;
+  }
+  else {
+    // the previous chunk is consumed, reuse its buffer for reading ahead
+    fill((iHead + nbuf - 1) % nbuf _add_sim_params);
+  }
+
+  auto &chunk = chunks[iHead];
+  if (chunk.pending) {
+    // chunkDone() gives it once the last read calls back
+    waitFunc = func;
+    waitData = arg;
+    waitAt = simTick;
+    return false;
+  }
+
+  *len = chunk.len;
+  if (!chunk.len)
+    return true;
+
+  simTick = std::max(simTick, chunk.readyAt);
+  iHead = (iHead + 1) % nbuf;
+  *data = chunk.data;
+  return true;
+}
+
+// a read of the chunk calls back from the event of the FTL
+void GenericAPP::Stream::chunkDone(uint64_t tick, void *data) {
+  auto &chunk = *(Chunk *)data;
+  auto stream = chunk.stream;
+
+  chunk.readyAt = std::max(chunk.readyAt, tick);
+  if (--chunk.pending || !stream->waitFunc ||
+      &chunk != &stream->chunks[stream->iHead])
+    return;
+
+  // the caller may delete the stream in the function, don't touch it after
+  auto func = stream->waitFunc;
+  stream->waitFunc = nullptr;
+  stream->iHead = (stream->iHead + 1) % stream->nbuf;
+  func(stream->waitData, chunk.data, chunk.len,
+       std::max(stream->waitAt, chunk.readyAt));
+}
+#endif
+
+/* -------------------------------------------------------------------------- */
+/*                            GenericAPP::ResultRing                          */
+/* -------------------------------------------------------------------------- */
+
+GenericAPP::ResultRing::ResultRing(size_t sz, size_t n, const Producer &p)
+    : region(DRAM::alloc(1, sz)),
+      capacity(sz),
+      head(0),
+      tail(0),
+      producer(p),
+      num(n),
+      next(0),
+      sts(ISC_STS_OK) {}
+
+GenericAPP::ResultRing::~ResultRing() { DRAM::dealloc(region); }
+
+// the caller makes sure there is room for them
+void GenericAPP::ResultRing::append(const char *src,
+                                    size_t len _ADD_SIM_PARAMS) {
+  while (len) {
+    auto ofs = tail % capacity;
+    auto sz = std::min(len, capacity - ofs);
+    region->write(ofs, sz, (void *)src _add_sim_params);
+    src += sz;
+    len -= sz;
+    tail += sz;
+  }
+}
+
+ISC_STS GenericAPP::ResultRing::pump(_SIM_PARAMS) {
+  for (;;) {
+    // bytes left by the last batch go first
+    auto sz = std::min(spill.size(), (size_t)(capacity - (tail - head)));
+    append(spill.data(), sz _add_sim_params);
+    spill.erase(0, sz);
+    if (!spill.empty() || tail - head == capacity)
+      break;  // full, wait for the host
+    if (next == num || sts != ISC_STS_OK)
+      break;
+
+    // a batch of items, one per ISC core
+    auto first = next;
+    std::vector<std::string> outs(std::min(num - next, SIM::numCores()));
+    sts = Runtime::runTasks(
+        outs.size(),
+        [&](size_t i _ADD_SIM_PARAMS) {
+          return producer(first + i, &outs[i] _add_sim_params);
+        } _add_sim_params);
+    next += outs.size();
+    if (sts != ISC_STS_OK) {
+      pr("Item [%lu, %lu) failed: %d", first, next, sts);
+      break;  // the result ends before the failed batch
+    }
+    for (auto &out : outs)
+      spill += out;
+
+    if (next == num)
+      producer = nullptr;  // release what it holds
+  }
+  if (sts != ISC_STS_OK)
+    producer = nullptr;
+  return sts;
+}
+
+size_t GenericAPP::ResultRing::pull(uint64_t ofs, void *buf,
+                                    size_t len _ADD_SIM_PARAMS) {
+  if (ofs < head || ofs > tail) {
+    pr("Offset %lu out of the ring [%lu, %lu]", ofs, head, tail);
+    return 0;
+  }
+
+  head = ofs;
+  pump(_sim_params);
+
+  len = std::min(len, (size_t)(tail - ofs));
+  for (size_t done = 0; done < len;) {
+    auto pos = (ofs + done) % capacity;
+    auto sz = std::min(len - done, capacity - pos);
+    region->read(pos, sz, (char *)buf + done _add_sim_params);
+    done += sz;
+  }
+  return len;
+}
+
 }  // namespace ISC
-}  // namespace SimpleSSD
\ No newline at end of file
+}  // namespace SimpleSSD
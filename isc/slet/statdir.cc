@@ -1,7 +1,12 @@
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
 #include "sims/configs.hh"
-#include "sims/ftl.hh"
 
 #include "runtime.hh"
+#include "utils/math.hh"
 
 #include "fs/ext4/ext4.hh"
 #include "slet/statdir.hh"
@@ -17,9 +22,6 @@ template ISC_STS_SLET_ID Runtime::addSlet<StatdirAPP>(_SIM_PARAMS);
 
 using namespace SIM;
 
-typedef struct dirent : public Ext4::dx_node {
-} dent_t;
-
 typedef struct inode : public Ext4::inode {
 } inode_t;
 
@@ -27,33 +29,42 @@ StatdirAPP::StatdirAPP(_SIM_PARAMS) {
   this->setOpt(ISC_KEY_NAME, strdup(str(StatdirAPP)));
 }
 
-size_t StatdirAPP::inodeFilter(const char *path, const char *dents,
-                               size_t szBuf, data_t *res _ADD_SIM_PARAMS) {
-  auto doit = [](const char *path, const char *dents, size_t szBuf,
+size_t StatdirAPP::inodeFilter(const char *path,
+                               const GenericFSA::Dirent *dents, size_t nd,
+                               data_t *res _ADD_SIM_PARAMS) {
+  auto doit = [](const char *path, const GenericFSA::Dirent *dents, size_t nd,
                  data_t *res _ADD_SIM_PARAMS) -> size_t {
-    size_t nd = 0, ofs = 0;
-    for (auto d = (dent_t *)dents; ofs < szBuf && d->fake.inode;
-         d = (dent_t *)(dents + ofs), ++nd) {
-      auto ino =
-          (inode_t *)Runtime::getInode(path, d->fake.inode _add_sim_params);
-
-      res[nd].mtime = ino->i_mtime;
-      res[nd].size = ino->i_size_lo;
-      res[nd].mode = ino->i_mode;
-      memcpy(res[nd].data, &d->data, d->fake.name_len);
-
-      free(ino);
-
-      // skip this dentry and 1 dummy tail dent (checksum)
-      ofs += d->fake.rec_len;
-      d = (dent_t *)(dents + ofs);
-      if (!d->fake.inode && d->fake.file_type == 0xde)
-        ofs += d->fake.rec_len;
+    for (size_t i = 0; i < nd; ++i)
+      memcpy(res[i].data, dents[i].name, dents[i].nameLen);
+
+    // get inodes in one batch sorted by number, then fill them by dentry
+    std::vector<size_t> order(nd);
+    for (size_t i = 0; i < nd; ++i)
+      order[i] = i;
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+      return dents[a].ino < dents[b].ino;
+    });
+
+    std::vector<uint64_t> sorted(nd);
+    for (size_t i = 0; i < nd; ++i)
+      sorted[i] = dents[order[i]].ino;
+
+    std::vector<inode_t> nodes(nd);
+    auto got = Runtime::getInodes(path, sorted.data(), nd,
+                                  nodes.data() _add_sim_params);
+    if (got != nd)
+      pr("Only %lu of %lu inodes got", got, nd);
+
+    for (size_t i = 0; i < got; ++i) {
+      auto &r = res[order[i]];
+      r.mtime = nodes[i].i_mtime;
+      r.size = nodes[i].i_size_lo;
+      r.mode = nodes[i].i_mode;
     }
     return nd;
   };
 
-  auto nums = doit(path, dents, szBuf, res _add_sim_params);
+  auto nums = doit(path, dents, nd, res _add_sim_params);
   simApplyManyLatency(CPU::ISC__SLET__STATDIR, STATDIR_INODE_FILTER, nums);
   return nums;
 }
@@ -61,47 +72,43 @@ size_t StatdirAPP::inodeFilter(const char *path, const char *dents,
 ISC_STS StatdirAPP::builtin_startup(_SIM_PARAMS) {
   auto doit = [this](_SIM_PARAMS) {
     // get inputs
-    auto path = (const char *)this->getOpt(keyPath);
-
-    // opendir
-    auto extList = Runtime::getExts(path _add_sim_params);
-    auto szBuf = (size_t *)calloc(1, sizeof(size_t));
-    for (size_t ie = 0; ie < extList.len; ++ie)
-      *szBuf += extList.exts[ie].len * BLK_SIZE;
-
-    // getdents
-    auto dents = (char *)calloc(1, *szBuf);
-    for (size_t ie = 0; ie < extList.len; ++ie) {
-      auto ofsBuf = ie * BLK_SIZE;
-      auto ofsData = extList.exts[ie].slbn * BLK_SIZE;
-      auto szData = extList.exts[ie].len * BLK_SIZE;
-      FTL::read(&dents[ofsBuf], ofsData, szData _add_sim_params);
-    }
-
-    // read inodes
-    auto res = (data_t *)calloc(*szBuf / sizeof(dent_t), sizeof(data_t));
-    auto nd = inodeFilter(path, dents, *szBuf, res _add_sim_params);
+    std::string path = this->getOpt<const char>(keyPath);
 
-    // update convert szbuf to result size
-    *szBuf = sizeof(data_t) * nd;
+    // entries point into the dir data, so they are kept together until the
+    // last batch is done, which may be after startup with a result ring
+    struct dir_t {
+      std::unique_ptr<GenericFSA::DirIter> it;
+      std::vector<GenericFSA::Dirent> dents;
+    };
+    auto dir = std::make_shared<dir_t>();
 
-    // clear data
-    free(extList.exts);
-    free(dents);
-
-    auto sts = this->setOpt(keyResultSize, szBuf);
-    if (sts != ISC_STS_OK)
-      return sts;
-    return this->setOpt(keyResult, res);
+    // opendir
+    dir->it.reset(Runtime::openDir(path.c_str() _add_sim_params));
+    GenericFSA::Dirent d;
+    while (dir->it && dir->it->next(&d))
+      dir->dents.push_back(d);
+
+    // read inodes by batches of entries
+    auto nd = dir->dents.size();
+    auto n = nd ? DIV64_CEIL(nd, BATCH_ENTS) : 0;
+    return this->produce(
+        n,
+        [this, dir, path](size_t i, std::string *out _ADD_SIM_PARAMS) {
+          auto first = i * BATCH_ENTS;
+          auto nd = std::min(BATCH_ENTS, dir->dents.size() - first);
+
+          out->assign(nd * sizeof(data_t), '\0');
+          inodeFilter(path.c_str(), &dir->dents[first], nd,
+                      (data_t *)&(*out)[0] _add_sim_params);
+          return ISC_STS_OK;
+        } _add_sim_params);
   };
   auto res = doit(_sim_params);
   simApplyLatency(CPU::ISC__SLET__STATDIR, CPU::ISC__START_SLET);
   return res;
 }
 
-const char *StatdirAPP::keyPath = "path";
-const char *StatdirAPP::keyResult = ISC_KEY_RESULT;
-const char *StatdirAPP::keyResultSize = ISC_KEY_RESULT_SIZE;
+const size_t StatdirAPP::BATCH_ENTS;
 
 }  // namespace ISC
 }  // namespace SimpleSSD
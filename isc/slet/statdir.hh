@@ -23,13 +23,11 @@ class StatdirAPP : public GenericAPP {
 
   ISC_STS builtin_startup(_SIM_PARAMS) override;
 
-  size_t inodeFilter(const char *, const char *, size_t,
+  size_t inodeFilter(const char *, const GenericFSA::Dirent *, size_t,
                      data_t *_ADD_SIM_PARAMS);
 
   static const size_t BLK_SIZE = 4096;
-  static const char *keyPath;
-  static const char *keyResult;
-  static const char *keyResultSize;
+  static const size_t BATCH_ENTS = 512;  // entries per item of the result
 };
 
 }  // namespace ISC
@@ -1,12 +1,12 @@
 #include "sims/cpu.hh"
 #include "sims/ftl.hh"
 
-#include "fs/ext4/ext4.hh"
 #include "slet/stats32.hh"
 
 #include "runtime.hh"
 
 #include "sims/configs.hh"
+#include "utils/simd.hh"
 
 #define PR_SECTION LOG_ISC_SLET_STATS32
 
@@ -17,15 +17,11 @@ template ISC_STS_SLET_ID Runtime::addSlet<Stats32APP>(_SIM_PARAMS);
 
 using namespace SIM;
 
-const char *Stats32APP::keyNumFiles = "numfiles";
-const char *Stats32APP::keyFileSizes = "filesizes";
-const char *Stats32APP::keyExts = "exts";
-
-const char *Stats32APP::keyPath = "path";
-const char *Stats32APP::keyResult = ISC_KEY_RESULT;
-const char *Stats32APP::keyResultSize = ISC_KEY_RESULT_SIZE;
-
 #define STATS32_TASK1_SUM CPU::ISC__TASK1
+#define STATS32_VTASK1_SUM CPU::ISC__VTASK1
+
+// elements in a vector of the simulated ISC core (128-bit)
+#define STATS32_SIM_LANES (16 / sizeof(int32_t))
 
 Stats32APP::Stats32APP(_SIM_PARAMS) {
   this->opt.name = strdup("Stats32APP");
@@ -35,13 +31,122 @@ Stats32APP::Stats32APP(_SIM_PARAMS) {
 #define MIN32(a, b) ({ (b) ^ (((a) ^ (b)) & -((a) < (b))); })
 #define MAX32(a, b) ({ (b) ^ (((a) ^ (b)) & -((a) > (b))); })
 
-ISC_STS
-Stats32APP::sum(const int32_t *src, size_t cnt, result_t *res _ADD_SIM_PARAMS) {
+typedef Stats32APP::result_t result_t;
+typedef void (*sum_kernel_t)(const int32_t *, size_t, result_t *);
+
+static void sumScalar(const int32_t *src, size_t cnt, result_t *res) {
   for (size_t i = 0; i < cnt; ++i) {
     res->sum += src[i];
     res->max = MAX32(res->max, src[i]);
     res->min = MIN32(res->min, src[i]);
   }
+}
+
+#ifdef ISC_SIMD_X86
+// merge the lanes of vector kernels into the result
+static void sumReduce(const int64_t *sums, size_t nsum, const int32_t *mins,
+                      const int32_t *maxs, size_t nmm, result_t *res) {
+  for (size_t i = 0; i < nsum; ++i)
+    res->sum += sums[i];
+  for (size_t i = 0; i < nmm; ++i) {
+    res->min = MIN32(res->min, mins[i]);
+    res->max = MAX32(res->max, maxs[i]);
+  }
+}
+
+SIMD_TARGET("sse4.1")
+static void sumSSE4(const int32_t *src, size_t cnt, result_t *res) {
+  __m128i vsum0 = _mm_setzero_si128(), vsum1 = _mm_setzero_si128();
+  __m128i vmin = _mm_set1_epi32(res->min), vmax = _mm_set1_epi32(res->max);
+
+  size_t i = 0;
+  for (; i + 4 <= cnt; i += 4) {
+    __m128i v = _mm_loadu_si128((const __m128i *)&src[i]);
+    vmin = _mm_min_epi32(vmin, v);
+    vmax = _mm_max_epi32(vmax, v);
+    vsum0 = _mm_add_epi64(vsum0, _mm_cvtepi32_epi64(v));
+    vsum1 = _mm_add_epi64(vsum1, _mm_cvtepi32_epi64(_mm_srli_si128(v, 8)));
+  }
+
+  int64_t sums[2];
+  int32_t mins[4], maxs[4];
+  _mm_storeu_si128((__m128i *)sums, _mm_add_epi64(vsum0, vsum1));
+  _mm_storeu_si128((__m128i *)mins, vmin);
+  _mm_storeu_si128((__m128i *)maxs, vmax);
+  sumReduce(sums, 2, mins, maxs, 4, res);
+  sumScalar(&src[i], cnt - i, res);
+}
+
+SIMD_TARGET("avx2")
+static void sumAVX2(const int32_t *src, size_t cnt, result_t *res) {
+  __m256i vsum0 = _mm256_setzero_si256(), vsum1 = _mm256_setzero_si256();
+  __m256i vmin = _mm256_set1_epi32(res->min);
+  __m256i vmax = _mm256_set1_epi32(res->max);
+
+  size_t i = 0;
+  for (; i + 8 <= cnt; i += 8) {
+    __m256i v = _mm256_loadu_si256((const __m256i *)&src[i]);
+    vmin = _mm256_min_epi32(vmin, v);
+    vmax = _mm256_max_epi32(vmax, v);
+    vsum0 = _mm256_add_epi64(
+        vsum0, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(v)));
+    vsum1 = _mm256_add_epi64(
+        vsum1, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(v, 1)));
+  }
+
+  int64_t sums[4];
+  int32_t mins[8], maxs[8];
+  _mm256_storeu_si256((__m256i *)sums, _mm256_add_epi64(vsum0, vsum1));
+  _mm256_storeu_si256((__m256i *)mins, vmin);
+  _mm256_storeu_si256((__m256i *)maxs, vmax);
+  sumReduce(sums, 4, mins, maxs, 8, res);
+  sumScalar(&src[i], cnt - i, res);
+}
+
+SIMD_AVX512_BEGIN
+SIMD_TARGET("avx512f")
+static void sumAVX512(const int32_t *src, size_t cnt, result_t *res) {
+  __m512i vsum0 = _mm512_setzero_si512(), vsum1 = _mm512_setzero_si512();
+  __m512i vmin = _mm512_set1_epi32(res->min);
+  __m512i vmax = _mm512_set1_epi32(res->max);
+
+  size_t i = 0;
+  for (; i + 16 <= cnt; i += 16) {
+    __m512i v = _mm512_loadu_si512((const void *)&src[i]);
+    vmin = _mm512_min_epi32(vmin, v);
+    vmax = _mm512_max_epi32(vmax, v);
+    vsum0 = _mm512_add_epi64(
+        vsum0, _mm512_cvtepi32_epi64(_mm512_castsi512_si256(v)));
+    vsum1 = _mm512_add_epi64(
+        vsum1, _mm512_cvtepi32_epi64(_mm512_extracti64x4_epi64(v, 1)));
+  }
+
+  int64_t sums[8];
+  int32_t mins[16], maxs[16];
+  _mm512_storeu_si512((void *)sums, _mm512_add_epi64(vsum0, vsum1));
+  _mm512_storeu_si512((void *)mins, vmin);
+  _mm512_storeu_si512((void *)maxs, vmax);
+  sumReduce(sums, 8, mins, maxs, 16, res);
+  sumScalar(&src[i], cnt - i, res);
+}
+SIMD_AVX512_END
+#endif
+
+ISC_STS
+Stats32APP::sum(const int32_t *src, size_t cnt, result_t *res _ADD_SIM_PARAMS) {
+#ifdef ISC_SIMD_X86
+  static const sum_kernel_t kernels[Utils::SIMD::ISA_COUNT] = {
+      sumScalar, sumSSE4, sumAVX2, sumAVX512};
+  kernels[Utils::SIMD::getISA()](src, cnt, res);
+#else
+  sumScalar(src, cnt, res);
+#endif
+
+  // the simulated core is charged by its own vector width
+  simApplyManyLatency(CPU::ISC__SLET__STATS32, STATS32_VTASK1_SUM,
+                      cnt / STATS32_SIM_LANES);
+  simApplyManyLatency(CPU::ISC__SLET__STATS32, STATS32_TASK1_SUM,
+                      cnt % STATS32_SIM_LANES);
   return ISC_STS_OK;
 }
 
@@ -49,190 +154,50 @@ ISC_STS Stats32APP::builtin_startup(_SIM_PARAMS) {
   auto doit = [this](_SIM_PARAMS) -> ISC_STS {
     auto sts = ISC_STS_OK;
 
-    // get options
-    GenericFSA::ExtList *fileExtLists = nullptr;
-    auto exts = (GenericFSA::Ext *)this->getOpt(keyExts);
-    auto numFiles = (size_t *)this->getOpt(keyNumFiles);
-    auto fileSizes = (size_t *)this->getOpt(keyFileSizes);
-    auto nofsa = exts && numFiles && fileSizes;
-
-    auto path = (const char *)this->getOpt(keyPath);
-    auto isdir = path[strlen(path) - 1] == '/';
-
-    // allocate result size buffer
-    auto bufOutSz = (size_t *)calloc(1, sizeof(size_t));
-    if (!bufOutSz)
-      return ISC_STS_FAIL;
+    Utils::Codec::Type codec;
+    if ((sts = this->getCodec(&codec)) != ISC_STS_OK)
+      return sts;
 
-    size_t iFile = 0, oBufDir = 0, szBufDir = 0;
-    char pathFile[512] = {0};
-
-    // determine output buffer size
-    result_t *bufOut;
-    char *bufDir = nullptr;
-    Ext4::fake_dirent *dirent;
-
-    if (isdir && !nofsa) {
-      auto dirExtList = Runtime::getExts(path _add_sim_params);
-      for (size_t ie = 0; ie < dirExtList.len; ++ie)
-        szBufDir += dirExtList.exts[ie].len * BLK_SIZE;
-
-      // read dir entries
-      bufDir = (char *)calloc(1, szBufDir);
-      if (!bufDir) {
-        free(dirExtList.exts);
-        sts = ISC_STS_FAIL;
-        goto out_free_ressize;
-      }
-      for (size_t ie = 0, ofsBuf = 0; ie < dirExtList.len; ++ie) {
-        auto ofsData = dirExtList.exts[ie].slbn * BLK_SIZE;
-        auto szData = dirExtList.exts[ie].len * BLK_SIZE;
-        SIM::FTL::read(&bufDir[ofsBuf], ofsData, szData _add_sim_params);
-        ofsBuf += szData;
-      }
-
-      // check number of files
-      for (oBufDir = 0; oBufDir < szBufDir; oBufDir += dirent->rec_len) {
-        dirent = (Ext4::fake_dirent *)&bufDir[oBufDir];
-
-        if (dirent->inode == 0) {
-          // skip 1 dummy tail dent (checksum)
-          if (dirent->file_type == 0xde) {
-            pr("End of directory block (+%d)", dirent->rec_len);
-            continue;
-          }
-          break;
-        }
-
-        if (dirent->file_type != 2 /* dir */) {
-          char name[256] = {0};
-          strncpy(name, &bufDir[oBufDir + sizeof(*dirent)], dirent->name_len);
-
-          *bufOutSz += BYTES_PER_RESULT;
-          pr("[+%lu]: '%s'", oBufDir, name);
-        }
-      }
-      free(dirExtList.exts);
-    }
-    else if (!nofsa) {
-      strncpy(pathFile, path, 255);
-      *bufOutSz = BYTES_PER_RESULT;
-    }
-    else {
-      // convert exts to ExtList
-      fileExtLists =
-          (GenericFSA::ExtList *)calloc(*numFiles, sizeof(GenericFSA::ExtList));
-
-      for (size_t i = 0, ie = 0; i < *numFiles; ++i, ++ie) {
-        fileExtLists[i].bytes = fileSizes[i];
-
-        // exts is separated by 'block == UINT64_MAX'
-        fileExtLists[i].exts = &exts[ie];
-        fileExtLists[i].len = 0;
-        for (; exts[ie].block != UINT64_MAX; ++ie)
-          fileExtLists[i].len++;
-      }
-
-      *bufOutSz = *numFiles * BYTES_PER_RESULT;
-      if (!isdir)
-        strncpy(pathFile, path, 255);
-    }
+    std::vector<GenericFSA::ExtList> files;
+    if ((sts = this->resolveFiles(files, false _add_sim_params)) != ISC_STS_OK)
+      return sts;
 
-    // allocate output buffer and start hashing
-    bufOut = (result_t *)calloc(*bufOutSz + 1, sizeof(uint8_t));
+    // allocate output buffer and start summing
+    auto szOut = files.size() * BYTES_PER_RESULT;
+    auto bufOut = (result_t *)calloc(szOut + 1, sizeof(uint8_t));
     if (!bufOut) {
-      sts = ISC_STS_FAIL;
-      goto out_free_ressize;
-    }
-    if (!isdir)
-      goto readfile;
-
-    pr("Num files: %lu %s", *bufOutSz / BYTES_PER_RESULT, isdir ? "(dir)" : "");
-    for (oBufDir = 0; iFile < (*bufOutSz / BYTES_PER_RESULT); ++iFile) {
-      // find next file
-      if (nofsa) {
-        // we don't know the exact filename, give it a symbolic name
-        snprintf(pathFile, 255, "%s[%lu]", path, iFile);
-        goto readfile;
-      }
-
-      for (char name[256]; oBufDir < szBufDir; oBufDir += dirent->rec_len) {
-        dirent = (Ext4::fake_dirent *)&bufDir[oBufDir];
-
-        if (dirent->file_type == 2 /* dir */)
-          continue;
-
-        memset(name, 0, 256);
-        strncpy(name, &bufDir[oBufDir + sizeof(*dirent)], dirent->name_len);
-
-        pr("[+%lu]: Find file %s", oBufDir, name);
-        snprintf(pathFile, 511, "%s%s", path, name);
-        oBufDir += dirent->rec_len;
-        break;
-      }
-
-      // read data of the path
-    readfile:
-      pr("File[%lu]: %s", iFile, pathFile);
-
-      auto szBufFile = 0;
-      GenericFSA::ExtList fileExtList;
-      if (nofsa)
-        fileExtList = fileExtLists[iFile];
-      else
-        fileExtList = Runtime::getExts(pathFile _add_sim_params);
-
-      for (size_t ie = 0; ie < fileExtList.len; ++ie)
-        szBufFile += fileExtList.exts[ie].len * BLK_SIZE;
-
-      // read file data
-      auto bufFile = (uint8_t *)calloc(1, szBufFile);
-      if (!bufFile) {
-        sts = ISC_STS_FAIL;
-        goto out_free_fileExt;
-      }
-      for (size_t ie = 0, ofsBuf = 0; ie < fileExtList.len; ++ie) {
-        auto ofsData = fileExtList.exts[ie].slbn * BLK_SIZE;
-        auto szData = fileExtList.exts[ie].len * BLK_SIZE;
-        SIM::FTL::read(&bufFile[ofsBuf], ofsData, szData _add_sim_params);
-        ofsBuf += szData;
-      }
-
-      // main operation
-      {
-        result_t *res = &bufOut[iFile];
-        size_t count = fileExtList.bytes / sizeof(int32_t);
-        sts = sum((int32_t *)bufFile, count, res _add_sim_params);
-        pr("Sum,Min,Max,Cnt=%ld,%d,%d,%lu", res->sum, res->min, res->max,
-           count);
-        simApplyManyLatency(CPU::ISC__SLET__STATS32, STATS32_TASK1_SUM, count);
-      }
-
-      free(bufFile);
-    out_free_fileExt:
-      if (!nofsa)
-        free(fileExtList.exts);
-
-      if (sts != ISC_STS_OK)
-        goto out_free_result;
+      freeFiles(files);
+      return ISC_STS_FAIL;
     }
 
-    // set result
-    sts = this->setOpt(keyResultSize, bufOutSz);
-    if (sts == ISC_STS_OK)
-      sts = this->setOpt(keyResult, bufOut);
-
-  out_free_result:
-    if (sts != ISC_STS_OK)
+    // files are summed by tasks on the ISC cores, chunk by chunk
+    sts = Runtime::runTasks(
+        files.size(),
+        [&](size_t i _ADD_SIM_PARAMS) {
+          result_t *res = &bufOut[i];
+          Stream stream(files[i], Stream::CHUNK_SIZE, 2, codec);
+          const byte *chunk;
+          size_t count = 0;
+          auto sts = ISC_STS_OK;
+
+          for (size_t len; (len = stream.next(&chunk _add_sim_params));) {
+            size_t cnt = len / sizeof(int32_t);
+            sts = sum((const int32_t *)chunk, cnt, res _add_sim_params);
+            count += cnt;
+          }
+          if (sts == ISC_STS_OK)
+            sts = stream.getStatus();
+          pr("Sum,Min,Max,Cnt=%ld,%d,%d,%lu", res->sum, res->min, res->max,
+             count);
+          return sts;
+        } _add_sim_params);
+    freeFiles(files);
+
+    if (sts != ISC_STS_OK) {
       free(bufOut);
-    if (isdir && !nofsa)
-      free(bufDir);
-    if (nofsa)
-      free(fileExtLists);
-  out_free_ressize:
-    if (sts != ISC_STS_OK)
-      free(bufOutSz);
-    return sts;
+      return sts;
+    }
+    return this->publishResult(bufOut, szOut);
   };
 
   auto res = doit(_sim_params);
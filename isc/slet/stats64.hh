@@ -35,12 +35,6 @@ class Stats64APP : public GenericAPP {
   ISC_STS builtin_startup(_SIM_PARAMS) override;
 
   static const size_t BLK_SIZE = 4096;
-  static const char *keyNumFiles;
-  static const char *keyFileSizes;
-  static const char *keyExts;
-  static const char *keyPath;
-  static const char *keyResult;
-  static const char *keyResultSize;
 };
 
 }  // namespace ISC
@@ -7,6 +7,8 @@
 
 // debugfs
 #include <queue>
+#include <string>
+#include <vector>
 
 #include "e2fs_utils.hh"
 
@@ -168,6 +170,7 @@ TEST(Ext4Test, PR_SECTION) {
 
     size_t nrUsed = sb->s_inodes_count - sb->s_free_inodes_count;
     size_t nrFound = 0;
+    std::vector<uint64_t> used;
     pr("Expect %lu Inodes used:", nrUsed);
 
     ext2_ino_t s = 1;
@@ -204,9 +207,21 @@ TEST(Ext4Test, PR_SECTION) {
 
       free(fsa_imap);
       free(fsa_inode);
+      used.push_back(ffs);
     }
     ASSERT_EQ(nrUsed, nrFound);
 
+    // inodes got in a batch are the same as those got one by one
+    std::vector<Ext4::inode> batch(used.size());
+    ASSERT_EQ(used.size(),
+              fsa->builtin_getInodes(used.data(), used.size(), batch.data()));
+    for (size_t i = 0; i < used.size(); ++i) {
+      auto fsa_inode = fsa->getInode(used[i]);
+      ASSERT_FALSE(memcmp(fsa_inode, &batch[i], sizeof(ext2_inode)))
+          << "Ino[" << used[i] << "]";
+      free(fsa_inode);
+    }
+
     // ext2fs_test_inode_bitmap_range() returns true if all bits in range are 0
     if (s < e) {
       pr("Checking Inodes[%u, %u] are all clear", s, e - 1);
@@ -467,3 +482,208 @@ TEST(Ext4Test, PR_SECTION) {
     FTL::destory();
   }
 }
+
+#undef PR_SECTION
+#define PR_SECTION DirExtsTest
+TEST(Ext4Test, PR_SECTION) {
+  size_t iDisk = 0;
+  for (auto disk : DISKSET) {
+    pr("-------Testing disk[%lu]: %s", iDisk++, disk);
+
+    check0(ext2fs_open, disk, flags, sblk, bsz, manager, &fs);
+    FTL::setImage(disk);
+    auto fsa = new Ext4();
+
+    // traverse directory (BFS)
+    struct Data {
+      std::vector<ext2_ino_t> files;
+      std::queue<pair<ino_t, std::string>> pending;
+      std::string cwd;
+    } data;
+    data.pending.push({2, "/"});
+
+    while (!data.pending.empty()) {
+      auto dir = data.pending.front();
+      data.pending.pop();
+
+      data.cwd = dir.second;
+      data.files.clear();
+      check0(
+          ext2fs_dir_iterate, fs, dir.first, 0, nullptr,
+          [](ext2_dir_entry *e, int, int, char *, void *data) {
+            auto d = (Data *)data;
+            auto ftype = ((Ext4::fake_dirent *)e)->file_type;
+
+            if (ftype == 1 /* reg file */)
+              d->files.push_back(e->inode);
+            else if (ftype == 2 /* dir */ && strcmp(e->name, ".") &&
+                     strcmp(e->name, ".."))
+              d->pending.push(
+                  {e->inode, d->cwd + std::string(e->name, e->name_len & 0xff) +
+                                 "/"});
+            return 0;
+          },
+          &data);
+
+      // files are in the order of dir entries, the second time is cached
+      for (int pass = 0; pass < 2; ++pass) {
+        auto lists = fsa->builtin_getExtsForDir(data.cwd.c_str(), true);
+        ASSERT_EQ(data.files.size(), lists.size()) << data.cwd;
+
+        for (size_t i = 0; i < lists.size(); ++i) {
+          ext2_inode inode;
+          check0(ext2fs_read_inode, fs, data.files[i], &inode);
+          EXPECT_EQ((size_t)EXT2_I_SIZE(&inode), lists[i].bytes);
+
+          size_t sz;
+          auto exts = fsa->getExtent(data.files[i], &sz, nullptr);
+          ASSERT_EQ(sz, lists[i].len);
+          EXPECT_EQ(0, memcmp(exts, lists[i].exts, sz * sizeof(Ext4::Ext)));
+          free(exts);
+          free(lists[i].exts);
+        }
+      }
+    }
+
+    ext2fs_close(fs);
+    delete fsa;
+    FTL::destory();
+  }
+}
+
+#undef PR_SECTION
+#define PR_SECTION HtreeTest
+TEST(Ext4Test, PR_SECTION) {
+  auto disk = "test/bin/fb-test.img";  // htree enabled
+  pr("-------Testing disk: %s", disk);
+
+  check0(ext2fs_open, disk, flags, sblk, bsz, manager, &fs);
+  FTL::setImage(disk);
+
+  struct Data {
+    std::queue<pair<ino_t, std::string>> pending;
+    std::string cwd;
+    int hashVer;
+    Ext4 *fsa;
+    int nrIndexed;
+  } data = {
+      .hashVer = fs->super->s_def_hash_version,
+      .fsa = new Ext4(),
+      .nrIndexed = 0,
+  };
+  if (fs->super->s_flags & EXT2_FLAGS_UNSIGNED_HASH)
+    data.hashVer += 3;
+  data.pending.push({2, ""});
+
+  while (!data.pending.empty()) {
+    auto dir = data.pending.front();
+    data.pending.pop();
+
+    ext2_inode inode;
+    check0(ext2fs_read_inode, fs, dir.first, &inode);
+    if (inode.i_flags & EXT2_INDEX_FL)
+      data.nrIndexed++;
+
+    data.cwd = dir.second;
+    check0(
+        ext2fs_dir_iterate, fs, dir.first, 0, nullptr,
+        [](ext2_dir_entry *e, int, int, char *, void *data) {
+          auto d = (Data *)data;
+          auto len = e->name_len & 0xff;
+
+          if (!strcmp(e->name, ".") || !strcmp(e->name, ".."))
+            return 0;
+
+          // hash of names, as stored in dx entries
+          ext2_dirhash_t hash, minor;
+          check0(ext2fs_dirhash, d->hashVer, e->name, len,
+                 fs->super->s_hash_seed, &hash, &minor);
+          EXPECT_EQ(hash, Ext4::dirHash(e->name, len, d->hashVer,
+                                        fs->super->s_hash_seed));
+
+          auto path = d->cwd + "/" + std::string(e->name, len);
+          EXPECT_EQ(e->inode, d->fsa->namei(path.c_str())) << path;
+
+          if (((Ext4::fake_dirent *)e)->file_type == 2 /* dir */)
+            d->pending.push({e->inode, path});
+          return 0;
+        },
+        &data);
+  }
+  pr("Total number of indexed directories: %d", data.nrIndexed);
+  EXPECT_GT(data.nrIndexed, 0);
+
+  ext2fs_close(fs);
+  delete data.fsa;
+  FTL::destory();
+}
+
+#undef PR_SECTION
+#define PR_SECTION DirIterTest
+TEST(Ext4Test, PR_SECTION) {
+  size_t iDisk = 0;
+  for (auto disk : DISKSET) {
+    pr("-------Testing disk[%lu]: %s", iDisk++, disk);
+
+    check0(ext2fs_open, disk, flags, sblk, bsz, manager, &fs);
+    FTL::setImage(disk);
+    auto fsa = new Ext4();
+
+    // traverse directory (BFS)
+    struct Dent {
+      uint32_t ino;
+      uint8_t type;
+      std::string name;
+    };
+    struct Data {
+      std::vector<Dent> dents;
+      std::queue<pair<ino_t, std::string>> pending;
+      std::string cwd;
+    } data;
+    data.pending.push({2, "/"});
+
+    while (!data.pending.empty()) {
+      auto dir = data.pending.front();
+      data.pending.pop();
+
+      data.cwd = dir.second;
+      check0(
+          ext2fs_dir_iterate, fs, dir.first, 0, nullptr,
+          [](ext2_dir_entry *e, int, int, char *, void *data) {
+            auto d = (Data *)data;
+            auto e2 = (ext2_dir_entry_2 *)e;
+            std::string name(e2->name, e2->name_len);
+            d->dents.push_back({e2->inode, e2->file_type, name});
+
+            if (e2->file_type == 2 /* dir */ && name != "." && name != "..")
+              d->pending.push({e->inode, d->cwd + name + "/"});
+            return 0;
+          },
+          &data);
+
+      // the same entries in the same order, names point into the dir data
+      auto it = fsa->builtin_openDir(data.cwd.c_str());
+      ASSERT_NE(it, nullptr) << data.cwd;
+      EXPECT_EQ(dir.first, it->getIno());
+
+      GenericFSA::Dirent d;
+      for (auto &dent : data.dents) {
+        ASSERT_TRUE(it->next(&d)) << data.cwd;
+        EXPECT_EQ(dent.ino, d.ino);
+        EXPECT_EQ(dent.type, d.type);
+        EXPECT_EQ(dent.name, std::string(d.name, d.nameLen));
+        EXPECT_TRUE(d.name >= it->getData() &&
+                    d.name + d.nameLen <= it->getData() + it->getSize());
+      }
+      EXPECT_FALSE(it->next(&d));
+      data.dents.clear();
+      delete it;
+    }
+
+    EXPECT_EQ(nullptr, fsa->builtin_openDir("/not/exists"));
+
+    ext2fs_close(fs);
+    delete fsa;
+    FTL::destory();
+  }
+}
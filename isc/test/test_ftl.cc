@@ -0,0 +1,287 @@
+#include "gtest/gtest.h"
+
+#include <fcntl.h>
+#include <ctime>
+#include <random>
+#include <vector>
+
+#include <lz4frame.h>
+#include <zstd.h>
+
+#include "sims/ftl.hh"
+#include "types.hh"
+
+#include "utils/debug.hh"
+
+using namespace SimpleSSD::ISC;
+using namespace SimpleSSD::ISC::SIM;
+
+#define BLK_SIZE 4096
+
+static double ts2s(timespec ts) { return ts.tv_sec + ts.tv_nsec / 1e9; }
+
+#undef PR_SECTION
+#define PR_SECTION Backends
+TEST(FtlTest, PR_SECTION) {
+  const char *disk = "/tmp/sss-isc-test.img";
+  const size_t szDisk = 256ULL << 20;
+  const size_t numReads = 1 << 16;
+
+  // the backend is selected by the test itself
+  unsetenv("ISC_TEST_FTL_BACKEND");
+
+  // init disk with random data
+  auto data = (uint64_t *)malloc(szDisk);
+  ASSERT_NE(data, nullptr);
+  std::mt19937_64 rng(0);
+  for (size_t i = 0; i < szDisk / sizeof(uint64_t); ++i)
+    data[i] = rng();
+
+  auto fd = open(disk, O_CREAT | O_TRUNC | O_WRONLY, 0644);
+  ASSERT_GE(fd, 0);
+  ASSERT_EQ((ssize_t)szDisk, write(fd, data, szDisk));
+  ASSERT_EQ(0, close(fd));
+
+  // random extents (1~8 blocks) within the disk
+  std::vector<std::pair<size_t, size_t>> exts;
+  for (size_t i = 0; i < numReads; ++i) {
+    size_t len = (rng() % 8 + 1) * BLK_SIZE;
+    size_t ofs = rng() % (szDisk / BLK_SIZE - 8) * BLK_SIZE;
+    exts.push_back({ofs, len});
+  }
+
+  auto buf = (char *)malloc(8 * BLK_SIZE);
+  ASSERT_NE(buf, nullptr);
+
+  for (auto backend : {FTL::PREAD, FTL::MMAP}) {
+    auto name = backend == FTL::MMAP ? "mmap" : "pread";
+    FTL::setImage(disk, 512, backend);
+    ASSERT_EQ(backend, FTL::getBackend());
+
+    // read
+    timespec tsBeg, tsEnd;
+    clock_gettime(CLOCK_MONOTONIC, &tsBeg);
+    for (auto &e : exts) {
+      FTL::read(buf, e.first, e.second);
+      ASSERT_EQ(0, memcmp(buf, (char *)data + e.first, e.second));
+    }
+    clock_gettime(CLOCK_MONOTONIC, &tsEnd);
+    printf("[%5s] read %lu extents: %.3f s\n", name, exts.size(),
+           ts2s(tsEnd) - ts2s(tsBeg));
+
+    // view, only the mapped image can be viewed
+    if (backend == FTL::PREAD) {
+      ASSERT_EQ(nullptr, FTL::view(exts[0].first, exts[0].second));
+    }
+    else {
+      clock_gettime(CLOCK_MONOTONIC, &tsBeg);
+      for (auto &e : exts) {
+        auto view = (const char *)FTL::view(e.first, e.second);
+        ASSERT_NE(view, nullptr);
+        ASSERT_EQ(0, memcmp(view, (char *)data + e.first, e.second));
+      }
+      clock_gettime(CLOCK_MONOTONIC, &tsEnd);
+      printf("[%5s] view %lu extents: %.3f s\n", name, exts.size(),
+             ts2s(tsEnd) - ts2s(tsBeg));
+    }
+
+    // out of range should not be viewed
+    ASSERT_EQ(nullptr, FTL::view(szDisk - BLK_SIZE, 2 * BLK_SIZE));
+
+    FTL::destory();
+    ASSERT_EQ(FTL::PREAD, FTL::getBackend());
+  }
+
+  free(buf);
+  free(data);
+  unlink(disk);
+}
+
+#undef PR_SECTION
+#define PR_SECTION Batch
+TEST(FtlTest, PR_SECTION) {
+  const char *disk = "/tmp/sss-isc-test.img";
+  const size_t numBlks = 64;
+
+  auto data = (char *)malloc(numBlks * BLK_SIZE);
+  ASSERT_NE(data, nullptr);
+  for (size_t i = 0; i < numBlks * BLK_SIZE; ++i)
+    data[i] = (char)(i * 7 + i / BLK_SIZE);
+
+  auto fd = open(disk, O_CREAT | O_TRUNC | O_WRONLY, 0644);
+  ASSERT_GE(fd, 0);
+  ASSERT_EQ((ssize_t)(numBlks * BLK_SIZE), write(fd, data, numBlks * BLK_SIZE));
+  ASSERT_EQ(0, close(fd));
+
+  FTL::setImage(disk);
+
+  // read blocks in reversed order, the data is there once the call returns
+  std::vector<char> buf(numBlks * BLK_SIZE);
+  std::vector<FTL::BatchRead> reqs(numBlks);
+  for (size_t i = 0; i < numBlks; ++i) {
+    reqs[i].buffer = &buf[i * BLK_SIZE];
+    reqs[i].offset = (numBlks - 1 - i) * BLK_SIZE;
+    reqs[i].size = BLK_SIZE;
+    reqs[i].doneAt = UINT64_MAX;
+  }
+  // no simulated latency in tests, every read completes at tick 0
+  ASSERT_EQ(0u, FTL::readBatch(reqs.data(), reqs.size()));
+  for (size_t i = 0; i < numBlks; ++i)
+    ASSERT_EQ(0u, reqs[i].doneAt);
+  for (size_t i = 0; i < numBlks; ++i)
+    ASSERT_EQ(0, memcmp(&buf[i * BLK_SIZE],
+                        &data[(numBlks - 1 - i) * BLK_SIZE], BLK_SIZE));
+
+  FTL::destory();
+  free(data);
+  unlink(disk);
+}
+
+#undef PR_SECTION
+#define PR_SECTION Stream
+TEST(FtlTest, PR_SECTION) {
+  const char *disk = "/tmp/sss-isc-test.img";
+  const size_t numBlks = 64;
+
+  auto data = (char *)malloc(numBlks * BLK_SIZE);
+  ASSERT_NE(data, nullptr);
+  for (size_t i = 0; i < numBlks * BLK_SIZE; ++i)
+    data[i] = (char)(i * 13 + i / BLK_SIZE);
+
+  auto fd = open(disk, O_CREAT | O_TRUNC | O_WRONLY, 0644);
+  ASSERT_GE(fd, 0);
+  ASSERT_EQ((ssize_t)(numBlks * BLK_SIZE), write(fd, data, numBlks * BLK_SIZE));
+  ASSERT_EQ(0, close(fd));
+
+  // a fragmented file, the last block is partially used
+  GenericFSA::Ext exts[] = {{0, 40, 5}, {5, 3, 2}, {7, 20, 4}};
+  GenericFSA::ExtList file;
+  file.exts = exts;
+  file.len = 3;
+  file.bytes = 10 * BLK_SIZE + 123;
+
+  std::string want;
+  for (auto &e : exts)
+    want.append(&data[e.slbn * BLK_SIZE], e.len * BLK_SIZE);
+  want.resize(file.bytes);
+
+  for (auto backend : {FTL::PREAD, FTL::MMAP}) {
+    FTL::setImage(disk, 512, backend);
+
+    // chunks cross the extent boundaries, and are rounded up to blocks
+    std::vector<size_t> szChunks = {1, 3 * BLK_SIZE, 2 * BLK_SIZE + 1, 1 << 20};
+    for (auto szChunk : szChunks) {
+      auto szMax = (szChunk + BLK_SIZE - 1) / BLK_SIZE * BLK_SIZE;
+      GenericAPP::Stream stream(file, szChunk, 2);
+      std::string got;
+      const byte *chunk;
+      for (size_t len; (len = stream.next(&chunk));) {
+        ASSERT_LE(len, szMax);
+        got.append((const char *)chunk, len);
+      }
+      ASSERT_EQ(want, got);
+    }
+  }
+
+  FTL::destory();
+  free(data);
+  unlink(disk);
+}
+
+#undef PR_SECTION
+#define PR_SECTION StreamCodec
+TEST(FtlTest, PR_SECTION) {
+  namespace Codec = SimpleSSD::Utils::Codec;
+  const char *disk = "/tmp/sss-isc-test.img";
+
+  // compressible lines, compressed as two frames each
+  std::string text;
+  std::mt19937_64 rng(0);
+  for (size_t i = 0; text.size() < (3 << 20) / 2; ++i)
+    text += "line " + std::to_string(i) + " value " +
+            std::to_string(rng() % 1000) + "\n";
+  auto half = text.size() / 3;
+
+  std::string zstd, lz4;
+  for (auto part : {text.substr(0, half), text.substr(half)}) {
+    std::string frame(ZSTD_compressBound(part.size()), '\0');
+    auto sz = ZSTD_compress(&frame[0], frame.size(), part.data(), part.size(),
+                            1);
+    ASSERT_FALSE(ZSTD_isError(sz));
+    zstd.append(frame.data(), sz);
+
+    LZ4F_preferences_t prefs;
+    memset(&prefs, 0, sizeof(prefs));
+    prefs.frameInfo.contentChecksumFlag = LZ4F_contentChecksumEnabled;
+    frame.resize(LZ4F_compressFrameBound(part.size(), &prefs));
+    sz = LZ4F_compressFrame(&frame[0], frame.size(), part.data(), part.size(),
+                            &prefs);
+    ASSERT_FALSE(LZ4F_isError(sz));
+    lz4.append(frame.data(), sz);
+  }
+
+  // a corrupted frame and a truncated one
+  std::string bad = zstd, cut = lz4.substr(0, lz4.size() - 100);
+  bad[bad.size() / 2] ^= 0x5A;
+
+  // files one after another, each is contiguous
+  std::vector<std::string> files = {text, zstd, lz4, bad, cut, ""};
+  std::vector<GenericFSA::Ext> exts;
+  std::string image;
+  for (auto &f : files) {
+    auto numBlks = (f.size() + BLK_SIZE - 1) / BLK_SIZE;
+    exts.push_back({0, image.size() / BLK_SIZE, numBlks});
+    image += f;
+    image.resize((image.size() + BLK_SIZE - 1) / BLK_SIZE * BLK_SIZE);
+  }
+  auto fd = open(disk, O_CREAT | O_TRUNC | O_WRONLY, 0644);
+  ASSERT_GE(fd, 0);
+  ASSERT_EQ((ssize_t)image.size(), write(fd, image.data(), image.size()));
+  ASSERT_EQ(0, close(fd));
+  FTL::setImage(disk);
+
+  struct {
+    size_t file;
+    Codec::Type codec;
+    const std::string *want;  // nullptr if it fails
+  } cases[] = {
+      {0, Codec::RAW, &text},   {0, Codec::AUTO, &text},
+      {1, Codec::ZSTD, &text},  {1, Codec::AUTO, &text},
+      {2, Codec::LZ4, &text},   {2, Codec::AUTO, &text},
+      {1, Codec::RAW, &zstd},   {1, Codec::LZ4, nullptr},
+      {0, Codec::ZSTD, nullptr}, {3, Codec::AUTO, nullptr},
+      {4, Codec::AUTO, nullptr}, {5, Codec::AUTO, &files[5]},
+  };
+
+  // chunks are not aligned with frames nor the chunks read
+  for (auto &c : cases) {
+    for (size_t szChunk : {(size_t)3 * BLK_SIZE, (size_t)(256 << 10)}) {
+      GenericFSA::ExtList file;
+      file.exts = &exts[c.file];
+      file.len = 1;
+      file.bytes = files[c.file].size();
+
+      GenericAPP::Stream stream(file, szChunk, 2, c.codec);
+      std::string got;
+      const byte *chunk;
+      for (size_t len; (len = stream.next(&chunk));) {
+        got.append((const char *)chunk, len);
+        if (c.codec != Codec::RAW && len < szChunk)
+          break;  // only the last chunk may be short
+      }
+
+      auto name = Codec::name(c.codec);
+      if (c.want) {
+        ASSERT_EQ(stream.getStatus(), ISC_STS_OK) << c.file << " " << name;
+        ASSERT_EQ(*c.want, got) << "file " << c.file << " by " << name;
+        ASSERT_EQ(stream.next(&chunk), 0ul);
+      }
+      else {
+        ASSERT_EQ(stream.getStatus(), ISC_STS_FAIL) << c.file << " " << name;
+      }
+    }
+  }
+
+  FTL::destory();
+  unlink(disk);
+}
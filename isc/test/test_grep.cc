@@ -8,6 +8,10 @@
 #include "fs/ext4/ext4.hh"
 #include "slet/grep.hh"
 
+#include <random>
+#include <string>
+#include <vector>
+
 using namespace SimpleSSD::ISC;
 
 #define ALIGN_UP(num, to) ((num + (to - 1)) & ~(to - 1))
@@ -54,14 +58,14 @@ TEST(SletTest, PR_SECTION) {
     ASSERT_NE(path, nullptr);
     auto pat1 = strdup("ne3");
     ASSERT_NE(pat1, nullptr);
-    ASSERT_NE(GrepAPP::keyPath, nullptr);
+    ASSERT_NE(GenericAPP::keyPath, nullptr);
     ASSERT_NE(GrepAPP::keyPatt, nullptr);
-    ASSERT_EQ(Runtime::setOpt(id, GrepAPP::keyPath, path), ISC_STS_OK);
+    ASSERT_EQ(Runtime::setOpt(id, GenericAPP::keyPath, path), ISC_STS_OK);
     ASSERT_EQ(Runtime::setOpt(id, GrepAPP::keyPatt, pat1), ISC_STS_OK);
 
     ASSERT_EQ(Runtime::startSlet(id), ISC_STS_OK);
-    auto result1 = (char *)Runtime::getOpt(id, GrepAPP::keyResult);
-    auto pResSz1 = (size_t *)Runtime::getOpt(id, GrepAPP::keyResultSize);
+    auto result1 = (char *)Runtime::getOpt(id, GenericAPP::keyResult);
+    auto pResSz1 = (size_t *)Runtime::getOpt(id, GenericAPP::keyResultSize);
     ASSERT_NE(result1, nullptr);
     ASSERT_NE(pResSz1, nullptr);
 
@@ -79,8 +83,8 @@ TEST(SletTest, PR_SECTION) {
     ASSERT_EQ(Runtime::setOpt(id, GrepAPP::keyPatt, pat2), ISC_STS_OK);
     ASSERT_EQ(Runtime::startSlet(id), ISC_STS_OK);
 
-    auto result2 = (char *)Runtime::getOpt(id, GrepAPP::keyResult);
-    auto pResSz2 = (size_t *)Runtime::getOpt(id, GrepAPP::keyResultSize);
+    auto result2 = (char *)Runtime::getOpt(id, GenericAPP::keyResult);
+    auto pResSz2 = (size_t *)Runtime::getOpt(id, GenericAPP::keyResultSize);
     ASSERT_NE(result2, nullptr);
     ASSERT_NE(pResSz2, nullptr);
 
@@ -95,6 +99,136 @@ TEST(SletTest, PR_SECTION) {
   SIM::FTL::destory();
 }
 
+#undef PR_SECTION
+#define PR_SECTION X_Y(GrepAPP, Matcher)
+TEST(SletTest, PR_SECTION) {
+  std::mt19937 rng(0);
+  auto randStr = [&](size_t len) {
+    std::string str;
+    for (size_t i = 0; i < len; ++i)
+      str += "abc"[rng() % 3];
+    return str;
+  };
+
+  // per-instance tables, matchers should not affect each other
+  GrepAPP::Matcher single, multi;
+  ASSERT_EQ(single.compile(""), ISC_STS_EARGS);
+  ASSERT_EQ(multi.compile("\n\n"), ISC_STS_EARGS);
+
+  for (size_t round = 0; round < 200; ++round) {
+    auto text = randStr(rng() % 256);
+    std::vector<std::string> pats;
+    std::string patterns;
+    for (size_t i = 0, n = 2 + rng() % 4; i < n; ++i) {
+      pats.push_back(randStr(1 + rng() % 5));
+      patterns += pats.back() + "\n";
+    }
+    ASSERT_EQ(single.compile(pats[0].c_str()), ISC_STS_OK);
+    ASSERT_EQ(multi.compile(patterns.c_str()), ISC_STS_OK);
+    ASSERT_EQ(multi.numPatterns(), pats.size());
+
+    // single pattern, the first occurrence
+    auto ofs = single.find(text.data(), text.size());
+    auto ans = text.find(pats[0]);
+    ASSERT_EQ(ans == std::string::npos ? -1 : (ssize_t)ans, ofs);
+
+    // multiple patterns, the occurrence which ends first
+    size_t end = SIZE_MAX;
+    for (auto &pat : pats) {
+      auto pos = text.find(pat);
+      if (pos != std::string::npos)
+        end = std::min(end, pos + pat.size());
+    }
+    ofs = multi.find(text.data(), text.size());
+    if (end == SIZE_MAX) {
+      ASSERT_EQ(-1, ofs);
+      continue;
+    }
+    ASSERT_GE(ofs, 0);
+    bool matched = false;
+    for (auto &pat : pats)
+      matched |= !text.compare(ofs, pat.size(), pat) && ofs + pat.size() == end;
+    ASSERT_TRUE(matched);
+  }
+}
+
+#undef PR_SECTION
+#define PR_SECTION X_Y(GrepAPP, Stream)
+TEST(SletTest, PR_SECTION) {
+  auto disk = "/tmp/sss-isc-test.img";
+
+  initialize_ext2_error_table();
+  const char *conf = "scripts/mke2fs.conf";
+  mkext4(disk, conf, (4 << 20));
+
+  // create test data
+  const char *pathTestFile = "/test.txt";
+  const char *dataTestFile = "line0\nline1\nline2\nthis is line3\nline4";
+  const auto dlen = strlen(dataTestFile);
+
+  check0(ext2fs_open, disk, EXT2_FLAG_RW, 0, 0, manager, &fs);
+  check0(ext2fs_read_block_bitmap, fs);
+  check0(ext2fs_read_inode_bitmap, fs);
+  newfile(fs, pathTestFile + 1, dataTestFile, dlen, 2);
+  check0(ext2fs_flush, fs);
+  ext2fs_free(fs);
+
+  SIM::FTL::setImage(disk);
+  ASSERT_EQ(Runtime::addSlet<Ext4>(), ++cntFSA);
+
+  auto id = Runtime::addSlet<GrepAPP>();
+  ASSERT_EQ(id, ++cntAPP);
+
+  struct answer_t {
+    uint64_t offset;
+    uint64_t lineno;
+    const char *line;
+  };
+  auto verify = [&](size_t maxCount, std::vector<answer_t> ans) {
+    auto pMaxCount = (size_t *)malloc(sizeof(size_t));
+    ASSERT_NE(pMaxCount, nullptr);
+    *pMaxCount = maxCount;
+    ASSERT_EQ(Runtime::setOpt(id, GrepAPP::keyMaxCount, pMaxCount),
+              ISC_STS_OK);
+    ASSERT_EQ(Runtime::startSlet(id), ISC_STS_OK);
+
+    auto result = (char *)Runtime::getOpt(id, GenericAPP::keyResult);
+    auto pResSz = (size_t *)Runtime::getOpt(id, GenericAPP::keyResultSize);
+    ASSERT_NE(pResSz, nullptr);
+
+    size_t ofsResult = 0;
+    for (auto &a : ans) {
+      ASSERT_LT(ofsResult, *pResSz);
+      auto m = (GrepAPP::match_t *)&result[ofsResult];
+      ASSERT_EQ(a.offset, m->offset);
+      ASSERT_EQ(a.lineno, m->lineno);
+      ASSERT_EQ(0U, m->file);
+      ASSERT_EQ(strlen(a.line), m->len);
+      ASSERT_EQ(0, memcmp(a.line, m + 1, m->len));
+      ofsResult += sizeof(*m) + ALIGN_UP(m->len, sizeof(size_t));
+    }
+    ASSERT_EQ(ofsResult, *pResSz);
+  };
+
+  // all matched lines of all patterns, a line is reported once
+  ASSERT_EQ(Runtime::setOpt(id, GenericAPP::keyPath, strdup(pathTestFile)),
+            ISC_STS_OK);
+  ASSERT_EQ(Runtime::setOpt(id, GrepAPP::keyPatt, strdup("ne3\nthis\n4")),
+            ISC_STS_OK);
+  ASSERT_EQ(Runtime::setOpt(id, GrepAPP::keyFormat, strdup("stream")),
+            ISC_STS_OK);
+  verify(0, {{18, 4, "this is line3"}, {32, 5, "line4"}});
+  verify(1, {{18, 4, "this is line3"}});
+
+  // no match, no record
+  ASSERT_EQ(Runtime::setOpt(id, GrepAPP::keyPatt, strdup("line9")),
+            ISC_STS_OK);
+  verify(0, {});
+
+  Runtime::destory();
+  SIM::FTL::destory();
+}
+
 #undef PR_SECTION
 #define PR_SECTION X_Y(GrepAPP, ManySmall)
 TEST(SletTest, PR_SECTION) {
@@ -156,14 +290,14 @@ TEST(SletTest, PR_SECTION) {
   char *path = dirPath;
   ASSERT_NE(dirPath, nullptr);
   ASSERT_NE(pattern, nullptr);
-  ASSERT_NE(GrepAPP::keyPath, nullptr);
+  ASSERT_NE(GenericAPP::keyPath, nullptr);
   ASSERT_NE(GrepAPP::keyPatt, nullptr);
-  ASSERT_EQ(Runtime::setOpt(id, GrepAPP::keyPath, path), ISC_STS_OK);
+  ASSERT_EQ(Runtime::setOpt(id, GenericAPP::keyPath, path), ISC_STS_OK);
   ASSERT_EQ(Runtime::setOpt(id, GrepAPP::keyPatt, pattern), ISC_STS_OK);
 
   ASSERT_EQ(Runtime::startSlet(id), ISC_STS_OK);
-  auto result = (char *)Runtime::getOpt(id, GrepAPP::keyResult);
-  auto pResSz = (size_t *)Runtime::getOpt(id, GrepAPP::keyResultSize);
+  auto result = (char *)Runtime::getOpt(id, GenericAPP::keyResult);
+  auto pResSz = (size_t *)Runtime::getOpt(id, GenericAPP::keyResultSize);
   ASSERT_NE(result, nullptr);
   ASSERT_NE(pResSz, nullptr);
 
@@ -303,17 +437,17 @@ TEST(SletTest, PR_SECTION) {
   char *path = path = strdup(pathFile);
 
   ASSERT_NE(path, nullptr);
-  ASSERT_NE(GrepAPP::keyPath, nullptr);
+  ASSERT_NE(GenericAPP::keyPath, nullptr);
 
   ASSERT_EQ(Runtime::setOpt(id, GrepAPP::keyPatt, pattern), ISC_STS_OK);
-  ASSERT_EQ(Runtime::setOpt(id, GrepAPP::keyPath, path), ISC_STS_OK);
-  ASSERT_EQ(Runtime::setOpt(id, GrepAPP::keyNumFiles, numFiles), ISC_STS_OK);
-  ASSERT_EQ(Runtime::setOpt(id, GrepAPP::keyFileSizes, sizes), ISC_STS_OK);
-  ASSERT_EQ(Runtime::setOpt(id, GrepAPP::keyExts, exts), ISC_STS_OK);
+  ASSERT_EQ(Runtime::setOpt(id, GenericAPP::keyPath, path), ISC_STS_OK);
+  ASSERT_EQ(Runtime::setOpt(id, GenericAPP::keyNumFiles, numFiles), ISC_STS_OK);
+  ASSERT_EQ(Runtime::setOpt(id, GenericAPP::keyFileSizes, sizes), ISC_STS_OK);
+  ASSERT_EQ(Runtime::setOpt(id, GenericAPP::keyExts, exts), ISC_STS_OK);
 
   ASSERT_EQ(Runtime::startSlet(id), ISC_STS_OK);
-  auto res = (char *)Runtime::getOpt(id, GrepAPP::keyResult);
-  auto pResSz = (size_t *)Runtime::getOpt(id, GrepAPP::keyResultSize);
+  auto res = (char *)Runtime::getOpt(id, GenericAPP::keyResult);
+  auto pResSz = (size_t *)Runtime::getOpt(id, GenericAPP::keyResultSize);
   ASSERT_NE(res, nullptr);
   ASSERT_NE(pResSz, nullptr);
   ASSERT_EQ(sizeof(size_t) + ALIGN_UP(tgtLen, sizeof(size_t)), *pResSz);
@@ -0,0 +1,195 @@
+#include "gtest/gtest.h"
+
+#include <fcntl.h>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "sims/ftl.hh"
+
+#include "runtime.hh"
+#include "types.hh"
+
+#include "slet/hash.hh"
+#include "utils/debug.hh"
+#include "utils/simd.hh"
+
+using namespace SimpleSSD::ISC;
+using namespace SimpleSSD::ISC::SIM;
+namespace SIMD = SimpleSSD::Utils::SIMD;
+
+static std::string hex(const uint8_t *d, size_t len) {
+  std::string s;
+  char buf[3];
+  for (size_t i = 0; i < len; ++i) {
+    snprintf(buf, sizeof(buf), "%02x", d[i]);
+    s += buf;
+  }
+  return s;
+}
+
+static std::string digest(const char *algo, const uint8_t *d, size_t len,
+                          size_t szChunk = SIZE_MAX) {
+  auto h = HashAPP::newHasher(algo);
+  std::vector<uint8_t> out(h->digestSize());
+
+  h->init();
+  for (size_t ofs = 0; ofs < len; ofs += szChunk)
+    h->update(&d[ofs], std::min(szChunk, len - ofs));
+  h->final(out.data());
+  delete h;
+  return hex(out.data(), out.size());
+}
+
+#undef PR_SECTION
+#define PR_SECTION X_Y(HashAPP, KnownAnswers)
+TEST(SletTest, PR_SECTION) {
+  struct {
+    const char *algo;
+    const char *s;
+    const char *ans;
+  } tests[] = {
+      {"xxh64", "", "ef46db3751d8e999"},
+      {"xxh64", "abc", "44bc2cf5ad770999"},
+      {"xxh64", "Nobody inspects the spammish repetition", "fbcea83c8a378bf1"},
+      {"crc32c", "", "00000000"},
+      {"crc32c", "123456789", "e3069283"},
+      {"sha256", "",
+       "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855"},
+      {"sha256", "abc",
+       "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad"},
+      {"sha256", "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq",
+       "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1"},
+  };
+
+  ASSERT_EQ(HashAPP::newHasher("md4"), nullptr);
+
+  for (int isa = SIMD::SCALAR; isa < SIMD::ISA_COUNT; ++isa) {
+    if (SIMD::setISA((SIMD::ISA)isa) != isa)
+      continue;  // not supported by the host
+    printf("[%6s] checking hashers (sha-ni: %d)\n",
+           SIMD::isaName((SIMD::ISA)isa), SIMD::hasSHA());
+
+    for (auto &t : tests)
+      ASSERT_EQ(t.ans, digest(t.algo, (const uint8_t *)t.s, strlen(t.s)))
+          << t.algo << "('" << t.s << "')";
+  }
+  SIMD::setISA(SIMD::hostISA());
+}
+
+#undef PR_SECTION
+#define PR_SECTION X_Y(HashAPP, Chunks)
+TEST(SletTest, PR_SECTION) {
+  const size_t len = (1 << 20) + 13;
+
+  std::mt19937_64 rng(0);
+  std::vector<uint8_t> data(len);
+  for (auto &d : data)
+    d = (uint8_t)rng();
+
+  // any split of the input, and any host kernel, gives the same digest
+  for (auto algo : {"xxh64", "crc32c", "sha256"}) {
+    SIMD::setISA(SIMD::SCALAR);
+    auto ans = digest(algo, data.data(), len);
+
+    for (int isa = SIMD::SCALAR; isa < SIMD::ISA_COUNT; ++isa) {
+      if (SIMD::setISA((SIMD::ISA)isa) != isa)
+        continue;
+
+      for (size_t szChunk : {1, 7, 31, 32, 63, 64, 65, 4096, 1 << 20})
+        ASSERT_EQ(ans, digest(algo, data.data(), len, szChunk))
+            << algo << " by " << szChunk << " bytes chunks ("
+            << SIMD::isaName((SIMD::ISA)isa) << ")";
+    }
+  }
+  SIMD::setISA(SIMD::hostISA());
+}
+
+#undef PR_SECTION
+#define PR_SECTION X_Y(HashAPP, NO_FSA)
+TEST(SletTest, PR_SECTION) {
+  const char *disk = "/tmp/sss-isc-test.img";
+  const size_t BLK_SIZE = HashAPP::BLK_SIZE;
+  const size_t szDisk = 16 << 20;
+  std::vector<size_t> szFiles = {0, 1, 4095, 4096, 100000, 1 << 20, 3 << 20};
+
+  std::mt19937_64 rng(0);
+  auto data = (uint8_t *)malloc(szDisk);
+  ASSERT_NE(data, nullptr);
+  for (size_t i = 0; i < szDisk / sizeof(uint64_t); ++i)
+    ((uint64_t *)data)[i] = rng();
+
+  auto fd = open(disk, O_CREAT | O_TRUNC | O_WRONLY, 0644);
+  ASSERT_GE(fd, 0);
+  ASSERT_EQ((ssize_t)szDisk, write(fd, data, szDisk));
+  ASSERT_EQ(0, close(fd));
+
+  // contiguous files, separated by a hole block
+  std::vector<GenericFSA::Ext> exts;
+  std::vector<size_t> slbns;
+  for (size_t i = 0, slbn = 0; i < szFiles.size(); ++i) {
+    auto numBlks = (szFiles[i] + BLK_SIZE - 1) / BLK_SIZE;
+    if (numBlks)
+      exts.push_back({0, slbn, numBlks});
+    exts.push_back({UINT64_MAX, UINT64_MAX, UINT64_MAX});
+    slbns.push_back(slbn);
+    slbn += numBlks + 1;
+    ASSERT_LE(slbn * BLK_SIZE, szDisk);
+  }
+
+  FTL::setImage(disk);
+
+  // files are hashed by tasks, results keep the order on any number of cores
+  for (auto algo : {"xxh64", "crc32c", "sha256", "unknown"}) {
+    numCores() = strcmp(algo, "crc32c") ? NUM_ISC_CORES : 3;
+
+    auto id = Runtime::addSlet<HashAPP>();
+    ASSERT_GT(id, 0);
+
+    // options are owned by the slet
+    auto numFiles = (size_t *)malloc(sizeof(size_t));
+    auto sizes = (size_t *)malloc(sizeof(size_t) * szFiles.size());
+    auto optExts = (GenericFSA::Ext *)malloc(sizeof(exts[0]) * exts.size());
+    *numFiles = szFiles.size();
+    memcpy(sizes, szFiles.data(), sizeof(size_t) * szFiles.size());
+    memcpy(optExts, exts.data(), sizeof(exts[0]) * exts.size());
+
+    ASSERT_EQ(Runtime::setOpt(id, GenericAPP::keyPath, strdup("/")),
+              ISC_STS_OK);
+    ASSERT_EQ(Runtime::setOpt(id, HashAPP::keyAlgo, strdup(algo)), ISC_STS_OK);
+    ASSERT_EQ(Runtime::setOpt(id, GenericAPP::keyNumFiles, numFiles),
+              ISC_STS_OK);
+    ASSERT_EQ(Runtime::setOpt(id, GenericAPP::keyFileSizes, sizes), ISC_STS_OK);
+    ASSERT_EQ(Runtime::setOpt(id, GenericAPP::keyExts, optExts), ISC_STS_OK);
+
+    auto hasher = HashAPP::newHasher(algo);
+    if (!hasher) {
+      ASSERT_EQ(Runtime::startSlet(id), ISC_STS_EARGS);
+      ASSERT_EQ(Runtime::delSlet(id), ISC_STS_OK);
+      continue;
+    }
+    ASSERT_EQ(Runtime::startSlet(id), ISC_STS_OK);
+
+    auto szDigest = hasher->digestSize();
+    delete hasher;
+
+    auto res = (uint8_t *)Runtime::getOpt(id, GenericAPP::keyResult);
+    auto pResSz = (size_t *)Runtime::getOpt(id, GenericAPP::keyResultSize);
+    ASSERT_NE(res, nullptr);
+    ASSERT_NE(pResSz, nullptr);
+    ASSERT_EQ(szFiles.size() * szDigest, *pResSz);
+
+    for (size_t i = 0; i < szFiles.size(); ++i)
+      ASSERT_EQ(digest(algo, &data[slbns[i] * BLK_SIZE], szFiles[i]),
+                hex(&res[i * szDigest], szDigest))
+          << algo << " of file[" << i << "] " << szFiles[i] << " bytes";
+
+    ASSERT_EQ(Runtime::delSlet(id), ISC_STS_OK);
+  }
+  numCores() = NUM_ISC_CORES;
+
+  free(data);
+  Runtime::destory();
+  FTL::destory();
+  unlink(disk);
+}
@@ -2,6 +2,7 @@
 
 #include <sys/fcntl.h>
 #include <ctime>
+#include <random>
 #include <vector>
 using namespace std;
 
@@ -13,6 +14,7 @@ using namespace std;
 #include "slet/md5.hh"
 
 #include "utils/debug.hh"
+#include "utils/simd.hh"
 
 // debugfs
 #include "e2fs_utils.hh"
@@ -236,12 +238,12 @@ TEST(SletTest, PR_SECTION) {
   ASSERT_EQ(id, ++cntAPP);
 
   // run
-  ASSERT_EQ(Runtime::setOpt(id, ISC_APP_CLASS::keyPath, path), ISC_STS_OK);
+  ASSERT_EQ(Runtime::setOpt(id, GenericAPP::keyPath, path), ISC_STS_OK);
   ASSERT_EQ(Runtime::startSlet(id), ISC_STS_OK);
 
-  auto resSize = (uint32_t *)Runtime::getOpt(id, ISC_APP_CLASS::keyResultSize);
+  auto resSize = (uint32_t *)Runtime::getOpt(id, GenericAPP::keyResultSize);
   ASSERT_NE(resSize, nullptr);
-  auto result = (uint8_t *)Runtime::getOpt(id, ISC_APP_CLASS::keyResult);
+  auto result = (uint8_t *)Runtime::getOpt(id, GenericAPP::keyResult);
   ASSERT_NE(result, nullptr);
 
   // verify
@@ -329,12 +331,12 @@ TEST(SletTest, PR_SECTION) {
   ASSERT_EQ(id, ++cntAPP);
 
   // run
-  ASSERT_EQ(Runtime::setOpt(id, ISC_APP_CLASS::keyPath, dirPath), ISC_STS_OK);
+  ASSERT_EQ(Runtime::setOpt(id, GenericAPP::keyPath, dirPath), ISC_STS_OK);
   ASSERT_EQ(Runtime::startSlet(id), ISC_STS_OK);
 
-  auto resSize = (uint32_t *)Runtime::getOpt(id, ISC_APP_CLASS::keyResultSize);
+  auto resSize = (uint32_t *)Runtime::getOpt(id, GenericAPP::keyResultSize);
   ASSERT_NE(resSize, nullptr);
-  auto results = (uint8_t *)Runtime::getOpt(id, ISC_APP_CLASS::keyResult);
+  auto results = (uint8_t *)Runtime::getOpt(id, GenericAPP::keyResult);
   ASSERT_NE(results, nullptr);
 
   ASSERT_EQ(16 * tests.size(), *resSize);
@@ -473,19 +475,19 @@ TEST(SletTest, PR_SECTION) {
   char *path = path = strdup(pathFile);
 
   ASSERT_NE(path, nullptr);
-  ASSERT_NE(ISC_APP_CLASS::keyPath, nullptr);
+  ASSERT_NE(GenericAPP::keyPath, nullptr);
 
-  ASSERT_EQ(Runtime::setOpt(id, ISC_APP_CLASS::keyPath, path), ISC_STS_OK);
-  ASSERT_EQ(Runtime::setOpt(id, ISC_APP_CLASS::keyNumFiles, numFiles),
+  ASSERT_EQ(Runtime::setOpt(id, GenericAPP::keyPath, path), ISC_STS_OK);
+  ASSERT_EQ(Runtime::setOpt(id, GenericAPP::keyNumFiles, numFiles),
             ISC_STS_OK);
-  ASSERT_EQ(Runtime::setOpt(id, ISC_APP_CLASS::keyFileSizes, sizes),
+  ASSERT_EQ(Runtime::setOpt(id, GenericAPP::keyFileSizes, sizes),
             ISC_STS_OK);
-  ASSERT_EQ(Runtime::setOpt(id, ISC_APP_CLASS::keyExts, exts), ISC_STS_OK);
+  ASSERT_EQ(Runtime::setOpt(id, GenericAPP::keyExts, exts), ISC_STS_OK);
 
   ASSERT_EQ(Runtime::startSlet(id), ISC_STS_OK);
   auto res =
-      (ISC_APP_CLASS::result_t *)Runtime::getOpt(id, ISC_APP_CLASS::keyResult);
-  auto pResSz = (size_t *)Runtime::getOpt(id, ISC_APP_CLASS::keyResultSize);
+      (ISC_APP_CLASS::result_t *)Runtime::getOpt(id, GenericAPP::keyResult);
+  auto pResSz = (size_t *)Runtime::getOpt(id, GenericAPP::keyResultSize);
   ASSERT_NE(res, nullptr);
   ASSERT_NE(pResSz, nullptr);
   ASSERT_EQ(sizeof(ISC_APP_CLASS::result_t), *pResSz);
@@ -511,3 +513,96 @@ TEST(SletTest, PR_SECTION) {
   Runtime::destory();
   SIM::FTL::destory();
 }
+
+#undef PR_SECTION
+#define PR_SECTION X_Y(ISC_APP_CLASS, MultiBuffer)
+TEST(SletTest, PR_SECTION) {
+  const char *disk = "/tmp/sss-isc-test.img";
+  const size_t BLK_SIZE = ISC_APP_CLASS::BLK_SIZE;
+  const size_t szDisk = 64 << 20;
+
+  // more files than lanes, sizes around the block and chunk boundaries
+  std::mt19937_64 rng(0);
+  std::vector<size_t> szFiles = {0,    1,    55,     56,     63,     64,
+                                 65,   4095, 4096,   4097,   100000, 300001,
+                                 1 << 20};
+  while (szFiles.size() < 3 * ISC_APP_CLASS::LANES)
+    szFiles.push_back(rng() % (256 << 10));
+
+  auto data = (char *)malloc(szDisk);
+  ASSERT_NE(data, nullptr);
+  for (size_t i = 0; i < szDisk / sizeof(uint64_t); ++i)
+    ((uint64_t *)data)[i] = rng();
+
+  auto fd = open(disk, O_CREAT | O_TRUNC | O_WRONLY, 0644);
+  ASSERT_GE(fd, 0);
+  ASSERT_EQ((ssize_t)szDisk, write(fd, data, szDisk));
+  ASSERT_EQ(0, close(fd));
+
+  // files are split into 2 extents, with a hole block between files
+  std::vector<GenericFSA::Ext> exts;
+  std::vector<TestCase::digest_t> answers(szFiles.size());
+  auto slet = new ISC_APP_CLASS();
+  for (size_t i = 0, slbn = 0; i < szFiles.size(); ++i) {
+    auto numBlks = (szFiles[i] + BLK_SIZE - 1) / BLK_SIZE;
+    auto half = numBlks / 2;
+    if (half)
+      exts.push_back({0, slbn, half});
+    if (numBlks - half)
+      exts.push_back({half, slbn + half, numBlks - half});
+    exts.push_back({UINT64_MAX, UINT64_MAX, UINT64_MAX});
+
+    slet->md5sum((uint8_t *)&data[slbn * BLK_SIZE], szFiles[i],
+                 answers[i].words);
+    slbn += numBlks + 1;
+    ASSERT_LE(slbn * BLK_SIZE, szDisk);
+  }
+  delete slet;
+
+  FTL::setImage(disk);
+
+  for (int isa = SIMD::SCALAR; isa <= SIMD::hostISA(); ++isa) {
+    SIMD::setISA((SIMD::ISA)isa);
+    pr("ISA: %s", SIMD::isaName((SIMD::ISA)isa));
+
+    auto id = Runtime::addSlet<ISC_APP_CLASS>();
+    ASSERT_EQ(id, ++cntAPP);
+
+    // options are owned by the slet
+    auto numFiles = (size_t *)malloc(sizeof(size_t));
+    auto sizes = (size_t *)malloc(sizeof(size_t) * szFiles.size());
+    auto optExts = (GenericFSA::Ext *)malloc(sizeof(exts[0]) * exts.size());
+    *numFiles = szFiles.size();
+    memcpy(sizes, szFiles.data(), sizeof(size_t) * szFiles.size());
+    memcpy(optExts, exts.data(), sizeof(exts[0]) * exts.size());
+
+    ASSERT_EQ(Runtime::setOpt(id, GenericAPP::keyPath, strdup("/")),
+              ISC_STS_OK);
+    ASSERT_EQ(Runtime::setOpt(id, GenericAPP::keyNumFiles, numFiles),
+              ISC_STS_OK);
+    ASSERT_EQ(Runtime::setOpt(id, GenericAPP::keyFileSizes, sizes),
+              ISC_STS_OK);
+    ASSERT_EQ(Runtime::setOpt(id, GenericAPP::keyExts, optExts),
+              ISC_STS_OK);
+    ASSERT_EQ(Runtime::startSlet(id), ISC_STS_OK);
+
+    auto res = (ISC_APP_CLASS::result_t *)Runtime::getOpt(
+        id, GenericAPP::keyResult);
+    auto pResSz = (size_t *)Runtime::getOpt(id, GenericAPP::keyResultSize);
+    ASSERT_NE(res, nullptr);
+    ASSERT_NE(pResSz, nullptr);
+    ASSERT_EQ(szFiles.size() * sizeof(*res), *pResSz);
+
+    for (size_t i = 0; i < szFiles.size(); ++i)
+      ASSERT_EQ(0, memcmp(res[i].data, answers[i].bytes, sizeof(*res)))
+          << "File[" << i << "] " << szFiles[i] << " bytes";
+
+    ASSERT_EQ(Runtime::delSlet(id), ISC_STS_OK);
+  }
+  SIMD::setISA(SIMD::hostISA());
+
+  free(data);
+  Runtime::destory();
+  SIM::FTL::destory();
+  unlink(disk);
+}
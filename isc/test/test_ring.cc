@@ -0,0 +1,419 @@
+#include "gtest/gtest.h"
+
+#include <cstdio>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "hil/nvme/subsystem.hh"
+#include "hil/scheduler/credit_scheduler.hh"
+#include "icl/icl.hh"
+#include "sim/cpu.hh"
+#include "sim/simulator.hh"
+
+#include "sims/dram.hh"
+#include "sims/ftl.hh"
+
+#include "runtime.hh"
+#include "types.hh"
+
+#include "slet/grep.hh"
+#include "slet/hash.hh"
+
+using namespace SimpleSSD;
+using namespace SimpleSSD::ISC;
+
+/* -------------------------------------------------------------------------- */
+/*        built without ISC_TEST, so slets read through the HIL request       */
+/*           given as simCtx; the SSD below it is faked here instead          */
+/* -------------------------------------------------------------------------- */
+
+// reads reaching the ICL, by the user of the request and the issue tick
+static std::vector<std::pair<uint32_t, uint64_t>> reads;
+
+static const uint64_t iclLatency = 1000;
+static const uint64_t cpuLatency = 10;
+
+// nothing of these is touched but their addresses, any storage stands in
+static uint64_t iclStorage[sizeof(ICL::ICL) / sizeof(uint64_t) + 1];
+static uint64_t confStorage[sizeof(ConfigReader) / sizeof(uint64_t) + 1];
+static uint64_t subsysStorage[sizeof(HIL::NVMe::Subsystem) / sizeof(uint64_t) +
+                              1];
+
+SimpleSSD::HIL::Scheduler *gScheduler = nullptr;
+
+namespace SimpleSSD {
+
+void debugprint(LOG_ID, const char *, ...) {}
+void panic(const char *, ...) { abort(); }
+void warn(const char *, ...) {}
+uint64_t applyLatency(CPU::NAMESPACE, CPU::FUNCTION) { return cpuLatency; }
+uint32_t getISCCoreCount() { return 2; }
+
+namespace ICL {
+
+void ICL::read(Request &req, uint64_t &tick) {
+  reads.push_back({req.userID, tick});
+  tick += iclLatency;
+}
+
+void ICL::write(Request &, uint64_t &tick) { tick += iclLatency; }
+
+}  // namespace ICL
+
+namespace DRAM {
+
+AbstractDRAM::AbstractDRAM(ConfigReader &c)
+    : conf(c), totalEnergy(0.0), totalPower(0.0) {}
+AbstractDRAM::~AbstractDRAM() {}
+void AbstractDRAM::getStatList(std::vector<Stats> &, std::string) {}
+void AbstractDRAM::getStatValues(std::vector<double> &) {}
+void AbstractDRAM::resetStatValues() {}
+
+}  // namespace DRAM
+
+namespace HIL {
+
+namespace NVMe {
+
+Namespace::Namespace(Subsystem *p, ConfigData &c)
+    : pParent(p),
+      pDisk(nullptr),
+      cfgdata(c),
+      conf(*c.pConfigReader),
+      nsid(NSID_NONE),
+      attached(false),
+      allocated(false),
+      formatFinishedAt(0) {}
+
+Namespace::~Namespace() {}
+
+// 512B LBAs on 4KB pages
+void Subsystem::convertUnit(Namespace *, uint64_t slba, uint64_t nlblk,
+                            Request &req) {
+  req.range.slpn = slba / 8;
+  req.range.nlp = (nlblk + slba % 8 + 7) / 8;
+  req.offset = slba % 8 * 512;
+  req.length = nlblk * 512;
+}
+
+}  // namespace NVMe
+
+}  // namespace HIL
+
+}  // namespace SimpleSSD
+
+class FakeDRAM : public DRAM::AbstractDRAM {
+ public:
+  FakeDRAM(ConfigReader &c) : AbstractDRAM(c) {}
+  void read(void *, uint64_t, uint64_t &tick) override { tick += 1; }
+  void write(void *, uint64_t, uint64_t &tick) override { tick += 1; }
+};
+
+// the event queue of the simulator, fired by step()
+class FakeSim : public Simulator {
+  uint64_t now = 0;
+  Event last = 0;
+  std::map<Event, EventFunction> funcs;
+  std::map<Event, uint64_t> when;
+
+ public:
+  uint64_t getCurrentTick() override { return now; }
+  Event allocateEvent(EventFunction f) override {
+    funcs[++last] = f;
+    return last;
+  }
+  void scheduleEvent(Event e, uint64_t t) override { when[e] = t; }
+  void descheduleEvent(Event e) override { when.erase(e); }
+  bool isScheduled(Event e, uint64_t *t) override {
+    auto it = when.find(e);
+    if (it != when.end() && t)
+      *t = it->second;
+    return it != when.end();
+  }
+  void deallocateEvent(Event e) override {
+    when.erase(e);
+    funcs.erase(e);
+  }
+
+  // fire the earliest event, false once the queue is empty
+  bool step() {
+    if (when.empty())
+      return false;
+    auto next = when.begin();
+    for (auto it = when.begin(); it != when.end(); ++it)
+      if (it->second < next->second)
+        next = it;
+    Event e = next->first;
+    now = next->second;
+    when.erase(next);
+    funcs[e](now);
+    return true;
+  }
+};
+
+template <class T>
+static T *val(T v) {
+  auto p = (T *)malloc(sizeof(T));
+  *p = v;
+  return p;
+}
+
+#undef PR_SECTION
+#define PR_SECTION X_Y(GrepAPP, Ring)
+TEST(SletTest, PR_SECTION) {
+  auto disk = "/tmp/sss-isc-ring.img";
+  const size_t blk = GenericAPP::Stream::BLK_SIZE;
+  const size_t numFiles = 6, blksPerFile = 3;
+
+  // files back to back from the second block, every third line matches
+  std::string image(blk, '\0');
+  std::vector<size_t> sizes;
+  std::vector<GenericFSA::Ext> exts;
+  for (size_t f = 0; f < numFiles; ++f) {
+    std::string text;
+    for (size_t l = 0; text.size() < blksPerFile * blk - 100; ++l)
+      text += "file " + std::to_string(f) + (l % 3 ? " line " : " hit ") +
+              std::to_string(l) + "\n";
+    text.resize(blksPerFile * blk - 100);
+
+    exts.push_back({0, image.size() / blk, blksPerFile});
+    exts.push_back({UINT64_MAX, 0, 0});
+    sizes.push_back(text.size());
+    image += text;
+    image.resize(image.size() + 100, '\0');
+  }
+  auto fp = fopen(disk, "wb");
+  ASSERT_NE(fp, nullptr);
+  ASSERT_EQ(fwrite(image.data(), 1, image.size(), fp), image.size());
+  fclose(fp);
+
+  HIL::NVMe::ConfigData cfg = {reinterpret_cast<ConfigReader *>(confStorage),
+                               nullptr, 0, 0, 0};
+  HIL::NVMe::Namespace ns(
+      reinterpret_cast<HIL::NVMe::Subsystem *>(subsysStorage), cfg);
+  FakeDRAM dram(*cfg.pConfigReader);
+
+  SIM::FTL::setImage(disk);
+  SIM::FTL::setCache(iclStorage);
+  SIM::DRAM::setDRAM(&dram);
+
+  // the ISC-GET the slet runs for
+  HIL::Request hReq;
+  hReq.ns = &ns;
+  hReq.userID = 7;
+  void *ctx = &hReq;
+  uint64_t tick = 0;
+
+  auto startGrep = [&](size_t szRing) {
+    auto id = Runtime::addSlet<GrepAPP>(tick, ctx);
+    auto e = (GenericFSA::Ext *)malloc(exts.size() * sizeof(GenericFSA::Ext));
+    memcpy(e, exts.data(), exts.size() * sizeof(GenericFSA::Ext));
+    auto s = (size_t *)malloc(numFiles * sizeof(size_t));
+    memcpy(s, sizes.data(), numFiles * sizeof(size_t));
+
+    EXPECT_EQ(Runtime::setOpt(id, GrepAPP::keyPatt, strdup("hit"), tick, ctx),
+              ISC_STS_OK);
+    EXPECT_EQ(
+        Runtime::setOpt(id, GrepAPP::keyFormat, strdup("stream"), tick, ctx),
+        ISC_STS_OK);
+    EXPECT_EQ(Runtime::setOpt(id, GenericAPP::keyNumFiles, val(numFiles), tick,
+                              ctx),
+              ISC_STS_OK);
+    EXPECT_EQ(Runtime::setOpt(id, GenericAPP::keyFileSizes, s, tick, ctx),
+              ISC_STS_OK);
+    EXPECT_EQ(Runtime::setOpt(id, GenericAPP::keyExts, e, tick, ctx),
+              ISC_STS_OK);
+    if (szRing) {
+      EXPECT_EQ(Runtime::setOpt(id, GenericAPP::keyResultRing, val(szRing),
+                                tick, ctx),
+                ISC_STS_OK);
+    }
+    EXPECT_EQ(Runtime::startSlet(id, tick, ctx), ISC_STS_OK);
+    return id;
+  };
+
+  // the whole result at once
+  auto id = startGrep(0);
+  auto res = (char *)Runtime::getOpt(id, GenericAPP::keyResult, tick, ctx);
+  auto szRes =
+      (size_t *)Runtime::getOpt(id, GenericAPP::keyResultSize, tick, ctx);
+  ASSERT_NE(res, nullptr);
+  ASSERT_NE(szRes, nullptr);
+  std::string expect(res, *szRes);
+  ASSERT_GT(expect.size(), 4 * 1024ul);
+
+  // through a ring smaller than the result, so files are searched by pulls
+  reads.clear();
+  id = startGrep(2048);
+  auto readsAtStart = reads.size();
+  ASSERT_GT(readsAtStart, 0ul);
+
+  std::string got;
+  size_t pulls = 0;
+  char buf[1500];
+  for (;;) {
+    auto begin = tick, before = reads.size();
+    auto n = Runtime::getResult(id, got.size(), buf, sizeof(buf), tick, ctx);
+    if (!n)
+      break;
+    got.append(buf, n);
+    ++pulls;
+
+    // reads of a pull are issued for the request, and delay its completion
+    for (size_t i = before; i < reads.size(); ++i) {
+      ASSERT_EQ(reads[i].first, hReq.userID);
+      ASSERT_GE(reads[i].second, begin);
+    }
+    if (reads.size() > before) {
+      ASSERT_GE(tick, begin + iclLatency);
+    }
+  }
+  ASSERT_EQ(got, expect);
+  ASSERT_GT(pulls, 1ul);
+  ASSERT_GT(reads.size(), readsAtStart);
+
+  bool done = false;
+  ASSERT_EQ(Runtime::getResultSize(id, &done, tick, ctx), expect.size());
+  ASSERT_TRUE(done);
+
+  Runtime::destory();
+  SIM::FTL::destory();
+}
+
+#undef PR_SECTION
+#define PR_SECTION X_Y(HashAPP, Async)
+TEST(SletTest, PR_SECTION) {
+  auto disk = "/tmp/sss-isc-async.img";
+  const size_t blk = GenericAPP::Stream::BLK_SIZE;
+  const size_t numFiles = 5, blksPerFile = 150;  // 3 chunks per file
+
+  // files back to back from the second block, of bytes by the position
+  std::string image(blk, '\0');
+  std::vector<size_t> sizes;
+  std::vector<GenericFSA::Ext> exts;
+  for (size_t f = 0; f < numFiles; ++f) {
+    exts.push_back({0, image.size() / blk, blksPerFile});
+    exts.push_back({UINT64_MAX, 0, 0});
+    sizes.push_back(blksPerFile * blk - f * 100);
+    for (size_t i = 0; i < blksPerFile * blk; ++i)
+      image += (char)(i < sizes.back() ? i * 131 + f : 0);
+  }
+  auto fp = fopen(disk, "wb");
+  ASSERT_NE(fp, nullptr);
+  ASSERT_EQ(fwrite(image.data(), 1, image.size(), fp), image.size());
+  fclose(fp);
+
+  HIL::NVMe::ConfigData cfg = {reinterpret_cast<ConfigReader *>(confStorage),
+                               nullptr, 0, 0, 0};
+  HIL::NVMe::Namespace ns(
+      reinterpret_cast<HIL::NVMe::Subsystem *>(subsysStorage), cfg);
+  FakeDRAM dram(*cfg.pConfigReader);
+
+  SIM::FTL::setImage(disk);
+  SIM::FTL::setCache(iclStorage);
+  SIM::DRAM::setDRAM(&dram);
+
+  // the ISC-GET the slet runs for
+  HIL::Request hReq;
+  hReq.ns = &ns;
+  hReq.userID = 7;
+  void *ctx = &hReq;
+  uint64_t tick = 0;
+
+  auto addHash = [&](bool async) {
+    auto id = Runtime::addSlet<HashAPP>(tick, ctx);
+    auto e = (GenericFSA::Ext *)malloc(exts.size() * sizeof(GenericFSA::Ext));
+    memcpy(e, exts.data(), exts.size() * sizeof(GenericFSA::Ext));
+    auto s = (size_t *)malloc(numFiles * sizeof(size_t));
+    memcpy(s, sizes.data(), numFiles * sizeof(size_t));
+
+    EXPECT_EQ(Runtime::setOpt(id, GenericAPP::keyNumFiles, val(numFiles), tick,
+                              ctx),
+              ISC_STS_OK);
+    EXPECT_EQ(Runtime::setOpt(id, GenericAPP::keyFileSizes, s, tick, ctx),
+              ISC_STS_OK);
+    EXPECT_EQ(Runtime::setOpt(id, GenericAPP::keyExts, e, tick, ctx),
+              ISC_STS_OK);
+    if (async) {
+      EXPECT_EQ(Runtime::setOpt(id, GenericSlet::keyAsync, val(true), tick,
+                                ctx),
+                ISC_STS_OK);
+    }
+    return id;
+  };
+  auto result = [&](ISC_STS_SLET_ID id) {
+    auto res = (char *)Runtime::getOpt(id, GenericAPP::keyResult, tick, ctx);
+    auto szRes =
+        (size_t *)Runtime::getOpt(id, GenericAPP::keyResultSize, tick, ctx);
+    return res && szRes ? std::string(res, *szRes) : std::string();
+  };
+
+  // digests of the run holding the caller, no async run unless asked for
+  auto id = addHash(false);
+  ASSERT_EQ(Runtime::startSletAsync(
+                id, [](ISC_STS, uint64_t) {}, tick, ctx),
+            ISC_STS_EFUNC);
+  ASSERT_EQ(Runtime::startSlet(id, tick, ctx), ISC_STS_OK);
+  auto expect = result(id);
+  ASSERT_EQ(expect.size(), numFiles * 8);  // xxh64
+
+  FakeSim sim;
+  setSimulator(&sim);
+
+  // returns once the first reads are issued, the rest is done by events
+  auto runAsync = [&](uint64_t beginAt) {
+    bool ended = false;
+    auto sts = ISC_STS_FAIL;
+    uint64_t endAt = 0;
+
+    reads.clear();
+    tick = beginAt;
+    id = addHash(true);
+    EXPECT_EQ(Runtime::startSletAsync(
+                  id,
+                  [&](ISC_STS s, uint64_t t) {
+                    ended = true;
+                    sts = s;
+                    endAt = t;
+                  },
+                  tick, ctx),
+              ISC_STS_OK);
+    EXPECT_FALSE(ended);
+
+    while (sim.step()) {
+    }
+    EXPECT_TRUE(ended);
+    EXPECT_EQ(sts, ISC_STS_OK);
+    EXPECT_EQ(result(id), expect);
+
+    // every chunk is read, and the slet ends after the last of them
+    EXPECT_GE(reads.size(), numFiles * 3);
+    for (auto &read : reads) {
+      EXPECT_EQ(read.first, hReq.userID);
+      EXPECT_GE(read.second, beginAt);
+      EXPECT_GE(endAt, read.second + iclLatency);
+    }
+    return reads.empty() ? 0 : reads.front().second;
+  };
+
+  // reads are issued at the tick of the slet
+  auto firstAt = runAsync(sim.getCurrentTick());
+  EXPECT_LT(firstAt, tick + iclLatency);
+
+  // the user has no credit until the scheduler refills it, so the reads wait
+  // for it and the slet goes on by the callbacks of them
+  {
+    HIL::CreditScheduler cs(reinterpret_cast<ICL::ICL *>(iclStorage),
+                            1000000000ULL, 1000000000000ULL);
+    gScheduler = &cs;
+    auto beginAt = sim.getCurrentTick();
+    firstAt = runAsync(beginAt);
+    EXPECT_GT(firstAt, beginAt + iclLatency);
+    gScheduler = nullptr;
+  }
+
+  Runtime::destory();
+  SIM::FTL::destory();
+  setSimulator(nullptr);
+}
@@ -5,6 +5,9 @@
 #include "sims/dram.hh"
 
 #include <algorithm>
+#include <set>
+#include <thread>
+#include <vector>
 
 using namespace SimpleSSD::ISC;
 using namespace SimpleSSD::ISC::SIM;
@@ -18,6 +21,56 @@ class TestSlet : public GenericAPP {
 
 template ISC_STS_SLET_ID Runtime::addSlet<TestSlet>(_SIM_PARAMS);
 
+// mounted at the given path, and tells who serves a path by the size of file
+class TestFSA : public GenericFSA {
+ public:
+  static const char *nextCwd;
+  static size_t nextMark;
+
+  TestFSA() : GenericFSA(), mark(nextMark) { setOpt("cwd", strdup(nextCwd)); }
+  ExtList builtin_getExt(const char *) override {
+    ExtList l;
+    l.bytes = mark;
+    return l;
+  }
+
+  size_t mark;
+};
+const char *TestFSA::nextCwd;
+size_t TestFSA::nextMark;
+
+// item i of the result is (i % 50 + 1) bytes of 'a' + i % 26
+class ProduceSlet : public GenericAPP {
+ public:
+  static const size_t numItems = 200;
+  static size_t produced;
+
+  static std::string item(size_t i) {
+    return std::string(i % 50 + 1, 'a' + i % 26);
+  }
+
+  ISC_STS builtin_startup(_SIM_PARAMS) override {
+    return produce(numItems, [](size_t i, std::string *out) {
+      ++produced;
+      *out = item(i);
+      return i == failAt ? ISC_STS_FAIL : ISC_STS_OK;
+    });
+  }
+
+  static size_t failAt;
+};
+const size_t ProduceSlet::numItems;
+size_t ProduceSlet::produced;
+size_t ProduceSlet::failAt = SIZE_MAX;
+
+template ISC_STS_SLET_ID Runtime::addSlet<ProduceSlet>(_SIM_PARAMS);
+
+static size_t *ringSize(size_t sz) {
+  auto p = (size_t *)malloc(sizeof(size_t));
+  *p = sz;
+  return p;
+}
+
 TEST(RuntimeTest, Basic) {
   int count = 0;
   auto id = Runtime::addSlet<TestSlet>();
@@ -37,6 +90,214 @@ TEST(RuntimeTest, Basic) {
   Runtime::destory();
 }
 
+TEST(RuntimeTest, Options) {
+  // equal names share one id and one copy of the name
+  char name[] = "test key";
+  SletKey key(name), same("test key"), other("other key");
+  ASSERT_EQ(key.id, same.id);
+  ASSERT_EQ(key.name, same.name);
+  ASSERT_NE(key.name, (const char *)name);
+  ASSERT_NE(key.id, other.id);
+  ASSERT_EQ(SletKey("name").id, (size_t)SletKey::NAME);
+  ASSERT_EQ(SletKey("cwd").id, (size_t)SletKey::CWD);
+
+  TestSlet slet;
+  ASSERT_EQ(slet.getOpt(key), nullptr);
+  ASSERT_EQ(slet.getOpt("never set"), nullptr);
+
+  // pointers are owned by the slet, scalars are kept inline
+  auto val = strdup("test val");
+  ASSERT_EQ(slet.setOpt(key, val), ISC_STS_OK);
+  ASSERT_EQ(slet.getOpt("test key"), val);
+  ASSERT_EQ(slet.getOpt<char>(key), val);
+  ASSERT_EQ(slet.setVal<size_t>(key, 42), ISC_STS_OK);
+  ASSERT_EQ(*slet.getOpt<size_t>(key), 42ul);
+  ASSERT_EQ(slet.getVal<size_t>(key, 0), 42ul);
+  ASSERT_EQ(slet.getVal<size_t>(other, 7), 7ul);
+  ASSERT_EQ(slet.setOpt(key, strdup("again")), ISC_STS_OK);
+  ASSERT_STREQ(slet.getOpt<char>(key), "again");
+
+  ASSERT_EQ(slet.setOpt(GenericSlet::keyCwd, strdup("/mnt")), ISC_STS_OK);
+  ASSERT_STREQ(slet.getOpt<char>("cwd"), "/mnt");
+}
+
+TEST(RuntimeTest, Registry) {
+  // ids are never reused, deleted or unknown slets are not found
+  auto id = Runtime::addSlet<TestSlet>();
+  ASSERT_GT(id, 0);
+  ASSERT_EQ(Runtime::startSlet(id), ISC_STS_OK);
+  ASSERT_EQ(Runtime::delSlet(id), ISC_STS_OK);
+  ASSERT_EQ(Runtime::startSlet(id), ISC_STS_EID);
+  ASSERT_EQ(Runtime::delSlet(id), ISC_STS_OK);
+  ASSERT_EQ(Runtime::addSlet<TestSlet>(), id + 1);
+  for (auto bad : {0, -1, id + 2, INT32_MAX})
+    ASSERT_EQ(Runtime::startSlet(bad), ISC_STS_EID) << bad;
+
+  // the longest mount point of a path serves it, the first FSA keeps a path
+  ASSERT_EQ(Runtime::getExts("/file").bytes, 0ul);
+  struct {
+    const char *cwd;
+    size_t mark;
+  } mounts[] = {{"/mnt/a", 1}, {"/", 2}, {"/mnt/ab", 3}, {"/mnt/a", 4}};
+  for (auto &m : mounts) {
+    TestFSA::nextCwd = m.cwd;
+    TestFSA::nextMark = m.mark;
+    ASSERT_GT(Runtime::addSlet<TestFSA>(), 0);
+  }
+  struct {
+    const char *path;
+    size_t mark;
+  } paths[] = {{"/file", 2},        {"/mnt", 2},       {"/mnt/", 2},
+               {"/mnt/a", 1},       {"/mnt/a/file", 1}, {"/mnt/ab", 3},
+               {"/mnt/abc/file", 3}, {"/mnt/b", 2},     {"mnt", 0}};
+  for (auto &p : paths)
+    ASSERT_EQ(Runtime::getExts(p.path).bytes, p.mark) << p.path;
+
+  // hosts add and run slets at the same time
+  const size_t numHosts = 4, numSlets = 100;
+  std::vector<ISC_STS_SLET_ID> ids[numHosts];
+  std::vector<std::thread> hosts;
+  for (size_t h = 0; h < numHosts; ++h) {
+    hosts.emplace_back([&ids, h]() {
+      for (size_t i = 0; i < numSlets; ++i) {
+        ids[h].push_back(Runtime::addSlet<TestSlet>());
+        if (Runtime::startSlet(ids[h].back()) != ISC_STS_OK ||
+            Runtime::getExts("/mnt/a/file").bytes != 1)
+          ids[h].back() = ISC_STS_FAIL;
+        if (i % 2)
+          Runtime::delSlet(ids[h][i - 1]);
+      }
+    });
+  }
+  std::set<ISC_STS_SLET_ID> unique;
+  for (size_t h = 0; h < numHosts; ++h) {
+    hosts[h].join();
+    for (auto i : ids[h]) {
+      ASSERT_GT(i, 0);
+      unique.insert(i);
+    }
+  }
+  ASSERT_EQ(unique.size(), numHosts * numSlets);
+
+  Runtime::destory();
+  ASSERT_EQ(Runtime::getExts("/file").bytes, 0ul);
+}
+
+TEST(RuntimeTest, Tasks) {
+  const size_t n = 10;
+  std::vector<size_t> order, cores(n);
+  auto record = [&](size_t i) {
+    order.push_back(i);
+    cores[i] = Runtime::taskCore();
+    return ISC_STS_OK;
+  };
+
+  // a single core runs all tasks in order
+  numCores() = 1;
+  ASSERT_EQ(ISC_STS_OK, Runtime::runTasks(n, record));
+  ASSERT_EQ(order, std::vector<size_t>({0, 1, 2, 3, 4, 5, 6, 7, 8, 9}));
+  ASSERT_EQ(cores, std::vector<size_t>(n, 0));
+  ASSERT_EQ(Runtime::taskCore(), 0ul);
+
+  // cores take contiguous ranges [0,2) [2,5) [5,7) [7,10), and idle cores
+  // steal from the back of the core with the most tasks left
+  numCores() = 4;
+  order.clear();
+  ASSERT_EQ(ISC_STS_OK, Runtime::runTasks(n, record));
+  ASSERT_EQ(order, std::vector<size_t>({0, 2, 5, 7, 1, 3, 6, 8, 4, 9}));
+  ASSERT_EQ(cores, std::vector<size_t>({0, 0, 1, 1, 0, 2, 2, 3, 3, 1}));
+
+  // no task is started after a failure, which is returned
+  order.clear();
+  ASSERT_EQ(ISC_STS_EARGS, Runtime::runTasks(n, [&](size_t i) {
+    order.push_back(i);
+    return i == 5 ? ISC_STS_EARGS : ISC_STS_OK;
+  }));
+  ASSERT_EQ(order, std::vector<size_t>({0, 2, 5}));
+
+  // more cores than tasks, or nothing to do
+  order.clear();
+  ASSERT_EQ(ISC_STS_OK, Runtime::runTasks(2, record));
+  ASSERT_EQ(order, std::vector<size_t>({0, 1}));
+  ASSERT_EQ(ISC_STS_OK, Runtime::runTasks(0, record));
+  ASSERT_EQ(order.size(), 2ul);
+
+  numCores() = NUM_ISC_CORES;
+}
+
+TEST(RuntimeTest, Results) {
+  std::string expect;
+  for (size_t i = 0; i < ProduceSlet::numItems; ++i)
+    expect += ProduceSlet::item(i);
+
+  // all items are joined as the result without a ring
+  ProduceSlet::produced = 0;
+  auto id = Runtime::addSlet<ProduceSlet>();
+  ASSERT_EQ(Runtime::startSlet(id), ISC_STS_OK);
+  ASSERT_EQ(ProduceSlet::produced, ProduceSlet::numItems);
+  bool done = false;
+  ASSERT_EQ(Runtime::getResultSize(id, &done), expect.size());
+  ASSERT_TRUE(done);
+  ASSERT_EQ(*(size_t *)Runtime::getOpt(id, ISC_KEY_RESULT_SIZE), expect.size());
+  std::string got(expect.size(), 0);
+  ASSERT_EQ(Runtime::getResult(id, 0, &got[0], got.size()), expect.size());
+  ASSERT_EQ(got, expect);
+  ASSERT_EQ(Runtime::getResult(id, expect.size(), &got[0], 1), 0ul);
+
+  // with a ring, items are produced as the host pulls chunks of the result,
+  // and the slet is never more than the ring (and a batch) ahead of the host
+  const size_t szRing = 256, szChunk = 100;
+  for (size_t cores : {1, 4}) {
+    numCores() = cores;
+    ProduceSlet::produced = 0;
+    id = Runtime::addSlet<ProduceSlet>();
+    ASSERT_EQ(Runtime::setOpt(id, ISC_KEY_RESULT_RING, ringSize(szRing)),
+              ISC_STS_OK);
+    ASSERT_EQ(Runtime::startSlet(id), ISC_STS_OK);
+    ASSERT_LT(ProduceSlet::produced, ProduceSlet::numItems);
+    ASSERT_FALSE(Runtime::getOpt(id, ISC_KEY_RESULT));
+
+    got.clear();
+    char buf[szChunk];
+    for (size_t n; (n = Runtime::getResult(id, got.size(), buf, szChunk));) {
+      // bytes may be pulled again until the host goes past them
+      char again[szChunk];
+      ASSERT_EQ(Runtime::getResult(id, got.size(), again, szChunk), n);
+      ASSERT_EQ(memcmp(buf, again, n), 0);
+      got.append(buf, n);
+      auto sz = Runtime::getResultSize(id, &done);
+      ASSERT_LE(sz - got.size(), szRing);
+      ASSERT_EQ(done, ProduceSlet::produced == ProduceSlet::numItems &&
+                          sz == expect.size());
+    }
+    ASSERT_EQ(got, expect);
+    ASSERT_EQ(ProduceSlet::produced, ProduceSlet::numItems);
+    ASSERT_EQ(Runtime::getResultSize(id, &done), expect.size());
+    ASSERT_TRUE(done);
+
+    // released bytes are gone
+    ASSERT_EQ(Runtime::getResult(id, 0, buf, szChunk), 0ul);
+    ASSERT_EQ(Runtime::getResult(id, expect.size() - 1, buf, szChunk), 0ul);
+  }
+  numCores() = NUM_ISC_CORES;
+
+  // the result ends before a failed item
+  ProduceSlet::failAt = 2;
+  id = Runtime::addSlet<ProduceSlet>();
+  ASSERT_EQ(Runtime::setOpt(id, ISC_KEY_RESULT_RING, ringSize(szRing)),
+            ISC_STS_OK);
+  ASSERT_EQ(Runtime::startSlet(id), ISC_STS_FAIL);
+  ASSERT_EQ(Runtime::getResultSize(id, &done),
+            (ProduceSlet::item(0) + ProduceSlet::item(1)).size());
+  ASSERT_TRUE(done);
+  ProduceSlet::failAt = SIZE_MAX;
+
+  // unknown slets have no result
+  char c;
+  ASSERT_EQ(Runtime::getResult(ISC_STS_EID, 0, &c, 1), 0ul);
+  Runtime::destory();
+}
+
 #undef PR_SECTION
 #define PR_SECTION NormalRegion
 TEST(DramTest, PR_SECTION) {
@@ -259,4 +520,53 @@ TEST(DramTest, PR_SECTION) {
 
   DRAM::dealloc(mem);
   DRAM::destroy();
-}
\ No newline at end of file
+}
+#undef PR_SECTION
+#define PR_SECTION HashLRURegion_SimpleTest
+TEST(DramTest, PR_SECTION) {
+  const size_t nmem = 100;
+  const size_t unit = sizeof(size_t);
+  DRAM::Region::Key_t keys[] = {
+      [](const void *buf) -> uint64_t { return *(const size_t *)buf; },
+      // entries collide in a few buckets, and are told apart by cmp
+      [](const void *buf) -> uint64_t { return *(const size_t *)buf % 7; },
+  };
+
+  for (auto key : keys) {
+    auto mem = DRAM::alloc(nmem, unit, DRAM::TYPES::HASH_LRU_CACHE, memcmp,
+                           memcpy, memcpy, key);
+    ASSERT_NE(mem, nullptr);
+
+    size_t buffer[nmem], tmp = 0;
+    memset(buffer, 1, nmem * unit);
+
+    LRU_BASIC_TESTS(mem, nmem, buffer, tmp);
+    DRAM::dealloc(mem);
+
+    // same results as the list based region on random accesses
+    mem = DRAM::alloc(nmem, unit, DRAM::TYPES::HASH_LRU_CACHE, memcmp, memcpy,
+                      memcpy, key);
+    auto ref = DRAM::alloc(nmem, unit, DRAM::TYPES::LRU_CACHE);
+    ASSERT_NE(mem, nullptr);
+    ASSERT_NE(ref, nullptr);
+
+    for (int i = 0; i < 10000; ++i) {
+      size_t a = rand() % (nmem * 2), b = a;
+      if (rand() % 2)
+        ASSERT_EQ(ref->write(0, 0, &a), mem->write(0, 0, &b));
+      else
+        ASSERT_EQ(ref->read(0, 0, &a), mem->read(0, 0, &b));
+    }
+
+    auto &stat = mem->getStat();
+    ASSERT_GT(stat.hits, 0UL);
+    ASSERT_GT(stat.evictions, 0UL);
+    ASSERT_EQ(ref->getStat().hits, stat.hits);
+    ASSERT_EQ(ref->getStat().misses, stat.misses);
+    ASSERT_EQ(ref->getStat().evictions, stat.evictions);
+
+    DRAM::dealloc(ref);
+    DRAM::dealloc(mem);
+  }
+  DRAM::destroy();
+}
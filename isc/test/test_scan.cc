@@ -0,0 +1,501 @@
+#include "gtest/gtest.h"
+
+#include <fcntl.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "sims/ftl.hh"
+
+#include "runtime.hh"
+#include "types.hh"
+
+#include "slet/scan.hh"
+#include "utils/debug.hh"
+#include "utils/simd.hh"
+
+using namespace SimpleSSD::ISC;
+using namespace SimpleSSD::ISC::SIM;
+namespace SIMD = SimpleSSD::Utils::SIMD;
+
+typedef ScanAPP::Value Value;
+
+// plans are built by ops in the encoding of ScanAPP
+class PlanBuilder {
+ public:
+  PlanBuilder &op(uint8_t op) { return put(&op, 1); }
+  PlanBuilder &col(ScanAPP::Type t) { return op(ScanAPP::COL).u8(t); }
+  PlanBuilder &rows(uint32_t n) { return op(ScanAPP::ROWS).put(&n, 4); }
+  PlanBuilder &between(uint8_t c, Value lo, Value hi) {
+    return op(ScanAPP::BETWEEN).u8(c).put(&lo, 8).put(&hi, 8);
+  }
+  PlanBuilder &by(uint8_t c, int64_t lo, uint32_t n) {
+    return op(ScanAPP::BY).u8(c).put(&lo, 8).put(&n, 4);
+  }
+  PlanBuilder &agg(ScanAPP::Op o, uint8_t c) { return op(o).u8(c); }
+  PlanBuilder &count() { return op(ScanAPP::COUNT); }
+  PlanBuilder &hist(uint8_t c, Value lo, Value hi, uint16_t n) {
+    return op(ScanAPP::HIST).u8(c).put(&lo, 8).put(&hi, 8).put(&n, 2);
+  }
+  PlanBuilder &end() { return op(ScanAPP::END); }
+
+  ISC_STS parse(ScanAPP::Plan *plan) const {
+    return plan->parse(bytes.data(), bytes.size());
+  }
+
+  // a copy owned by the slet, of only the first len bytes if given, so
+  // reading past them is caught by the sanitizers
+  uint8_t *copy(size_t len = SIZE_MAX) const {
+    len = std::min(len, bytes.size());
+    auto p = (uint8_t *)malloc(len);
+    memcpy(p, bytes.data(), len);
+    return p;
+  }
+
+  std::vector<uint8_t> bytes;
+
+ private:
+  PlanBuilder &u8(uint8_t v) { return put(&v, 1); }
+  PlanBuilder &put(const void *v, size_t sz) {
+    bytes.insert(bytes.end(), (const uint8_t *)v, (const uint8_t *)v + sz);
+    return *this;
+  }
+};
+
+static Value I(int64_t i) {
+  Value v;
+  v.i = i;
+  return v;
+}
+
+static Value F(double f) {
+  Value v;
+  v.f = f;
+  return v;
+}
+
+// columns of a table, floats are kept as doubles
+struct Table {
+  std::vector<ScanAPP::Type> types;
+  std::vector<std::vector<Value>> rows;
+
+  static bool isFloat(ScanAPP::Type t) {
+    return t == ScanAPP::F32 || t == ScanAPP::F64;
+  }
+
+  // in groups of the given rows, columns one after another in a group
+  std::vector<uint8_t> encode(size_t first, size_t last, size_t groupRows) {
+    std::vector<uint8_t> out;
+    for (size_t g = first; g < last; g += groupRows) {
+      auto n = std::min(groupRows, last - g);
+      for (size_t c = 0; c < types.size(); ++c) {
+        for (size_t r = g; r < g + n; ++r) {
+          auto v = rows[r][c];
+          int32_t i32 = (int32_t)v.i;
+          float f32 = (float)v.f;
+          switch (types[c]) {
+            case ScanAPP::I32:
+              out.insert(out.end(), (uint8_t *)&i32, (uint8_t *)&i32 + 4);
+              break;
+            case ScanAPP::F32:
+              out.insert(out.end(), (uint8_t *)&f32, (uint8_t *)&f32 + 4);
+              break;
+            default:
+              out.insert(out.end(), (uint8_t *)&v, (uint8_t *)&v + 8);
+              break;
+          }
+        }
+      }
+    }
+    return out;
+  }
+
+  // the result of rows [first, last) by the plan, row by row
+  std::vector<uint8_t> reference(const ScanAPP::Plan &plan, size_t first,
+                                 size_t last) {
+    struct Acc {
+      uint64_t count = 0;
+      Value sum = I(0), min = I(INT64_MAX), max = I(INT64_MIN);
+      std::vector<uint64_t> bins;
+    };
+    std::vector<std::vector<Acc>> accs(plan.numGroups,
+                                       std::vector<Acc>(plan.aggs.size()));
+    for (auto &group : accs) {
+      for (size_t a = 0; a < plan.aggs.size(); ++a) {
+        auto &agg = plan.aggs[a];
+        group[a].bins.resize(agg.nbins);
+        if (agg.op != ScanAPP::COUNT && isFloat(types[agg.col])) {
+          group[a].sum = F(0);
+          group[a].min = F(INFINITY);
+          group[a].max = F(-INFINITY);
+        }
+      }
+    }
+
+    for (size_t r = first; r < last; ++r) {
+      auto &row = rows[r];
+      bool kept = true;
+      for (auto &p : plan.preds) {
+        auto v = row[p.col];
+        kept &= isFloat(types[p.col]) ? v.f >= p.lo.f && v.f <= p.hi.f
+                                      : v.i >= p.lo.i && v.i <= p.hi.i;
+      }
+      size_t g = 0;
+      if (plan.by) {
+        auto key = row[plan.byCol].i;
+        kept &= key >= plan.byLo && key < plan.byLo + plan.numGroups;
+        g = (size_t)(key - plan.byLo);
+      }
+      if (!kept)
+        continue;
+
+      for (size_t a = 0; a < plan.aggs.size(); ++a) {
+        auto &agg = plan.aggs[a];
+        auto &acc = accs[g][a];
+        auto v = row[agg.col];
+        bool fp = isFloat(types[agg.col]);
+
+        if (agg.op == ScanAPP::HIST) {
+          if (fp && v.f >= agg.lo.f && v.f < agg.hi.f) {
+            auto b = (size_t)((v.f - agg.lo.f) / (agg.hi.f - agg.lo.f) *
+                              agg.nbins);
+            ++acc.bins[std::min<size_t>(b, agg.nbins - 1)];
+          }
+          else if (!fp && v.i >= agg.lo.i && v.i < agg.hi.i) {
+            auto d = (__int128)v.i - agg.lo.i;
+            auto r = (__int128)agg.hi.i - agg.lo.i;
+            ++acc.bins[(size_t)(d * agg.nbins / r)];
+          }
+          continue;
+        }
+
+        ++acc.count;
+        if (agg.op == ScanAPP::COUNT)
+          continue;
+        if (fp) {
+          acc.sum.f += v.f;
+          acc.min.f = std::min(acc.min.f, v.f);
+          acc.max.f = std::max(acc.max.f, v.f);
+        }
+        else {
+          acc.sum.i += v.i;  // kept in range by the data
+          acc.min.i = std::min(acc.min.i, v.i);
+          acc.max.i = std::max(acc.max.i, v.i);
+        }
+      }
+    }
+
+    std::vector<uint8_t> out;
+    auto put = [&out](const void *v, size_t sz) {
+      out.insert(out.end(), (const uint8_t *)v, (const uint8_t *)v + sz);
+    };
+    for (auto &group : accs) {
+      for (size_t a = 0; a < plan.aggs.size(); ++a) {
+        auto &acc = group[a];
+        switch (plan.aggs[a].op) {
+          case ScanAPP::COUNT:
+            put(&acc.count, 8);
+            break;
+          case ScanAPP::SUM:
+            put(&acc.sum, 8);
+            break;
+          case ScanAPP::MIN:
+            put(&acc.min, 8);
+            break;
+          case ScanAPP::MAX:
+            put(&acc.max, 8);
+            break;
+          default:
+            put(acc.bins.data(), acc.bins.size() * 8);
+            break;
+        }
+      }
+    }
+    return out;
+  }
+};
+
+// i32 keys of few values, i64, f32 with NaNs, and f64
+static Table randomTable(size_t n) {
+  Table t;
+  t.types = {ScanAPP::I32, ScanAPP::I64, ScanAPP::F32, ScanAPP::F64};
+
+  std::mt19937_64 rng(0);
+  std::normal_distribution<double> normal(0, 100);
+  for (size_t i = 0; i < n; ++i) {
+    auto f32 = (float)normal(rng);
+    t.rows.push_back({I((int64_t)(rng() % 20) - 5), I((int64_t)rng() >> 24),
+                      F(i % 97 ? (double)f32 : NAN), F(normal(rng))});
+  }
+  return t;
+}
+
+// a plan of all kinds of aggregates on all columns, by groups or not
+static PlanBuilder fullPlan(bool by) {
+  PlanBuilder p;
+  p.col(ScanAPP::I32).col(ScanAPP::I64).col(ScanAPP::F32).col(ScanAPP::F64);
+  p.rows(512).between(2, F(-50), F(75.5)).between(1, I(-(1LL << 38)),
+                                                  I(1LL << 39));
+  if (by)
+    p.by(0, -2, 10);
+  p.count();
+  for (uint8_t c = 0; c < 4; ++c)
+    p.agg(ScanAPP::SUM, c).agg(ScanAPP::MIN, c).agg(ScanAPP::MAX, c);
+  p.hist(0, I(-5), I(15), 7).hist(3, F(-200), F(200), 16);
+  return p.end();
+}
+
+#undef PR_SECTION
+#define PR_SECTION X_Y(ScanAPP, Plan)
+TEST(SletTest, PR_SECTION) {
+  ScanAPP::Plan plan;
+
+  // 4 + 8 + 4 + 8 bytes per row, 512 rows fill 3 blocks
+  auto p = fullPlan(true);
+  ASSERT_EQ(p.parse(&plan), ISC_STS_OK);
+  ASSERT_EQ(plan.cols.size(), 4ul);
+  ASSERT_EQ(plan.rowBytes, 24ul);
+  ASSERT_EQ(plan.offsets, std::vector<size_t>({0, 4, 12, 16}));
+  ASSERT_EQ(plan.groupRows, 512u);
+  ASSERT_EQ(plan.preds.size(), 2ul);
+  ASSERT_EQ(plan.aggs.size(), 15ul);
+  ASSERT_TRUE(plan.by);
+  ASSERT_EQ(plan.numGroups, 10u);
+  ASSERT_EQ(plan.resultSize(), 10 * (13 + 7 + 16) * sizeof(uint64_t));
+
+  // bytes after END are not read
+  p.bytes.push_back(0xFF);
+  ASSERT_EQ(p.parse(&plan), ISC_STS_OK);
+
+  // a single column needs no groups
+  ASSERT_EQ(PlanBuilder().col(ScanAPP::F64).agg(ScanAPP::SUM, 0).end().parse(
+                &plan),
+            ISC_STS_OK);
+  ASSERT_EQ(plan.groupRows, 0u);
+  ASSERT_EQ(plan.resultSize(), sizeof(uint64_t));
+
+  // groups times bins up to the limit of the result
+  ASSERT_EQ(PlanBuilder().col(ScanAPP::I32).by(0, 0, 1 << 16).count()
+                .hist(0, I(0), I(5), 127).end().parse(&plan),
+            ISC_STS_OK);
+  ASSERT_EQ(plan.resultSize(), (size_t)64 << 20);
+
+  // malformed plans
+  PlanBuilder bad[] = {
+      PlanBuilder(),                                           // empty
+      PlanBuilder().col(ScanAPP::I32).agg(ScanAPP::SUM, 0),    // no END
+      PlanBuilder().col(ScanAPP::I32).end(),                   // no aggregates
+      PlanBuilder().agg(ScanAPP::SUM, 0).end(),                // no columns
+      PlanBuilder().col(ScanAPP::I32).agg(ScanAPP::MAX, 1).end(),  // bad col
+      PlanBuilder().col(ScanAPP::NUM_TYPES).agg(ScanAPP::SUM, 0).end(),
+      PlanBuilder().col(ScanAPP::I32).op(0x7F).end(),  // unknown op
+      PlanBuilder().col(ScanAPP::F32).by(0, 0, 4).count().end(),
+      PlanBuilder().col(ScanAPP::I32).by(0, 0, 0).count().end(),
+      PlanBuilder().col(ScanAPP::I32).hist(0, I(5), I(5), 4).end(),
+      PlanBuilder().col(ScanAPP::F64).hist(0, F(0), F(NAN), 4).end(),
+      PlanBuilder().col(ScanAPP::I32).hist(0, I(0), I(5), 0).end(),
+      // results too large, though each count is in its limit
+      PlanBuilder().col(ScanAPP::I32).by(0, 0, 1 << 16)
+          .hist(0, I(0), I(5), 65535).end(),
+      PlanBuilder().col(ScanAPP::I32).by(0, 0, 1 << 16).count()
+          .hist(0, I(0), I(5), 128).end(),
+      // groups of many columns shall fill blocks
+      PlanBuilder().col(ScanAPP::I32).col(ScanAPP::I64).agg(ScanAPP::SUM, 0)
+          .end(),
+      PlanBuilder().col(ScanAPP::I32).col(ScanAPP::I64).rows(100)
+          .agg(ScanAPP::SUM, 0).end(),
+  };
+  for (size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); ++i)
+    ASSERT_EQ(bad[i].parse(&plan), ISC_STS_EARGS) << "plan " << i;
+}
+
+#undef PR_SECTION
+#define PR_SECTION X_Y(ScanAPP, SIMD)
+TEST(SletTest, PR_SECTION) {
+  // the last group is short, so the columns of it are not aligned
+  const size_t n = 5001;
+  auto table = randomTable(n);
+  auto data = table.encode(0, n, 512);
+
+  ScanAPP app;
+  for (int isa = SIMD::SCALAR; isa < SIMD::ISA_COUNT; ++isa) {
+    if (SIMD::setISA((SIMD::ISA)isa) != isa)
+      continue;  // not supported by the host
+    printf("[%6s] checking kernels\n", SIMD::isaName((SIMD::ISA)isa));
+
+    for (bool by : {false, true}) {
+      ScanAPP::Plan plan;
+      ASSERT_EQ(fullPlan(by).parse(&plan), ISC_STS_OK);
+
+      ScanAPP::State st(plan);
+      ASSERT_EQ(app.scan(plan, data.data(), data.size(), &st), ISC_STS_OK);
+      std::vector<uint8_t> res(plan.resultSize());
+      st.output(plan, res.data());
+      ASSERT_EQ(table.reference(plan, 0, n), res) << "by " << by;
+    }
+
+    // bounds out of the type, and not a float exactly
+    struct {
+      uint8_t col;
+      Value lo, hi;
+    } preds[] = {
+        {0, I(INT64_MIN), I(INT64_MAX)}, {0, I(1LL << 40), I(1LL << 41)},
+        {0, I(3), I(2)},                 {2, F(-1e300), F(1e300)},
+        {2, F(0.1), F(0.30000001)},      {2, F(-INFINITY), F(-1)},
+        {3, F(NAN), F(1)},               {1, I(INT64_MIN), I(-1)},
+    };
+    for (auto &pred : preds) {
+      ScanAPP::Plan plan;
+      auto p = PlanBuilder();
+      p.col(ScanAPP::I32).col(ScanAPP::I64).col(ScanAPP::F32).col(ScanAPP::F64);
+      p.rows(512).between(pred.col, pred.lo, pred.hi);
+      ASSERT_EQ(p.count().end().parse(&plan), ISC_STS_OK);
+
+      ScanAPP::State st(plan);
+      ASSERT_EQ(app.scan(plan, data.data(), data.size(), &st), ISC_STS_OK);
+      std::vector<uint8_t> res(plan.resultSize());
+      st.output(plan, res.data());
+      ASSERT_EQ(table.reference(plan, 0, n), res) << "on col " << pred.col;
+    }
+
+    // integer histograms over ranges wider than INT64_MAX
+    Value ranges[][2] = {
+        {I(INT64_MIN), I(INT64_MAX)},
+        {I(INT64_MIN), I(0)},
+        {I(-1), I(INT64_MAX)},
+    };
+    for (auto &range : ranges) {
+      ScanAPP::Plan plan;
+      auto p = PlanBuilder();
+      p.col(ScanAPP::I32).col(ScanAPP::I64).col(ScanAPP::F32).col(ScanAPP::F64);
+      p.rows(512).hist(0, range[0], range[1], 5).hist(1, range[0], range[1], 64);
+      ASSERT_EQ(p.end().parse(&plan), ISC_STS_OK);
+
+      ScanAPP::State st(plan);
+      ASSERT_EQ(app.scan(plan, data.data(), data.size(), &st), ISC_STS_OK);
+      std::vector<uint8_t> res(plan.resultSize());
+      st.output(plan, res.data());
+      ASSERT_EQ(table.reference(plan, 0, n), res)
+          << "on [" << range[0].i << ", " << range[1].i << ")";
+    }
+  }
+  SIMD::setISA(SIMD::hostISA());
+}
+
+#undef PR_SECTION
+#define PR_SECTION X_Y(ScanAPP, NO_FSA)
+TEST(SletTest, PR_SECTION) {
+  const char *disk = "/tmp/sss-isc-test.img";
+  const size_t BLK_SIZE = ScanAPP::BLK_SIZE;
+  const size_t szDisk = 16 << 20;
+
+  // tables of many chunks, or less than a group, or nothing
+  std::vector<size_t> numRows = {30000, 100, 0, 12345};
+  size_t total = 0;
+  for (auto n : numRows)
+    total += n;
+  auto table = randomTable(total);
+
+  std::vector<uint8_t> disk_(szDisk, 0);
+  std::vector<GenericFSA::Ext> exts;
+  std::vector<size_t> sizes;
+  for (size_t i = 0, first = 0, slbn = 0; i < numRows.size(); ++i) {
+    auto data = table.encode(first, first + numRows[i], 512);
+    auto numBlks = (data.size() + BLK_SIZE - 1) / BLK_SIZE;
+    ASSERT_LE((slbn + numBlks) * BLK_SIZE, szDisk);
+    std::copy(data.begin(), data.end(), disk_.begin() + slbn * BLK_SIZE);
+
+    if (numBlks)
+      exts.push_back({0, slbn, numBlks});
+    exts.push_back({UINT64_MAX, UINT64_MAX, UINT64_MAX});
+    sizes.push_back(data.size());
+    first += numRows[i];
+    slbn += numBlks + 1;
+  }
+
+  auto fd = open(disk, O_CREAT | O_TRUNC | O_WRONLY, 0644);
+  ASSERT_GE(fd, 0);
+  ASSERT_EQ((ssize_t)szDisk, write(fd, disk_.data(), szDisk));
+  ASSERT_EQ(0, close(fd));
+  FTL::setImage(disk);
+
+  // sums of floats depend on the order, so only exact aggregates here
+  PlanBuilder p;
+  p.col(ScanAPP::I32).col(ScanAPP::I64).col(ScanAPP::F32).col(ScanAPP::F64);
+  p.rows(512).between(3, F(-150), F(150)).by(0, 0, 8);
+  p.count().agg(ScanAPP::SUM, 1).agg(ScanAPP::MIN, 2);
+  p.agg(ScanAPP::MAX, 3).hist(2, F(-100), F(100), 5).end();
+  ScanAPP::Plan plan;
+  ASSERT_EQ(p.parse(&plan), ISC_STS_OK);
+  auto ans = table.reference(plan, 0, total);
+
+  for (size_t cores : {1, 3}) {
+    numCores() = cores;
+
+    auto id = Runtime::addSlet<ScanAPP>();
+    ASSERT_GT(id, 0);
+
+    // options are owned by the slet
+    auto numFiles = (size_t *)malloc(sizeof(size_t));
+    auto optSizes = (size_t *)malloc(sizeof(size_t) * sizes.size());
+    auto optExts = (GenericFSA::Ext *)malloc(sizeof(exts[0]) * exts.size());
+    *numFiles = sizes.size();
+    memcpy(optSizes, sizes.data(), sizeof(size_t) * sizes.size());
+    memcpy(optExts, exts.data(), sizeof(exts[0]) * exts.size());
+
+    ASSERT_EQ(Runtime::setOpt(id, GenericAPP::keyPath, strdup("/")),
+              ISC_STS_OK);
+    ASSERT_EQ(Runtime::setOpt(id, GenericAPP::keyNumFiles, numFiles),
+              ISC_STS_OK);
+    ASSERT_EQ(Runtime::setOpt(id, GenericAPP::keyFileSizes, optSizes),
+              ISC_STS_OK);
+    ASSERT_EQ(Runtime::setOpt(id, GenericAPP::keyExts, optExts), ISC_STS_OK);
+
+    // no plan, plans cut short (END, then the hi and lo of BETWEEN at 13) or
+    // of unknown size, then a good one
+    ASSERT_EQ(Runtime::startSlet(id), ISC_STS_EARGS);
+    for (auto cut : {p.bytes.size() - 1, (size_t)26, (size_t)20}) {
+      ASSERT_EQ(Runtime::setOpt(id, ScanAPP::keyPlan, p.copy(cut), cut),
+                ISC_STS_OK);
+      ASSERT_EQ(Runtime::startSlet(id), ISC_STS_EARGS) << "cut at " << cut;
+    }
+    ASSERT_EQ(Runtime::setOpt(id, ScanAPP::keyPlan, p.copy()), ISC_STS_OK);
+    ASSERT_EQ(Runtime::startSlet(id), ISC_STS_EARGS);
+
+    // a few bytes of plan asking for a result of 32GB are turned down
+    auto huge = PlanBuilder();
+    huge.col(ScanAPP::I32).by(0, 0, 1 << 16).hist(0, I(0), I(5), 65535).end();
+    ASSERT_EQ(Runtime::setOpt(id, ScanAPP::keyPlan, huge.copy(),
+                              huge.bytes.size()),
+              ISC_STS_OK);
+    ASSERT_EQ(Runtime::startSlet(id), ISC_STS_EARGS);
+    ASSERT_EQ(Runtime::setOpt(id, ScanAPP::keyPlan, p.copy(), p.bytes.size()),
+              ISC_STS_OK);
+    ASSERT_EQ(Runtime::startSlet(id), ISC_STS_OK);
+
+    auto res = (uint8_t *)Runtime::getOpt(id, GenericAPP::keyResult);
+    auto pResSz = (size_t *)Runtime::getOpt(id, GenericAPP::keyResultSize);
+    ASSERT_NE(res, nullptr);
+    ASSERT_NE(pResSz, nullptr);
+    ASSERT_EQ(ans, std::vector<uint8_t>(res, res + *pResSz));
+
+    // raw files pass through the codec probe, unknown codecs are rejected
+    ASSERT_EQ(Runtime::setOpt(id, GenericAPP::keyCodec, strdup("auto")),
+              ISC_STS_OK);
+    ASSERT_EQ(Runtime::startSlet(id), ISC_STS_OK);
+    res = (uint8_t *)Runtime::getOpt(id, GenericAPP::keyResult);
+    pResSz = (size_t *)Runtime::getOpt(id, GenericAPP::keyResultSize);
+    ASSERT_EQ(ans, std::vector<uint8_t>(res, res + *pResSz));
+    ASSERT_EQ(Runtime::setOpt(id, GenericAPP::keyCodec, strdup("gzip")),
+              ISC_STS_OK);
+    ASSERT_EQ(Runtime::startSlet(id), ISC_STS_EARGS);
+
+    ASSERT_EQ(Runtime::delSlet(id), ISC_STS_OK);
+  }
+  numCores() = NUM_ISC_CORES;
+
+  Runtime::destory();
+  FTL::destory();
+}
@@ -56,10 +56,10 @@ TEST(SletTest, PR_SECTION) {
   ASSERT_EQ(id, ++cnt);
 
   // run and verify
-  ASSERT_EQ(Runtime::setOpt(id, SeqReadAPP::keyPath, strdup(path)), ISC_STS_OK);
+  ASSERT_EQ(Runtime::setOpt(id, GenericAPP::keyPath, strdup(path)), ISC_STS_OK);
   ASSERT_EQ(Runtime::startSlet(id), ISC_STS_OK);
 
-  auto result = (char *)Runtime::getOpt(id, SeqReadAPP::keyResult);
+  auto result = (char *)Runtime::getOpt(id, GenericAPP::keyResult);
   ASSERT_NE(result, nullptr);
   ASSERT_EQ(memcmp(result, data, dlen), 0);
 
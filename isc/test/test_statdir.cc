@@ -73,11 +73,11 @@ TEST(SletTest, PR_SECTION) {
   ASSERT_EQ(id, ++cntAPP);
 
   // run
-  ASSERT_EQ(Runtime::setOpt(id, ISC_APP_CLASS::keyPath, strdup(dirpath)),
+  ASSERT_EQ(Runtime::setOpt(id, GenericAPP::keyPath, strdup(dirpath)),
             ISC_STS_OK);
   ASSERT_EQ(Runtime::startSlet(id), ISC_STS_OK);
-  auto result = (char *)Runtime::getOpt(id, ISC_APP_CLASS::keyResult);
-  auto resSize = (uint64_t *)Runtime::getOpt(id, ISC_APP_CLASS::keyResultSize);
+  auto result = (char *)Runtime::getOpt(id, GenericAPP::keyResult);
+  auto resSize = (uint64_t *)Runtime::getOpt(id, GenericAPP::keyResultSize);
   ASSERT_NE(result, nullptr);
   ASSERT_NE(resSize, nullptr);
 
@@ -8,7 +8,9 @@
 #include "fs/ext4/ext4.hh"
 #include "slet/stats32.hh"
 #include "slet/stats64.hh"
+#include "utils/simd.hh"
 
+#include <random>
 #include <vector>
 using namespace std;
 
@@ -394,4 +396,58 @@ TEST(SletTest, PR_SECTION) {
   free(data);
   Runtime::destory();
   SIM::FTL::destory();
-}
\ No newline at end of file
+}
+#undef SLET_APP
+#define SLET_APP Stats3264APP
+
+#undef PR_SECTION
+#define PR_SECTION X_Y(SLET_APP, SIMD)
+TEST(SletTest, PR_SECTION) {
+  namespace SIMD = SimpleSSD::Utils::SIMD;
+
+  // not a multiple of any vector width
+  const size_t cnt = 4099;
+
+  std::mt19937_64 rng(0);
+  std::vector<int32_t> d32(cnt);
+  std::vector<int64_t> d64(cnt);
+  for (size_t i = 0; i < cnt; ++i) {
+    d32[i] = (int32_t)rng();
+    d64[i] = (int64_t)rng() >> 16;  // keep the sum in range
+  }
+
+  Stats32APP app32;
+  Stats64APP app64;
+  for (int isa = SIMD::SCALAR; isa < SIMD::ISA_COUNT; ++isa) {
+    if (SIMD::setISA((SIMD::ISA)isa) != isa)
+      continue;  // not supported by the host
+    printf("[%6s] checking kernels\n", SIMD::isaName((SIMD::ISA)isa));
+
+    // unaligned heads and short tails
+    for (size_t ofs : {0, 1, 3, 4095}) {
+      Stats32APP::result_t res32 = {0, 0, 0}, ans32 = {0, 0, 0};
+      ASSERT_EQ(app32.sum(&d32[ofs], cnt - ofs, &res32), ISC_STS_OK);
+      for (size_t i = ofs; i < cnt; ++i) {
+        ans32.sum += d32[i];
+        ans32.max = std::max(ans32.max, d32[i]);
+        ans32.min = std::min(ans32.min, d32[i]);
+      }
+      ASSERT_EQ(ans32.sum, res32.sum);
+      ASSERT_EQ(ans32.max, res32.max);
+      ASSERT_EQ(ans32.min, res32.min);
+
+      Stats64APP::result_t res64 = {0, 0, 0};
+      int64_t sum64 = 0, max64 = 0, min64 = 0;
+      ASSERT_EQ(app64.sum(&d64[ofs], cnt - ofs, &res64), ISC_STS_OK);
+      for (size_t i = ofs; i < cnt; ++i) {
+        sum64 += d64[i];
+        max64 = std::max(max64, d64[i]);
+        min64 = std::min(min64, d64[i]);
+      }
+      ASSERT_EQ(sum64, (int64_t)res64.sum);
+      ASSERT_EQ(max64, res64.max);
+      ASSERT_EQ(min64, res64.min);
+    }
+  }
+  SIMD::setISA(SIMD::hostISA());
+}
@@ -2,9 +2,17 @@
 #define __SIMPLESSD_ISC_TYPES_HH__
 
 #include <cstring>  // for memcpy
+#include <deque>
+#include <functional>
+#include <string>
+#include <type_traits>
+#include <vector>
 
 #include "sims/cpu.hh"
+#include "sims/dram.hh"
+#include "sims/ftl.hh"
 
+#include "utils/codec.hh"
 #include "utils/debug.hh"
 #include "utils/types.hh"
 
@@ -31,28 +39,41 @@ struct Extent {
   Extent(size_t b, size_t s, size_t n) : fblk(b), slpn(s), nlp(n) {}
 };
 
+/**
+ * @brief Option key interned to a small id, so the name is compared only once
+ *
+ * Slets keep their keys as static SletKey, names from hosts are interned by
+ * the implicit conversion.
+ */
+class SletKey {
+ public:
+  enum : size_t { NAME, CWD };  // interned first, kept in SletOpts fields
+
+  SletKey(const char *n) { id = intern(n, &name); }
+
+  operator const char *() const { return name; }
+
+  size_t id;
+  const char *name;  // the interned copy
+
+ private:
+  static size_t intern(const char *, const char **);
+};
+
 struct SletOpts {
-  struct SletKeyCmp {
-    /**
-     * @brief Allocator for comparing map key
-     *
-     * In imprecise terms, two objects a and b are considered equivalent (not
-     * unique) if neither compares less than the other: !comp(a, b) && !comp(b,
-     * a).
-     *
-     * @ref https://en.cppreference.com/w/cpp/container/map
-     */
-    bool operator()(const char *a, const char *b) {
-      auto res = strcmp(a, b);
-      return res < 0;
-    }
+  // a pointer owned by the slet, or a scalar kept inline
+  struct Slot {
+    void *ptr;
+    uint64_t val;
+    size_t len;  // bytes of the value, 0 if the setter did not tell
+    bool inl;
   };
 
  public:
   char *cwd = nullptr;
   char *name = nullptr;
   list<Extent> extents;
-  map<const char *, void *, SletKeyCmp> extra;
+  std::deque<Slot> extra;  // indexed by SletKey::id, slots never move
 };
 
 enum SletType : uint16_t {
@@ -66,6 +87,24 @@ class GenericSlet {
  public:
   virtual ISC_STS builtin_startup(_SIM_PARAMS) { return ISC_STS_EFUNC; }
   virtual ISC_STS builtin_shutdown(byte *, size_t) { return ISC_STS_EFUNC; }
+#ifndef ISC_TEST
+  // called with the status and the tick the slet ends
+  typedef std::function<void(ISC_STS, uint64_t)> DoneFunc;
+
+  /**
+   * @brief Start the slet driven by the event queue
+   *
+   * The slet returns once its first reads are issued, and goes on by the
+   * callbacks of them, so it does not hold the caller while the reads are in
+   * flight. The function is called from an event when the slet ends, or
+   * before it returns if nothing is read.
+   *
+   * @return ISC_STS ISC_STS_EFUNC if the slet only runs by builtin_startup()
+   */
+  virtual ISC_STS builtin_startAsync(const DoneFunc &_ADD_SIM_PARAMS) {
+    return ISC_STS_EFUNC;
+  }
+#endif
 
   GenericSlet(SletType t) : type(t) {
     assert(t != SletType::NUMS || "Invalid type");
@@ -80,13 +119,53 @@ class GenericSlet {
    *
    * @param key pointer to target option key
    * @param data pointer to target option value
+   * @param len bytes of the value, 0 if unknown
    * @return ISC_STS ISC_STS_OK if no error
    */
-  ISC_STS setOpt(const char *key, void *data);
+  ISC_STS setOpt(const SletKey &key, void *data, size_t len = 0);
+
+  void *getOpt(const SletKey &key);
+
+  // bytes of the option value given to setOpt(), 0 if unknown or not set
+  size_t getOptLen(const SletKey &key);
+
+  template <typename T>
+  T *getOpt(const SletKey &key) {
+    return (T *)getOpt(key);
+  }
+
+  /**
+   * @brief Set a scalar option, kept in the slot without allocation
+   *
+   * getOpt() of it gives the address of the inline copy.
+   */
+  template <typename T>
+  ISC_STS setVal(const SletKey &key, T val) {
+    static_assert(std::is_trivially_copyable<T>() && sizeof(T) <= 8,
+                  "Only scalars are kept inline");
+    auto &slot = getSlot(key);
+    if (!slot.inl)
+      free(slot.ptr);
+    slot.ptr = nullptr;
+    slot.len = sizeof(T);
+    slot.inl = true;
+    memcpy(&slot.val, &val, sizeof(T));
+    return ISC_STS_OK;
+  }
+
+  template <typename T>
+  T getVal(const SletKey &key, T def) {
+    auto val = (T *)getOpt(key);
+    return val ? *val : def;
+  }
 
-  void *getOpt(const char *key);
+  static const SletKey keyName;
+  static const SletKey keyCwd;
+  static const SletKey keyAsync;  // run by builtin_startAsync() if it is set
 
  protected:
+  SletOpts::Slot &getSlot(const SletKey &);
+
   SletType type;
   SletOpts opt;
 
@@ -94,13 +173,6 @@ class GenericSlet {
   size_t szShutdown;
 };
 
-// just a class for convenience
-class GenericAPP : public GenericSlet {
- public:
-  GenericAPP() : GenericSlet(SletType::APP) {}
-  ~GenericAPP() {}
-};
-
 class GenericFSA : public GenericSlet {
  public:
   struct Ext {
@@ -117,6 +189,45 @@ class GenericFSA : public GenericSlet {
     ExtList() : exts(nullptr), len(0), bytes(0) {}
   };
 
+  struct Dirent {
+    const char *name;  // not null-terminated, points into the dir data
+    size_t nameLen;
+    uint64_t ino;
+    uint8_t type;  // 1 for regular files and 2 for dirs, as ext4 does
+  };
+
+  /**
+   * @brief Iterator of the entries of a directory, names are not copied
+   *
+   * The directory data is read by the FSA into one buffer of SIM::DRAM, and
+   * entries returned by next() point into it, so they are valid as long as the
+   * iterator is. Unused entries, e.g., deleted ones, are skipped.
+   */
+  class DirIter {
+   public:
+    DirIter(uint64_t, size_t);
+    virtual ~DirIter();
+
+    /**
+     * @brief Get the next entry of the directory
+     *
+     * @return false if no more entries
+     */
+    virtual bool next(Dirent *) = 0;
+
+    uint64_t getIno() const { return ino; }
+    // raw data of the directory, in the format of the FSA
+    const char *getData() const { return data; }
+    size_t getSize() const { return size; }
+
+   protected:
+    uint64_t ino;
+    SIM::DRAM::Region *region;
+    char *data;
+    size_t size;
+    size_t ofs;  // the next entry in data
+  };
+
   GenericFSA() : GenericSlet(SletType::FSA) {}
   ~GenericFSA() {}
 
@@ -125,10 +236,45 @@ class GenericFSA : public GenericSlet {
     return nullptr;
   }
 
+  /**
+   * @brief Get many inodes into the given array of FSA inode records
+   *
+   * Inode numbers are expected in ascending order, so the inodes sharing a
+   * block of the inode table are read together.
+   *
+   * @return The number of inodes got, stop at the first one failed
+   */
+  virtual size_t builtin_getInodes(const uint64_t *, size_t,
+                                   void *_ADD_SIM_PARAMS) {
+    pr("%s not implemented", __func__);
+    return 0;
+  }
+
   virtual ExtList builtin_getExt(const char *_ADD_SIM_PARAMS) {
     pr("%s not implemented", __func__);
     return ExtList();
   }
+  /**
+   * @brief Get extents of all files in a directory by one pass of its entries
+   *
+   * @param regOnly Only regular files if true, otherwise all but directories
+   * @return The extent lists in the order of directory entries, extents are
+   * malloc'd and shall be free'd by the caller
+   */
+  virtual std::vector<ExtList> builtin_getExtsForDir(const char *,
+                                                     bool _ADD_SIM_PARAMS) {
+    pr("%s not implemented", __func__);
+    return std::vector<ExtList>();
+  }
+  /**
+   * @brief Open a directory to iterate its entries
+   *
+   * @return DirIter* nullptr if failed, otherwise shall be deleted after use
+   */
+  virtual DirIter *builtin_openDir(const char *_ADD_SIM_PARAMS) {
+    pr("%s not implemented", __func__);
+    return nullptr;
+  }
   virtual ExtList builtin_getExtRange(const char *, size_t, size_t) {
     pr("%s not implemented", __func__);
     return ExtList();
@@ -139,6 +285,253 @@ class GenericFSA : public GenericSlet {
   size_t szGetExtRange;
 };
 
+// just a class for convenience
+class GenericAPP : public GenericSlet {
+ public:
+  class ResultRing;
+
+  GenericAPP() : GenericSlet(SletType::APP), ring(nullptr) {}
+  ~GenericAPP();
+
+  /**
+   * @brief Produce the output of item i (e.g., a file) into the given string
+   */
+  typedef std::function<ISC_STS(size_t, std::string *_ADD_SIM_PARAMS)>
+      Producer;
+
+  /**
+   * @brief Produce the result by items [0, n), joined in the order of items
+   *
+   * Without keyResultRing, all items are produced by tasks now, and joined as
+   * keyResult and keyResultSize. Otherwise the items are appended to a result
+   * ring of that size, and only as many as it takes are produced now, the
+   * others are produced as the host pulls the result, see ResultRing.
+   *
+   * @note the producer may be called after the slet started, so it shall own
+   * what it uses
+   */
+  ISC_STS produce(size_t, const Producer & _ADD_SIM_PARAMS);
+
+  /**
+   * @brief Copy bytes of the result from the given offset
+   *
+   * @return size_t bytes copied, 0 if no more bytes or the offset is gone
+   */
+  size_t getResult(uint64_t, void *, size_t _ADD_SIM_PARAMS);
+  /**
+   * @brief Bytes of the result so far
+   *
+   * @param done set to whether all bytes of the result are produced
+   */
+  size_t getResultSize(bool *);
+
+  static const SletKey keyResult;
+  static const SletKey keyResultSize;
+  static const SletKey keyResultRing;  // bytes of the result ring, size_t
+  static const SletKey keyCodec;       // codec of files, see getCodec()
+  // files to process, see resolveFiles()
+  static const SletKey keyPath;
+  static const SletKey keyNumFiles;
+  static const SletKey keyFileSizes;
+  static const SletKey keyExts;
+
+  /**
+   * @brief The codec of files given by keyCodec, raw by default
+   *
+   * @return ISC_STS ISC_STS_EARGS if the name is unknown
+   */
+  ISC_STS getCodec(Utils::Codec::Type *);
+
+  /**
+   * @brief Split the extents given by the host (no FSA) into files
+   *
+   * @return The extent lists point into the given extents, don't free them
+   */
+  static std::vector<GenericFSA::ExtList> splitExts(GenericFSA::Ext *, size_t,
+                                                    const size_t *);
+
+  /**
+   * @brief Get extents of the files to process
+   *
+   * Files are given by the host as keyExts, keyNumFiles and keyFileSizes (no
+   * FSA), or by keyPath, which is a directory if it ends with '/'.
+   *
+   * @param files set to the extent lists, owned by the caller: release them
+   * by freeFiles()
+   * @param regOnly only regular files of a directory, see
+   * GenericFSA::builtin_getExtsForDir()
+   * @return ISC_STS ISC_STS_EARGS if no files are given
+   */
+  ISC_STS resolveFiles(std::vector<GenericFSA::ExtList> &files,
+                       bool regOnly _ADD_SIM_PARAMS);
+  static void freeFiles(std::vector<GenericFSA::ExtList> &);
+
+  /**
+   * @brief Set a result of sz bytes as keyResult and keyResultSize
+   *
+   * @param buf malloc'd, owned by the slet afterwards (free'd if failed)
+   */
+  ISC_STS publishResult(void *buf, size_t sz);
+
+  /**
+   * @brief Read file data chunk by chunk with rotating buffers
+   *
+   * The buffers are allocated from SIM::DRAM, so the memory usage is bounded
+   * by nbuf * szChunk instead of the file size. Reads of the next (nbuf - 1)
+   * chunks are issued before the current chunk is returned, so the flash
+   * latency of them overlaps with the compute on the current chunk.
+   *
+   * A compressed file is decoded on the way, and next() returns chunks of the
+   * decoded data instead, of szChunk bytes but the last one as well. The
+   * decoding runs on the core of the caller and is charged by the bytes it
+   * outputs.
+   *
+   * @note the chunk returned by next() is valid until the next call
+   */
+  class Stream {
+   public:
+    static const size_t BLK_SIZE = 4096;
+    static const size_t CHUNK_SIZE = 256 << 10;
+
+    Stream(const GenericFSA::ExtList &, size_t = CHUNK_SIZE, size_t = 2,
+           Utils::Codec::Type = Utils::Codec::RAW);
+    ~Stream();
+
+    /**
+     * @brief Get the next chunk of file data
+     *
+     * @param chunk set to the chunk data
+     * @return size_t size of the chunk, 0 if no more data or failed
+     */
+    size_t next(const byte **chunk _ADD_SIM_PARAMS);
+
+#ifndef ISC_TEST
+    // called with the chunk (0 bytes at the end) and the tick it is ready
+    typedef void (*ChunkFunc)(void *, const byte *, size_t, uint64_t);
+
+    /**
+     * @brief Get the next chunk without waiting for its reads
+     *
+     * Reads are issued by SIM::FTL::submitBatch() instead, and a chunk whose
+     * reads are in flight is given to the function by the event of the last
+     * one, so the caller shall return to the event queue meanwhile. Only raw
+     * files, and a stream is read by either next() or this.
+     *
+     * @param chunk set to the chunk data if it is ready
+     * @param len set to the size of the chunk if it is ready
+     * @note no read of the stream is in flight once it ends, delete it only
+     * then
+     *
+     * @return bool true if the chunk is ready, simTick is set to the time it
+     * is, and the function is not called
+     */
+    bool nextAsync(const byte **chunk, size_t *len, ChunkFunc,
+                   void *_ADD_SIM_PARAMS);
+#endif
+
+    // ISC_STS_FAIL if the file failed to decode
+    ISC_STS getStatus() const { return sts; }
+
+   protected:
+    struct Chunk {
+      const byte *data;
+      size_t len;
+      uint64_t readyAt;  // tick when data arrives the buffer
+      size_t pending;    // reads of submitBatch() in flight
+      Stream *stream;
+    };
+
+    void fill(size_t _ADD_SIM_PARAMS);
+#ifndef ISC_TEST
+    static void chunkDone(uint64_t, void *);
+#endif
+
+    GenericFSA::ExtList file;
+    size_t szChunk;
+    size_t nbuf;
+    SIM::DRAM::Region *region;
+    std::vector<Chunk> chunks;
+    std::vector<SIM::FTL::BatchRead> reqs;
+
+    size_t iExt, ofsExt;  // next position to read
+    size_t szIssued;      // bytes have been read (or reading)
+    size_t iHead;         // chunk to be returned by next()
+    bool started;
+
+    size_t read(const byte ** _ADD_SIM_PARAMS);
+    size_t decode(const byte ** _ADD_SIM_PARAMS);
+
+    Utils::Codec::Type codec;  // AUTO until the first chunk is probed
+    Utils::Codec::Decoder *decoder;
+    const byte *in;  // input left in the last chunk read
+    size_t inLen;
+    bool eof;  // all chunks are read
+    ISC_STS sts;
+
+#ifndef ISC_TEST
+    bool async = false;  // read by nextAsync()
+    // the caller waiting for the head chunk, see nextAsync()
+    ChunkFunc waitFunc = nullptr;
+    void *waitData = nullptr;
+    uint64_t waitAt = 0;
+#endif
+  };
+
+  /**
+   * @brief A bounded result channel between a slet and the host
+   *
+   * Bytes are addressed by their offset in the whole result. Only the ones
+   * not yet released are kept in a ring of SIM::DRAM, and the host releases
+   * the bytes before the offset it pulls from. Items are produced only while
+   * the ring has room, so a slet can't go further ahead of the host than the
+   * ring size (plus the output of the last batch of items).
+   */
+  class ResultRing {
+   public:
+    ResultRing(size_t, size_t, const Producer &);
+    ~ResultRing();
+
+    /**
+     * @brief Produce items until the ring is full or all are done
+     */
+    ISC_STS pump(_SIM_PARAMS);
+
+    /**
+     * @brief Copy bytes from the given offset, bytes before it are released
+     *
+     * Items are produced into the released room before copying.
+     *
+     * @return size_t bytes copied, 0 if the offset is released or not produced
+     */
+    size_t pull(uint64_t, void *, size_t _ADD_SIM_PARAMS);
+
+    uint64_t getHead() const { return head; }
+    uint64_t getTail() const { return tail; }
+    // all items are produced (or one failed) and appended
+    bool isDone() const {
+      return (next == num || sts != ISC_STS_OK) && spill.empty();
+    }
+    ISC_STS getStatus() const { return sts; }
+
+   protected:
+    void append(const char *, size_t _ADD_SIM_PARAMS);
+
+    SIM::DRAM::Region *region;
+    size_t capacity;
+    uint64_t head;  // offset of the oldest byte kept
+    uint64_t tail;  // offset of the next byte appended
+
+    Producer producer;
+    size_t num;
+    size_t next;        // item to be produced
+    std::string spill;  // output produced but not fit in the ring yet
+    ISC_STS sts;
+  };
+
+ protected:
+  ResultRing *ring;
+};
+
 }  // namespace ISC
 }  // namespace SimpleSSD
 
@@ -0,0 +1,148 @@
+#include "utils/codec.hh"
+
+#include <cstring>
+
+#include <lz4frame.h>
+#include <zstd.h>
+
+namespace SimpleSSD {
+namespace Utils {
+namespace Codec {
+
+static const char *names[CODEC_COUNT] = {"raw", "lz4", "zstd", "auto"};
+
+Type fromName(const char *s) {
+  for (uint8_t i = 0; i < CODEC_COUNT; ++i) {
+    if (!strcmp(s, names[i]))
+      return (Type)i;
+  }
+  return CODEC_COUNT;
+}
+
+const char *name(Type t) { return t < CODEC_COUNT ? names[t] : "unknown"; }
+
+#define MAGIC_LZ4 0x184D2204u
+#define MAGIC_ZSTD 0xFD2FB528u
+#define MAGIC_SKIPPABLE 0x184D2A50u  // of both, the low 4 bits are free
+
+Type probe(const uint8_t *data, size_t len) {
+  if (len < 4)
+    return RAW;
+
+  uint32_t magic = (uint32_t)data[0] | (uint32_t)data[1] << 8 |
+                   (uint32_t)data[2] << 16 | (uint32_t)data[3] << 24;
+  if (magic == MAGIC_LZ4)
+    return LZ4;
+  if (magic == MAGIC_ZSTD || (magic & ~0xFu) == MAGIC_SKIPPABLE)
+    return ZSTD;
+  return RAW;
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                    LZ4                                     */
+/* -------------------------------------------------------------------------- */
+
+class LZ4Decoder : public Decoder {
+ public:
+  LZ4Decoder() : dctx(nullptr), hint(0), err(nullptr) {
+    auto r = LZ4F_createDecompressionContext(&dctx, LZ4F_VERSION);
+    if (LZ4F_isError(r))
+      err = LZ4F_getErrorName(r);
+  }
+  ~LZ4Decoder() { LZ4F_freeDecompressionContext(dctx); }
+
+  bool decode(const uint8_t **in, size_t *inLen, uint8_t **out,
+              size_t *outLen) override {
+    if (err)
+      return false;
+
+    size_t szIn = *inLen, szOut = *outLen;
+    auto r = LZ4F_decompress(dctx, *out, &szOut, *in, &szIn, nullptr);
+    if (LZ4F_isError(r)) {
+      err = LZ4F_getErrorName(r);
+      return false;
+    }
+
+    // an idle call hints the header of the next frame, keep the last hint
+    if (szIn || szOut)
+      hint = r;
+    *in += szIn;
+    *inLen -= szIn;
+    *out += szOut;
+    *outLen -= szOut;
+    return true;
+  }
+
+  // 0 is hinted once a frame is done and flushed
+  bool atFrameEnd() const override { return !hint; }
+
+  const char *error() const override { return err ? err : "no error"; }
+
+ private:
+  LZ4F_dctx *dctx;
+  size_t hint;  // bytes of input expected next
+  const char *err;
+};
+
+/* -------------------------------------------------------------------------- */
+/*                                    ZSTD                                    */
+/* -------------------------------------------------------------------------- */
+
+class ZstdDecoder : public Decoder {
+ public:
+  ZstdDecoder() : dctx(ZSTD_createDCtx()), hint(0), err(nullptr) {
+    if (!dctx)
+      err = "out of memory";
+    else
+      ZSTD_DCtx_setParameter(dctx, ZSTD_d_windowLogMax, ZSTD_WINDOW_LOG_MAX);
+  }
+  ~ZstdDecoder() { ZSTD_freeDCtx(dctx); }
+
+  bool decode(const uint8_t **in, size_t *inLen, uint8_t **out,
+              size_t *outLen) override {
+    if (err)
+      return false;
+
+    ZSTD_inBuffer src = {*in, *inLen, 0};
+    ZSTD_outBuffer dst = {*out, *outLen, 0};
+    auto r = ZSTD_decompressStream(dctx, &dst, &src);
+    if (ZSTD_isError(r)) {
+      err = ZSTD_getErrorName(r);
+      return false;
+    }
+
+    // an idle call hints the header of the next frame, keep the last hint
+    if (src.pos || dst.pos)
+      hint = r;
+    *in += src.pos;
+    *inLen -= src.pos;
+    *out += dst.pos;
+    *outLen -= dst.pos;
+    return true;
+  }
+
+  // 0 is returned once a frame is done and flushed
+  bool atFrameEnd() const override { return !hint; }
+
+  const char *error() const override { return err ? err : "no error"; }
+
+ private:
+  ZSTD_DCtx *dctx;
+  size_t hint;  // bytes of input expected next
+  const char *err;
+};
+
+Decoder *Decoder::create(Type t) {
+  switch (t) {
+    case LZ4:
+      return new LZ4Decoder();
+    case ZSTD:
+      return new ZstdDecoder();
+    default:
+      return nullptr;
+  }
+}
+
+}  // namespace Codec
+}  // namespace Utils
+}  // namespace SimpleSSD
@@ -0,0 +1,74 @@
+#ifndef __SIMPLESSD_ISC_UTILS_CODEC_HH__
+#define __SIMPLESSD_ISC_UTILS_CODEC_HH__
+
+#include <cstddef>
+#include <cstdint>
+
+namespace SimpleSSD {
+namespace Utils {
+namespace Codec {
+
+/**
+ * @brief Compression formats of file data
+ *
+ * Only the frame formats are supported (the output of the lz4 and zstd tools),
+ * a file may be a concatenation of frames.
+ */
+typedef enum : uint8_t {
+  RAW,
+  LZ4,
+  ZSTD,
+  AUTO,  // probe each file by the magic number of its first frame
+
+  CODEC_COUNT,
+} Type;
+
+// the type of the given name ("raw", "lz4", "zstd" or "auto")
+Type fromName(const char *);
+
+const char *name(Type);
+
+// the codec of data by the magic number at its head, RAW if none
+Type probe(const uint8_t *, size_t);
+
+/**
+ * @brief A streaming decoder of concatenated frames
+ *
+ * The input and output may be given piece by piece of any size, the decoder
+ * keeps what it can't output yet.
+ */
+class Decoder {
+ public:
+  virtual ~Decoder() {}
+
+  /**
+   * @brief Decode the input into the output
+   *
+   * The buffers and their sizes are advanced by the bytes consumed and
+   * produced. Some input may be consumed without any output (e.g., headers).
+   *
+   * @return false if the input is corrupted
+   */
+  virtual bool decode(const uint8_t **in, size_t *inLen, uint8_t **out,
+                      size_t *outLen) = 0;
+
+  // whether the input so far ends exactly at the end of a frame
+  virtual bool atFrameEnd() const = 0;
+
+  // the last error, for logs
+  virtual const char *error() const = 0;
+
+  /**
+   * @brief A decoder of LZ4 or ZSTD, nullptr for others
+   */
+  static Decoder *create(Type);
+
+  // the max window of zstd frames, so the memory of a decoder is bounded
+  static const unsigned ZSTD_WINDOW_LOG_MAX = 23;
+};
+
+}  // namespace Codec
+}  // namespace Utils
+}  // namespace SimpleSSD
+
+#endif /* __SIMPLESSD_ISC_UTILS_CODEC_HH__ */
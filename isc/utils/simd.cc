@@ -0,0 +1,79 @@
+#include "utils/simd.hh"
+
+#include <cstdlib>
+#include <cstring>
+
+#ifdef ISC_SIMD_X86
+#include <cpuid.h>
+#endif
+
+namespace SimpleSSD {
+namespace Utils {
+namespace SIMD {
+
+static ISA probe() {
+#ifdef ISC_SIMD_X86
+  // the builtins check both CPUID and the register states enabled by OS
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f"))
+    return AVX512;
+  if (__builtin_cpu_supports("avx2"))
+    return AVX2;
+  if (__builtin_cpu_supports("sse4.2"))
+    return SSE4;
+#endif
+  return SCALAR;
+}
+
+// not all compilers know "sha" in __builtin_cpu_supports(), ask CPUID
+static bool probeSHA() {
+#ifdef ISC_SIMD_X86
+  unsigned eax, ebx, ecx, edx;
+  if (__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx))
+    return ebx & bit_SHA;
+#endif
+  return false;
+}
+
+static ISA initISA() {
+  ISA isa = hostISA();
+
+#ifdef ISC_TEST
+  // allow lowering the ISA without rebuilding tests
+  auto env = getenv("ISC_TEST_SIMD");
+  for (int i = 0; env && i < ISA_COUNT; ++i) {
+    if (!strcmp(env, isaName((ISA)i)) && i < isa)
+      isa = (ISA)i;
+  }
+#endif
+
+  return isa;
+}
+
+static ISA curISA = initISA();
+
+ISA hostISA() {
+  static ISA isa = probe();
+  return isa;
+}
+
+ISA getISA() { return curISA; }
+
+ISA setISA(ISA isa) {
+  curISA = isa < hostISA() ? isa : hostISA();
+  return curISA;
+}
+
+bool hasSHA() {
+  static bool sha = probeSHA();
+  return sha && curISA >= SSE4;
+}
+
+const char *isaName(ISA isa) {
+  static const char *names[] = {"scalar", "sse4", "avx2", "avx512"};
+  return isa < ISA_COUNT ? names[isa] : "unknown";
+}
+
+}  // namespace SIMD
+}  // namespace Utils
+}  // namespace SimpleSSD
@@ -0,0 +1,65 @@
+#ifndef __SIMPLESSD_ISC_UTILS_SIMD_HH__
+#define __SIMPLESSD_ISC_UTILS_SIMD_HH__
+
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define ISC_SIMD_X86 1
+#include <immintrin.h>
+
+// build a function for the given ISA regardless of the compile flags
+#define SIMD_TARGET(isa) __attribute__((target(isa)))
+
+// GCC warns on _mm512_undefined_*() used inside its own AVX-512 intrinsics
+#if defined(__GNUC__) && !defined(__clang__)
+#define SIMD_AVX512_BEGIN                                                      \
+  _Pragma("GCC diagnostic push")                                               \
+      _Pragma("GCC diagnostic ignored \"-Wmaybe-uninitialized\"")
+#define SIMD_AVX512_END _Pragma("GCC diagnostic pop")
+#else
+#define SIMD_AVX512_BEGIN
+#define SIMD_AVX512_END
+#endif
+#else
+#define SIMD_TARGET(isa)
+#endif
+
+namespace SimpleSSD {
+namespace Utils {
+namespace SIMD {
+
+/**
+ * @brief Instruction sets of the host kernels, ordered by vector width
+ *
+ * Kernels are picked at runtime, so the same binary runs on any x86 host (and
+ * falls back to SCALAR on others). Note that this only affects the host time,
+ * the simulated ISC core has its own fixed vector width (see cpu/def.hh).
+ */
+typedef enum : uint8_t {
+  SCALAR,
+  SSE4,    // 128-bit (SSE4.1, and SSE4.2 for 64-bit compares)
+  AVX2,    // 256-bit
+  AVX512,  // 512-bit (AVX-512F)
+
+  ISA_COUNT,
+} ISA;
+
+// the best ISA supported by the host CPU (and OS), probed by CPUID once
+ISA hostISA();
+
+// the ISA in use, hostISA() by default
+ISA getISA();
+
+// select the ISA in use, capped to hostISA(), return the applied one
+ISA setISA(ISA);
+
+const char *isaName(ISA);
+
+// SHA extensions of the host, only used if the ISA in use is SSE4 or above
+bool hasSHA();
+
+}  // namespace SIMD
+}  // namespace Utils
+}  // namespace SimpleSSD
+
+#endif /* __SIMPLESSD_ISC_UTILS_SIMD_HH__ */
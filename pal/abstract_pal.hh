@@ -21,6 +21,7 @@
 #define __PAL_ABSTRACT_PAL__
 
 #include <cinttypes>
+#include <vector>
 
 #include "pal/pal.hh"
 
@@ -40,6 +41,9 @@ class AbstractPAL : public StatObject {
   virtual void read(Request &, uint64_t &) = 0;
   virtual void write(Request &, uint64_t &) = 0;
   virtual void erase(Request &, uint64_t &) = 0;
+
+  // Tick up to which each die has operations scheduled
+  virtual void getBusyState(std::vector<uint64_t> &die) { die.clear(); }
 };
 
 }  // namespace PAL
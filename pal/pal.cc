@@ -142,6 +142,10 @@ Parameter *PAL::getInfo() {
   return &param;
 }
 
+void PAL::getBusyState(std::vector<uint64_t> &die) {
+  pPAL->getBusyState(die);
+}
+
 void PAL::getStatList(std::vector<Stats> &list, std::string prefix) {
   pPAL->getStatList(list, prefix + "pal.");
 }
@@ -59,6 +59,7 @@ class PAL : public StatObject {
   void copyback(uint32_t, uint32_t, uint32_t, uint64_t &);
 
   Parameter *getInfo();
+  void getBusyState(std::vector<uint64_t> &);
 
   void getStatList(std::vector<Stats> &, std::string) override;
   void getStatValues(std::vector<double> &) override;
@@ -333,6 +333,11 @@ void PALOLD::printPPN(Request &req, const char *prefix) {
              req.pageIndex);
 }
 
+// The rightmost free slot of a timeline starts where its last operation ends
+void PALOLD::getBusyState(std::vector<uint64_t> &die) {
+  die.assign(pal->DieStartPoint, pal->DieStartPoint + pal->totalDie);
+}
+
 void PALOLD::getStatList(std::vector<Stats> &list, std::string prefix) {
   Stats temp;
 
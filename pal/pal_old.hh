@@ -63,6 +63,8 @@ class PALOLD : public AbstractPAL {
   void write(Request &, uint64_t &) override;
   void erase(Request &, uint64_t &) override;
 
+  void getBusyState(std::vector<uint64_t> &) override;
+
   void getStatList(std::vector<Stats> &, std::string) override;
   void getStatValues(std::vector<double> &) override;
   void resetStatValues() override;
@@ -96,4 +96,12 @@ uint64_t applyLatency(CPU::NAMESPACE ns, CPU::FUNCTION fct) {
   return 0;
 }
 
+uint32_t getISCCoreCount() {
+  if (cpu) {
+    return cpu->getISCCoreCount();
+  }
+
+  return 1;
+}
+
 }  // namespace SimpleSSD
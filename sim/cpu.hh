@@ -52,6 +52,7 @@ void printCPULastStat();
 void execute(CPU::NAMESPACE, CPU::FUNCTION, DMAFunction &, void * = nullptr,
              uint64_t = 0);
 uint64_t applyLatency(CPU::NAMESPACE, CPU::FUNCTION);
+uint32_t getISCCoreCount();
 
 void commonCPUHandler(uint64_t, void *);
 
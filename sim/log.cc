@@ -118,10 +118,14 @@ const std::string logName[LOG_NUM] = {
     "ISC::SLET::GREP",          //!< LOG_ISC_SLET_GREP
     "ISC::SLET::STATS32",       //!< LOG_ISC_SLET_STATS32
     "ISC::SLET::STATS64",       //!< LOG_ISC_SLET_STATS64
+    "ISC::SLET::HASH",          //!< LOG_ISC_SLET_HASH
+    "ISC::SLET::SCAN",          //!< LOG_ISC_SLET_SCAN
     "ISC::FSA",                 //!< LOG_ISC_FSA
     "ISC::FSA::EXT4",           //!< LOG_ISC_EXT4
     "HIL::CREDIT_SCHEDULER",    //!< LOG_HIL_CREDIT_SCHEDULER
     "HIL::FCFS_SCHEDULER",      //!< LOG_HIL_FCFS_SCHEDULER
+    "HIL::DRR_SCHEDULER",       //!< LOG_HIL_DRR_SCHEDULER
+    "HIL::FLIN_SCHEDULER",      //!< LOG_HIL_FLIN_SCHEDULER
 };
 
 void debugprint(LOG_ID id, const char *format, ...) {
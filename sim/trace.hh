@@ -50,10 +50,14 @@ typedef enum {
   LOG_ISC_SLET_GREP,
   LOG_ISC_SLET_STATS32,
   LOG_ISC_SLET_STATS64,
+  LOG_ISC_SLET_HASH,
+  LOG_ISC_SLET_SCAN,
   LOG_ISC_FSA,
   LOG_ISC_EXT4,
   LOG_HIL_CREDIT_SCHEDULER,
   LOG_HIL_FCFS_SCHEDULER,
+  LOG_HIL_DRR_SCHEDULER,
+  LOG_HIL_FLIN_SCHEDULER,
   LOG_NUM
 } LOG_ID;
 
@@ -18,7 +18,9 @@
  */
 #include "util/def.hh"
 #include <cstdlib>
+#include <deque>
 #include <iostream>
+#include <vector>
 
 namespace SimpleSSD {
 
@@ -27,44 +29,123 @@ LPNRange::_LPNRange(uint64_t s, uint64_t n) : slpn(s), nlp(n) {}
 
 namespace HIL {
 
+namespace {
+
+const uint32_t NoSlot = UINT32_MAX;
+
+struct CallbackTable {
+  std::deque<DMAFunction> slots;  // deque: slots never move when it grows
+  std::vector<uint32_t> freeSlots;
+};
+
+CallbackTable &callbackTable() {
+  // never destroyed, handles may outlive static destruction order
+  static CallbackTable *table = new CallbackTable();
+
+  return *table;
+}
+
+}  // namespace
+
+CallbackHandle::CallbackHandle() : slot(NoSlot) {}
+
+CallbackHandle::CallbackHandle(DMAFunction &f) : slot(NoSlot) {
+  auto &table = callbackTable();
+
+  if (table.freeSlots.empty()) {
+    slot = (uint32_t)table.slots.size();
+    table.slots.push_back(f);
+  }
+  else {
+    slot = table.freeSlots.back();
+    table.freeSlots.pop_back();
+    table.slots[slot] = f;
+  }
+}
+
+CallbackHandle::CallbackHandle(CallbackHandle &&rhs) : slot(rhs.slot) {
+  rhs.slot = NoSlot;
+}
+
+CallbackHandle::~CallbackHandle() {
+  reset();
+}
+
+CallbackHandle &CallbackHandle::operator=(CallbackHandle &&rhs) {
+  if (this != &rhs) {
+    reset();
+
+    slot = rhs.slot;
+    rhs.slot = NoSlot;
+  }
+
+  return *this;
+}
+
+void CallbackHandle::operator()(uint64_t tick, void *context) const {
+  callbackTable().slots[slot](tick, context);
+}
+
+CallbackHandle::operator bool() const {
+  return slot != NoSlot && callbackTable().slots[slot];
+}
+
+void CallbackHandle::reset() {
+  if (slot != NoSlot) {
+    auto &table = callbackTable();
+
+    table.slots[slot] = nullptr;
+    table.freeSlots.push_back(slot);
+    slot = NoSlot;
+  }
+}
+
 Request::_Request()
     : reqID(0),
       reqSubID(0),
       offset(0),
       length(0),
-      userID(0),
-      prio(0),
-      op(OpType::READ),
-      ns(nullptr),                           // 加入 ns 初始化
+      beginAt(0),
       finishedAt(0),
-      function(nullptr),                     // 加入 function 初始化
+      ns(nullptr),
       context(nullptr),
-      state(RequestState::NORMAL),           // 新增欄位初始化
-      creditNeeded(0),                       // 新增欄位初始化
-      deferTime(0),                          // 新增欄位初始化
-      originalFunction(nullptr),             // 新增欄位初始化
-      originalContext(nullptr) {}            // 新增欄位初始化
+      next(nullptr),
+      userID(0),
+      prio(0),
+      op(OpType::READ) {}
 
 Request::_Request(DMAFunction &f, void *c)
     : reqID(0),
       reqSubID(0),
       offset(0),
       length(0),
-      userID(0), 
-      prio(0),
-      op(OpType::READ),
-      ns(nullptr),                           // 加入 ns 初始化
+      beginAt(0),
       finishedAt(0),
-      function(f),
+      ns(nullptr),
       context(c),
-      state(RequestState::NORMAL),           // 新增欄位初始化
-      creditNeeded(0),                       // 新增欄位初始化
-      deferTime(0),                          // 新增欄位初始化
-      originalFunction(nullptr),             // 新增欄位初始化
-      originalContext(nullptr) {}            // 新增欄位初始化
-
-bool Request::operator()(const Request &a, const Request &b) {
-  return a.finishedAt > b.finishedAt;
+      next(nullptr),
+      userID(0),
+      prio(0),
+      function(f),
+      op(OpType::READ) {}
+
+Request Request::clone() const {
+  Request req;
+
+  req.reqID = reqID;
+  req.reqSubID = reqSubID;
+  req.offset = offset;
+  req.length = length;
+  req.range = range;
+  req.beginAt = beginAt;
+  req.finishedAt = finishedAt;
+  req.ns = ns;
+  req.context = context;
+  req.userID = userID;
+  req.prio = prio;
+  req.op = op;
+
+  return req;
 }
 
 }  // namespace HIL
@@ -79,7 +160,7 @@ Request::_Request()
       userID(0),
       prio(0) {}    // 移除 state 初始化
 
-Request::_Request(HIL::Request &r)
+Request::_Request(const HIL::Request &r)
     : reqID(r.reqID),
       reqSubID(r.reqSubID),
       offset(r.offset),
@@ -51,48 +51,128 @@ enum class OpType : uint8_t {
   ISC_RESULT,
 };
 
-// 新增：請求狀態枚舉
-enum class RequestState : uint8_t {
-  NORMAL = 0,      // 正常請求
-  DEFERRED = 1,    // 因 credit 不足被延遲
-  RESUMED = 2,     // 從延遲隊列恢復執行
-  COMPLETED = 3    // 已完成
+// Completion callback of a request. The std::function itself is parked in
+// a shared table and the request only carries the 32-bit slot, so queueing
+// or moving a request never copies the callback. Move-only: the slot belongs
+// to exactly one request and is released when the handle is reset.
+//
+// Making a handle still copies the callback once into its slot, as callers
+// keep theirs (a trim passes the same one per range). Freed slots are reused,
+// so the table stays at the peak number of requests in flight; see
+// util/test/bench_request.cc for the cost against the copied requests.
+class CallbackHandle {
+ private:
+  uint32_t slot;
+
+ public:
+  CallbackHandle();
+  CallbackHandle(DMAFunction &);
+  CallbackHandle(CallbackHandle &&);
+  CallbackHandle(const CallbackHandle &) = delete;
+  ~CallbackHandle();
+
+  CallbackHandle &operator=(CallbackHandle &&);
+  CallbackHandle &operator=(const CallbackHandle &) = delete;
+
+  // the handle must outlive the call: drop it only after the callback returns
+  void operator()(uint64_t, void *) const;
+  explicit operator bool() const;
+  void reset();
 };
 
+// Move-only: HIL keeps requests in a pool and hands pointers to schedulers,
+// which keep ICL::Request snapshots when they need a copy
 typedef struct _Request {
   uint64_t reqID;
   uint64_t reqSubID;
   uint64_t offset;
   uint64_t length;
   LPNRange range;
-  
-  uint32_t userID;   ///< host uid (encoded by driver)
-  uint32_t prio;
-  
-  OpType   op;
-  
-  const void *ns;
-  
+
+  uint64_t beginAt;     ///< HIL handed the request to the scheduler
   uint64_t finishedAt;
-  DMAFunction function;
+
+  const void *ns;
   void *context;
-  
-  // ========== 新增欄位 ==========
-  RequestState state;           // 請求狀態
-  uint64_t creditNeeded;        // 需要的 credit (pages)
-  uint64_t deferTime;           // 延遲開始時間
-  
-  // 保存原始 callback（用於延遲後恢復）
-  DMAFunction originalFunction;
-  void *originalContext;
-  // ==============================
-  
+  _Request *next;  ///< intrusive link, owned by the queue holding the request
+
+  uint32_t userID;   ///< host uid (encoded by driver)
+  uint32_t prio;     ///< priority class from NVMe CDW2, 0 is the highest
+  CallbackHandle function;
+  OpType op;
+
   _Request();
   _Request(DMAFunction &, void *);
-  
-  bool operator()(const _Request &a, const _Request &b);
+  _Request(_Request &&) = default;
+  _Request(const _Request &) = delete;
+
+  _Request &operator=(_Request &&) = default;
+  _Request &operator=(const _Request &) = delete;
+
+  // Same request without the callback, for side requests derived from it
+  _Request clone() const;
 } Request;
 
+// FIFO of requests linked through Request::next, never owns them
+class RequestList {
+ private:
+  Request *head;
+  Request *tail;
+  uint64_t count;
+
+ public:
+  RequestList() : head(nullptr), tail(nullptr), count(0) {}
+
+  void push(Request *req) {
+    req->next = nullptr;
+
+    if (tail)
+      tail->next = req;
+    else
+      head = req;
+
+    tail = req;
+    count++;
+  }
+
+  Request *pop() {
+    Request *req = head;
+
+    if (req) {
+      head = req->next;
+      req->next = nullptr;
+
+      if (!head)
+        tail = nullptr;
+
+      count--;
+    }
+
+    return req;
+  }
+
+  // moves all of other to the tail of this list
+  void splice(RequestList &other) {
+    if (!other.head)
+      return;
+
+    if (tail)
+      tail->next = other.head;
+    else
+      head = other.head;
+
+    tail = other.tail;
+    count += other.count;
+
+    other.head = nullptr;
+    other.tail = nullptr;
+    other.count = 0;
+  }
+
+  bool empty() const { return head == nullptr; }
+  uint64_t size() const { return count; }
+};
+
 }  // namespace HIL
 
 namespace ICL {
@@ -108,7 +188,7 @@ typedef struct _Request {
   uint32_t prio;
   
   _Request();
-  _Request(HIL::Request &);
+  _Request(const HIL::Request &);
 } Request;
 
 }  // namespace ICL
@@ -0,0 +1,130 @@
+/*
+ * Copyright (C) 2024
+ *
+ * This file is part of SimpleSSD.
+ *
+ * SimpleSSD is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * SimpleSSD is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with SimpleSSD.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "util/histogram.hh"
+
+#include <cmath>
+
+#include "util/algorithm.hh"
+
+namespace SimpleSSD {
+
+LatencyHistogram::LatencyHistogram()
+    : total(0), sum(0), minValue(UINT64_MAX), maxValue(0) {}
+
+uint32_t LatencyHistogram::bucketOf(uint64_t value) {
+  const uint64_t limit = (uint64_t)1 << MaxBits;
+
+  if (value >= limit) {
+    value = limit - 1;
+  }
+  if (value < ((uint64_t)2 << SubBits)) {
+    return (uint32_t)value;
+  }
+
+  // the leading one and SubBits bits below it
+  uint32_t shift = 63 - __builtin_clzll(value) - SubBits;
+
+  return (shift << SubBits) + (uint32_t)(value >> shift);
+}
+
+uint64_t LatencyHistogram::upperOf(uint32_t bucket) {
+  if (bucket < (2u << SubBits)) {
+    return bucket;
+  }
+
+  uint32_t shift = (bucket >> SubBits) - 1;
+  uint64_t head = (bucket & ((1u << SubBits) - 1)) | (1u << SubBits);
+
+  return ((head + 1) << shift) - 1;
+}
+
+void LatencyHistogram::record(uint64_t value) {
+  if (counts.empty()) {
+    counts.resize(Buckets, 0);
+  }
+
+  counts[bucketOf(value)]++;
+  total++;
+  sum += value;
+
+  if (value < minValue) {
+    minValue = value;
+  }
+  if (value > maxValue) {
+    maxValue = value;
+  }
+}
+
+void LatencyHistogram::merge(const LatencyHistogram &rhs) {
+  if (rhs.total == 0) {
+    return;
+  }
+  if (counts.empty()) {
+    counts.resize(Buckets, 0);
+  }
+
+  for (uint32_t i = 0; i < Buckets; i++) {
+    counts[i] += rhs.counts[i];
+  }
+
+  total += rhs.total;
+  sum += rhs.sum;
+  minValue = MIN(minValue, rhs.minValue);
+  maxValue = MAX(maxValue, rhs.maxValue);
+}
+
+void LatencyHistogram::reset() {
+  if (total) {
+    counts.assign(counts.size(), 0);
+  }
+
+  total = 0;
+  sum = 0;
+  minValue = UINT64_MAX;
+  maxValue = 0;
+}
+
+double LatencyHistogram::mean() const {
+  return total ? (double)sum / total : 0.0;
+}
+
+uint64_t LatencyHistogram::percentile(double q) const {
+  if (total == 0) {
+    return 0;
+  }
+
+  uint64_t rank = (uint64_t)std::ceil(q * (double)total);
+  uint64_t seen = 0;
+
+  rank = MAX(rank, 1);
+
+  for (uint32_t i = 0; i < Buckets; i++) {
+    seen += counts[i];
+
+    if (seen >= rank) {
+      return MIN(upperOf(i), maxValue);
+    }
+  }
+
+  return maxValue;
+}
+
+}  // namespace SimpleSSD
@@ -0,0 +1,76 @@
+/*
+ * Copyright (C) 2024
+ *
+ * This file is part of SimpleSSD.
+ *
+ * SimpleSSD is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * SimpleSSD is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with SimpleSSD.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#ifndef __UTIL_HISTOGRAM__
+#define __UTIL_HISTOGRAM__
+
+#include <cinttypes>
+#include <vector>
+
+namespace SimpleSSD {
+
+/**
+ * Log-linear (HDR-style) histogram of latencies
+ *
+ * Values below 2^(SubBits + 1) have a bucket each. Above that, every power of
+ * two is split into 2^SubBits equal buckets, so a percentile is within
+ * 2^-SubBits (about 3%) of the recorded value. Values of MaxBits bits or more
+ * are counted in the last bucket. The buckets are allocated on the first
+ * record, so an unused histogram costs nothing, and record() is O(1).
+ */
+class LatencyHistogram {
+ public:
+  static const uint32_t SubBits = 5;
+  static const uint32_t MaxBits = 48;  // 2^48 ps is about 281 seconds
+  static const uint32_t Buckets = (MaxBits + 1 - SubBits) << SubBits;
+
+ private:
+  std::vector<uint64_t> counts;
+  uint64_t total;
+  uint64_t sum;
+  uint64_t minValue;
+  uint64_t maxValue;
+
+ public:
+  LatencyHistogram();
+
+  // The bucket of a value and the largest value in a bucket
+  static uint32_t bucketOf(uint64_t);
+  static uint64_t upperOf(uint32_t);
+
+  void record(uint64_t);
+  void merge(const LatencyHistogram &);
+  void reset();
+
+  uint64_t count() const { return total; }
+  uint64_t min() const { return total ? minValue : 0; }
+  uint64_t max() const { return maxValue; }
+  double mean() const;
+
+  // The smallest bucket bound of which q (0-1) of the values are at most, 0 if
+  // empty. This walks the buckets, so call it for stats, not per request.
+  uint64_t percentile(double q) const;
+};
+
+}  // namespace SimpleSSD
+
+#endif
@@ -0,0 +1,194 @@
+/*
+ * Copyright (C) 2024
+ *
+ * This file is part of SimpleSSD.
+ *
+ * SimpleSSD is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * SimpleSSD is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with SimpleSSD.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <queue>
+#include <vector>
+
+#include "sim/trace.hh"
+#include "util/def.hh"
+
+/* -------------------------------------------------------------------------- */
+/*     host time of a request from the HIL to its completion, the request     */
+/*       copied through the scheduler queues as before (Legacy) and the       */
+/*              pooled one holding a callback handle (Pooled)                 */
+/* -------------------------------------------------------------------------- */
+
+using namespace SimpleSSD;
+
+namespace SimpleSSD {
+
+void panic(const char *, ...) { abort(); }
+
+}  // namespace SimpleSSD
+
+// HIL::Request before it was pooled, both callbacks copied with it
+struct LegacyRequest {
+  uint64_t reqID;
+  uint64_t reqSubID;
+  uint64_t offset;
+  uint64_t length;
+  LPNRange range;
+  uint32_t userID;
+  uint32_t prio;
+  HIL::OpType op;
+  const void *ns;
+  uint64_t finishedAt;
+  DMAFunction function;
+  void *context;
+  uint8_t state;
+  uint64_t creditNeeded;
+  uint64_t deferTime;
+  DMAFunction originalFunction;
+  void *originalContext;
+
+  LegacyRequest(DMAFunction &f, void *c)
+      : reqID(0),
+        reqSubID(0),
+        offset(0),
+        length(0),
+        userID(0),
+        prio(0),
+        op(HIL::OpType::READ),
+        ns(nullptr),
+        finishedAt(0),
+        function(f),
+        context(c),
+        state(0),
+        creditNeeded(0),
+        deferTime(0),
+        originalFunction(nullptr),
+        originalContext(nullptr) {}
+};
+
+struct LaterFinish {
+  bool operator()(const LegacyRequest &a, const LegacyRequest &b) const {
+    return a.finishedAt > b.finishedAt;
+  }
+};
+
+static uint64_t completed = 0;
+
+typedef std::priority_queue<LegacyRequest, std::vector<LegacyRequest>,
+                            LaterFinish>
+    LegacyCompletion;
+
+// HIL takes the request by reference, the scheduler queues a copy, and the
+// completion queue another one
+static void runLegacy(DMAFunction &func, size_t inflight,
+                      std::queue<LegacyRequest> &scheduled,
+                      LegacyCompletion &done) {
+  for (size_t i = 0; i < inflight; ++i) {
+    LegacyRequest req(func, nullptr);
+
+    req.reqID = i;
+    scheduled.push(req);
+  }
+  while (!scheduled.empty()) {
+    LegacyRequest req = scheduled.front();
+
+    scheduled.pop();
+    req.finishedAt = req.reqID;
+    done.push(req);
+  }
+  while (!done.empty()) {
+    LegacyRequest req = done.top();
+
+    done.pop();
+    req.function(req.finishedAt, req.context);
+  }
+}
+
+// HIL moves the request into its pool, queues pass pointers
+static void runPooled(DMAFunction &func, size_t inflight,
+                      std::deque<HIL::Request> &pool,
+                      std::vector<HIL::Request *> &freeRequests) {
+  HIL::RequestList scheduled;
+  HIL::RequestList done;
+
+  for (size_t i = 0; i < inflight; ++i) {
+    HIL::Request req(func, nullptr);
+    HIL::Request *pReq;
+
+    req.reqID = i;
+    if (freeRequests.empty()) {
+      pool.push_back(std::move(req));
+      pReq = &pool.back();
+    }
+    else {
+      pReq = freeRequests.back();
+      freeRequests.pop_back();
+      *pReq = std::move(req);
+    }
+    scheduled.push(pReq);
+  }
+  while (auto pReq = scheduled.pop()) {
+    pReq->finishedAt = pReq->reqID;
+    done.push(pReq);
+  }
+  while (auto pReq = done.pop()) {
+    pReq->function(pReq->finishedAt, pReq->context);
+    pReq->function.reset();
+    freeRequests.push_back(pReq);
+  }
+}
+
+int main(int argc, char *argv[]) {
+  const size_t total = argc > 1 ? strtoull(argv[1], nullptr, 10) : 4000000;
+  const size_t inflight = 64;
+
+  // as the completion of Namespace, holding the callback of the DMA
+  DMAFunction dmaDone = [](uint64_t tick, void *) { completed += tick & 1; };
+  void *owner = &completed;
+  DMAFunction func = [owner, dmaDone](uint64_t tick, void *context) {
+    if (owner)
+      dmaDone(tick, context);
+  };
+
+  std::queue<LegacyRequest> scheduled;
+  LegacyCompletion done;
+  std::deque<HIL::Request> pool;
+  std::vector<HIL::Request *> freeRequests;
+
+  auto measure = [&](const char *name, size_t size, bool pooled) {
+    auto begin = std::chrono::steady_clock::now();
+
+    for (size_t n = 0; n < total; n += inflight) {
+      if (pooled)
+        runPooled(func, inflight, pool, freeRequests);
+      else
+        runLegacy(func, inflight, scheduled, done);
+    }
+
+    std::chrono::duration<double, std::nano> ns =
+        std::chrono::steady_clock::now() - begin;
+    printf("%-8s sizeof %3zu B, %6.1f ns/request\n", name, size,
+           ns.count() / total);
+  };
+
+  measure("Legacy", sizeof(LegacyRequest), false);
+  measure("Pooled", sizeof(HIL::Request), true);
+  printf("completed %" PRIu64 " requests\n", completed);
+
+  return 0;
+}
@@ -0,0 +1,112 @@
+/*
+ * Copyright (C) 2024
+ *
+ * This file is part of SimpleSSD.
+ *
+ * SimpleSSD is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * SimpleSSD is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with SimpleSSD.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "util/histogram.hh"
+
+using namespace SimpleSSD;
+
+#undef PR_SECTION
+#define PR_SECTION HistogramBuckets
+TEST(HistogramTest, PR_SECTION) {
+  typedef LatencyHistogram H;
+
+  // one bucket per value up to 63, then 32 buckets per power of two
+  EXPECT_EQ(0u, H::bucketOf(0));
+  EXPECT_EQ(0u, H::upperOf(0));
+  EXPECT_EQ(63u, H::bucketOf(63));
+  EXPECT_EQ(63u, H::upperOf(63));
+  EXPECT_EQ(64u, H::bucketOf(64));
+  EXPECT_EQ(65u, H::upperOf(64));
+  EXPECT_EQ(64u, H::bucketOf(65));
+  EXPECT_EQ(65u, H::bucketOf(66));
+
+  // the last bucket ends at 2^48 - 1 and takes anything above
+  const uint64_t last = ((uint64_t)1 << H::MaxBits) - 1;
+  EXPECT_EQ(H::Buckets - 1, H::bucketOf(last));
+  EXPECT_EQ(last, H::upperOf(H::Buckets - 1));
+  EXPECT_EQ(H::Buckets - 1, H::bucketOf(last + 1));
+  EXPECT_EQ(H::Buckets - 1, H::bucketOf(UINT64_MAX));
+
+  // buckets are contiguous and within 2^-SubBits of their lower bound
+  for (uint32_t b = 1; b < H::Buckets; ++b) {
+    uint64_t lo = H::upperOf(b - 1) + 1;
+    ASSERT_EQ(b, H::bucketOf(lo));
+    ASSERT_EQ(b, H::bucketOf(H::upperOf(b)));
+    ASSERT_LE((double)(H::upperOf(b) - lo), lo / 32.0);
+  }
+}
+
+#undef PR_SECTION
+#define PR_SECTION HistogramPercentile
+TEST(HistogramTest, PR_SECTION) {
+  // uniform 1..100000
+  {
+    LatencyHistogram h;
+    EXPECT_EQ(0u, h.percentile(0.5));
+    for (uint64_t v = 1; v <= 100000; ++v)
+      h.record(v);
+    EXPECT_EQ(100000u, h.count());
+    EXPECT_EQ(1u, h.min());
+    EXPECT_EQ(100000u, h.max());
+    EXPECT_NEAR(50000.5, h.mean(), 1e-9);
+
+    // a percentile is the upper bound of the bucket holding the rank, but
+    // never above the largest value
+    for (double q : {0.5, 0.99, 0.999}) {
+      uint64_t exact = (uint64_t)std::ceil(q * 100000);
+      uint64_t upper =
+          LatencyHistogram::upperOf(LatencyHistogram::bucketOf(exact));
+      EXPECT_EQ(std::min<uint64_t>(upper, 100000), h.percentile(q));
+      EXPECT_GE(h.percentile(q), exact);
+      EXPECT_LE(h.percentile(q), exact * 1.04);
+    }
+  }
+
+  // 990 fast, 9 slow and one very slow value
+  {
+    LatencyHistogram h;
+    for (uint32_t i = 0; i < 990; ++i)
+      h.record(1000);
+    for (uint32_t i = 0; i < 9; ++i)
+      h.record(1000000);
+    h.record(123456789);
+
+    EXPECT_NEAR(1000.0, (double)h.percentile(0.5), 1000 / 32.0);
+    EXPECT_NEAR(1000.0, (double)h.percentile(0.99), 1000 / 32.0);
+    EXPECT_NEAR(1000000.0, (double)h.percentile(0.995), 1000000 / 32.0);
+    EXPECT_NEAR(1000000.0, (double)h.percentile(0.999), 1000000 / 32.0);
+    EXPECT_EQ(123456789u, h.percentile(1.0));
+
+    // merging doubles every count, the ranks stay
+    LatencyHistogram m;
+    m.merge(h);
+    m.merge(h);
+    EXPECT_EQ(2000u, m.count());
+    EXPECT_EQ(h.percentile(0.999), m.percentile(0.999));
+
+    h.reset();
+    EXPECT_EQ(0u, h.count());
+    EXPECT_EQ(0u, h.percentile(0.99));
+  }
+}